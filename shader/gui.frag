@@ -3,10 +3,10 @@
 layout(location = 0) in vec4 inColor;
 layout(location = 1) in vec2 inTexCoord;
 
-layout(binding = 0) uniform sampler2D tex;
+layout(set = 1, binding = 0) uniform sampler2D atlas;
 
 layout(location = 0) out vec4 outColor;
 
 void main() {
-    outColor = texture(tex, inTexCoord);
+    outColor = inColor * texture(atlas, inTexCoord);
 }
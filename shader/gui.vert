@@ -1,14 +1,25 @@
 #version 450
 
+// one instance per element, the four vertices of its triangle strip are the corners
 layout(location = 0) in vec2 inPosition;
 layout(location = 1) in vec2 inExtent;
+layout(location = 2) in vec4 inUvRect;
+layout(location = 3) in vec4 inColor;
 
-layout(location = 0) out vec2 outPosition;
-layout(location = 1) out vec2 outExtent;
+layout(location = 0) out vec4 outColor;
+layout(location = 1) out vec2 outTexCoord;
+
+layout(push_constant) uniform Push {
+    vec2 scale;
+} push;
 
 void main() {
-    outPosition = inPosition;
-    outExtent = inExtent;
+    vec2 corner = vec2(gl_VertexIndex & 1, gl_VertexIndex >> 1);
+
+    outColor = inColor;
+    outTexCoord = mix(inUvRect.xy, inUvRect.zw, corner);
 
-    gl_Position = vec4(inPosition, 0.0, 1.0);
-}
\ No newline at end of file
+    // pixels from the top left, which is where Vulkan puts -1, -1
+    vec2 pixel = inPosition + corner * inExtent;
+    gl_Position = vec4(pixel * push.scale - 1.0, 0.0, 1.0);
+}
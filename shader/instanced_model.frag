@@ -0,0 +1,21 @@
+#version 450
+
+layout(location = 0) in vec3 inColor;
+layout(location = 1) in vec3 inNormal;
+
+layout(location = 0) out vec4 outColor;
+
+layout(set = 0, binding = 0) uniform GlobalUbo {
+    mat4 projection;
+    mat4 view;
+    vec4 ambientLightColor;
+} ubo;
+
+const vec3 LIGHT_DIRECTION = normalize(vec3(1.0, -3.0, -1.0));
+
+void main() {
+    vec3 ambient = ubo.ambientLightColor.rgb * ubo.ambientLightColor.a;
+    float diffuse = max(dot(normalize(inNormal), -LIGHT_DIRECTION), 0.0);
+
+    outColor = vec4(inColor * (ambient + diffuse), 1.0);
+}
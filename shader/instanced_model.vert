@@ -0,0 +1,33 @@
+#version 450
+
+layout(location = 0) in vec3 inPosition;
+layout(location = 1) in vec3 inColor;
+layout(location = 2) in vec3 inNormal;
+layout(location = 3) in vec2 inUv;
+
+layout(location = 0) out vec3 outColor;
+layout(location = 1) out vec3 outNormal;
+
+layout(set = 0, binding = 0) uniform GlobalUbo {
+    mat4 projection;
+    mat4 view;
+    vec4 ambientLightColor;
+} ubo;
+
+struct Instance {
+    mat4 modelMatrix;
+    mat4 normalMatrix;
+    uint modelIndex;
+};
+
+layout(std430, set = 1, binding = 0) readonly buffer Instances { Instance instances[]; };
+// written by cull.comp, the draw's firstInstance points at its batch
+layout(std430, set = 1, binding = 1) readonly buffer Visible { uint visible[]; };
+
+void main() {
+    Instance instance = instances[visible[gl_InstanceIndex]];
+
+    gl_Position = ubo.projection * ubo.view * instance.modelMatrix * vec4(inPosition, 1.0);
+    outNormal = normalize(mat3(instance.normalMatrix) * inNormal);
+    outColor = inColor;
+}
@@ -1,5 +1,8 @@
 #version 450
 
+// Pipeline variants, see ParticleVariant in ParticleRenderSystem.h
+layout(constant_id = 0) const bool SOFT_EDGE = true;
+
 layout(location = 0) in vec4 inColor;
 layout(location = 1) in vec2 inTexCoord;
 
@@ -7,9 +10,8 @@ layout(location = 0) out vec4 outColor;
 
 void main() {
     float distance = length(inTexCoord - vec2(0.5));
-    float alpha = smoothstep(0.5, 0.4, distance);
-
+    float alpha = SOFT_EDGE ? smoothstep(0.5, 0.4, distance) : step(distance, 0.5);
 
     outColor = inColor;
     outColor.a *= alpha;
-}
\ No newline at end of file
+}
@@ -1,5 +1,8 @@
 #version 450
 
+// Pipeline variants, see ParticleVariant in ParticleRenderSystem.h
+layout(constant_id = 1) const bool PALETTE_COLOR = false;
+
 layout(location = 0) in vec2 inPosition;
 layout(location = 1) in vec4 inColor;
 layout(location = 2) in float inSize;
@@ -8,11 +11,19 @@ layout(location = 0) out vec2 outPosition;
 layout(location = 1) out vec4 outColor;
 layout(location = 2) out float outSize;
 
+layout(push_constant) uniform Push {
+    // indexed by inColor.r in the PALETTE_COLOR variant
+    vec4 palette[7];
+    // read by particle.geom in the FIXED_SIZE variant
+    float quadSize;
+} push;
+
 void main() {
     outPosition = inPosition;
-    outColor = inColor;
+    // R8G8B8A8_UNORM, so the index arrives divided by 255
+    outColor = PALETTE_COLOR ? push.palette[int(inColor.r * 255.0 + 0.5)] : inColor;
     outSize = inSize;
 
     gl_Position = vec4(inPosition, 0.0, 1.0);
     gl_PointSize = inSize;
-}
\ No newline at end of file
+}
@@ -0,0 +1,24 @@
+#version 450
+
+layout(location = 0) in vec2 inRibbonCoord;
+
+layout(location = 0) out vec4 outColor;
+
+layout(push_constant) uniform Push {
+    vec4 color;
+    float radius;
+    // of the path, the caps reach radius past both ends
+    float length;
+} push;
+
+void main() {
+    // distance from the path's centerline, measured from the nearest end point inside the caps,
+    // which rounds both the caps and the outer side of sharp corners
+    float along = inRibbonCoord.x < 0.0 ? inRibbonCoord.x : max(inRibbonCoord.x - push.length, 0.0);
+    float across = inRibbonCoord.y * push.radius;
+    if (along * along + across * across > push.radius * push.radius) {
+        discard;
+    }
+
+    outColor = push.color;
+}
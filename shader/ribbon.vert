@@ -0,0 +1,18 @@
+#version 450
+
+layout(location = 0) in vec2 inPosition;
+// x along the path from its first point, y across it from -1 to 1 (past that at mitered corners)
+layout(location = 1) in vec2 inRibbonCoord;
+
+layout(location = 0) out vec2 outRibbonCoord;
+
+layout(set = 0, binding = 0) uniform GlobalUbo {
+    mat4 projection;
+    mat4 view;
+} ubo;
+
+void main() {
+    outRibbonCoord = inRibbonCoord;
+    // in world units, see Camera2D
+    gl_Position = ubo.projection * ubo.view * vec4(inPosition, 0.0, 1.0);
+}
@@ -0,0 +1,173 @@
+#include "AppleField.h"
+
+#include <glm/common.hpp>
+#include <glm/geometric.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace engine {
+
+    static uint32_t countTrailingZeros(uint64_t bits) {
+#ifdef _MSC_VER
+        unsigned long index;
+        _BitScanForward64(&index, bits);
+        return index;
+#else
+        return static_cast<uint32_t>(__builtin_ctzll(bits));
+#endif
+    }
+
+    static uint32_t popCount(uint64_t bits) {
+#ifdef _MSC_VER
+        return static_cast<uint32_t>(__popcnt64(bits));
+#else
+        return static_cast<uint32_t>(__builtin_popcountll(bits));
+#endif
+    }
+
+    AppleField::AppleField(const Settings &settings)
+            : mSettings(settings), mCellSize(2.0f * settings.appleSize), mGenerator(settings.seed) {
+        mGridSize = glm::max(glm::ivec2((settings.max - settings.min) / mCellSize), glm::ivec2(1));
+        auto cellCount = static_cast<uint32_t>(mGridSize.x * mGridSize.y);
+
+        mFree.resize((cellCount + 63) / 64);
+        mFreeSummary.resize((mFree.size() + 63) / 64);
+        mSnake.resize(mFree.size());
+        mAppleOfCell.assign(cellCount, NO_APPLE);
+        for (uint32_t cell = 0; cell < cellCount; cell++) {
+            SetFree(cell, true);
+        }
+    }
+
+    glm::ivec2 AppleField::CellOf(const glm::vec2 &position) const {
+        glm::ivec2 cell{glm::floor((position - mSettings.min) / mCellSize)};
+        return glm::clamp(cell, glm::ivec2(0), mGridSize - 1);
+    }
+
+    void AppleField::SetFree(uint32_t cell, bool free) {
+        uint64_t &word = mFree[cell / 64];
+        uint64_t bit = uint64_t{1} << (cell % 64);
+        if (((word & bit) != 0) == free) {
+            return;
+        }
+        word ^= bit;
+        if (free) {
+            mFreeCount++;
+        } else {
+            mFreeCount--;
+        }
+
+        uint32_t wordIndex = cell / 64;
+        uint64_t summaryBit = uint64_t{1} << (wordIndex % 64);
+        if (word) {
+            mFreeSummary[wordIndex / 64] |= summaryBit;
+        } else {
+            mFreeSummary[wordIndex / 64] &= ~summaryBit;
+        }
+    }
+
+    void AppleField::UpdateFree(uint32_t cell) {
+        bool snake = (mSnake[cell / 64] >> (cell % 64)) & 1;
+        SetFree(cell, !snake && mAppleOfCell[cell] == NO_APPLE);
+    }
+
+    void AppleField::UpdateBlocked(const std::vector<LinkedParticle> &snake) {
+        for (uint32_t cell : mSnakeCells) {
+            mSnake[cell / 64] &= ~(uint64_t{1} << (cell % 64));
+            UpdateFree(cell);
+        }
+        mSnakeCells.clear();
+
+        for (const LinkedParticle &segment : snake) {
+            const Particle &particle = *segment.particle;
+            // every cell an apple could overlap the segment from
+            glm::ivec2 first = CellOf(particle.position - glm::vec2(particle.size + mSettings.appleSize));
+            glm::ivec2 last = CellOf(particle.position + glm::vec2(particle.size + mSettings.appleSize));
+            for (int32_t y = first.y; y <= last.y; y++) {
+                for (int32_t x = first.x; x <= last.x; x++) {
+                    auto cell = static_cast<uint32_t>(y * mGridSize.x + x);
+                    uint64_t bit = uint64_t{1} << (cell % 64);
+                    if (mSnake[cell / 64] & bit) {
+                        continue;
+                    }
+                    mSnake[cell / 64] |= bit;
+                    mSnakeCells.push_back(cell);
+                    SetFree(cell, false);
+                }
+            }
+        }
+    }
+
+    bool AppleField::Spawn() {
+        if (mFreeCount == 0) {
+            return false;
+        }
+
+        // the first word with a free cell from a random one on, found through the summary
+        auto start = static_cast<uint32_t>(mGenerator() % mFree.size());
+        uint32_t summaryIndex = start / 64;
+        uint64_t summary = mFreeSummary[summaryIndex] & (~uint64_t{0} << (start % 64));
+        while (!summary) {
+            summaryIndex = (summaryIndex + 1) % mFreeSummary.size();
+            summary = mFreeSummary[summaryIndex];
+        }
+        uint32_t wordIndex = summaryIndex * 64 + countTrailingZeros(summary);
+
+        // a random one of its free cells
+        uint64_t word = mFree[wordIndex];
+        for (uint32_t skip = mGenerator() % popCount(word); skip > 0; skip--) {
+            word &= word - 1;
+        }
+        uint32_t cell = wordIndex * 64 + countTrailingZeros(word);
+
+        glm::vec2 center = mSettings.min + (glm::vec2(cell % mGridSize.x, cell / mGridSize.x) + 0.5f) * mCellSize;
+        mAppleOfCell[cell] = static_cast<uint32_t>(mApples.size());
+        mApples.emplace_back(center, mSettings.color, mSettings.appleSize);
+        mAppleCells.push_back(cell);
+        SetFree(cell, false);
+        return true;
+    }
+
+    void AppleField::Fill(size_t count) {
+        while (mApples.size() < count && Spawn()) {}
+    }
+
+    bool AppleField::Eat(const glm::vec2 &position, float radius) {
+        glm::ivec2 first = CellOf(position - glm::vec2(radius + mSettings.appleSize));
+        glm::ivec2 last = CellOf(position + glm::vec2(radius + mSettings.appleSize));
+        for (int32_t y = first.y; y <= last.y; y++) {
+            for (int32_t x = first.x; x <= last.x; x++) {
+                auto cell = static_cast<uint32_t>(y * mGridSize.x + x);
+                uint32_t index = mAppleOfCell[cell];
+                if (index == NO_APPLE) {
+                    continue;
+                }
+
+                float reach = radius + mApples[index].size;
+                glm::vec2 offset = mApples[index].position - position;
+                if (glm::dot(offset, offset) > reach * reach) {
+                    continue;
+                }
+
+                // the last apple takes the eaten one's place
+                uint32_t lastCell = mAppleCells.back();
+                mApples[index] = mApples.back();
+                mAppleCells[index] = lastCell;
+                mAppleOfCell[lastCell] = index;
+                mApples.pop_back();
+                mAppleCells.pop_back();
+
+                mAppleOfCell[cell] = NO_APPLE;
+                UpdateFree(cell);
+                return true;
+            }
+        }
+        return false;
+    }
+
+} // engine
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "Particle.h"
+
+#include <glm/vec2.hpp>
+#include <glm/vec4.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+namespace engine {
+
+    // Apples on a grid of cells, at most one per cell, that never spawn under the snake. Free
+    // cells are tracked in a bitmap with one summary bit per 64-cell word that still has a free
+    // cell, so spawning finds a free cell with a couple of bit scans instead of retrying random
+    // positions, and eating only looks at the cells around the head. Neither depends on the number
+    // of apples, which allows thousands of them.
+    class AppleField {
+    public:
+        struct Settings {
+            // the rectangle apples spawn in
+            glm::vec2 min{-1.0f};
+            glm::vec2 max{1.0f};
+            // apple radius, the cells are its diameter
+            float appleSize = 0.02f;
+            glm::vec4 color{0.7f, 0.1f, 0.1f, 1.0f};
+            uint32_t seed = 0;
+        };
+
+        explicit AppleField(const Settings &settings);
+
+        AppleField(const AppleField &) = delete;
+        AppleField &operator=(const AppleField &) = delete;
+
+        // Blocks the cells the snake covers for spawning and releases the ones it covered at the
+        // last call. Costs a few cells per segment.
+        void UpdateBlocked(const std::vector<LinkedParticle> &snake);
+
+        // Puts an apple in a free cell picked at random. Returns false if there is none.
+        bool Spawn();
+
+        // Spawns until there are count apples or no free cells are left.
+        void Fill(size_t count);
+
+        // Removes an apple the circle overlaps, returns whether there was one.
+        bool Eat(const glm::vec2 &position, float radius);
+
+        // for drawing
+        [[nodiscard]] const std::vector<Particle> &Apples() const { return mApples; }
+
+        [[nodiscard]] size_t FreeCellCount() const { return mFreeCount; }
+        [[nodiscard]] size_t CellCount() const { return mAppleOfCell.size(); }
+
+    private:
+        static constexpr uint32_t NO_APPLE = UINT32_MAX;
+
+        [[nodiscard]] glm::ivec2 CellOf(const glm::vec2 &position) const;
+        void SetFree(uint32_t cell, bool free);
+        void UpdateFree(uint32_t cell);
+
+        const Settings mSettings;
+        float mCellSize;
+        glm::ivec2 mGridSize;
+
+        // one bit per cell, set while it has neither an apple nor the snake in it
+        std::vector<uint64_t> mFree;
+        // one bit per word of mFree that has a free cell
+        std::vector<uint64_t> mFreeSummary;
+        size_t mFreeCount = 0;
+
+        std::vector<uint64_t> mSnake;
+        // cells set in mSnake, to clear them on the next UpdateBlocked
+        std::vector<uint32_t> mSnakeCells;
+
+        std::vector<Particle> mApples;
+        std::vector<uint32_t> mAppleCells;
+        // index into mApples per cell
+        std::vector<uint32_t> mAppleOfCell;
+
+        std::mt19937 mGenerator;
+    };
+
+} // engine
@@ -1,17 +1,29 @@
 #include "Application.h"
 
 
+#include "AppleField.h"
+#include "Camera2D.h"
+#include "ChunkedWorld.h"
+#include "GuiFont.h"
 #include "Imgui.h"
+#include "ParticleLod.h"
+#include "SnakePath.h"
 #include "imgui/imgui_stdlib.h"
 #include "systems/SnakeGame.h"
+#include "systems/GuiRenderSystem.h"
 #include "systems/ParticleRenderSystem.h"
+#include "systems/RibbonRenderSystem.h"
 #include <descriptors/DescriptorWriter.h>
 
 #include <GLFW/glfw3.h>
 
+#include <algorithm>
 #include <chrono>
+#include <cmath>
 #include <memory>
 #include <random>
+#include <stdexcept>
+#include <string>
 
 namespace engine {
 
@@ -28,7 +40,16 @@ namespace engine {
         Imgui imgui{mWindow, mDevice, mRenderer.GetSwapChainRenderPass(), mRenderer.GetImageCount()};
 
         ImGuiIO& io = ImGui::GetIO();
-        io.Fonts->AddFontFromFileTTF("../font/MontserratAlternates-Bold.otf", 32.0f);
+        ImFont *hudFont = io.Fonts->AddFontFromFileTTF("../font/MontserratAlternates-Bold.otf", 32.0f);
+        if (!hudFont) {
+            throw std::runtime_error("failed to load font: MontserratAlternates-Bold.otf");
+        }
+
+        // the score and game over text are drawn from an atlas of just the glyphs they use
+        TextureAtlas::Builder hudAtlasBuilder{mDevice};
+        GuiFont hudGlyphs{*io.Fonts, *hudFont, "0123456789 :SnakeGamScorOv", hudAtlasBuilder};
+        std::unique_ptr<TextureAtlas> hudAtlas = hudAtlasBuilder.build();
+        hudGlyphs.Resolve(*hudAtlas);
 
         std::vector<std::unique_ptr<Buffer>> uboBuffers(SwapChain::MAX_FRAMES_IN_FLIGHT);
         for (int i = 0; i < uboBuffers.size(); i++) {
@@ -41,7 +62,7 @@ namespace engine {
         auto globalSetLayout = DescriptorSetLayout::Builder(mDevice)
                 .addBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
                             VK_SHADER_STAGE_ALL_GRAPHICS)
-                .build();
+                .build(mLayoutCache);
 
         std::vector<VkDescriptorSet> globalDescriptorSets(SwapChain::MAX_FRAMES_IN_FLIGHT);
         for (int i = 0; i < globalDescriptorSets.size(); i++) {
@@ -51,20 +72,48 @@ namespace engine {
                     .build(globalDescriptorSets[i]);
         }
 
+        GuiRenderSystem guiRenderSystem{mDevice, mLayoutCache, mRenderer.GetSwapChainRenderPass(),
+                                        globalSetLayout->getDescriptorSetLayout(), *hudAtlas};
+#ifdef SHADER_HOT_RELOAD
+        guiRenderSystem.WatchShaders(mShaderHotReloader);
+#endif
+        GuiInfo hud{};
+
 //        const uint32_t MAX_PARTICLES = 23;
 //        ParticleRenderSystem particleRenderSystem{mDevice, mRenderer.GetSwapChainRenderPass(),
 //                                            globalSetLayout->getDescriptorSetLayout(), MAX_PARTICLES};
         std::unique_ptr<ParticleRenderSystem> particleRenderSystem;
+        std::unique_ptr<RibbonRenderSystem> ribbonRenderSystem;
+        std::unique_ptr<SnakePath> snakePath;
+        // only in a large arena
+        std::unique_ptr<ChunkedWorld> world;
+        std::unique_ptr<ParticleRenderSystem> worldRenderSystem;
+        Camera2D camera;
         uint32_t maxScore;
 
-        Particle *apple;
+        // apples outside of a large arena
+        std::unique_ptr<AppleField> appleField;
+        std::unique_ptr<ParticleRenderSystem> appleRenderSystem;
+        uint32_t appleCount = 1;
 
         bool isRunning = false;
         bool showMenu = true;
         bool startNewGame = false;
         bool quitGame = false;
+        bool softParticleEdges = true;
+        bool ribbonSnakeBody = false;
+        bool pathSnakeBody = false;
+        bool particleLod = false;
+        bool largeArena = false;
+        float cameraZoom = 1.0f;
+        // world units per second the head steers toward the cursor in a large arena
+        const float snakeSpeed = 1.0f;
 
         std::vector<LinkedParticle> snake;
+        std::vector<glm::vec2> snakePoints;
+        std::vector<glm::vec2> pathPositions;
+        std::vector<Particle> lodParticles;
+        std::vector<Particle> worldParticles;
 
 
         mBackgroundColor = glm::vec3(0.3f, 0.5f, 1.0f);
@@ -79,10 +128,15 @@ namespace engine {
             float frameTime = std::chrono::duration<float, std::chrono::seconds::period>(newTime - currentTime).count();
             currentTime = newTime;
 
+#ifdef SHADER_HOT_RELOAD
+            mShaderHotReloader.Update();
+#endif
+
             if (auto commandBuffer = mRenderer.BeginFrame()) {
                 imgui.newFrame();
 
                 int frameIndex = (int) mRenderer.GetFrameIndex();
+                mGpuProfiler.BeginFrame(commandBuffer, frameIndex);
 
                 FrameInfo frameInfo{
                         frameIndex,
@@ -93,27 +147,71 @@ namespace engine {
 
                 mRenderer.SetClearColor(mBackgroundColor);
 
-                GlobalUbo ubo{};
-                ubo.ambientLightColor = glm::vec4(mRenderer.GetClearColor(), 0.3f);
-
-                uboBuffers[frameIndex]->writeToBuffer(&ubo);
-                uboBuffers[frameIndex]->flush();
-
                 if (startNewGame) {
                     particleRenderSystem = std::make_unique<ParticleRenderSystem>(mDevice,
+                                                                                  mLayoutCache,
                                                                                   mRenderer.GetSwapChainRenderPass(),
                                                                                   globalSetLayout->getDescriptorSetLayout(),
                                                                                   maxScore + 2);
-
-                    apple = particleRenderSystem->AddParticle(glm::vec2(frand(-1, 1), frand(-0.8, 0.8)),
-                                                              glm::vec4(0.7, 0.1, 0.1, 1),
-                                                              0.02);
+                    ribbonRenderSystem = std::make_unique<RibbonRenderSystem>(mDevice,
+                                                                              mLayoutCache,
+                                                                              mRenderer.GetSwapChainRenderPass(),
+                                                                              globalSetLayout->getDescriptorSetLayout(),
+                                                                              maxScore + 2);
+#ifdef SHADER_HOT_RELOAD
+                    particleRenderSystem->WatchShaders(mShaderHotReloader);
+                    ribbonRenderSystem->WatchShaders(mShaderHotReloader);
+#endif
 
                     snake.clear();
                     Particle *temp = particleRenderSystem->AddParticle(glm::vec2(0, 0.02), glm::vec4(1), 0.01);
                     snake.emplace_back(particleRenderSystem->AddParticle(glm::vec2(0, 0), glm::vec4(1), 0.01), temp);
                     snake.emplace_back(temp, nullptr);
 
+                    // a few samples per segment for the longest snake, plus the two it starts with
+                    float spacing = 2.0f * snake[0].particle->size;
+                    snakePath = std::make_unique<SnakePath>((maxScore + 2) * 4, spacing / 4.0f);
+                    snakePath->Reset(temp->position, snake[0].particle->position);
+
+                    camera.SetCenter(glm::vec2(0.0f));
+                    if (largeArena) {
+                        ChunkedWorld::Settings worldSettings{};
+                        worldSettings.seed = static_cast<uint32_t>(std::time(nullptr));
+                        world = std::make_unique<ChunkedWorld>(worldSettings);
+                        worldRenderSystem = std::make_unique<ParticleRenderSystem>(mDevice,
+                                                                                   mLayoutCache,
+                                                                                   mRenderer.GetSwapChainRenderPass(),
+                                                                                   globalSetLayout->getDescriptorSetLayout(),
+                                                                                   world->MaxLoadedParticles());
+#ifdef SHADER_HOT_RELOAD
+                        worldRenderSystem->WatchShaders(mShaderHotReloader);
+#endif
+                        // the world has apples of its own
+                        appleField.reset();
+                        appleRenderSystem.reset();
+                    } else {
+                        world.reset();
+                        worldRenderSystem.reset();
+
+                        // smaller apples the more there are, so about half the cells stay free
+                        AppleField::Settings appleSettings{};
+                        appleSettings.min = glm::vec2(-0.9f);
+                        appleSettings.max = glm::vec2(0.9f);
+                        appleSettings.appleSize = std::min(0.02f, 0.9f / std::sqrt(2.0f * static_cast<float>(appleCount)));
+                        appleSettings.seed = static_cast<uint32_t>(std::time(nullptr));
+                        appleField = std::make_unique<AppleField>(appleSettings);
+                        appleField->UpdateBlocked(snake);
+                        appleField->Fill(appleCount);
+                        appleRenderSystem = std::make_unique<ParticleRenderSystem>(mDevice,
+                                                                                   mLayoutCache,
+                                                                                   mRenderer.GetSwapChainRenderPass(),
+                                                                                   globalSetLayout->getDescriptorSetLayout(),
+                                                                                   appleCount);
+#ifdef SHADER_HOT_RELOAD
+                        appleRenderSystem->WatchShaders(mShaderHotReloader);
+#endif
+                    }
+
                     startNewGame = false;
                     isRunning = true;
                 }
@@ -123,14 +221,30 @@ namespace engine {
                 }
 
                 if (isRunning) {
-                    snake[0].particle->position = mWindow.getCursorPosition();
-
-                    glm::vec2 distanceVector = snake[0].particle->position - apple->position;
-                    float distanceSquared = glm::dot(distanceVector, distanceVector);
-                    float collisionDistanceSquared = (snake[0].particle->size + apple->size) * (snake[0].particle->size + apple->size);
+                    if (world) {
+                        // the head steers toward the cursor and the camera follows it
+                        glm::vec2 head = snake[0].particle->position;
+                        glm::vec2 toCursor = camera.ScreenToWorld(mWindow.getCursorPosition()) - head;
+                        float distance = glm::length(toCursor);
+                        if (distance > 0.0f) {
+                            head += toCursor / distance * std::min(distance, snakeSpeed * frameTime);
+                        }
+                        snake[0].particle->position = glm::clamp(head, world->Min(), world->Max());
+                    } else {
+                        snake[0].particle->position = mWindow.getCursorPosition();
+                    }
+                    // recorded in both modes, so switching to the path mid game has a history to follow
+                    snakePath->Push(snake[0].particle->position);
+
+                    bool ateApple;
+                    if (world) {
+                        ateApple = world->EatApple(snake[0].particle->position, snake[0].particle->size);
+                    } else {
+                        // only the apples in the cells around the head are tested
+                        ateApple = appleField->Eat(snake[0].particle->position, snake[0].particle->size);
+                    }
 
-                    if (distanceSquared <= collisionDistanceSquared) {
-                        apple->position = glm::vec2(frand(-0.8, 0.8), frand(-0.8, 0.8));
+                    if (ateApple) {
                         snake.emplace_back(particleRenderSystem->AddParticle(snake.back().particle->position, glm::vec4(1), 0.01),nullptr);
                         snake[snake.size() - 2].child = snake.back().particle;
 
@@ -140,12 +254,22 @@ namespace engine {
                         }
                     }
 
-                    for (auto &linkedParticle : snake) {
-                        if (!linkedParticle.child) continue;
-                        glm::vec2 dist = linkedParticle.distToChild();
-                        float maxDist = linkedParticle.particle->size + linkedParticle.child->size;
-                        if (glm::length(dist) > maxDist) {
-                            linkedParticle.child->position = linkedParticle.particle->position - glm::normalize(dist) * maxDist;
+                    if (pathSnakeBody) {
+                        // every segment sits a fixed distance behind the head along the path, a new one
+                        // just resolves one spacing further back
+                        pathPositions.resize(snake.size());
+                        snakePath->Resolve(2.0f * snake[0].particle->size, snake.size(), pathPositions.data());
+                        for (size_t i = 1; i < snake.size(); i++) {
+                            snake[i].particle->position = pathPositions[i];
+                        }
+                    } else {
+                        for (auto &linkedParticle : snake) {
+                            if (!linkedParticle.child) continue;
+                            glm::vec2 dist = linkedParticle.distToChild();
+                            float maxDist = linkedParticle.particle->size + linkedParticle.child->size;
+                            if (glm::length(dist) > maxDist) {
+                                linkedParticle.child->position = linkedParticle.particle->position - glm::normalize(dist) * maxDist;
+                            }
                         }
                     }
 
@@ -158,14 +282,77 @@ namespace engine {
                             }
                         }
                     }
+
+                    if (world) {
+                        camera.Follow(snake[0].particle->position, frameTime);
+                        camera.SetZoom(std::max(cameraZoom, world->MinZoom()));
+                        world->Update(snake[0].particle->position, camera.VisibleMin(), camera.VisibleMax(), frameTime);
+                    } else {
+                        // eaten apples respawn only once the cells under the moved body are blocked
+                        appleField->UpdateBlocked(snake);
+                        appleField->Fill(appleCount);
+                    }
+                }
+                if (!world) {
+                    camera.SetZoom(1.0f);
                 }
 
+                GlobalUbo ubo{};
+                ubo.projection = camera.Projection();
+                ubo.view = camera.View();
+                ubo.ambientLightColor = glm::vec4(mRenderer.GetClearColor(), 0.3f);
+
+                uboBuffers[frameIndex]->writeToBuffer(&ubo);
+                uboBuffers[frameIndex]->flush();
 
 
                 // render
                 mRenderer.BeginSwapChainRenderPass(commandBuffer);
 
-                if (isRunning) particleRenderSystem->Render(frameInfo);
+                snakePoints.clear();
+                for (auto &linkedParticle : snake) {
+                    snakePoints.push_back(linkedParticle.particle->position);
+                }
+
+                if (isRunning) {
+                    if (world) {
+                        worldParticles.clear();
+                        world->Gather(camera.VisibleMin(), camera.VisibleMax(), worldParticles);
+                        worldRenderSystem->SetSoftEdges(softParticleEdges);
+                        worldRenderSystem->SetCullBounds(camera.VisibleMin(), camera.VisibleMax());
+                        worldRenderSystem->Render(frameInfo, worldParticles.data(), worldParticles.size());
+                    } else {
+                        const std::vector<Particle> &apples = appleField->Apples();
+                        appleRenderSystem->SetSoftEdges(softParticleEdges);
+                        appleRenderSystem->SetCullBounds(camera.VisibleMin(), camera.VisibleMax());
+                        appleRenderSystem->Render(frameInfo, apples.data(), apples.size());
+                    }
+
+                    particleRenderSystem->SetSoftEdges(softParticleEdges);
+                    particleRenderSystem->SetCullBounds(camera.VisibleMin(), camera.VisibleMax());
+                    if (ribbonSnakeBody) {
+                        const Particle &head = *snake[0].particle;
+                        mGpuProfiler.BeginScope(commandBuffer, "Snake ribbon");
+                        ribbonRenderSystem->Render(frameInfo, snakePoints, head.size, head.color);
+                        mGpuProfiler.EndScope(commandBuffer);
+                    } else if (particleLod) {
+                        // collisions above still ran against every segment
+                        ParticleLodSettings lodSettings{};
+                        lodSettings.viewportSize = {io.DisplaySize.x, io.DisplaySize.y};
+                        lodSettings.viewMin = camera.VisibleMin();
+                        lodSettings.viewMax = camera.VisibleMax();
+                        lodParticles.clear();
+                        BuildChainLod(snake, lodSettings, lodParticles);
+
+                        mGpuProfiler.BeginScope(commandBuffer, "Snake particles");
+                        particleRenderSystem->Render(frameInfo, lodParticles.data(), lodParticles.size());
+                        mGpuProfiler.EndScope(commandBuffer);
+                    } else {
+                        mGpuProfiler.BeginScope(commandBuffer, "Snake particles");
+                        particleRenderSystem->Render(frameInfo);
+                        mGpuProfiler.EndScope(commandBuffer);
+                    }
+                }
 
                 ImGui::Begin("Settings");
                 {
@@ -173,41 +360,86 @@ namespace engine {
 
                     ImGui::ColorPicker3("Background Color", &mBackgroundColor.x);
 
+                    ImGui::Checkbox("Soft particle edges", &softParticleEdges);
+                    ImGui::Checkbox("Ribbon snake body", &ribbonSnakeBody);
+                    ImGui::Checkbox("Path-based snake body", &pathSnakeBody);
+                    ImGui::Checkbox("Particle LOD", &particleLod);
+                    if (particleLod && !ribbonSnakeBody) {
+                        ImGui::Text("LOD particles: %zu of %zu", lodParticles.size(), snake.size());
+                    }
+                    if (particleRenderSystem) {
+                        ImGui::Text("Particles drawn: %u, culled: %u", particleRenderSystem->DrawnCount(), particleRenderSystem->CulledCount());
+                    }
+                    if (world) {
+                        // the view has to stay inside the chunks the world keeps loaded
+                        ImGui::SliderFloat("Zoom", &cameraZoom, std::max(0.1f, world->MinZoom()), 2.0f);
+                        ImGui::Text("Chunks loaded: %zu, saved: %zu", world->LoadedChunkCount(), world->SavedChunkCount());
+                        ImGui::Text("Chunk updates: %u full rate, %u reduced", world->FullRateUpdates(), world->ReducedRateUpdates());
+                        ImGui::Text("World particles drawn: %u, culled: %u", worldRenderSystem->DrawnCount(), worldRenderSystem->CulledCount());
+                    }
+                    if (appleField) {
+                        ImGui::Text("Apples: %zu, free cells: %zu of %zu", appleField->Apples().size(), appleField->FreeCellCount(), appleField->CellCount());
+                    }
+
+                    if (mGpuProfiler.Enabled()) {
+                        // overdraw against the pixels the body covers
+                        float snakePixels = RibbonRenderSystem::CoveredArea(snakePoints, snake.empty() ? 0.0f : snake[0].particle->size)
+                                            * camera.Zoom() * camera.Zoom() * io.DisplaySize.x * io.DisplaySize.y / 4.0f;
+                        for (const GpuProfiler::ScopeStats &scope : mGpuProfiler.Scopes()) {
+                            ImGui::Text("%s: %.3f ms", scope.name.c_str(), scope.milliseconds);
+                            if (mGpuProfiler.HasPipelineStatistics() && snakePixels > 0.0f) {
+                                ImGui::Text("  %llu fragments, %.2fx overdraw", (unsigned long long) scope.fragmentInvocations,
+                                            static_cast<float>(scope.fragmentInvocations) / snakePixels);
+                            }
+                        }
+                    }
+
                 }
                 ImGui::End();
 
-                ImGui::SetNextWindowPos(ImVec2(0, 0));
-                ImGui::SetNextWindowSize(ImVec2(ImGui::GetIO().DisplaySize.x, 0));
-                ImGui::Begin("Snake", nullptr, ImGuiWindowFlags_NoMove |
-                                               ImGuiWindowFlags_NoResize |
-                                               ImGuiWindowFlags_NoTitleBar |
-                                               ImGuiWindowFlags_NoScrollbar |
-                                               ImGuiWindowFlags_NoSavedSettings);
+                // the score bar and the game over panel, in one draw under the ImGui windows
+                hud.extent = mRenderer.GetSwapChainExtent();
+                hud.guiElements.clear();
                 {
-                    ImGui::Text("Snake Game");
-                    ImGui::SameLine(ImGui::GetWindowWidth() - 150 );
-                    ImGui::Text("Score: %d", snake.size() - 2);
-
+                    glm::vec2 screen{static_cast<float>(hud.extent.width), static_cast<float>(hud.extent.height)};
+                    const glm::vec4 panelColor{0.0f, 0.0f, 0.0f, 0.6f};
+                    const glm::vec4 textColor{1.0f};
+                    const float padding = 8.0f;
+                    std::string score = "Score: " + std::to_string(snake.size() >= 2 ? snake.size() - 2 : 0);
+
+                    hud.guiElements.push_back({{0.0f, 0.0f}, {screen.x, hudGlyphs.LineHeight() + 2.0f * padding},
+                                               TextureAtlas::WHITE_REGION, panelColor, 0});
+                    hudGlyphs.AddText(hud.guiElements, {padding, padding}, "Snake Game", textColor, 1);
+                    hudGlyphs.AddText(hud.guiElements, {screen.x - hudGlyphs.Measure(score) - padding, padding}, score, textColor, 1);
+
+                    if (!isRunning && !showMenu) {
+                        glm::vec2 panelSize{400.0f, 200.0f};
+                        glm::vec2 panelMin = glm::floor((screen - panelSize) * 0.5f);
+                        hud.guiElements.push_back({panelMin, panelSize, TextureAtlas::WHITE_REGION, panelColor, 0});
+                        glm::vec2 line = panelMin + padding * 2.0f;
+                        hudGlyphs.AddText(hud.guiElements, line, "Game Over", textColor, 1);
+                        line.y += hudGlyphs.LineHeight();
+                        hudGlyphs.AddText(hud.guiElements, line, score, textColor, 1);
+                    }
                 }
-                ImGui::End();
+                guiRenderSystem.RenderElements(frameInfo, hud);
 
                 if (!isRunning && !showMenu) {
-                    ImVec2 center = ImVec2(io.DisplaySize.x * 0.5f, io.DisplaySize.y * 0.5f);
+                    // the button needs input, so it stays an ImGui window below the game over text
+                    ImVec2 buttonPos = ImVec2(io.DisplaySize.x * 0.5f, io.DisplaySize.y * 0.5f + 40.0f);
 
-                    ImGui::SetNextWindowPos(center, ImGuiCond_Always, ImVec2(0.5f, 0.5f));
-                    ImGui::SetNextWindowSize(ImVec2(400, 200)); // Adjust size as needed
+                    ImGui::SetNextWindowPos(buttonPos, ImGuiCond_Always, ImVec2(0.5f, 0.0f));
 
                     ImFont* bigFont = io.Fonts->Fonts[0]; // Assuming this is your large font
                     ImGui::PushFont(bigFont);
 
-                    ImGui::Begin("Centered Window", nullptr, ImGuiWindowFlags_NoMove |
-                                                             ImGuiWindowFlags_NoResize |
-                                                             ImGuiWindowFlags_NoTitleBar |
-                                                             ImGuiWindowFlags_NoScrollbar |
-                                                             ImGuiWindowFlags_AlwaysAutoResize);
+                    ImGui::Begin("Game Over", nullptr, ImGuiWindowFlags_NoMove |
+                                                       ImGuiWindowFlags_NoResize |
+                                                       ImGuiWindowFlags_NoTitleBar |
+                                                       ImGuiWindowFlags_NoScrollbar |
+                                                       ImGuiWindowFlags_NoBackground |
+                                                       ImGuiWindowFlags_AlwaysAutoResize);
 
-                    ImGui::Text("Game Over");
-                    ImGui::Text("Score: %d", snake.size() - 2);
                     if (ImGui::Button("Menu")) {
                         showMenu = true;
                     }
@@ -234,6 +466,10 @@ namespace engine {
 
                     ImGui::Text("Menu");
                     ImGui::SliderInt("Max Score", (int *)&maxScore, 0, 100);
+                    ImGui::Checkbox("Large arena", &largeArena);
+                    if (!largeArena) {
+                        ImGui::SliderInt("Apples", (int *)&appleCount, 1, 10000);
+                    }
 
                     if (ImGui::Button("Start Game")) {
                         startNewGame = true;
@@ -1,11 +1,14 @@
 #pragma once
 
 #include "Device.h"
+#include "GpuProfiler.h"
 #include "Pipeline.h"
+#include "ShaderHotReloader.h"
 #include "Window.h"
 #include "Renderer.h"
 #include "Buffer.h"
 #include "descriptors/DescriptorPool.h"
+#include "descriptors/LayoutCache.h"
 #include "Components.h"
 
 #include "imgui/imgui.h"
@@ -38,6 +41,11 @@ namespace engine {
         Window mWindow{WIDTH, HEIGHT, "App"};
         Device mDevice{mWindow};
         Renderer mRenderer{mWindow, mDevice};
+        LayoutCache mLayoutCache{mDevice};
+        GpuProfiler mGpuProfiler{mDevice};
+#ifdef SHADER_HOT_RELOAD
+        ShaderHotReloader mShaderHotReloader{mDevice, SHADER_SOURCE_DIR, SHADER_CACHE_DIR, SHADER_COMPILER};
+#endif
 
         // Declaration order matters!!!!!!
         std::unique_ptr<DescriptorPool> mGlobalPool{};
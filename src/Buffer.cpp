@@ -48,9 +48,9 @@ namespace engine {
 
     Buffer::~Buffer() {
         unmap();
-        vkDeviceWaitIdle(m_Device.device());
-        vkDestroyBuffer(m_Device.device(), buffer, nullptr);
-        vkFreeMemory(m_Device.device(), memory, nullptr);
+        m_Device.dispatch().vkDeviceWaitIdle(m_Device.device());
+        m_Device.dispatch().vkDestroyBuffer(m_Device.device(), buffer, nullptr);
+        m_Device.dispatch().vkFreeMemory(m_Device.device(), memory, nullptr);
     }
 
 /**
@@ -64,7 +64,7 @@ namespace engine {
  */
     VkResult Buffer::map(VkDeviceSize size, VkDeviceSize offset) {
         assert(buffer && memory && "Called map on buffer before create");
-        return vkMapMemory(m_Device.device(), memory, offset, size, 0, &mapped);
+        return m_Device.dispatch().vkMapMemory(m_Device.device(), memory, offset, size, 0, &mapped);
     }
 
 /**
@@ -75,7 +75,7 @@ namespace engine {
  */
     void Buffer::unmap() {
         if (mapped) {
-            vkUnmapMemory(m_Device.device(), memory);
+            m_Device.dispatch().vkUnmapMemory(m_Device.device(), memory);
             mapped = nullptr;
         }
     }
@@ -118,7 +118,7 @@ namespace engine {
         mappedRange.memory = memory;
         mappedRange.offset = offset;
         mappedRange.size = size;
-        return vkFlushMappedMemoryRanges(m_Device.device(), 1, &mappedRange);
+        return m_Device.dispatch().vkFlushMappedMemoryRanges(m_Device.device(), 1, &mappedRange);
     }
 
 /**
@@ -138,7 +138,7 @@ namespace engine {
         mappedRange.memory = memory;
         mappedRange.offset = offset;
         mappedRange.size = size;
-        return vkInvalidateMappedMemoryRanges(m_Device.device(), 1, &mappedRange);
+        return m_Device.dispatch().vkInvalidateMappedMemoryRanges(m_Device.device(), 1, &mappedRange);
     }
 
 /**
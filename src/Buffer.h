@@ -59,7 +59,7 @@ namespace engine {
         [[nodiscard]] VkDeviceAddress getBufferDeviceAddress() const {
             VkBufferDeviceAddressInfo addressInfo{VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO};
             addressInfo.buffer = buffer;
-            return vkGetBufferDeviceAddress(m_Device.device(), &addressInfo);
+            return m_Device.dispatch().vkGetBufferDeviceAddress(m_Device.device(), &addressInfo);
         }
 
 
@@ -0,0 +1,493 @@
+#include "Bvh.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#define BVH_SSE 1
+#include <emmintrin.h>
+#endif
+
+namespace engine {
+    static_assert(sizeof(Bvh::Node) == 32, "nodes are meant to be half a cache line");
+
+    namespace {
+        constexpr uint32_t BIN_COUNT = 16;
+        // below this many triangles a subtree is not worth a thread
+        constexpr uint32_t MIN_TRIANGLES_PER_THREAD = 16 * 1024;
+        constexpr uint32_t STACK_SIZE = 64;
+        // Traversal never has more nodes on its stack than the tree is deep. Past this depth the
+        // builder switches to median splits, which finish any subtree in at most 32 more levels.
+        constexpr uint32_t MAX_SAH_DEPTH = STACK_SIZE - 32;
+
+        struct Bounds {
+            glm::vec3 min{FLT_MAX};
+            glm::vec3 max{-FLT_MAX};
+
+            void grow(const glm::vec3 &point) {
+                min = glm::min(min, point);
+                max = glm::max(max, point);
+            }
+
+            void grow(const Bounds &other) {
+                min = glm::min(min, other.min);
+                max = glm::max(max, other.max);
+            }
+
+            [[nodiscard]] float halfArea() const {
+                glm::vec3 extent = max - min;
+                return extent.x * extent.y + extent.y * extent.z + extent.z * extent.x;
+            }
+        };
+
+        struct Bin {
+            Bounds bounds;
+            uint32_t count = 0;
+        };
+
+        uint32_t packCost(uint32_t triangleCount) {
+            return (triangleCount + Bvh::MAX_LEAF_TRIANGLES - 1) / Bvh::MAX_LEAF_TRIANGLES;
+        }
+    }
+
+    struct BvhBuilder {
+        Bvh &bvh;
+        const Model::Vertex *vertices;
+        const uint32_t *indices;
+
+        std::vector<Bounds> triangleBounds;
+        std::vector<glm::vec3> centroids;
+        std::vector<uint32_t> triangles;
+
+        std::atomic<uint32_t> nodeCount{1};
+        std::atomic<uint32_t> packCount{0};
+        std::atomic<int32_t> idleWorkers{0};
+
+        void build(uint32_t node, uint32_t begin, uint32_t end, uint32_t depth) {
+            Bounds bounds;
+            Bounds centroidBounds;
+            for (uint32_t i = begin; i < end; i++) {
+                bounds.grow(triangleBounds[triangles[i]]);
+                centroidBounds.grow(centroids[triangles[i]]);
+            }
+            bvh.mNodes[node].min = bounds.min;
+            bvh.mNodes[node].max = bounds.max;
+
+            uint32_t count = end - begin;
+            if (count <= Bvh::MAX_LEAF_TRIANGLES) {
+                makeLeaf(node, begin, end);
+                return;
+            }
+
+            uint32_t middle = depth < MAX_SAH_DEPTH ? split(begin, end, centroidBounds)
+                                                    : medianSplit(begin, end, centroidBounds);
+
+            uint32_t left = nodeCount.fetch_add(2);
+            bvh.mNodes[node].first = left;
+            bvh.mNodes[node].count = 0;
+
+            // hand one half to a worker if one is free
+            if (count >= MIN_TRIANGLES_PER_THREAD && idleWorkers.fetch_sub(1) > 0) {
+                std::thread worker([&] {
+                    build(left, begin, middle, depth + 1);
+                    idleWorkers.fetch_add(1);
+                });
+                build(left + 1, middle, end, depth + 1);
+                worker.join();
+                return;
+            }
+            if (count >= MIN_TRIANGLES_PER_THREAD) {
+                idleWorkers.fetch_add(1);
+            }
+
+            build(left, begin, middle, depth + 1);
+            build(left + 1, middle, end, depth + 1);
+        }
+
+        // Partitions [begin, end) at the cheapest binned SAH plane and returns the split point.
+        // Every split is taken, since leaves cannot grow beyond one pack.
+        uint32_t split(uint32_t begin, uint32_t end, const Bounds &centroidBounds) {
+            float bestCost = FLT_MAX;
+            int bestAxis = -1;
+            uint32_t bestBin = 0;
+
+            for (int axis = 0; axis < 3; axis++) {
+                float extent = centroidBounds.max[axis] - centroidBounds.min[axis];
+                if (extent <= 0.0f) {
+                    continue;
+                }
+
+                Bin bins[BIN_COUNT];
+                float scale = BIN_COUNT / extent;
+                for (uint32_t i = begin; i < end; i++) {
+                    uint32_t triangle = triangles[i];
+                    auto bin = std::min(BIN_COUNT - 1, static_cast<uint32_t>((centroids[triangle][axis] - centroidBounds.min[axis]) * scale));
+                    bins[bin].bounds.grow(triangleBounds[triangle]);
+                    bins[bin].count++;
+                }
+
+                // sweep from the right, then evaluate each plane sweeping from the left
+                float rightArea[BIN_COUNT - 1];
+                uint32_t rightCount[BIN_COUNT - 1];
+                Bounds right;
+                uint32_t rightTriangles = 0;
+                for (uint32_t i = BIN_COUNT - 1; i > 0; i--) {
+                    right.grow(bins[i].bounds);
+                    rightTriangles += bins[i].count;
+                    rightArea[i - 1] = right.halfArea();
+                    rightCount[i - 1] = rightTriangles;
+                }
+
+                Bounds left;
+                uint32_t leftTriangles = 0;
+                for (uint32_t i = 0; i < BIN_COUNT - 1; i++) {
+                    left.grow(bins[i].bounds);
+                    leftTriangles += bins[i].count;
+                    if (leftTriangles == 0 || rightCount[i] == 0) {
+                        continue;
+                    }
+
+                    float cost = left.halfArea() * packCost(leftTriangles) + rightArea[i] * packCost(rightCount[i]);
+                    if (cost < bestCost) {
+                        bestCost = cost;
+                        bestAxis = axis;
+                        bestBin = i;
+                    }
+                }
+            }
+
+            if (bestAxis < 0) {
+                // all centroids coincide, any split is as good as another
+                return medianSplit(begin, end, centroidBounds);
+            }
+
+            float minimum = centroidBounds.min[bestAxis];
+            float scale = BIN_COUNT / (centroidBounds.max[bestAxis] - minimum);
+            auto middle = std::partition(triangles.begin() + begin, triangles.begin() + end, [&](uint32_t triangle) {
+                auto bin = std::min(BIN_COUNT - 1, static_cast<uint32_t>((centroids[triangle][bestAxis] - minimum) * scale));
+                return bin <= bestBin;
+            });
+            return static_cast<uint32_t>(middle - triangles.begin());
+        }
+
+        uint32_t medianSplit(uint32_t begin, uint32_t end, const Bounds &centroidBounds) {
+            glm::vec3 extent = centroidBounds.max - centroidBounds.min;
+            int axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+
+            uint32_t middle = begin + (end - begin) / 2;
+            std::nth_element(triangles.begin() + begin, triangles.begin() + middle, triangles.begin() + end,
+                             [&](uint32_t a, uint32_t b) { return centroids[a][axis] < centroids[b][axis]; });
+            return middle;
+        }
+
+        void makeLeaf(uint32_t node, uint32_t begin, uint32_t end) {
+            uint32_t pack = packCount.fetch_add(1);
+            bvh.mNodes[node].first = pack;
+            bvh.mNodes[node].count = end - begin;
+
+            Bvh::TrianglePack &packed = bvh.mPacks[pack];
+            std::memset(&packed, 0, sizeof(packed));
+
+            for (uint32_t lane = 0; lane < end - begin; lane++) {
+                uint32_t triangle = triangles[begin + lane];
+                glm::vec3 v0 = vertices[indices[3 * triangle + 0]].position;
+                glm::vec3 v1 = vertices[indices[3 * triangle + 1]].position;
+                glm::vec3 v2 = vertices[indices[3 * triangle + 2]].position;
+
+                for (int axis = 0; axis < 3; axis++) {
+                    packed.v0[axis][lane] = v0[axis];
+                    packed.edge1[axis][lane] = v1[axis] - v0[axis];
+                    packed.edge2[axis][lane] = v2[axis] - v0[axis];
+                }
+                packed.primitive[lane] = triangle;
+            }
+        }
+    };
+
+    Bvh::Bvh(const Model::Builder &builder, uint32_t workerCount)
+            : Bvh(builder.vertices.data(), static_cast<uint32_t>(builder.vertices.size()), builder.indices.data(),
+                  builder.lods.empty() ? static_cast<uint32_t>(builder.indices.size()) : builder.lods[0].indexCount,
+                  workerCount) {
+    }
+
+    Bvh::Bvh(const Model::Vertex *vertices, uint32_t vertexCount, const uint32_t *indices, uint32_t indexCount,
+             uint32_t workerCount) {
+        mTriangleCount = indexCount / 3;
+        if (mTriangleCount == 0) {
+            throw std::runtime_error("cannot build a BVH without triangles");
+        }
+        for (uint32_t i = 0; i < mTriangleCount * 3; i++) {
+            if (indices[i] >= vertexCount) {
+                throw std::runtime_error("BVH index out of range");
+            }
+        }
+
+        BvhBuilder builder{*this, vertices, indices};
+        builder.triangleBounds.resize(mTriangleCount);
+        builder.centroids.resize(mTriangleCount);
+        builder.triangles.resize(mTriangleCount);
+
+        for (uint32_t triangle = 0; triangle < mTriangleCount; triangle++) {
+            Bounds bounds;
+            for (uint32_t corner = 0; corner < 3; corner++) {
+                bounds.grow(vertices[indices[3 * triangle + corner]].position);
+            }
+            builder.triangleBounds[triangle] = bounds;
+            builder.centroids[triangle] = (bounds.min + bounds.max) * 0.5f;
+            builder.triangles[triangle] = triangle;
+        }
+
+        if (workerCount == 0) {
+            workerCount = std::max(1u, std::thread::hardware_concurrency());
+        }
+        builder.idleWorkers = static_cast<int32_t>(workerCount) - 1;
+
+        // a binary tree with at least one triangle per leaf has fewer than 2n nodes
+        mNodes.resize(2 * mTriangleCount - 1);
+        mPacks.resize(mTriangleCount);
+
+        builder.build(0, 0, mTriangleCount, 0);
+
+        mNodes.resize(builder.nodeCount);
+        mPacks.resize(builder.packCount);
+        mNodes.shrink_to_fit();
+        mPacks.shrink_to_fit();
+    }
+
+    namespace {
+        struct PreparedRay {
+#ifdef BVH_SSE
+            __m128 origin;
+            __m128 inverseDirection;
+#endif
+            glm::vec3 origin3;
+            glm::vec3 direction;
+            glm::vec3 inverseDirection3;
+            float tMin;
+        };
+
+        PreparedRay prepare(const Ray &ray) {
+            PreparedRay prepared{};
+            prepared.origin3 = ray.origin;
+            prepared.direction = ray.direction;
+            prepared.inverseDirection3 = 1.0f / ray.direction;
+            prepared.tMin = ray.tMin;
+#ifdef BVH_SSE
+            prepared.origin = _mm_setr_ps(ray.origin.x, ray.origin.y, ray.origin.z, 0.0f);
+            prepared.inverseDirection = _mm_setr_ps(prepared.inverseDirection3.x, prepared.inverseDirection3.y,
+                                                    prepared.inverseDirection3.z, 0.0f);
+#endif
+            return prepared;
+        }
+
+        // Slab test, returns the entry distance or FLT_MAX on a miss.
+        inline float intersectNode(const Bvh::Node &node, const PreparedRay &ray, float tMax) {
+#ifdef BVH_SSE
+            // lane 3 holds first/count and is never read
+            __m128 t1 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(&node.min.x), ray.origin), ray.inverseDirection);
+            __m128 t2 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(&node.max.x), ray.origin), ray.inverseDirection);
+            __m128 near = _mm_min_ps(t1, t2);
+            __m128 far = _mm_max_ps(t1, t2);
+
+            near = _mm_max_ss(_mm_max_ss(near, _mm_shuffle_ps(near, near, _MM_SHUFFLE(1, 1, 1, 1))),
+                              _mm_movehl_ps(near, near));
+            far = _mm_min_ss(_mm_min_ss(far, _mm_shuffle_ps(far, far, _MM_SHUFFLE(1, 1, 1, 1))),
+                             _mm_movehl_ps(far, far));
+
+            float entry = std::max(_mm_cvtss_f32(near), ray.tMin);
+            float exit = std::min(_mm_cvtss_f32(far), tMax);
+#else
+            glm::vec3 t1 = (node.min - ray.origin3) * ray.inverseDirection3;
+            glm::vec3 t2 = (node.max - ray.origin3) * ray.inverseDirection3;
+            glm::vec3 near = glm::min(t1, t2);
+            glm::vec3 far = glm::max(t1, t2);
+
+            float entry = std::max(std::max(near.x, near.y), std::max(near.z, ray.tMin));
+            float exit = std::min(std::min(far.x, far.y), std::min(far.z, tMax));
+#endif
+            return entry <= exit ? entry : FLT_MAX;
+        }
+    }
+
+    bool Bvh::Intersect(const Ray &ray, RayHit &hit, uint32_t flags) const {
+        PreparedRay prepared = prepare(ray);
+        float tMax = ray.tMax;
+        bool found = false;
+        bool anyHit = (flags & RAY_FLAGS_TERMINATE_ON_FIRST_HIT) != 0;
+
+        uint32_t stack[STACK_SIZE];
+        uint32_t stackSize = 0;
+        uint32_t node = 0;
+
+        if (intersectNode(mNodes[0], prepared, tMax) == FLT_MAX) {
+            return false;
+        }
+
+        while (true) {
+            const Node &current = mNodes[node];
+
+            if (current.count > 0) {
+                const TrianglePack &pack = mPacks[current.first];
+                float t[4];
+                float u[4];
+                float v[4];
+                int hits = 0;
+                int backFacing = 0;
+
+#ifdef BVH_SSE
+                // Möller-Trumbore on all four lanes
+                __m128 dx = _mm_set1_ps(ray.direction.x);
+                __m128 dy = _mm_set1_ps(ray.direction.y);
+                __m128 dz = _mm_set1_ps(ray.direction.z);
+
+                __m128 e1x = _mm_loadu_ps(pack.edge1[0]);
+                __m128 e1y = _mm_loadu_ps(pack.edge1[1]);
+                __m128 e1z = _mm_loadu_ps(pack.edge1[2]);
+                __m128 e2x = _mm_loadu_ps(pack.edge2[0]);
+                __m128 e2y = _mm_loadu_ps(pack.edge2[1]);
+                __m128 e2z = _mm_loadu_ps(pack.edge2[2]);
+
+                // p = d x e2, det = e1 . p
+                __m128 px = _mm_sub_ps(_mm_mul_ps(dy, e2z), _mm_mul_ps(dz, e2y));
+                __m128 py = _mm_sub_ps(_mm_mul_ps(dz, e2x), _mm_mul_ps(dx, e2z));
+                __m128 pz = _mm_sub_ps(_mm_mul_ps(dx, e2y), _mm_mul_ps(dy, e2x));
+                __m128 det = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e1x, px), _mm_mul_ps(e1y, py)), _mm_mul_ps(e1z, pz));
+                __m128 inverseDet = _mm_div_ps(_mm_set1_ps(1.0f), det);
+
+                __m128 sx = _mm_sub_ps(_mm_set1_ps(ray.origin.x), _mm_loadu_ps(pack.v0[0]));
+                __m128 sy = _mm_sub_ps(_mm_set1_ps(ray.origin.y), _mm_loadu_ps(pack.v0[1]));
+                __m128 sz = _mm_sub_ps(_mm_set1_ps(ray.origin.z), _mm_loadu_ps(pack.v0[2]));
+                __m128 lu = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(sx, px), _mm_mul_ps(sy, py)), _mm_mul_ps(sz, pz)),
+                                       inverseDet);
+
+                // q = s x e1
+                __m128 qx = _mm_sub_ps(_mm_mul_ps(sy, e1z), _mm_mul_ps(sz, e1y));
+                __m128 qy = _mm_sub_ps(_mm_mul_ps(sz, e1x), _mm_mul_ps(sx, e1z));
+                __m128 qz = _mm_sub_ps(_mm_mul_ps(sx, e1y), _mm_mul_ps(sy, e1x));
+                __m128 lv = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, qx), _mm_mul_ps(dy, qy)), _mm_mul_ps(dz, qz)),
+                                       inverseDet);
+                __m128 lt = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(e2x, qx), _mm_mul_ps(e2y, qy)), _mm_mul_ps(e2z, qz)),
+                                       inverseDet);
+
+                // comparisons with NaN are false, which rejects the degenerate padding lanes
+                __m128 zero = _mm_setzero_ps();
+                __m128 mask = _mm_cmpneq_ps(det, zero);
+                mask = _mm_and_ps(mask, _mm_cmpge_ps(lu, zero));
+                mask = _mm_and_ps(mask, _mm_cmpge_ps(lv, zero));
+                mask = _mm_and_ps(mask, _mm_cmple_ps(_mm_add_ps(lu, lv), _mm_set1_ps(1.0f)));
+                mask = _mm_and_ps(mask, _mm_cmpgt_ps(lt, _mm_set1_ps(ray.tMin)));
+                mask = _mm_and_ps(mask, _mm_cmplt_ps(lt, _mm_set1_ps(tMax)));
+
+                hits = _mm_movemask_ps(mask) & ((1 << current.count) - 1);
+                // det > 0 is counter-clockwise as seen from the origin
+                backFacing = _mm_movemask_ps(_mm_cmpgt_ps(det, zero));
+
+                _mm_storeu_ps(t, lt);
+                _mm_storeu_ps(u, lu);
+                _mm_storeu_ps(v, lv);
+#else
+                for (uint32_t lane = 0; lane < current.count; lane++) {
+                    glm::vec3 edge1{pack.edge1[0][lane], pack.edge1[1][lane], pack.edge1[2][lane]};
+                    glm::vec3 edge2{pack.edge2[0][lane], pack.edge2[1][lane], pack.edge2[2][lane]};
+                    glm::vec3 v0{pack.v0[0][lane], pack.v0[1][lane], pack.v0[2][lane]};
+
+                    glm::vec3 p = glm::cross(ray.direction, edge2);
+                    float det = glm::dot(edge1, p);
+                    if (det == 0.0f) {
+                        continue;
+                    }
+                    float inverseDet = 1.0f / det;
+                    glm::vec3 s = ray.origin - v0;
+                    glm::vec3 q = glm::cross(s, edge1);
+                    u[lane] = glm::dot(s, p) * inverseDet;
+                    v[lane] = glm::dot(ray.direction, q) * inverseDet;
+                    t[lane] = glm::dot(edge2, q) * inverseDet;
+
+                    if (u[lane] >= 0.0f && v[lane] >= 0.0f && u[lane] + v[lane] <= 1.0f &&
+                        t[lane] > ray.tMin && t[lane] < tMax) {
+                        hits |= 1 << lane;
+                    }
+                    if (det > 0.0f) {
+                        backFacing |= 1 << lane;
+                    }
+                }
+#endif
+
+                if (flags & RAY_FLAGS_CULL_BACK_FACING_TRIANGLES) {
+                    hits &= ~backFacing;
+                }
+                if (flags & RAY_FLAGS_CULL_FRONT_FACING_TRIANGLES) {
+                    hits &= backFacing;
+                }
+
+                for (uint32_t lane = 0; hits != 0; lane++, hits >>= 1) {
+                    if ((hits & 1) && t[lane] < tMax) {
+                        tMax = t[lane];
+                        hit.t = t[lane];
+                        hit.primitiveIndex = pack.primitive[lane];
+                        hit.barycentrics = {u[lane], v[lane]};
+                        hit.frontFace = (backFacing & (1 << lane)) == 0;
+                        found = true;
+                    }
+                }
+
+                if (found && anyHit) {
+                    return true;
+                }
+            } else {
+                uint32_t near = current.first;
+                uint32_t far = current.first + 1;
+                float nearEntry = intersectNode(mNodes[near], prepared, tMax);
+                float farEntry = intersectNode(mNodes[far], prepared, tMax);
+                if (farEntry < nearEntry) {
+                    std::swap(near, far);
+                    std::swap(nearEntry, farEntry);
+                }
+
+                if (nearEntry != FLT_MAX) {
+                    if (farEntry != FLT_MAX) {
+                        stack[stackSize++] = far;
+                    }
+                    node = near;
+                    continue;
+                }
+            }
+
+            // the far children on the stack may have been passed by a closer hit since
+            do {
+                if (stackSize == 0) {
+                    return found;
+                }
+                node = stack[--stackSize];
+            } while (found && intersectNode(mNodes[node], prepared, tMax) == FLT_MAX);
+        }
+    }
+
+    bool Bvh::Occluded(const glm::vec3 &from, const glm::vec3 &to) const {
+        Ray ray{from, 0.0f, to - from, 1.0f};
+        RayHit hit{};
+        return Intersect(ray, hit, RAY_FLAGS_TERMINATE_ON_FIRST_HIT);
+    }
+
+    void RayQuery::Initialize(const Bvh &bvh, uint32_t rayFlags, const glm::vec3 &origin, float tMin,
+                              const glm::vec3 &direction, float tMax) {
+        mBvh = &bvh;
+        mRay = {origin, tMin, direction, tMax};
+        mFlags = rayFlags;
+        mHit = {};
+        mHasHit = false;
+    }
+
+    bool RayQuery::Proceed() {
+        if (mBvh) {
+            mHasHit = mBvh->Intersect(mRay, mHit, mFlags);
+            mBvh = nullptr;
+        }
+        return false;
+    }
+}
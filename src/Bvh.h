@@ -0,0 +1,125 @@
+#pragma once
+
+#include "Model.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace engine {
+    // Same values as the gl_RayFlags*EXT constants, so flags can be passed to either path unchanged.
+    // All geometry is opaque, as in RayTracingModel, so the opaque flags have no effect.
+    enum RayFlags : uint32_t {
+        RAY_FLAGS_NONE = 0x00,
+        RAY_FLAGS_TERMINATE_ON_FIRST_HIT = 0x04,
+        RAY_FLAGS_CULL_BACK_FACING_TRIANGLES = 0x10,
+        RAY_FLAGS_CULL_FRONT_FACING_TRIANGLES = 0x20,
+    };
+
+    // Hits are accepted for tMin < t < tMax, in units of direction, which need not be normalized.
+    // Rays are in object space; for an instance, transform origin and direction by the inverse
+    // model matrix and t stays valid in world space.
+    struct Ray {
+        glm::vec3 origin;
+        float tMin;
+        glm::vec3 direction;
+        float tMax;
+    };
+
+    struct RayHit {
+        float t;
+        // triangle of the full detail level, its vertices are indices[3 * primitiveIndex + 0..2]
+        uint32_t primitiveIndex;
+        // weights of the second and third vertex, like the hitAttributeEXT of a triangle hit
+        glm::vec2 barycentrics;
+        // Vulkan's default facing: clockwise as seen from the ray origin
+        bool frontFace;
+    };
+
+    // CPU bounding volume hierarchy over the triangles of a mesh, for picking, line of sight and
+    // collision queries where RayTracingModel's BLAS is unavailable or its result is needed on
+    // the CPU. Built from the same Model::Builder (only the full detail level), with a binned SAH
+    // over centroids and subtrees handed to worker threads. Leaves hold up to four triangles
+    // stored side by side, so a leaf is a single SSE ray/triangle test.
+    class Bvh {
+    public:
+        // 32 bytes, two per cache line. Inner nodes have their children at first and first + 1,
+        // leaves (count > 0) own the triangle pack at first.
+        struct Node {
+            glm::vec3 min;
+            uint32_t first;
+            glm::vec3 max;
+            uint32_t count;
+        };
+
+        static constexpr uint32_t MAX_LEAF_TRIANGLES = 4;
+
+        explicit Bvh(const Model::Builder &builder, uint32_t workerCount = 0);
+
+        Bvh(const Model::Vertex *vertices, uint32_t vertexCount, const uint32_t *indices, uint32_t indexCount,
+            uint32_t workerCount = 0);
+
+        // Closest hit, or any hit with RAY_FLAGS_TERMINATE_ON_FIRST_HIT. Thread safe.
+        bool Intersect(const Ray &ray, RayHit &hit, uint32_t flags = RAY_FLAGS_NONE) const;
+
+        // Whether the segment between the points hits any triangle, for line of sight tests.
+        bool Occluded(const glm::vec3 &from, const glm::vec3 &to) const;
+
+        [[nodiscard]] const std::vector<Node> &GetNodes() const { return mNodes; }
+        [[nodiscard]] uint32_t TriangleCount() const { return mTriangleCount; }
+        [[nodiscard]] glm::vec3 GetMinExtent() const { return mNodes[0].min; }
+        [[nodiscard]] glm::vec3 GetMaxExtent() const { return mNodes[0].max; }
+
+    private:
+        // four triangles in structure of arrays form, as Möller-Trumbore wants them; unused lanes
+        // are degenerate and never hit
+        struct TrianglePack {
+            float v0[3][4];
+            float edge1[3][4];
+            float edge2[3][4];
+            uint32_t primitive[4];
+        };
+
+        friend struct BvhBuilder;
+
+        std::vector<Node> mNodes;
+        std::vector<TrianglePack> mPacks;
+        uint32_t mTriangleCount = 0;
+    };
+
+    // CPU counterpart of rayQueryEXT, so code written against a BLAS query reads the same here:
+    //   RayQuery query;
+    //   query.Initialize(bvh, RAY_FLAGS_NONE, origin, 0.0f, direction, 100.0f);
+    //   while (query.Proceed()) {}
+    //   if (query.GetCommittedIntersectionType() == RayQuery::Intersection::Triangle) ...
+    class RayQuery {
+    public:
+        enum class Intersection {
+            None,
+            Triangle
+        };
+
+        void Initialize(const Bvh &bvh, uint32_t rayFlags, const glm::vec3 &origin, float tMin,
+                        const glm::vec3 &direction, float tMax);
+
+        // Traverses the whole hierarchy. Geometry is opaque, so there are never candidates to
+        // confirm and this always returns false.
+        bool Proceed();
+
+        [[nodiscard]] Intersection GetCommittedIntersectionType() const {
+            return mHasHit ? Intersection::Triangle : Intersection::None;
+        }
+        [[nodiscard]] float GetCommittedT() const { return mHit.t; }
+        [[nodiscard]] uint32_t GetCommittedPrimitiveIndex() const { return mHit.primitiveIndex; }
+        [[nodiscard]] glm::vec2 GetCommittedBarycentrics() const { return mHit.barycentrics; }
+        [[nodiscard]] bool GetCommittedFrontFace() const { return mHit.frontFace; }
+
+    private:
+        const Bvh *mBvh = nullptr;
+        Ray mRay{};
+        uint32_t mFlags = RAY_FLAGS_NONE;
+        RayHit mHit{};
+        bool mHasHit = false;
+    };
+}
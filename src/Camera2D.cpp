@@ -0,0 +1,23 @@
+#include "Camera2D.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <cmath>
+
+namespace engine {
+
+    void Camera2D::Follow(const glm::vec2 &target, float frameTime, float sharpness) {
+        // exponential decay, so the camera lags the same distance at any frame rate
+        float t = 1.0f - std::exp(-sharpness * frameTime);
+        mCenter += (target - mCenter) * t;
+    }
+
+    glm::mat4 Camera2D::View() const {
+        return glm::translate(glm::mat4{1.0f}, glm::vec3(-mCenter, 0.0f));
+    }
+
+    glm::mat4 Camera2D::Projection() const {
+        return glm::scale(glm::mat4{1.0f}, glm::vec3(mZoom, mZoom, 1.0f));
+    }
+
+} // engine
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <glm/mat4x4.hpp>
+#include <glm/vec2.hpp>
+
+namespace engine {
+
+    // Orthographic camera over the 2D world. At zoom 1 one world unit spans half the window, like
+    // the normalized device coordinates the game used before, and bigger zooms magnify.
+    class Camera2D {
+    public:
+        void SetCenter(const glm::vec2 &center) { mCenter = center; }
+        [[nodiscard]] const glm::vec2 &Center() const { return mCenter; }
+
+        void SetZoom(float zoom) { mZoom = zoom; }
+        [[nodiscard]] float Zoom() const { return mZoom; }
+
+        // Eases the center toward target. sharpness is how much of the distance is closed per
+        // second, independent of the frame rate.
+        void Follow(const glm::vec2 &target, float frameTime, float sharpness = 4.0f);
+
+        // for GlobalUbo
+        [[nodiscard]] glm::mat4 View() const;
+        [[nodiscard]] glm::mat4 Projection() const;
+
+        // between world positions and normalized device coordinates, e.g. Window::getCursorPosition()
+        [[nodiscard]] glm::vec2 ScreenToWorld(const glm::vec2 &screen) const { return mCenter + screen / mZoom; }
+        [[nodiscard]] glm::vec2 WorldToScreen(const glm::vec2 &world) const { return (world - mCenter) * mZoom; }
+
+        // the world rectangle the window shows
+        [[nodiscard]] glm::vec2 VisibleMin() const { return ScreenToWorld(glm::vec2(-1.0f)); }
+        [[nodiscard]] glm::vec2 VisibleMax() const { return ScreenToWorld(glm::vec2(1.0f)); }
+
+    private:
+        glm::vec2 mCenter{0.0f};
+        float mZoom = 1.0f;
+    };
+
+} // engine
@@ -0,0 +1,216 @@
+#include "ChunkedWorld.h"
+
+#include <glm/geometric.hpp>
+#include <glm/gtc/constants.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <random>
+
+namespace engine {
+
+    static constexpr float APPLE_SIZE = 0.02f;
+    static const glm::vec4 APPLE_COLOR{0.7f, 0.1f, 0.1f, 1.0f};
+    static const glm::vec4 PARTICLE_COLOR{1.0f, 1.0f, 0.7f, 0.5f};
+
+    // splitmix64 over both coordinates and the seed, every bit of the result depends on all of them
+    static uint64_t mix(const ChunkCoord &coord, uint32_t seed) {
+        uint64_t z = (uint64_t(uint32_t(coord.x)) << 32 | uint32_t(coord.y)) ^ (uint64_t(seed) * 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+    static int32_t chebyshev(const ChunkCoord &a, const ChunkCoord &b) {
+        return std::max(std::abs(a.x - b.x), std::abs(a.y - b.y));
+    }
+
+    ChunkedWorld::ChunkedWorld(const Settings &settings) : mSettings(settings), mLoadRadius(settings.loadRadius) {}
+
+    ChunkCoord ChunkedWorld::ChunkOf(const glm::vec2 &position) const {
+        return {static_cast<int32_t>(std::floor(position.x / mSettings.chunkSize)),
+                static_cast<int32_t>(std::floor(position.y / mSettings.chunkSize))};
+    }
+
+    bool ChunkedWorld::InWorld(const ChunkCoord &coord) const {
+        int32_t first = -mSettings.worldChunks / 2;
+        int32_t last = first + mSettings.worldChunks;
+        return coord.x >= first && coord.x < last && coord.y >= first && coord.y < last;
+    }
+
+    glm::vec2 ChunkedWorld::Origin(const ChunkCoord &coord) const {
+        return glm::vec2(coord.x, coord.y) * mSettings.chunkSize;
+    }
+
+    glm::vec2 ChunkedWorld::Min() const {
+        return glm::vec2(static_cast<float>(-mSettings.worldChunks / 2) * mSettings.chunkSize);
+    }
+
+    glm::vec2 ChunkedWorld::Max() const {
+        return Min() + glm::vec2(static_cast<float>(mSettings.worldChunks) * mSettings.chunkSize);
+    }
+
+    uint32_t ChunkedWorld::MaxLoadedParticles() const {
+        // chunks are only streamed out one ring past the load radius
+        auto side = static_cast<uint32_t>(2 * (mSettings.maxLoadRadius + 1) + 1);
+        return side * side * (mSettings.applesPerChunk + mSettings.particlesPerChunk);
+    }
+
+    float ChunkedWorld::MinZoom() const {
+        // the view reaches 1 / zoom from the camera center in each direction
+        return 1.0f / (static_cast<float>(mSettings.maxLoadRadius - 1) * mSettings.chunkSize);
+    }
+
+    int32_t ChunkedWorld::LoadRadius(const ChunkCoord &center, const glm::vec2 &viewMin, const glm::vec2 &viewMax) const {
+        ChunkCoord first = ChunkOf(viewMin);
+        ChunkCoord last = ChunkOf(viewMax);
+        int32_t radius = std::max({mSettings.loadRadius,
+                                   center.x - first.x, last.x - center.x,
+                                   center.y - first.y, last.y - center.y});
+        return std::min(radius, mSettings.maxLoadRadius);
+    }
+
+    void ChunkedWorld::Update(const glm::vec2 &focus, const glm::vec2 &viewMin, const glm::vec2 &viewMax, float frameTime) {
+        mFrame++;
+        ChunkCoord center = ChunkOf(focus);
+        mLoadRadius = LoadRadius(center, viewMin, viewMax);
+        StreamOut(center);
+        StreamIn(center);
+
+        mFullRateUpdates = 0;
+        mReducedRateUpdates = 0;
+        for (auto &[coord, chunk] : mChunks) {
+            chunk->pendingTime += frameTime;
+            if (chebyshev(coord, center) <= mSettings.fullRateRadius) {
+                Simulate(*chunk, chunk->pendingTime);
+                mFullRateUpdates++;
+            } else if ((mFrame + mix(coord, mSettings.seed)) % mSettings.reducedRateInterval == 0) {
+                // staggered by the mixed coordinate, so the reduced rate chunks do not all land on the same frame
+                Simulate(*chunk, chunk->pendingTime);
+                mReducedRateUpdates++;
+            } else {
+                continue;
+            }
+            chunk->pendingTime = 0.0f;
+        }
+    }
+
+    void ChunkedWorld::StreamOut(const ChunkCoord &center) {
+        // one ring of slack, so moving back and forth over a chunk border does not reload chunks
+        for (auto it = mChunks.begin(); it != mChunks.end();) {
+            if (chebyshev(it->first, center) <= mLoadRadius + 1) {
+                ++it;
+                continue;
+            }
+            if (it->second->modified) {
+                mSavedApples[it->first] = std::move(it->second->apples);
+            }
+            it = mChunks.erase(it);
+        }
+    }
+
+    void ChunkedWorld::StreamIn(const ChunkCoord &center) {
+        uint32_t loads = 0;
+        for (int32_t ring = 0; ring <= mLoadRadius; ring++) {
+            for (int32_t y = center.y - ring; y <= center.y + ring; y++) {
+                for (int32_t x = center.x - ring; x <= center.x + ring; x++) {
+                    ChunkCoord coord{x, y};
+                    if (chebyshev(coord, center) != ring || !InWorld(coord) || mChunks.count(coord)) {
+                        continue;
+                    }
+                    if (loads++ == mSettings.maxLoadsPerUpdate) {
+                        return;
+                    }
+                    mChunks.emplace(coord, Load(coord));
+                }
+            }
+        }
+    }
+
+    std::unique_ptr<ChunkedWorld::Chunk> ChunkedWorld::Load(const ChunkCoord &coord) const {
+        auto chunk = std::make_unique<Chunk>();
+        chunk->coord = coord;
+
+        // the same chunk always comes out the same for a seed, so unchanged chunks need no saving
+        uint64_t chunkSeed = mix(coord, mSettings.seed);
+        std::seed_seq seedSequence{uint32_t(chunkSeed), uint32_t(chunkSeed >> 32)};
+        std::mt19937 generator(seedSequence);
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+        glm::vec2 origin = Origin(coord);
+        auto inside = [&](float margin) {
+            return origin + glm::vec2(margin) + glm::vec2(unit(generator), unit(generator)) * (mSettings.chunkSize - 2.0f * margin);
+        };
+
+        auto saved = mSavedApples.find(coord);
+        if (saved != mSavedApples.end()) {
+            chunk->apples = saved->second;
+            chunk->modified = true;
+        } else {
+            chunk->apples.reserve(mSettings.applesPerChunk);
+            for (uint32_t i = 0; i < mSettings.applesPerChunk; i++) {
+                chunk->apples.emplace_back(inside(APPLE_SIZE), APPLE_COLOR, APPLE_SIZE);
+            }
+        }
+
+        chunk->particles.reserve(mSettings.particlesPerChunk);
+        chunk->velocities.reserve(mSettings.particlesPerChunk);
+        for (uint32_t i = 0; i < mSettings.particlesPerChunk; i++) {
+            chunk->particles.emplace_back(inside(0.0f), PARTICLE_COLOR, 0.004f + 0.004f * unit(generator));
+            float angle = unit(generator) * glm::two_pi<float>();
+            float speed = 0.05f + 0.15f * unit(generator);
+            chunk->velocities.emplace_back(std::cos(angle) * speed, std::sin(angle) * speed);
+        }
+        return chunk;
+    }
+
+    void ChunkedWorld::Simulate(Chunk &chunk, float time) const {
+        // particles wrap around inside their chunk, so they never have to move between chunks
+        glm::vec2 origin = Origin(chunk.coord);
+        for (size_t i = 0; i < chunk.particles.size(); i++) {
+            glm::vec2 local = chunk.particles[i].position + chunk.velocities[i] * time - origin;
+            local -= glm::floor(local / mSettings.chunkSize) * mSettings.chunkSize;
+            chunk.particles[i].position = origin + local;
+        }
+    }
+
+    bool ChunkedWorld::EatApple(const glm::vec2 &position, float radius) {
+        ChunkCoord first = ChunkOf(position - glm::vec2(radius + APPLE_SIZE));
+        ChunkCoord last = ChunkOf(position + glm::vec2(radius + APPLE_SIZE));
+        for (int32_t y = first.y; y <= last.y; y++) {
+            for (int32_t x = first.x; x <= last.x; x++) {
+                auto it = mChunks.find({x, y});
+                if (it == mChunks.end()) {
+                    continue;
+                }
+
+                std::vector<Particle> &apples = it->second->apples;
+                for (size_t i = 0; i < apples.size(); i++) {
+                    float reach = radius + apples[i].size;
+                    glm::vec2 offset = apples[i].position - position;
+                    if (glm::dot(offset, offset) <= reach * reach) {
+                        apples[i] = apples.back();
+                        apples.pop_back();
+                        it->second->modified = true;
+                        return true;
+                    }
+                }
+            }
+        }
+        return false;
+    }
+
+    void ChunkedWorld::Gather(const glm::vec2 &min, const glm::vec2 &max, std::vector<Particle> &out) const {
+        for (const auto &[coord, chunk] : mChunks) {
+            // apples and particles stick out of their chunk by at most their size
+            glm::vec2 chunkMin = Origin(coord) - glm::vec2(APPLE_SIZE);
+            glm::vec2 chunkMax = Origin(coord) + glm::vec2(mSettings.chunkSize + APPLE_SIZE);
+            if (chunkMax.x < min.x || chunkMin.x > max.x || chunkMax.y < min.y || chunkMin.y > max.y) {
+                continue;
+            }
+            out.insert(out.end(), chunk->apples.begin(), chunk->apples.end());
+            out.insert(out.end(), chunk->particles.begin(), chunk->particles.end());
+        }
+    }
+
+} // engine
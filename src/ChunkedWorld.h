@@ -0,0 +1,122 @@
+#pragma once
+
+#include "Particle.h"
+
+#include <glm/vec2.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace engine {
+
+    struct ChunkCoord {
+        int32_t x, y;
+
+        bool operator==(const ChunkCoord &other) const { return x == other.x && y == other.y; }
+    };
+
+    struct ChunkCoordHash {
+        size_t operator()(const ChunkCoord &coord) const {
+            return std::hash<uint64_t>{}(uint64_t(uint32_t(coord.x)) << 32 | uint32_t(coord.y));
+        }
+    };
+
+    // An arena far bigger than the screen, split into square chunks with their own apples and
+    // drifting ambient particles. Only chunks around a focus point, the snake's head, are loaded.
+    // Those next to it are simulated every frame, the rest of the loaded ones every few frames with
+    // the time they missed, and everything further away costs nothing. Chunks are generated from
+    // the seed when they stream in, only the apples of chunks that were changed are kept when they
+    // stream out.
+    class ChunkedWorld {
+    public:
+        struct Settings {
+            // edge length of a chunk in world units, the window spans 2 at zoom 1
+            float chunkSize = 2.0f;
+            // chunks per side, the world is centered on the origin
+            int32_t worldChunks = 256;
+            uint32_t applesPerChunk = 2;
+            uint32_t particlesPerChunk = 24;
+            // Chebyshev distances in chunks around the focus. The load radius grows with the view up
+            // to maxLoadRadius, which bounds the number of loaded chunks.
+            int32_t fullRateRadius = 1;
+            int32_t loadRadius = 3;
+            int32_t maxLoadRadius = 8;
+            // chunks between fullRateRadius and loadRadius are simulated every this many frames
+            uint32_t reducedRateInterval = 4;
+            // chunks generated or restored per Update, nearest first, the rest wait a frame
+            uint32_t maxLoadsPerUpdate = 32;
+            uint32_t seed = 0;
+        };
+
+        explicit ChunkedWorld(const Settings &settings);
+
+        ChunkedWorld(const ChunkedWorld &) = delete;
+        ChunkedWorld &operator=(const ChunkedWorld &) = delete;
+
+        // Streams chunks in and out around focus, far enough to cover the visible rectangle from
+        // viewMin to viewMax, and simulates the loaded ones by their distance to it. Call once per
+        // frame.
+        void Update(const glm::vec2 &focus, const glm::vec2 &viewMin, const glm::vec2 &viewMax, float frameTime);
+
+        // Removes the first apple that overlaps the circle, returns whether there was one.
+        bool EatApple(const glm::vec2 &position, float radius);
+
+        // Appends the apples and particles of the loaded chunks that overlap the rectangle.
+        void Gather(const glm::vec2 &min, const glm::vec2 &max, std::vector<Particle> &out) const;
+
+        [[nodiscard]] ChunkCoord ChunkOf(const glm::vec2 &position) const;
+
+        // The world rectangle, e.g. to keep the snake inside.
+        [[nodiscard]] glm::vec2 Min() const;
+        [[nodiscard]] glm::vec2 Max() const;
+
+        // Most particles Gather can return, for sizing the render system.
+        [[nodiscard]] uint32_t MaxLoadedParticles() const;
+
+        // The smallest Camera2D zoom whose view still fits inside maxLoadRadius, with a chunk of
+        // slack for the camera trailing the focus.
+        [[nodiscard]] float MinZoom() const;
+
+        [[nodiscard]] size_t LoadedChunkCount() const { return mChunks.size(); }
+        [[nodiscard]] size_t SavedChunkCount() const { return mSavedApples.size(); }
+        // by the last Update
+        [[nodiscard]] uint32_t FullRateUpdates() const { return mFullRateUpdates; }
+        [[nodiscard]] uint32_t ReducedRateUpdates() const { return mReducedRateUpdates; }
+
+    private:
+        struct Chunk {
+            ChunkCoord coord;
+            std::vector<Particle> apples;
+            std::vector<Particle> particles;
+            std::vector<glm::vec2> velocities;
+            // time the chunk still has to be simulated for
+            float pendingTime = 0.0f;
+            // apples were eaten, has to be saved when streamed out
+            bool modified = false;
+        };
+
+        [[nodiscard]] bool InWorld(const ChunkCoord &coord) const;
+        [[nodiscard]] glm::vec2 Origin(const ChunkCoord &coord) const;
+
+        [[nodiscard]] int32_t LoadRadius(const ChunkCoord &center, const glm::vec2 &viewMin, const glm::vec2 &viewMax) const;
+
+        void StreamOut(const ChunkCoord &center);
+        void StreamIn(const ChunkCoord &center);
+        std::unique_ptr<Chunk> Load(const ChunkCoord &coord) const;
+
+        void Simulate(Chunk &chunk, float time) const;
+
+        const Settings mSettings;
+        std::unordered_map<ChunkCoord, std::unique_ptr<Chunk>, ChunkCoordHash> mChunks;
+        // apples of modified chunks that were streamed out, everything else is regenerated
+        std::unordered_map<ChunkCoord, std::vector<Particle>, ChunkCoordHash> mSavedApples;
+        int32_t mLoadRadius;
+        uint64_t mFrame = 0;
+        uint32_t mFullRateUpdates = 0;
+        uint32_t mReducedRateUpdates = 0;
+    };
+
+} // engine
@@ -0,0 +1,47 @@
+#include "ComputePipeline.h"
+#include "Pipeline.h"
+
+#include <stdexcept>
+
+namespace engine {
+
+    ComputePipeline::ComputePipeline(Device &device, const std::string &compPath, VkPipelineLayout pipelineLayout)
+            : m_Device(device) {
+        m_CompShaderModule = Pipeline::createShaderModule(m_Device, nullptr, compPath);
+        createComputePipeline(pipelineLayout);
+    }
+
+    ComputePipeline::ComputePipeline(Device &device, const ShaderInfo &compShader, VkPipelineLayout pipelineLayout)
+            : m_Device(device) {
+        m_CompShaderModule = Pipeline::createShaderModule(m_Device, &compShader, "");
+        createComputePipeline(pipelineLayout);
+    }
+
+    void ComputePipeline::createComputePipeline(VkPipelineLayout pipelineLayout) {
+        VkComputePipelineCreateInfo pipelineInfo{};
+        pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+        pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+        pipelineInfo.stage.module = m_CompShaderModule;
+        pipelineInfo.stage.pName = "main";
+        pipelineInfo.layout = pipelineLayout;
+        pipelineInfo.basePipelineIndex = -1;
+        pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
+
+        if (m_Device.dispatch().vkCreateComputePipelines(m_Device.device(), VK_NULL_HANDLE, 1, &pipelineInfo, nullptr,
+                                     &m_ComputePipeline) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create compute pipeline");
+        }
+    }
+
+    ComputePipeline::~ComputePipeline() {
+        m_Device.dispatch().vkQueueWaitIdle(m_Device.graphicsQueue());
+        m_Device.dispatch().vkDestroyShaderModule(m_Device.device(), m_CompShaderModule, nullptr);
+        m_Device.dispatch().vkDestroyPipeline(m_Device.device(), m_ComputePipeline, nullptr);
+    }
+
+    void ComputePipeline::bind(VkCommandBuffer commandBuffer) {
+        m_Device.dispatch().vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_ComputePipeline);
+    }
+
+} // namespace engine
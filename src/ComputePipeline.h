@@ -0,0 +1,32 @@
+#pragma once
+
+#include "Device.h"
+#include "ShaderReflection.h"
+
+#include <string>
+#include <vulkan/vulkan_core.h>
+
+namespace engine {
+
+    class ComputePipeline {
+    public:
+        ComputePipeline(Device &device, const std::string &compPath, VkPipelineLayout pipelineLayout);
+
+        ComputePipeline(Device &device, const ShaderInfo &compShader, VkPipelineLayout pipelineLayout);
+
+        ~ComputePipeline();
+
+        ComputePipeline(const ComputePipeline &) = delete;
+
+        void operator=(const ComputePipeline &) = delete;
+
+        void bind(VkCommandBuffer commandBuffer);
+
+    private:
+        void createComputePipeline(VkPipelineLayout pipelineLayout);
+
+        Device &m_Device;
+        VkPipeline m_ComputePipeline;
+        VkShaderModule m_CompShaderModule;
+    };
+} // namespace engine
@@ -54,9 +54,9 @@ namespace engine {
     }
 
     Device::~Device() {
-        vkDeviceWaitIdle(device_);
-        vkDestroyCommandPool(device_, commandPool, nullptr);
-        vkDestroyDevice(device_, nullptr);
+        dispatch_.vkDeviceWaitIdle(device_);
+        dispatch_.vkDestroyCommandPool(device_, commandPool, nullptr);
+        dispatch_.vkDestroyDevice(device_, nullptr);
 
         if (enableValidationLayers) {
             DestroyDebugUtilsMessengerEXT(instance_, debugMessenger, nullptr);
@@ -149,18 +149,57 @@ namespace engine {
             queueCreateInfos.push_back(queueCreateInfo);
         }
 
-        VkPhysicalDeviceFeatures deviceFeatures = {};
+        VkPhysicalDeviceFeatures supportedFeatures;
+        vkGetPhysicalDeviceFeatures(physicalDevice_, &supportedFeatures);
+
+        VkPhysicalDeviceFeatures &deviceFeatures = enabledFeatures_;
         deviceFeatures.samplerAnisotropy = VK_TRUE;
         deviceFeatures.fillModeNonSolid = VK_TRUE;
         deviceFeatures.geometryShader = VK_TRUE;
+        // cooked .ktx2 textures are BC compressed, everything else still works without it
+        deviceFeatures.textureCompressionBC = supportedFeatures.textureCompressionBC;
+        // GPU driven rendering, InstancedModelRenderSystem checks for them
+        deviceFeatures.multiDrawIndirect = supportedFeatures.multiDrawIndirect;
+        deviceFeatures.drawIndirectFirstInstance = supportedFeatures.drawIndirectFirstInstance;
+        // fragment shader invocation counts in GpuProfiler
+        deviceFeatures.pipelineStatisticsQuery = supportedFeatures.pipelineStatisticsQuery;
+
+        VkPhysicalDeviceVulkan12Features supportedFeatures12{};
+        supportedFeatures12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+        bool hasVulkan12 = properties.apiVersion >= VK_API_VERSION_1_2;
+        if (hasVulkan12) {
+            VkPhysicalDeviceFeatures2 features2{};
+            features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+            features2.pNext = &supportedFeatures12;
+            vkGetPhysicalDeviceFeatures2(physicalDevice_, &features2);
+        }
+
+        enabledFeatures12_.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+        enabledFeatures12_.drawIndirectCount = supportedFeatures12.drawIndirectCount;
 
         VkDeviceCreateInfo createInfo{};
         createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
         createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
         createInfo.pQueueCreateInfos = queueCreateInfos.data();
-        createInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
-        createInfo.ppEnabledExtensionNames = deviceExtensions.data();
+        uint32_t extensionCount;
+        vkEnumerateDeviceExtensionProperties(physicalDevice_, nullptr, &extensionCount, nullptr);
+        std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+        vkEnumerateDeviceExtensionProperties(physicalDevice_, nullptr, &extensionCount, availableExtensions.data());
+
+        enabledExtensions_ = deviceExtensions;
+        for (const char *optional: optionalDeviceExtensions) {
+            for (const auto &extension: availableExtensions) {
+                if (strcmp(extension.extensionName, optional) == 0) {
+                    enabledExtensions_.push_back(optional);
+                    break;
+                }
+            }
+        }
+
+        createInfo.enabledExtensionCount = static_cast<uint32_t>(enabledExtensions_.size());
+        createInfo.ppEnabledExtensionNames = enabledExtensions_.data();
         createInfo.pEnabledFeatures = &deviceFeatures;
+        createInfo.pNext = hasVulkan12 ? &enabledFeatures12_ : nullptr;
 
         // might not really be necessary anymore because device specific validation
         // layers have been deprecated
@@ -177,8 +216,11 @@ namespace engine {
             throw std::runtime_error("failed to create logical device!");
         }
 
-        vkGetDeviceQueue(device_, indices.graphicsFamily, 0, &graphicsQueue_);
-        vkGetDeviceQueue(device_, indices.presentFamily, 0, &presentQueue_);
+        // before anything else touches the device
+        dispatch_.load(device_);
+
+        dispatch_.vkGetDeviceQueue(device_, indices.graphicsFamily, 0, &graphicsQueue_);
+        dispatch_.vkGetDeviceQueue(device_, indices.presentFamily, 0, &presentQueue_);
     }
 
     void Device::createCommandPool() {
@@ -190,7 +232,7 @@ namespace engine {
         poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT |
                          VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
 
-        if (vkCreateCommandPool(device_, &poolInfo, nullptr, &commandPool) !=
+        if (dispatch_.vkCreateCommandPool(device_, &poolInfo, nullptr, &commandPool) !=
             VK_SUCCESS) {
             throw std::runtime_error("failed to create command pool!");
         }
@@ -430,12 +472,12 @@ namespace engine {
         bufferInfo.usage = usage;
         bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 
-        if (vkCreateBuffer(device_, &bufferInfo, nullptr, &buffer) != VK_SUCCESS) {
+        if (dispatch_.vkCreateBuffer(device_, &bufferInfo, nullptr, &buffer) != VK_SUCCESS) {
             throw std::runtime_error("failed to create vertex buffer!");
         }
 
         VkMemoryRequirements memRequirements;
-        vkGetBufferMemoryRequirements(device_, buffer, &memRequirements);
+        dispatch_.vkGetBufferMemoryRequirements(device_, buffer, &memRequirements);
 
         VkMemoryAllocateInfo allocInfo{};
         allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
@@ -443,12 +485,12 @@ namespace engine {
         allocInfo.memoryTypeIndex =
                 findMemoryType(memRequirements.memoryTypeBits, properties);
 
-        if (vkAllocateMemory(device_, &allocInfo, nullptr, &bufferMemory) !=
+        if (dispatch_.vkAllocateMemory(device_, &allocInfo, nullptr, &bufferMemory) !=
             VK_SUCCESS) {
             throw std::runtime_error("failed to allocate vertex buffer memory!");
         }
 
-        vkBindBufferMemory(device_, buffer, bufferMemory, 0);
+        dispatch_.vkBindBufferMemory(device_, buffer, bufferMemory, 0);
     }
 
     VkCommandBuffer Device::beginSingleTimeCommands() {
@@ -459,28 +501,28 @@ namespace engine {
         allocInfo.commandBufferCount = 1;
 
         VkCommandBuffer commandBuffer;
-        vkAllocateCommandBuffers(device_, &allocInfo, &commandBuffer);
+        dispatch_.vkAllocateCommandBuffers(device_, &allocInfo, &commandBuffer);
 
         VkCommandBufferBeginInfo beginInfo{};
         beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
         beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
 
-        vkBeginCommandBuffer(commandBuffer, &beginInfo);
+        dispatch_.vkBeginCommandBuffer(commandBuffer, &beginInfo);
         return commandBuffer;
     }
 
     void Device::endSingleTimeCommands(VkCommandBuffer commandBuffer) {
-        vkEndCommandBuffer(commandBuffer);
+        dispatch_.vkEndCommandBuffer(commandBuffer);
 
         VkSubmitInfo submitInfo{};
         submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
         submitInfo.commandBufferCount = 1;
         submitInfo.pCommandBuffers = &commandBuffer;
 
-        vkQueueSubmit(graphicsQueue_, 1, &submitInfo, VK_NULL_HANDLE);
-        vkQueueWaitIdle(graphicsQueue_);
+        dispatch_.vkQueueSubmit(graphicsQueue_, 1, &submitInfo, VK_NULL_HANDLE);
+        dispatch_.vkQueueWaitIdle(graphicsQueue_);
 
-        vkFreeCommandBuffers(device_, commandPool, 1, &commandBuffer);
+        dispatch_.vkFreeCommandBuffers(device_, commandPool, 1, &commandBuffer);
     }
 
     void Device::copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer,
@@ -491,7 +533,7 @@ namespace engine {
         copyRegion.srcOffset = 0; // Optional
         copyRegion.dstOffset = 0; // Optional
         copyRegion.size = size;
-        vkCmdCopyBuffer(commandBuffer, srcBuffer, dstBuffer, 1, &copyRegion);
+        dispatch_.vkCmdCopyBuffer(commandBuffer, srcBuffer, dstBuffer, 1, &copyRegion);
 
         endSingleTimeCommands(commandBuffer);
     }
@@ -515,9 +557,9 @@ namespace engine {
             region.imageOffset = {0, 0, 0};
             region.imageExtent = {width, height, 1};
 
-            vkCmdCopyBufferToImage(commandBuffer, buffer, image,VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+            dispatch_.vkCmdCopyBufferToImage(commandBuffer, buffer, image,VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
         } else {
-            vkCmdCopyBufferToImage(commandBuffer, buffer, image,VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, regions);
+            dispatch_.vkCmdCopyBufferToImage(commandBuffer, buffer, image,VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, regions);
         }
 
         endSingleTimeCommands(commandBuffer);
@@ -526,12 +568,12 @@ namespace engine {
     void Device::createImageWithInfo(const VkImageCreateInfo &imageInfo,
                                      VkMemoryPropertyFlags properties,
                                      VkImage &image, VkDeviceMemory &imageMemory) {
-        if (vkCreateImage(device_, &imageInfo, nullptr, &image) != VK_SUCCESS) {
+        if (dispatch_.vkCreateImage(device_, &imageInfo, nullptr, &image) != VK_SUCCESS) {
             throw std::runtime_error("failed to create image!");
         }
 
         VkMemoryRequirements memRequirements;
-        vkGetImageMemoryRequirements(device_, image, &memRequirements);
+        dispatch_.vkGetImageMemoryRequirements(device_, image, &memRequirements);
 
         VkMemoryAllocateInfo allocInfo{};
         allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
@@ -539,16 +581,25 @@ namespace engine {
         allocInfo.memoryTypeIndex =
                 findMemoryType(memRequirements.memoryTypeBits, properties);
 
-        if (vkAllocateMemory(device_, &allocInfo, nullptr, &imageMemory) !=
+        if (dispatch_.vkAllocateMemory(device_, &allocInfo, nullptr, &imageMemory) !=
             VK_SUCCESS) {
             throw std::runtime_error("failed to allocate image memory!");
         }
 
-        if (vkBindImageMemory(device_, image, imageMemory, 0) != VK_SUCCESS) {
+        if (dispatch_.vkBindImageMemory(device_, image, imageMemory, 0) != VK_SUCCESS) {
             throw std::runtime_error("failed to bind image memory!");
         }
     }
 
+    bool Device::isExtensionEnabled(const char *name) const {
+        for (const char *extension: enabledExtensions_) {
+            if (strcmp(extension, name) == 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
     uint32_t Device::graphicsQueueFamily() const {
         return 0;
     }
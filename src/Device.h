@@ -1,5 +1,6 @@
 #pragma once
 
+#include "DeviceDispatch.h"
 #include "Window.h"
 
 // std lib headers
@@ -59,6 +60,15 @@ namespace engine {
 
         VkInstance instance() { return instance_; }
 
+        // Device level functions, loaded in createLogicalDevice. Prefer these over the global vk* symbols.
+        const DeviceDispatch &dispatch() const { return dispatch_; }
+
+        const VkPhysicalDeviceFeatures &enabledFeatures() const { return enabledFeatures_; }
+
+        const VkPhysicalDeviceVulkan12Features &enabledFeatures12() const { return enabledFeatures12_; }
+
+        bool isExtensionEnabled(const char *name) const;
+
         SwapChainSupportDetails getSwapChainSupport() {
             return querySwapChainSupport(physicalDevice_);
         }
@@ -136,6 +146,9 @@ namespace engine {
         VkCommandPool commandPool;
 
         VkDevice device_;
+        DeviceDispatch dispatch_;
+        VkPhysicalDeviceFeatures enabledFeatures_{};
+        VkPhysicalDeviceVulkan12Features enabledFeatures12_{};
         VkSurfaceKHR surface_;
         VkQueue graphicsQueue_;
         VkQueue presentQueue_;
@@ -145,6 +158,11 @@ namespace engine {
         const std::vector<const char *> deviceExtensions = {
                 VK_KHR_SWAPCHAIN_EXTENSION_NAME,
                 };
+        // enabled when the physical device has them, query with isExtensionEnabled()
+        const std::vector<const char *> optionalDeviceExtensions = {
+                VK_EXT_MEMORY_BUDGET_EXTENSION_NAME,
+                };
+        std::vector<const char *> enabledExtensions_;
     };
 
 } // namespace engine
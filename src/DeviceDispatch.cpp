@@ -0,0 +1,9 @@
+#include "DeviceDispatch.h"
+
+namespace engine {
+    void DeviceDispatch::load(VkDevice device) {
+#define ENGINE_LOAD_DEVICE_FUNCTION(name) name = reinterpret_cast<PFN_##name>(vkGetDeviceProcAddr(device, #name));
+        ENGINE_DEVICE_FUNCTIONS(ENGINE_LOAD_DEVICE_FUNCTION)
+#undef ENGINE_LOAD_DEVICE_FUNCTION
+    }
+}
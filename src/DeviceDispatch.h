@@ -0,0 +1,214 @@
+#pragma once
+
+#include <vulkan/vulkan_core.h>
+
+// Device level entry points, as static lists so the table, its loader and anything else that
+// needs every name stay in sync. Instance level functions (vkGetPhysicalDevice*, surfaces, ...)
+// keep going through the loader, they are not on any hot path.
+#define ENGINE_DEVICE_FUNCTIONS_1_0(X) \
+    X(vkDestroyDevice) \
+    X(vkGetDeviceQueue) \
+    X(vkQueueSubmit) \
+    X(vkQueueWaitIdle) \
+    X(vkDeviceWaitIdle) \
+    X(vkAllocateMemory) \
+    X(vkFreeMemory) \
+    X(vkMapMemory) \
+    X(vkUnmapMemory) \
+    X(vkFlushMappedMemoryRanges) \
+    X(vkInvalidateMappedMemoryRanges) \
+    X(vkGetDeviceMemoryCommitment) \
+    X(vkBindBufferMemory) \
+    X(vkBindImageMemory) \
+    X(vkGetBufferMemoryRequirements) \
+    X(vkGetImageMemoryRequirements) \
+    X(vkGetImageSparseMemoryRequirements) \
+    X(vkQueueBindSparse) \
+    X(vkCreateFence) \
+    X(vkDestroyFence) \
+    X(vkResetFences) \
+    X(vkGetFenceStatus) \
+    X(vkWaitForFences) \
+    X(vkCreateSemaphore) \
+    X(vkDestroySemaphore) \
+    X(vkCreateEvent) \
+    X(vkDestroyEvent) \
+    X(vkGetEventStatus) \
+    X(vkSetEvent) \
+    X(vkResetEvent) \
+    X(vkCreateQueryPool) \
+    X(vkDestroyQueryPool) \
+    X(vkGetQueryPoolResults) \
+    X(vkCreateBuffer) \
+    X(vkDestroyBuffer) \
+    X(vkCreateBufferView) \
+    X(vkDestroyBufferView) \
+    X(vkCreateImage) \
+    X(vkDestroyImage) \
+    X(vkGetImageSubresourceLayout) \
+    X(vkCreateImageView) \
+    X(vkDestroyImageView) \
+    X(vkCreateShaderModule) \
+    X(vkDestroyShaderModule) \
+    X(vkCreatePipelineCache) \
+    X(vkDestroyPipelineCache) \
+    X(vkGetPipelineCacheData) \
+    X(vkMergePipelineCaches) \
+    X(vkCreateGraphicsPipelines) \
+    X(vkCreateComputePipelines) \
+    X(vkDestroyPipeline) \
+    X(vkCreatePipelineLayout) \
+    X(vkDestroyPipelineLayout) \
+    X(vkCreateSampler) \
+    X(vkDestroySampler) \
+    X(vkCreateDescriptorSetLayout) \
+    X(vkDestroyDescriptorSetLayout) \
+    X(vkCreateDescriptorPool) \
+    X(vkDestroyDescriptorPool) \
+    X(vkResetDescriptorPool) \
+    X(vkAllocateDescriptorSets) \
+    X(vkFreeDescriptorSets) \
+    X(vkUpdateDescriptorSets) \
+    X(vkCreateFramebuffer) \
+    X(vkDestroyFramebuffer) \
+    X(vkCreateRenderPass) \
+    X(vkDestroyRenderPass) \
+    X(vkGetRenderAreaGranularity) \
+    X(vkCreateCommandPool) \
+    X(vkDestroyCommandPool) \
+    X(vkResetCommandPool) \
+    X(vkAllocateCommandBuffers) \
+    X(vkFreeCommandBuffers) \
+    X(vkBeginCommandBuffer) \
+    X(vkEndCommandBuffer) \
+    X(vkResetCommandBuffer) \
+    X(vkCmdBindPipeline) \
+    X(vkCmdSetViewport) \
+    X(vkCmdSetScissor) \
+    X(vkCmdSetLineWidth) \
+    X(vkCmdSetDepthBias) \
+    X(vkCmdSetBlendConstants) \
+    X(vkCmdSetDepthBounds) \
+    X(vkCmdSetStencilCompareMask) \
+    X(vkCmdSetStencilWriteMask) \
+    X(vkCmdSetStencilReference) \
+    X(vkCmdBindDescriptorSets) \
+    X(vkCmdBindIndexBuffer) \
+    X(vkCmdBindVertexBuffers) \
+    X(vkCmdDraw) \
+    X(vkCmdDrawIndexed) \
+    X(vkCmdDrawIndirect) \
+    X(vkCmdDrawIndexedIndirect) \
+    X(vkCmdDispatch) \
+    X(vkCmdDispatchIndirect) \
+    X(vkCmdCopyBuffer) \
+    X(vkCmdCopyImage) \
+    X(vkCmdBlitImage) \
+    X(vkCmdCopyBufferToImage) \
+    X(vkCmdCopyImageToBuffer) \
+    X(vkCmdUpdateBuffer) \
+    X(vkCmdFillBuffer) \
+    X(vkCmdClearColorImage) \
+    X(vkCmdClearDepthStencilImage) \
+    X(vkCmdClearAttachments) \
+    X(vkCmdResolveImage) \
+    X(vkCmdSetEvent) \
+    X(vkCmdResetEvent) \
+    X(vkCmdWaitEvents) \
+    X(vkCmdPipelineBarrier) \
+    X(vkCmdBeginQuery) \
+    X(vkCmdEndQuery) \
+    X(vkCmdResetQueryPool) \
+    X(vkCmdWriteTimestamp) \
+    X(vkCmdCopyQueryPoolResults) \
+    X(vkCmdPushConstants) \
+    X(vkCmdBeginRenderPass) \
+    X(vkCmdNextSubpass) \
+    X(vkCmdEndRenderPass) \
+    X(vkCmdExecuteCommands)
+
+#define ENGINE_DEVICE_FUNCTIONS_1_1(X) \
+    X(vkBindBufferMemory2) \
+    X(vkBindImageMemory2) \
+    X(vkGetDeviceGroupPeerMemoryFeatures) \
+    X(vkCmdSetDeviceMask) \
+    X(vkCmdDispatchBase) \
+    X(vkGetImageMemoryRequirements2) \
+    X(vkGetBufferMemoryRequirements2) \
+    X(vkGetImageSparseMemoryRequirements2) \
+    X(vkTrimCommandPool) \
+    X(vkGetDeviceQueue2) \
+    X(vkCreateSamplerYcbcrConversion) \
+    X(vkDestroySamplerYcbcrConversion) \
+    X(vkCreateDescriptorUpdateTemplate) \
+    X(vkDestroyDescriptorUpdateTemplate) \
+    X(vkUpdateDescriptorSetWithTemplate) \
+    X(vkGetDescriptorSetLayoutSupport)
+
+#define ENGINE_DEVICE_FUNCTIONS_1_2(X) \
+    X(vkCmdDrawIndirectCount) \
+    X(vkCmdDrawIndexedIndirectCount) \
+    X(vkCreateRenderPass2) \
+    X(vkCmdBeginRenderPass2) \
+    X(vkCmdNextSubpass2) \
+    X(vkCmdEndRenderPass2) \
+    X(vkResetQueryPool) \
+    X(vkGetSemaphoreCounterValue) \
+    X(vkWaitSemaphores) \
+    X(vkSignalSemaphore) \
+    X(vkGetBufferDeviceAddress) \
+    X(vkGetBufferOpaqueCaptureAddress) \
+    X(vkGetDeviceMemoryOpaqueCaptureAddress)
+
+#define ENGINE_DEVICE_FUNCTIONS_1_3(X) \
+    X(vkCmdPipelineBarrier2) \
+    X(vkCmdWriteTimestamp2) \
+    X(vkQueueSubmit2) \
+    X(vkCmdCopyBuffer2) \
+    X(vkCmdCopyImage2) \
+    X(vkCmdCopyBufferToImage2) \
+    X(vkCmdCopyImageToBuffer2) \
+    X(vkCmdBlitImage2) \
+    X(vkCmdBeginRendering) \
+    X(vkCmdEndRendering) \
+    X(vkCmdSetCullMode) \
+    X(vkCmdSetFrontFace) \
+    X(vkCmdSetPrimitiveTopology) \
+    X(vkCmdSetDepthTestEnable) \
+    X(vkCmdSetDepthWriteEnable) \
+    X(vkCmdSetDepthCompareOp)
+
+#define ENGINE_DEVICE_FUNCTIONS_KHR_SWAPCHAIN(X) \
+    X(vkCreateSwapchainKHR) \
+    X(vkDestroySwapchainKHR) \
+    X(vkGetSwapchainImagesKHR) \
+    X(vkAcquireNextImageKHR) \
+    X(vkQueuePresentKHR)
+
+#define ENGINE_DEVICE_FUNCTIONS_KHR_ACCELERATION_STRUCTURE(X) \
+    X(vkCreateAccelerationStructureKHR) \
+    X(vkDestroyAccelerationStructureKHR) \
+    X(vkCmdBuildAccelerationStructuresKHR) \
+    X(vkGetAccelerationStructureBuildSizesKHR) \
+    X(vkGetAccelerationStructureDeviceAddressKHR)
+
+#define ENGINE_DEVICE_FUNCTIONS(X) \
+    ENGINE_DEVICE_FUNCTIONS_1_0(X) \
+    ENGINE_DEVICE_FUNCTIONS_1_1(X) \
+    ENGINE_DEVICE_FUNCTIONS_1_2(X) \
+    ENGINE_DEVICE_FUNCTIONS_1_3(X) \
+    ENGINE_DEVICE_FUNCTIONS_KHR_SWAPCHAIN(X) \
+    ENGINE_DEVICE_FUNCTIONS_KHR_ACCELERATION_STRUCTURE(X)
+
+namespace engine {
+    // Device function pointers fetched once with vkGetDeviceProcAddr, like volk's VolkDeviceTable.
+    // Calling through them skips the loader trampoline that the exported vk* symbols go through.
+    // Functions of extensions or core versions the device does not have stay nullptr.
+    struct DeviceDispatch {
+#define ENGINE_DECLARE_DEVICE_FUNCTION(name) PFN_##name name = nullptr;
+        ENGINE_DEVICE_FUNCTIONS(ENGINE_DECLARE_DEVICE_FUNCTION)
+#undef ENGINE_DECLARE_DEVICE_FUNCTION
+
+        void load(VkDevice device);
+    };
+}
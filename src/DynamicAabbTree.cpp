@@ -0,0 +1,312 @@
+#include "DynamicAabbTree.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace engine {
+    // how far ahead of the last displacement the fat box reaches
+    static constexpr float DISPLACEMENT_MULTIPLIER = 4.0f;
+
+    DynamicAabbTree::DynamicAabbTree(float margin) : m_margin(margin) {}
+
+    int32_t DynamicAabbTree::AllocateNode() {
+        int32_t node;
+        if (m_freeList != NULL_PROXY) {
+            node = m_freeList;
+            m_freeList = m_nodes[node].parent;
+        } else {
+            node = static_cast<int32_t>(m_nodes.size());
+            m_nodes.emplace_back();
+        }
+
+        Node &allocated = m_nodes[node];
+        allocated.parent = NULL_PROXY;
+        allocated.child1 = NULL_PROXY;
+        allocated.child2 = NULL_PROXY;
+        allocated.height = 0;
+        allocated.userData = 0;
+        allocated.moved = false;
+        return node;
+    }
+
+    void DynamicAabbTree::FreeNode(int32_t node) {
+        m_nodes[node].parent = m_freeList;
+        m_nodes[node].height = -1;
+        m_freeList = node;
+    }
+
+    DynamicAabbTree::ProxyId DynamicAabbTree::CreateProxy(const component::AABBCollider &aabb, uint32_t userData) {
+        int32_t proxy = AllocateNode();
+        glm::vec3 margin{m_margin};
+        m_nodes[proxy].aabb = {aabb.minExtent - margin, aabb.maxExtent + margin};
+        m_nodes[proxy].userData = userData;
+        m_nodes[proxy].moved = true;
+
+        InsertLeaf(proxy);
+        m_moveBuffer.push_back(proxy);
+        m_proxyCount++;
+        return proxy;
+    }
+
+    void DynamicAabbTree::DestroyProxy(ProxyId proxy) {
+        assert(m_nodes[proxy].isLeaf() && m_nodes[proxy].height == 0 && "Not a proxy");
+
+        if (m_nodes[proxy].moved) {
+            std::replace(m_moveBuffer.begin(), m_moveBuffer.end(), proxy, NULL_PROXY);
+        }
+
+        RemoveLeaf(proxy);
+        FreeNode(proxy);
+        m_proxyCount--;
+    }
+
+    bool DynamicAabbTree::MoveProxy(ProxyId proxy, const component::AABBCollider &aabb, const glm::vec3 &displacement) {
+        assert(m_nodes[proxy].isLeaf() && m_nodes[proxy].height == 0 && "Not a proxy");
+
+        glm::vec3 margin{m_margin};
+        component::AABBCollider fat{aabb.minExtent - margin, aabb.maxExtent + margin};
+
+        glm::vec3 reach = displacement * DISPLACEMENT_MULTIPLIER;
+        fat.minExtent += glm::min(reach, glm::vec3{0.0f});
+        fat.maxExtent += glm::max(reach, glm::vec3{0.0f});
+
+        const component::AABBCollider &current = m_nodes[proxy].aabb;
+        if (aabb::Contains(current, aabb)) {
+            // still inside, unless the fat box has grown far larger than needed, e.g. after a
+            // fast move, in which case a tighter one gives fewer false pairs
+            glm::vec3 limit = margin * 4.0f;
+            component::AABBCollider huge{fat.minExtent - limit, fat.maxExtent + limit};
+            if (aabb::Contains(huge, current)) {
+                return false;
+            }
+        }
+
+        RemoveLeaf(proxy);
+        m_nodes[proxy].aabb = fat;
+        InsertLeaf(proxy);
+
+        if (!m_nodes[proxy].moved) {
+            m_nodes[proxy].moved = true;
+            m_moveBuffer.push_back(proxy);
+        }
+        return true;
+    }
+
+    void DynamicAabbTree::InsertLeaf(int32_t leaf) {
+        if (m_root == NULL_PROXY) {
+            m_root = leaf;
+            m_nodes[leaf].parent = NULL_PROXY;
+            return;
+        }
+
+        // descend towards the sibling with the smallest increase in total surface area
+        component::AABBCollider leafAabb = m_nodes[leaf].aabb;
+        int32_t index = m_root;
+        while (!m_nodes[index].isLeaf()) {
+            const Node &node = m_nodes[index];
+
+            float area = aabb::HalfArea(node.aabb);
+            float combinedArea = aabb::HalfArea(aabb::Union(node.aabb, leafAabb));
+
+            // pairing with this node creates a parent covering both
+            float cost = 2.0f * combinedArea;
+            // descending grows every ancestor below this one as well
+            float inheritanceCost = 2.0f * (combinedArea - area);
+
+            auto descendCost = [&](int32_t child) {
+                const Node &childNode = m_nodes[child];
+                float grown = aabb::HalfArea(aabb::Union(leafAabb, childNode.aabb));
+                return (childNode.isLeaf() ? grown : grown - aabb::HalfArea(childNode.aabb)) + inheritanceCost;
+            };
+            float cost1 = descendCost(node.child1);
+            float cost2 = descendCost(node.child2);
+
+            if (cost < cost1 && cost < cost2) {
+                break;
+            }
+            index = cost1 < cost2 ? node.child1 : node.child2;
+        }
+
+        int32_t sibling = index;
+        int32_t oldParent = m_nodes[sibling].parent;
+        int32_t newParent = AllocateNode();
+
+        m_nodes[newParent].parent = oldParent;
+        m_nodes[newParent].aabb = aabb::Union(leafAabb, m_nodes[sibling].aabb);
+        m_nodes[newParent].height = m_nodes[sibling].height + 1;
+        m_nodes[newParent].child1 = sibling;
+        m_nodes[newParent].child2 = leaf;
+        m_nodes[sibling].parent = newParent;
+        m_nodes[leaf].parent = newParent;
+
+        if (oldParent != NULL_PROXY) {
+            if (m_nodes[oldParent].child1 == sibling) {
+                m_nodes[oldParent].child1 = newParent;
+            } else {
+                m_nodes[oldParent].child2 = newParent;
+            }
+        } else {
+            m_root = newParent;
+        }
+
+        // refit and rebalance on the way up
+        for (index = m_nodes[leaf].parent; index != NULL_PROXY; index = m_nodes[index].parent) {
+            index = Balance(index);
+
+            Node &node = m_nodes[index];
+            node.height = 1 + std::max(m_nodes[node.child1].height, m_nodes[node.child2].height);
+            node.aabb = aabb::Union(m_nodes[node.child1].aabb, m_nodes[node.child2].aabb);
+        }
+    }
+
+    void DynamicAabbTree::RemoveLeaf(int32_t leaf) {
+        if (leaf == m_root) {
+            m_root = NULL_PROXY;
+            return;
+        }
+
+        int32_t parent = m_nodes[leaf].parent;
+        int32_t grandParent = m_nodes[parent].parent;
+        int32_t sibling = m_nodes[parent].child1 == leaf ? m_nodes[parent].child2 : m_nodes[parent].child1;
+
+        FreeNode(parent);
+
+        if (grandParent == NULL_PROXY) {
+            m_root = sibling;
+            m_nodes[sibling].parent = NULL_PROXY;
+            return;
+        }
+
+        if (m_nodes[grandParent].child1 == parent) {
+            m_nodes[grandParent].child1 = sibling;
+        } else {
+            m_nodes[grandParent].child2 = sibling;
+        }
+        m_nodes[sibling].parent = grandParent;
+
+        for (int32_t index = grandParent; index != NULL_PROXY; index = m_nodes[index].parent) {
+            index = Balance(index);
+
+            Node &node = m_nodes[index];
+            node.height = 1 + std::max(m_nodes[node.child1].height, m_nodes[node.child2].height);
+            node.aabb = aabb::Union(m_nodes[node.child1].aabb, m_nodes[node.child2].aabb);
+        }
+    }
+
+    // If one subtree of a is more than one level taller than the other, rotates its root up into
+    // a's place. Returns the node now at a's position.
+    int32_t DynamicAabbTree::Balance(int32_t a) {
+        Node &nodeA = m_nodes[a];
+        if (nodeA.isLeaf() || nodeA.height < 2) {
+            return a;
+        }
+
+        int32_t b = nodeA.child1;
+        int32_t c = nodeA.child2;
+        Node &nodeB = m_nodes[b];
+        Node &nodeC = m_nodes[c];
+
+        int32_t balance = nodeC.height - nodeB.height;
+
+        // rotates up the taller child of a, which keeps the taller of its own children
+        auto rotateUp = [&](int32_t up, Node &nodeUp, Node &nodeOther, bool upIsChild2) {
+            int32_t f = nodeUp.child1;
+            int32_t g = nodeUp.child2;
+            Node &nodeF = m_nodes[f];
+            Node &nodeG = m_nodes[g];
+
+            nodeUp.child1 = a;
+            nodeUp.parent = nodeA.parent;
+            nodeA.parent = up;
+
+            if (nodeUp.parent != NULL_PROXY) {
+                Node &parent = m_nodes[nodeUp.parent];
+                if (parent.child1 == a) {
+                    parent.child1 = up;
+                } else {
+                    parent.child2 = up;
+                }
+            } else {
+                m_root = up;
+            }
+
+            int32_t keep = nodeF.height > nodeG.height ? f : g;
+            int32_t give = keep == f ? g : f;
+            nodeUp.child2 = keep;
+            if (upIsChild2) {
+                nodeA.child2 = give;
+            } else {
+                nodeA.child1 = give;
+            }
+            m_nodes[give].parent = a;
+
+            nodeA.aabb = aabb::Union(nodeOther.aabb, m_nodes[give].aabb);
+            nodeUp.aabb = aabb::Union(nodeA.aabb, m_nodes[keep].aabb);
+            nodeA.height = 1 + std::max(nodeOther.height, m_nodes[give].height);
+            nodeUp.height = 1 + std::max(nodeA.height, m_nodes[keep].height);
+        };
+
+        if (balance > 1) {
+            rotateUp(c, nodeC, nodeB, true);
+            return c;
+        }
+        if (balance < -1) {
+            rotateUp(b, nodeB, nodeC, false);
+            return b;
+        }
+        return a;
+    }
+
+    void DynamicAabbTree::CollectPairs(std::vector<Pair> &pairs, bool movedOnly) {
+        auto collect = [&](ProxyId proxy) {
+            bool moved = m_nodes[proxy].moved;
+            Query(m_nodes[proxy].aabb, [&](ProxyId other) {
+                if (other == proxy) {
+                    return true;
+                }
+                // both ends of a pair of moved proxies find it, only the lower one keeps it
+                if ((!movedOnly || (moved && m_nodes[other].moved)) && other < proxy) {
+                    return true;
+                }
+                pairs.push_back({std::min(proxy, other), std::max(proxy, other)});
+                return true;
+            });
+        };
+
+        if (movedOnly) {
+            for (ProxyId proxy : m_moveBuffer) {
+                if (proxy != NULL_PROXY) {
+                    collect(proxy);
+                }
+            }
+        } else {
+            for (int32_t node = 0; node < static_cast<int32_t>(m_nodes.size()); node++) {
+                if (m_nodes[node].height == 0) {
+                    collect(node);
+                }
+            }
+        }
+
+        std::sort(pairs.begin(), pairs.end(), [](const Pair &a, const Pair &b) {
+            return a.first != b.first ? a.first < b.first : a.second < b.second;
+        });
+        pairs.erase(std::unique(pairs.begin(), pairs.end()), pairs.end());
+    }
+
+    void DynamicAabbTree::UpdatePairs(std::vector<Pair> &pairs) {
+        pairs.clear();
+        CollectPairs(pairs, true);
+
+        for (ProxyId proxy : m_moveBuffer) {
+            if (proxy != NULL_PROXY) {
+                m_nodes[proxy].moved = false;
+            }
+        }
+        m_moveBuffer.clear();
+    }
+
+    void DynamicAabbTree::FindAllPairs(std::vector<Pair> &pairs) {
+        pairs.clear();
+        CollectPairs(pairs, false);
+    }
+}
@@ -0,0 +1,132 @@
+#pragma once
+
+#include "Components.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace engine {
+    // Broadphase over moving axis aligned boxes, after the dynamic tree of Box2D. Leaves store
+    // the box fattened by a margin (and stretched along the last displacement), so a proxy that
+    // moves a little stays in place and only the ones that leave their fat box are reinserted.
+    // Inserts pick the sibling with the cheapest surface area increase and rotations keep the
+    // tree balanced, so queries stay logarithmic however the proxies move.
+    class DynamicAabbTree {
+    public:
+        using ProxyId = int32_t;
+        static constexpr ProxyId NULL_PROXY = -1;
+
+        // overlapping proxies, first < second
+        struct Pair {
+            ProxyId first;
+            ProxyId second;
+
+            bool operator==(const Pair &other) const { return first == other.first && second == other.second; }
+        };
+
+        explicit DynamicAabbTree(float margin = 0.1f);
+
+        ProxyId CreateProxy(const component::AABBCollider &aabb, uint32_t userData);
+        void DestroyProxy(ProxyId proxy);
+
+        // Returns whether the proxy had to be reinserted. displacement is how far the box moved
+        // since the last call, the fat box is extended in that direction to anticipate the next move.
+        bool MoveProxy(ProxyId proxy, const component::AABBCollider &aabb, const glm::vec3 &displacement);
+
+        [[nodiscard]] uint32_t GetUserData(ProxyId proxy) const { return m_nodes[proxy].userData; }
+        [[nodiscard]] const component::AABBCollider &GetFatAabb(ProxyId proxy) const { return m_nodes[proxy].aabb; }
+
+        // Calls callback(ProxyId) for every proxy whose fat box overlaps aabb, stops when it returns false.
+        template<typename Callback>
+        void Query(const component::AABBCollider &aabb, Callback &&callback) const;
+
+        // Replaces pairs with the overlapping pairs involving at least one proxy created or
+        // reinserted since the last call, sorted and without duplicates. Pairs between proxies
+        // that stayed inside their fat boxes are the caller's to keep. The vector is only cleared,
+        // so passing the same one every step reuses its memory.
+        void UpdatePairs(std::vector<Pair> &pairs);
+
+        // Every overlapping pair, sorted, for callers that do not track pairs across steps.
+        void FindAllPairs(std::vector<Pair> &pairs);
+
+        [[nodiscard]] uint32_t GetProxyCount() const { return m_proxyCount; }
+        [[nodiscard]] int32_t GetHeight() const { return m_root == NULL_PROXY ? 0 : m_nodes[m_root].height; }
+
+    private:
+        struct Node {
+            component::AABBCollider aabb;
+            uint32_t userData;
+            // next free node while the node is on the free list
+            int32_t parent;
+            int32_t child1;
+            int32_t child2;
+            // leaves are 0, free nodes -1
+            int32_t height;
+            bool moved;
+
+            [[nodiscard]] bool isLeaf() const { return child1 == NULL_PROXY; }
+        };
+
+        int32_t AllocateNode();
+        void FreeNode(int32_t node);
+        void InsertLeaf(int32_t leaf);
+        void RemoveLeaf(int32_t leaf);
+        int32_t Balance(int32_t node);
+        void CollectPairs(std::vector<Pair> &pairs, bool movedOnly);
+
+        std::vector<Node> m_nodes;
+        int32_t m_root = NULL_PROXY;
+        int32_t m_freeList = NULL_PROXY;
+        uint32_t m_proxyCount = 0;
+        float m_margin;
+
+        // proxies created or reinserted since the last UpdatePairs
+        std::vector<ProxyId> m_moveBuffer;
+        mutable std::vector<int32_t> m_stack;
+    };
+
+    namespace aabb {
+        inline component::AABBCollider Union(const component::AABBCollider &a, const component::AABBCollider &b) {
+            return {glm::min(a.minExtent, b.minExtent), glm::max(a.maxExtent, b.maxExtent)};
+        }
+
+        // half the surface area, the SAH cost of a box
+        inline float HalfArea(const component::AABBCollider &a) {
+            glm::vec3 extent = a.maxExtent - a.minExtent;
+            return extent.x * extent.y + extent.y * extent.z + extent.z * extent.x;
+        }
+
+        inline bool Contains(const component::AABBCollider &outer, const component::AABBCollider &inner) {
+            return glm::all(glm::lessThanEqual(outer.minExtent, inner.minExtent)) &&
+                   glm::all(glm::greaterThanEqual(outer.maxExtent, inner.maxExtent));
+        }
+    }
+
+    template<typename Callback>
+    void DynamicAabbTree::Query(const component::AABBCollider &aabb, Callback &&callback) const {
+        if (m_root == NULL_PROXY) {
+            return;
+        }
+
+        m_stack.clear();
+        m_stack.push_back(m_root);
+        while (!m_stack.empty()) {
+            const Node &node = m_nodes[m_stack.back()];
+            int32_t index = m_stack.back();
+            m_stack.pop_back();
+
+            if (!node.aabb.checkCollision(aabb)) {
+                continue;
+            }
+
+            if (node.isLeaf()) {
+                if (!callback(static_cast<ProxyId>(index))) {
+                    return;
+                }
+            } else {
+                m_stack.push_back(node.child1);
+                m_stack.push_back(node.child2);
+            }
+        }
+    }
+}
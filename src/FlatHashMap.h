@@ -0,0 +1,123 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+namespace engine {
+    // Open addressing hash map with linear probing for hot insert/lookup loops such as vertex
+    // deduplication. Slots live in one contiguous array, so there is no allocation per entry,
+    // and a one byte tag per slot avoids most key comparisons. There is no erase; Key and Value
+    // must be default constructible.
+    template<typename Key, typename Value, typename Hash = std::hash<Key>, typename Equal = std::equal_to<Key>>
+    class FlatHashMap {
+    public:
+        explicit FlatHashMap(size_t expectedSize = 0) { reserve(expectedSize); }
+
+        void reserve(size_t expectedSize) {
+            size_t capacity = 16;
+            // keep the load factor at or below 3/4
+            while (capacity * 3 < expectedSize * 4) {
+                capacity *= 2;
+            }
+            if (capacity > mTags.size()) {
+                rehash(capacity);
+            }
+        }
+
+        // Inserts the pair unless the key is present. Returns the stored value and whether it was
+        // inserted, with a single probe sequence (unlike count() followed by operator[]).
+        std::pair<Value &, bool> tryEmplace(const Key &key, const Value &value) {
+            if ((mSize + 1) * 4 > mTags.size() * 3) {
+                rehash(mTags.size() * 2);
+            }
+
+            size_t hash = hashOf(key);
+            uint8_t tag = tagOf(hash);
+            size_t mask = mTags.size() - 1;
+
+            for (size_t i = hash & mask;; i = (i + 1) & mask) {
+                if (mTags[i] == EMPTY) {
+                    mTags[i] = tag;
+                    mSlots[i] = {key, value};
+                    mSize++;
+                    return {mSlots[i].second, true};
+                }
+                if (mTags[i] == tag && mEqual(mSlots[i].first, key)) {
+                    return {mSlots[i].second, false};
+                }
+            }
+        }
+
+        [[nodiscard]] const Value *find(const Key &key) const {
+            size_t hash = hashOf(key);
+            uint8_t tag = tagOf(hash);
+            size_t mask = mTags.size() - 1;
+
+            for (size_t i = hash & mask;; i = (i + 1) & mask) {
+                if (mTags[i] == EMPTY) {
+                    return nullptr;
+                }
+                if (mTags[i] == tag && mEqual(mSlots[i].first, key)) {
+                    return &mSlots[i].second;
+                }
+            }
+        }
+
+        [[nodiscard]] size_t size() const { return mSize; }
+        [[nodiscard]] bool empty() const { return mSize == 0; }
+
+        void clear() {
+            std::fill(mTags.begin(), mTags.end(), EMPTY);
+            mSize = 0;
+        }
+
+    private:
+        static constexpr uint8_t EMPTY = 0;
+
+        // std::hash of integers is the identity, which would put consecutive keys into one long
+        // probe run. Mixing the bits keeps such keys spread out; a good hash is unaffected.
+        size_t hashOf(const Key &key) const {
+            uint64_t hash = static_cast<uint64_t>(mHash(key));
+            hash ^= hash >> 33;
+            hash *= 0xFF51AFD7ED558CCDull;
+            hash ^= hash >> 33;
+            return static_cast<size_t>(hash);
+        }
+
+        // top hash bits, with the high bit set so a tag is never EMPTY
+        static uint8_t tagOf(size_t hash) {
+            return static_cast<uint8_t>(hash >> (sizeof(size_t) * 8 - 7)) | 0x80;
+        }
+
+        void rehash(size_t capacity) {
+            std::vector<uint8_t> oldTags = std::move(mTags);
+            std::vector<std::pair<Key, Value>> oldSlots = std::move(mSlots);
+
+            mTags.assign(capacity, EMPTY);
+            mSlots.resize(capacity);
+            size_t mask = capacity - 1;
+
+            for (size_t slot = 0; slot < oldTags.size(); slot++) {
+                if (oldTags[slot] == EMPTY) {
+                    continue;
+                }
+                size_t i = hashOf(oldSlots[slot].first) & mask;
+                while (mTags[i] != EMPTY) {
+                    i = (i + 1) & mask;
+                }
+                mTags[i] = oldTags[slot];
+                mSlots[i] = std::move(oldSlots[slot]);
+            }
+        }
+
+        std::vector<uint8_t> mTags;
+        std::vector<std::pair<Key, Value>> mSlots;
+        size_t mSize = 0;
+        Hash mHash{};
+        Equal mEqual{};
+    };
+}
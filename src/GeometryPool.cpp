@@ -0,0 +1,303 @@
+#include "GeometryPool.h"
+#include "MeshCache.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <iterator>
+#include <stdexcept>
+
+namespace engine {
+    void RangeAllocator::Reset(uint32_t capacity) {
+        mFreeRanges.clear();
+        if (capacity > 0) {
+            mFreeRanges[0] = capacity;
+        }
+        mCapacity = capacity;
+        mFreeSize = capacity;
+    }
+
+    bool RangeAllocator::Allocate(uint32_t size, uint32_t &offset) {
+        if (size == 0) {
+            offset = 0;
+            return true;
+        }
+
+        for (auto it = mFreeRanges.begin(); it != mFreeRanges.end(); ++it) {
+            if (it->second < size) {
+                continue;
+            }
+
+            offset = it->first;
+            uint32_t remaining = it->second - size;
+            mFreeRanges.erase(it);
+            if (remaining > 0) {
+                mFreeRanges[offset + size] = remaining;
+            }
+            mFreeSize -= size;
+            return true;
+        }
+        return false;
+    }
+
+    void RangeAllocator::Free(uint32_t offset, uint32_t size) {
+        if (size == 0) {
+            return;
+        }
+        mFreeSize += size;
+
+        auto next = mFreeRanges.lower_bound(offset);
+        if (next != mFreeRanges.end() && offset + size == next->first) {
+            size += next->second;
+            next = mFreeRanges.erase(next);
+        }
+
+        if (next != mFreeRanges.begin()) {
+            auto previous = std::prev(next);
+            if (previous->first + previous->second == offset) {
+                previous->second += size;
+                return;
+            }
+        }
+        mFreeRanges[offset] = size;
+    }
+
+    uint32_t RangeAllocator::LargestFreeRange() const {
+        uint32_t largest = 0;
+        for (const auto &[offset, size] : mFreeRanges) {
+            largest = std::max(largest, size);
+        }
+        return largest;
+    }
+
+    GeometryPool::GeometryPool(Device &device, uint32_t vertexCapacity, uint32_t indexCapacity)
+            : mDevice{device} {
+        mVertexBuffer = CreateVertexBuffer(vertexCapacity);
+        mIndexBuffer = CreateIndexBuffer(indexCapacity);
+        mVertexAllocator.Reset(vertexCapacity);
+        mIndexAllocator.Reset(indexCapacity);
+    }
+
+    std::unique_ptr<Buffer> GeometryPool::CreateVertexBuffer(uint32_t capacity) {
+        // TRANSFER_SRC so the contents can be moved when repacking
+        return std::make_unique<Buffer>(mDevice, sizeof(Model::Vertex), std::max(capacity, 1u),
+                                        VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT |
+                                        VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                                        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    }
+
+    std::unique_ptr<Buffer> GeometryPool::CreateIndexBuffer(uint32_t capacity) {
+        return std::make_unique<Buffer>(mDevice, sizeof(uint32_t), std::max(capacity, 1u),
+                                        VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT |
+                                        VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                                        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    }
+
+    GeometryPool::MeshHandle GeometryPool::Add(const Model::Vertex *vertices, uint32_t vertexCount,
+                                               const uint32_t *indices, uint32_t indexCount,
+                                               const Model::Lod *lods, uint32_t lodCount) {
+        if (vertexCount == 0 || indexCount == 0) {
+            throw std::runtime_error("geometry pool meshes need vertices and indices");
+        }
+
+        uint32_t vertexOffset;
+        uint32_t firstIndex;
+        if (!Allocate(vertexCount, indexCount, vertexOffset, firstIndex)) {
+            MakeRoom(vertexCount, indexCount);
+            if (!Allocate(vertexCount, indexCount, vertexOffset, firstIndex)) {
+                throw std::runtime_error("failed to allocate geometry pool space!");
+            }
+        }
+
+        Mesh mesh{};
+        mesh.vertexOffset = static_cast<int32_t>(vertexOffset);
+        mesh.vertexCount = vertexCount;
+        mesh.firstIndex = firstIndex;
+        mesh.indexCount = indexCount;
+        if (lodCount > 0) {
+            mesh.lods.assign(lods, lods + lodCount);
+        } else {
+            mesh.lods.push_back({0, indexCount, 0.0f});
+        }
+
+        mesh.minExtent = mesh.maxExtent = vertices[0].position;
+        for (uint32_t i = 1; i < vertexCount; i++) {
+            mesh.minExtent = glm::min(mesh.minExtent, vertices[i].position);
+            mesh.maxExtent = glm::max(mesh.maxExtent, vertices[i].position);
+        }
+
+        // one staging buffer and one submission for both ranges
+        VkDeviceSize vertexBytes = sizeof(Model::Vertex) * static_cast<VkDeviceSize>(vertexCount);
+        VkDeviceSize indexBytes = sizeof(uint32_t) * static_cast<VkDeviceSize>(indexCount);
+
+        Buffer stagingBuffer{
+                mDevice,
+                1,
+                static_cast<uint32_t>(vertexBytes + indexBytes),
+                VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+        };
+        stagingBuffer.map();
+        auto *staging = static_cast<char *>(stagingBuffer.getMappedMemory());
+        std::memcpy(staging, vertices, vertexBytes);
+        std::memcpy(staging + vertexBytes, indices, indexBytes);
+
+        VkCommandBuffer commandBuffer = mDevice.beginSingleTimeCommands();
+
+        VkBufferCopy vertexCopy{0, vertexOffset * sizeof(Model::Vertex), vertexBytes};
+        mDevice.dispatch().vkCmdCopyBuffer(commandBuffer, stagingBuffer.getBuffer(), mVertexBuffer->getBuffer(), 1, &vertexCopy);
+
+        VkBufferCopy indexCopy{vertexBytes, firstIndex * sizeof(uint32_t), indexBytes};
+        mDevice.dispatch().vkCmdCopyBuffer(commandBuffer, stagingBuffer.getBuffer(), mIndexBuffer->getBuffer(), 1, &indexCopy);
+
+        mDevice.endSingleTimeCommands(commandBuffer);
+
+        MeshHandle handle;
+        if (!mFreeHandles.empty()) {
+            handle = mFreeHandles.back();
+            mFreeHandles.pop_back();
+            mMeshes[handle] = std::move(mesh);
+            mLive[handle] = true;
+        } else {
+            handle = static_cast<MeshHandle>(mMeshes.size());
+            mMeshes.push_back(std::move(mesh));
+            mLive.push_back(true);
+        }
+        return handle;
+    }
+
+    GeometryPool::MeshHandle GeometryPool::Add(const Model::Builder &builder) {
+        return Add(builder.vertices.data(), static_cast<uint32_t>(builder.vertices.size()),
+                   builder.indices.data(), static_cast<uint32_t>(builder.indices.size()),
+                   builder.lods.data(), static_cast<uint32_t>(builder.lods.size()));
+    }
+
+    GeometryPool::MeshHandle GeometryPool::AddFromFile(const std::string &filepath) {
+        if (auto cached = MeshCache::Load(filepath)) {
+            std::cout << "Vertex count: " << cached->vertexCount() << " (cached)" << std::endl;
+            return Add(cached->vertices(), cached->vertexCount(), cached->indices(), cached->indexCount(),
+                       cached->lods(), cached->lodCount());
+        }
+
+        Model::Builder builder{};
+        builder.Cook(filepath);
+        return Add(builder);
+    }
+
+    void GeometryPool::Remove(MeshHandle mesh) {
+        if (mesh >= mMeshes.size() || !mLive[mesh]) {
+            return;
+        }
+
+        const Mesh &removed = mMeshes[mesh];
+        mVertexAllocator.Free(static_cast<uint32_t>(removed.vertexOffset), removed.vertexCount);
+        mIndexAllocator.Free(removed.firstIndex, removed.indexCount);
+
+        mLive[mesh] = false;
+        mMeshes[mesh].lods.clear();
+        mFreeHandles.push_back(mesh);
+    }
+
+    bool GeometryPool::Allocate(uint32_t vertexCount, uint32_t indexCount,
+                                uint32_t &vertexOffset, uint32_t &firstIndex) {
+        if (!mVertexAllocator.Allocate(vertexCount, vertexOffset)) {
+            return false;
+        }
+        if (!mIndexAllocator.Allocate(indexCount, firstIndex)) {
+            mVertexAllocator.Free(vertexOffset, vertexCount);
+            return false;
+        }
+        return true;
+    }
+
+    void GeometryPool::MakeRoom(uint32_t vertexCount, uint32_t indexCount) {
+        uint32_t vertexCapacity = mVertexAllocator.Capacity();
+        uint32_t indexCapacity = mIndexAllocator.Capacity();
+
+        if (mVertexAllocator.FreeSize() >= vertexCount && mIndexAllocator.FreeSize() >= indexCount) {
+            // everything fits once the holes are closed
+            Reallocate(vertexCapacity, indexCapacity);
+            return;
+        }
+
+        uint32_t usedVertices = vertexCapacity - mVertexAllocator.FreeSize();
+        uint32_t usedIndices = indexCapacity - mIndexAllocator.FreeSize();
+        while (vertexCapacity < usedVertices + vertexCount) {
+            vertexCapacity = std::max(vertexCapacity * 2, 1024u);
+        }
+        while (indexCapacity < usedIndices + indexCount) {
+            indexCapacity = std::max(indexCapacity * 2, 1024u);
+        }
+
+        Reallocate(vertexCapacity, indexCapacity);
+    }
+
+    void GeometryPool::Reallocate(uint32_t vertexCapacity, uint32_t indexCapacity) {
+        std::vector<VkBufferCopy> vertexCopies;
+        std::vector<VkBufferCopy> indexCopies;
+        uint32_t vertexEnd = 0;
+        uint32_t indexEnd = 0;
+
+        for (size_t i = 0; i < mMeshes.size(); i++) {
+            if (!mLive[i]) {
+                continue;
+            }
+            Mesh &mesh = mMeshes[i];
+
+            vertexCopies.push_back({mesh.vertexOffset * sizeof(Model::Vertex),
+                                    vertexEnd * sizeof(Model::Vertex),
+                                    mesh.vertexCount * sizeof(Model::Vertex)});
+            indexCopies.push_back({mesh.firstIndex * sizeof(uint32_t),
+                                   indexEnd * sizeof(uint32_t),
+                                   mesh.indexCount * sizeof(uint32_t)});
+
+            mesh.vertexOffset = static_cast<int32_t>(vertexEnd);
+            mesh.firstIndex = indexEnd;
+            vertexEnd += mesh.vertexCount;
+            indexEnd += mesh.indexCount;
+        }
+
+        if (vertexEnd > vertexCapacity || indexEnd > indexCapacity) {
+            throw std::runtime_error("geometry pool capacity is smaller than its contents!");
+        }
+
+        auto vertexBuffer = CreateVertexBuffer(vertexCapacity);
+        auto indexBuffer = CreateIndexBuffer(indexCapacity);
+
+        if (!vertexCopies.empty()) {
+            VkCommandBuffer commandBuffer = mDevice.beginSingleTimeCommands();
+            mDevice.dispatch().vkCmdCopyBuffer(commandBuffer, mVertexBuffer->getBuffer(), vertexBuffer->getBuffer(),
+                            static_cast<uint32_t>(vertexCopies.size()), vertexCopies.data());
+            mDevice.dispatch().vkCmdCopyBuffer(commandBuffer, mIndexBuffer->getBuffer(), indexBuffer->getBuffer(),
+                            static_cast<uint32_t>(indexCopies.size()), indexCopies.data());
+            // waits for the queue to go idle, so nothing in flight still reads the old buffers
+            mDevice.endSingleTimeCommands(commandBuffer);
+        }
+
+        mVertexBuffer = std::move(vertexBuffer);
+        mIndexBuffer = std::move(indexBuffer);
+
+        mVertexAllocator.Reset(vertexCapacity);
+        mIndexAllocator.Reset(indexCapacity);
+        uint32_t offset;
+        mVertexAllocator.Allocate(vertexEnd, offset);
+        mIndexAllocator.Allocate(indexEnd, offset);
+
+        mGeneration++;
+    }
+
+    void GeometryPool::Bind(VkCommandBuffer commandBuffer) {
+        VkBuffer buffers[] = {mVertexBuffer->getBuffer()};
+        VkDeviceSize offsets[] = {0};
+        mDevice.dispatch().vkCmdBindVertexBuffers(commandBuffer, 0, 1, buffers, offsets);
+        mDevice.dispatch().vkCmdBindIndexBuffer(commandBuffer, mIndexBuffer->getBuffer(), 0, VK_INDEX_TYPE_UINT32);
+    }
+
+    void GeometryPool::Draw(VkCommandBuffer commandBuffer, MeshHandle mesh, uint32_t lod,
+                            uint32_t instanceCount, uint32_t firstInstance) const {
+        const Mesh &drawn = mMeshes[mesh];
+        const Model::Lod &level = drawn.lods[std::min(lod, static_cast<uint32_t>(drawn.lods.size()) - 1)];
+        mDevice.dispatch().vkCmdDrawIndexed(commandBuffer, level.indexCount, instanceCount, drawn.firstIndex + level.firstIndex,
+                         drawn.vertexOffset, firstInstance);
+    }
+}
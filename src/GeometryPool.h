@@ -0,0 +1,110 @@
+#pragma once
+
+#include "Buffer.h"
+#include "Device.h"
+#include "Model.h"
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace engine {
+    // First fit allocator over [0, capacity). Free ranges are kept sorted by offset and merged
+    // with their neighbours when released.
+    class RangeAllocator {
+    public:
+        explicit RangeAllocator(uint32_t capacity = 0) { Reset(capacity); }
+
+        // frees everything
+        void Reset(uint32_t capacity);
+
+        bool Allocate(uint32_t size, uint32_t &offset);
+        void Free(uint32_t offset, uint32_t size);
+
+        [[nodiscard]] uint32_t Capacity() const { return mCapacity; }
+        [[nodiscard]] uint32_t FreeSize() const { return mFreeSize; }
+        [[nodiscard]] uint32_t LargestFreeRange() const;
+
+    private:
+        // offset -> size
+        std::map<uint32_t, uint32_t> mFreeRanges;
+        uint32_t mCapacity = 0;
+        uint32_t mFreeSize = 0;
+    };
+
+    // One device local vertex buffer and one index buffer shared by many meshes, so every mesh
+    // can be drawn after a single Bind() and batched into multi draw indirect calls. A mesh is
+    // only a record of where its vertices and indices live; indices stay relative to the mesh
+    // and are offset with vertexOffset when drawn.
+    //
+    // Removing meshes leaves holes. Add() defragments when a mesh does not fit into any hole
+    // but the total free space would do, and grows the buffers when it would not. Both repack
+    // all meshes into new buffers and wait for the GPU, so they belong to load time.
+    class GeometryPool {
+    public:
+        using MeshHandle = uint32_t;
+        static constexpr MeshHandle INVALID_MESH = ~0u;
+
+        struct Mesh {
+            int32_t vertexOffset;
+            uint32_t vertexCount;
+            uint32_t firstIndex;
+            uint32_t indexCount;
+            // index ranges relative to firstIndex, level 0 is the full mesh
+            std::vector<Model::Lod> lods;
+            glm::vec3 minExtent;
+            glm::vec3 maxExtent;
+        };
+
+        GeometryPool(Device &device, uint32_t vertexCapacity = 1 << 20, uint32_t indexCapacity = 1 << 22);
+
+        GeometryPool(const GeometryPool &) = delete;
+        GeometryPool &operator=(const GeometryPool &) = delete;
+
+        MeshHandle Add(const Model::Vertex *vertices, uint32_t vertexCount,
+                       const uint32_t *indices, uint32_t indexCount,
+                       const Model::Lod *lods = nullptr, uint32_t lodCount = 0);
+        MeshHandle Add(const Model::Builder &builder);
+        // Same caching as Model::CreateModelFromFile.
+        MeshHandle AddFromFile(const std::string &filepath);
+
+        // The space is reused by later meshes. Handles of other meshes stay valid.
+        void Remove(MeshHandle mesh);
+
+        // Packs all meshes to the front of new buffers of the given size, waiting for the GPU.
+        void Reallocate(uint32_t vertexCapacity, uint32_t indexCapacity);
+        void Defragment() { Reallocate(mVertexAllocator.Capacity(), mIndexAllocator.Capacity()); }
+
+        void Bind(VkCommandBuffer commandBuffer);
+        void Draw(VkCommandBuffer commandBuffer, MeshHandle mesh, uint32_t lod = 0,
+                  uint32_t instanceCount = 1, uint32_t firstInstance = 0) const;
+
+        [[nodiscard]] const Mesh &GetMesh(MeshHandle mesh) const { return mMeshes[mesh]; }
+
+        // Bumped whenever meshes move, anything caching their offsets has to refresh them.
+        [[nodiscard]] uint32_t Generation() const { return mGeneration; }
+
+        [[nodiscard]] const RangeAllocator &VertexAllocator() const { return mVertexAllocator; }
+        [[nodiscard]] const RangeAllocator &IndexAllocator() const { return mIndexAllocator; }
+
+    private:
+        std::unique_ptr<Buffer> CreateVertexBuffer(uint32_t capacity);
+        std::unique_ptr<Buffer> CreateIndexBuffer(uint32_t capacity);
+        bool Allocate(uint32_t vertexCount, uint32_t indexCount, uint32_t &vertexOffset, uint32_t &firstIndex);
+        // defragments, or grows the buffers when the free space is too small
+        void MakeRoom(uint32_t vertexCount, uint32_t indexCount);
+
+        Device &mDevice;
+        std::unique_ptr<Buffer> mVertexBuffer;
+        std::unique_ptr<Buffer> mIndexBuffer;
+        RangeAllocator mVertexAllocator;
+        RangeAllocator mIndexAllocator;
+
+        std::vector<Mesh> mMeshes;
+        std::vector<bool> mLive;
+        std::vector<MeshHandle> mFreeHandles;
+        uint32_t mGeneration = 0;
+    };
+}
@@ -0,0 +1,144 @@
+#include "GpuProfiler.h"
+
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+#include <vector>
+
+namespace engine {
+
+    // Bits a timestamp of the graphics queue holds, 0 if it has no timestamps.
+    static uint32_t graphicsTimestampBits(Device &device) {
+        uint32_t queueFamilyCount = 0;
+        vkGetPhysicalDeviceQueueFamilyProperties(device.physicalDevice(), &queueFamilyCount, nullptr);
+        std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+        vkGetPhysicalDeviceQueueFamilyProperties(device.physicalDevice(), &queueFamilyCount, queueFamilies.data());
+
+        uint32_t graphicsFamily = device.findPhysicalQueueFamilies().graphicsFamily;
+        return graphicsFamily < queueFamilyCount ? queueFamilies[graphicsFamily].timestampValidBits : 0;
+    }
+
+    GpuProfiler::GpuProfiler(Device &device, uint32_t maxScopes)
+            : mDevice(device), mMaxScopes(maxScopes), mTimestampPeriod(device.properties.limits.timestampPeriod) {
+        // timestampComputeAndGraphics only promises timestamps on every graphics and compute queue,
+        // the graphics queue may still have them without it
+        uint32_t timestampBits = graphicsTimestampBits(mDevice);
+        if (timestampBits == 0 || mTimestampPeriod <= 0.0f) {
+            // nothing is measured, the game runs as usual
+            return;
+        }
+        mTimestampMask = timestampBits >= 64 ? ~uint64_t{0} : (uint64_t{1} << timestampBits) - 1;
+
+        for (size_t i = 0; i < mTimestampPools.size(); i++) {
+            VkQueryPoolCreateInfo poolInfo{};
+            poolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+            poolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+            poolInfo.queryCount = mMaxScopes * 2;
+            if (mDevice.dispatch().vkCreateQueryPool(mDevice.device(), &poolInfo, nullptr, &mTimestampPools[i]) != VK_SUCCESS) {
+                throw std::runtime_error("failed to create timestamp query pool!");
+            }
+
+            if (mDevice.enabledFeatures().pipelineStatisticsQuery) {
+                poolInfo.queryType = VK_QUERY_TYPE_PIPELINE_STATISTICS;
+                poolInfo.queryCount = mMaxScopes;
+                poolInfo.pipelineStatistics = VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT;
+                if (mDevice.dispatch().vkCreateQueryPool(mDevice.device(), &poolInfo, nullptr, &mStatisticsPools[i]) != VK_SUCCESS) {
+                    throw std::runtime_error("failed to create pipeline statistics query pool!");
+                }
+            }
+        }
+    }
+
+    GpuProfiler::~GpuProfiler() {
+        for (size_t i = 0; i < mTimestampPools.size(); i++) {
+            if (mTimestampPools[i]) {
+                mDevice.dispatch().vkDestroyQueryPool(mDevice.device(), mTimestampPools[i], nullptr);
+            }
+            if (mStatisticsPools[i]) {
+                mDevice.dispatch().vkDestroyQueryPool(mDevice.device(), mStatisticsPools[i], nullptr);
+            }
+        }
+    }
+
+    void GpuProfiler::BeginFrame(VkCommandBuffer commandBuffer, int frameIndex) {
+        assert(!mScopeOpen && "EndScope missing in the last frame");
+        if (!Enabled()) {
+            return;
+        }
+        mFrameIndex = frameIndex;
+
+        ReadBack(frameIndex);
+        mScopeNames[frameIndex].clear();
+
+        mDevice.dispatch().vkCmdResetQueryPool(commandBuffer, mTimestampPools[frameIndex], 0, mMaxScopes * 2);
+        if (HasPipelineStatistics()) {
+            mDevice.dispatch().vkCmdResetQueryPool(commandBuffer, mStatisticsPools[frameIndex], 0, mMaxScopes);
+        }
+    }
+
+    void GpuProfiler::BeginScope(VkCommandBuffer commandBuffer, const std::string &name) {
+        assert(!mScopeOpen && "GpuProfiler scopes can not be nested");
+        if (!Enabled()) {
+            return;
+        }
+        std::vector<std::string> &names = mScopeNames[mFrameIndex];
+        if (names.size() == mMaxScopes) {
+            return;
+        }
+
+        auto scope = static_cast<uint32_t>(names.size());
+        mDevice.dispatch().vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                                               mTimestampPools[mFrameIndex], scope * 2);
+        if (HasPipelineStatistics()) {
+            mDevice.dispatch().vkCmdBeginQuery(commandBuffer, mStatisticsPools[mFrameIndex], scope, 0);
+        }
+        names.push_back(name);
+        mScopeOpen = true;
+    }
+
+    void GpuProfiler::EndScope(VkCommandBuffer commandBuffer) {
+        if (!mScopeOpen) {
+            // BeginScope ran out of queries, or the profiler is disabled
+            return;
+        }
+
+        auto scope = static_cast<uint32_t>(mScopeNames[mFrameIndex].size() - 1);
+        if (HasPipelineStatistics()) {
+            mDevice.dispatch().vkCmdEndQuery(commandBuffer, mStatisticsPools[mFrameIndex], scope);
+        }
+        mDevice.dispatch().vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                                               mTimestampPools[mFrameIndex], scope * 2 + 1);
+        mScopeOpen = false;
+    }
+
+    void GpuProfiler::ReadBack(int frameIndex) {
+        const std::vector<std::string> &names = mScopeNames[frameIndex];
+        if (names.empty()) {
+            return;
+        }
+
+        auto count = static_cast<uint32_t>(names.size());
+        std::vector<uint64_t> timestamps(count * 2);
+        // the frame's fence was waited on, anything not available was never written
+        if (mDevice.dispatch().vkGetQueryPoolResults(mDevice.device(), mTimestampPools[frameIndex], 0, count * 2,
+                                                     timestamps.size() * sizeof(uint64_t), timestamps.data(),
+                                                     sizeof(uint64_t), VK_QUERY_RESULT_64_BIT) != VK_SUCCESS) {
+            return;
+        }
+
+        std::vector<uint64_t> invocations(count);
+        if (HasPipelineStatistics() &&
+            mDevice.dispatch().vkGetQueryPoolResults(mDevice.device(), mStatisticsPools[frameIndex], 0, count,
+                                                     invocations.size() * sizeof(uint64_t), invocations.data(),
+                                                     sizeof(uint64_t), VK_QUERY_RESULT_64_BIT) != VK_SUCCESS) {
+            std::fill(invocations.begin(), invocations.end(), 0);
+        }
+
+        mResults.resize(count);
+        for (uint32_t i = 0; i < count; i++) {
+            mResults[i].name = names[i];
+            mResults[i].milliseconds = static_cast<float>((timestamps[i * 2 + 1] - timestamps[i * 2]) & mTimestampMask) * mTimestampPeriod * 1e-6f;
+            mResults[i].fragmentInvocations = invocations[i];
+        }
+    }
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "Device.h"
+#include "SwapChain.h"
+
+#include <array>
+#include <string>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+namespace engine {
+
+    // GPU time of named scopes from timestamp queries, plus the fragment shader invocations in
+    // each scope where the device supports pipeline statistics. A frame's queries are read back
+    // when its slot comes around again, after Renderer::BeginFrame waited on its fence, so reading
+    // them never stalls. Without timestamps on the graphics queue the profiler is disabled: scopes
+    // are not measured and Scopes() stays empty.
+    class GpuProfiler {
+    public:
+        struct ScopeStats {
+            std::string name;
+            float milliseconds = 0.0f;
+            // 0 without pipeline statistics
+            uint64_t fragmentInvocations = 0;
+        };
+
+        explicit GpuProfiler(Device &device, uint32_t maxScopes = 16);
+
+        ~GpuProfiler();
+
+        GpuProfiler(const GpuProfiler &) = delete;
+        GpuProfiler &operator=(const GpuProfiler &) = delete;
+
+        // Call right after Renderer::BeginFrame, outside of any render pass.
+        void BeginFrame(VkCommandBuffer commandBuffer, int frameIndex);
+
+        // Scopes can not be nested. Scopes past maxScopes are not measured.
+        void BeginScope(VkCommandBuffer commandBuffer, const std::string &name);
+        void EndScope(VkCommandBuffer commandBuffer);
+
+        // The scopes of the last frame that was read back.
+        [[nodiscard]] const std::vector<ScopeStats> &Scopes() const { return mResults; }
+
+        [[nodiscard]] bool Enabled() const { return mTimestampPools[0] != VK_NULL_HANDLE; }
+
+        [[nodiscard]] bool HasPipelineStatistics() const { return mStatisticsPools[0] != VK_NULL_HANDLE; }
+
+    private:
+        void ReadBack(int frameIndex);
+
+        Device &mDevice;
+        const uint32_t mMaxScopes;
+        float mTimestampPeriod;
+        // the valid bits of a timestamp, they wrap around above them
+        uint64_t mTimestampMask = 0;
+
+        // two timestamps per scope
+        std::array<VkQueryPool, SwapChain::MAX_FRAMES_IN_FLIGHT> mTimestampPools{};
+        std::array<VkQueryPool, SwapChain::MAX_FRAMES_IN_FLIGHT> mStatisticsPools{};
+        std::array<std::vector<std::string>, SwapChain::MAX_FRAMES_IN_FLIGHT> mScopeNames;
+
+        int mFrameIndex = 0;
+        bool mScopeOpen = false;
+        std::vector<ScopeStats> mResults;
+    };
+}
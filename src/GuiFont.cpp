@@ -0,0 +1,106 @@
+#include "GuiFont.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace engine {
+
+    GuiFont::GuiFont(ImFontAtlas &fonts, const ImFont &font, const std::string &characters, TextureAtlas::Builder &builder) {
+        unsigned char *pixels;
+        int width, height;
+        fonts.GetTexDataAsRGBA32(&pixels, &width, &height);
+        if (!pixels) {
+            throw std::runtime_error("failed to build the font atlas");
+        }
+        // only known once the atlas is built
+        mLineHeight = font.FontSize;
+
+        std::vector<uint8_t> texels;
+        for (char c : characters) {
+            auto code = static_cast<unsigned char>(c);
+            if (code >= mGlyphs.size() || mGlyphs[code].present) {
+                continue;
+            }
+            const ImFontGlyph *source = font.FindGlyphNoFallback(static_cast<ImWchar>(code));
+            if (!source) {
+                continue;
+            }
+
+            Glyph &glyph = mGlyphs[code];
+            glyph.present = true;
+            glyph.advance = source->AdvanceX;
+            glyph.offset = {source->X0, source->Y0};
+            glyph.size = {source->X1 - source->X0, source->Y1 - source->Y0};
+            if (!source->Visible) {
+                continue;
+            }
+
+            // the texels of the glyph in the ImGui atlas, which is oversampled horizontally
+            auto x0 = static_cast<uint32_t>(std::lround(source->U0 * static_cast<float>(width)));
+            auto y0 = static_cast<uint32_t>(std::lround(source->V0 * static_cast<float>(height)));
+            auto x1 = static_cast<uint32_t>(std::lround(source->U1 * static_cast<float>(width)));
+            auto y1 = static_cast<uint32_t>(std::lround(source->V1 * static_cast<float>(height)));
+            if (x1 <= x0 || y1 <= y0) {
+                continue;
+            }
+
+            texels.resize(size_t{x1 - x0} * (y1 - y0) * 4);
+            for (uint32_t y = y0; y < y1; y++) {
+                const unsigned char *row = pixels + (size_t{y} * width + x0) * 4;
+                std::copy(row, row + size_t{x1 - x0} * 4, texels.begin() + size_t{y - y0} * (x1 - x0) * 4);
+            }
+            builder.addPixels(RegionName(c), x1 - x0, y1 - y0, texels.data());
+            glyph.visible = true;
+        }
+    }
+
+    std::string GuiFont::RegionName(char c) {
+        return std::string("glyph_") + c;
+    }
+
+    void GuiFont::Resolve(const TextureAtlas &atlas) {
+        for (size_t code = 0; code < mGlyphs.size(); code++) {
+            if (mGlyphs[code].visible) {
+                mGlyphs[code].region = atlas.Find(RegionName(static_cast<char>(code)));
+            }
+        }
+    }
+
+    const GuiFont::Glyph *GuiFont::Find(char c) const {
+        auto code = static_cast<unsigned char>(c);
+        if (code >= mGlyphs.size() || !mGlyphs[code].present) {
+            return nullptr;
+        }
+        return &mGlyphs[code];
+    }
+
+    float GuiFont::AddText(std::vector<GuiElement> &elements, const glm::vec2 &position, const std::string &text,
+                           const glm::vec4 &color, uint32_t layer) const {
+        float pen = 0.0f;
+        for (char c : text) {
+            const Glyph *glyph = Find(c);
+            if (!glyph) {
+                continue;
+            }
+            if (glyph->visible) {
+                // whole pixels keep the glyphs sharp
+                glm::vec2 corner = glm::floor(position + glm::vec2(pen, 0.0f) + glyph->offset + 0.5f);
+                elements.push_back({corner, glyph->size, glyph->region, color, layer});
+            }
+            pen += glyph->advance;
+        }
+        return pen;
+    }
+
+    float GuiFont::Measure(const std::string &text) const {
+        float width = 0.0f;
+        for (char c : text) {
+            if (const Glyph *glyph = Find(c)) {
+                width += glyph->advance;
+            }
+        }
+        return width;
+    }
+
+} // engine
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "systems/GuiRenderSystem.h"
+#include "textures/TextureAtlas.h"
+
+#include <imgui/imgui.h>
+
+#include <glm/glm.hpp>
+
+#include <array>
+#include <string>
+#include <vector>
+
+namespace engine {
+
+    // The glyphs of an ImGui font copied into a TextureAtlas, so text can be laid out as
+    // GuiElements and drawn by GuiRenderSystem together with the rest of the HUD. Only the
+    // printable ASCII characters that were asked for are copied.
+    class GuiFont {
+    public:
+        // Adds a region per visible glyph of characters to builder. Call Resolve once the atlas is
+        // built.
+        GuiFont(ImFontAtlas &fonts, const ImFont &font, const std::string &characters, TextureAtlas::Builder &builder);
+
+        // Looks up the regions of the glyphs in the atlas built from the builder.
+        void Resolve(const TextureAtlas &atlas);
+
+        // Appends one element per visible glyph of text, with its top left corner at position in
+        // pixels. Characters that were not asked for are skipped. Returns the width of the text.
+        float AddText(std::vector<GuiElement> &elements, const glm::vec2 &position, const std::string &text,
+                      const glm::vec4 &color, uint32_t layer = 0) const;
+
+        [[nodiscard]] float Measure(const std::string &text) const;
+        [[nodiscard]] float LineHeight() const { return mLineHeight; }
+
+    private:
+        struct Glyph {
+            bool present = false;
+            bool visible = false;
+            // from the pen position at the top of the line, in pixels
+            glm::vec2 offset;
+            glm::vec2 size;
+            float advance = 0.0f;
+            uint32_t region = TextureAtlas::WHITE_REGION;
+        };
+
+        [[nodiscard]] const Glyph *Find(char c) const;
+
+        static std::string RegionName(char c);
+
+        std::array<Glyph, 128> mGlyphs;
+        float mLineHeight;
+    };
+
+} // engine
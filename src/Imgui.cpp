@@ -30,7 +30,7 @@ namespace engine {
         pool_info.maxSets = 1000 * IM_ARRAYSIZE(pool_sizes);
         pool_info.poolSizeCount = (uint32_t)IM_ARRAYSIZE(pool_sizes);
         pool_info.pPoolSizes = pool_sizes;
-        if (vkCreateDescriptorPool(device.device(), &pool_info, nullptr, &descriptorPool) != VK_SUCCESS) {
+        if (device.dispatch().vkCreateDescriptorPool(device.device(), &pool_info, nullptr, &descriptorPool) != VK_SUCCESS) {
             throw std::runtime_error("failed to set up descriptor pool for imgui");
         }
 
@@ -99,7 +99,7 @@ namespace engine {
         ImGui_ImplGlfw_Shutdown();
         ImGui::DestroyContext();
 
-        vkDestroyDescriptorPool(mDevice.device(), descriptorPool, nullptr);
+        mDevice.dispatch().vkDestroyDescriptorPool(mDevice.device(), descriptorPool, nullptr);
     }
 
     void Imgui::newFrame() {
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace engine {
+    // Read-only memory mapping of a whole file. The OS pages data in on first access, so
+    // copying straight from data() avoids reading the file into an intermediate buffer.
+    class MappedFile {
+    public:
+        MappedFile() = default;
+        ~MappedFile();
+
+        MappedFile(const MappedFile &) = delete;
+        MappedFile &operator=(const MappedFile &) = delete;
+
+        // Returns false (and stays closed) if the file does not exist or cannot be mapped.
+        bool Open(const std::string &path);
+        void Close();
+
+        [[nodiscard]] bool isOpen() const { return mData != nullptr; }
+        [[nodiscard]] const unsigned char *data() const { return static_cast<const unsigned char *>(mData); }
+        [[nodiscard]] size_t size() const { return mSize; }
+
+    private:
+        void *mData = nullptr;
+        size_t mSize = 0;
+#ifdef _WIN32
+        void *mFile = nullptr;
+        void *mMapping = nullptr;
+#endif
+    };
+}
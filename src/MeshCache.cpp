@@ -0,0 +1,125 @@
+#include "MeshCache.h"
+#include "Utils.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <type_traits>
+
+namespace engine {
+    static constexpr char MESH_CACHE_MAGIC[4] = {'S', 'V', 'K', 'M'};
+
+    static_assert(std::is_trivially_copyable_v<MeshCacheHeader>);
+    static_assert(std::is_trivially_copyable_v<Model::Vertex>);
+    static_assert(std::is_trivially_copyable_v<Model::Lod>);
+
+    static uint64_t alignUp(uint64_t value, uint64_t alignment) {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    bool MeshCache::HashSource(const std::string &sourcePath, uint64_t &hash, uint64_t &size) {
+        MappedFile source;
+        if (!source.Open(sourcePath)) {
+            return false;
+        }
+        hash = HashBytes(source.data(), source.size());
+        size = source.size();
+        return true;
+    }
+
+    std::unique_ptr<CachedMesh> MeshCache::Load(const std::string &sourcePath) {
+        auto mesh = std::make_unique<CachedMesh>();
+        if (!mesh->mFile.Open(CachePath(sourcePath)) || mesh->mFile.size() < sizeof(MeshCacheHeader)) {
+            return nullptr;
+        }
+
+        const auto *header = reinterpret_cast<const MeshCacheHeader *>(mesh->mFile.data());
+        if (std::memcmp(header->magic, MESH_CACHE_MAGIC, sizeof(MESH_CACHE_MAGIC)) != 0 ||
+            header->version != VERSION ||
+            header->vertexStride != sizeof(Model::Vertex)) {
+            return nullptr;
+        }
+
+        // the sections are used in place through typed pointers, so they have to be aligned for them
+        if (header->vertexOffset % sizeof(Model::Vertex) != 0 ||
+            header->indexOffset % sizeof(uint32_t) != 0 ||
+            header->lodOffset % alignof(Model::Lod) != 0) {
+            return nullptr;
+        }
+        // checked first, so the ends below cannot overflow
+        if (header->vertexOffset > mesh->mFile.size() || header->indexOffset > mesh->mFile.size() ||
+            header->lodOffset > mesh->mFile.size()) {
+            return nullptr;
+        }
+
+        uint64_t vertexEnd = header->vertexOffset + uint64_t(header->vertexCount) * sizeof(Model::Vertex);
+        uint64_t indexEnd = header->indexOffset + uint64_t(header->indexCount) * sizeof(uint32_t);
+        uint64_t lodEnd = header->lodOffset + uint64_t(header->lodCount) * sizeof(Model::Lod);
+        if (vertexEnd > mesh->mFile.size() || indexEnd > mesh->mFile.size() || lodEnd > mesh->mFile.size()) {
+            return nullptr;
+        }
+        const auto *lods = reinterpret_cast<const Model::Lod *>(mesh->mFile.data() + header->lodOffset);
+        for (uint32_t i = 0; i < header->lodCount; i++) {
+            const Model::Lod &lod = lods[i];
+            if (uint64_t(lod.firstIndex) + lod.indexCount > header->indexCount) {
+                return nullptr;
+            }
+        }
+
+        uint64_t sourceHash, sourceSize;
+        if (HashSource(sourcePath, sourceHash, sourceSize) &&
+            (sourceHash != header->sourceHash || sourceSize != header->sourceSize)) {
+            return nullptr;
+        }
+        // a cache without its source is still usable, e.g. when only cooked assets are shipped
+
+        mesh->mHeader = header;
+        return mesh;
+    }
+
+    void MeshCache::Write(const std::string &sourcePath, const Model::Builder &builder) {
+        MeshCacheHeader header{};
+        std::memcpy(header.magic, MESH_CACHE_MAGIC, sizeof(MESH_CACHE_MAGIC));
+        header.version = VERSION;
+        if (!HashSource(sourcePath, header.sourceHash, header.sourceSize)) {
+            throw std::runtime_error("failed to read mesh source: " + sourcePath);
+        }
+        header.vertexStride = sizeof(Model::Vertex);
+        header.vertexCount = static_cast<uint32_t>(builder.vertices.size());
+        header.indexCount = static_cast<uint32_t>(builder.indices.size());
+        // the stride is a multiple of 16, so this keeps the 16 byte alignment of the other sections
+        static_assert(sizeof(Model::Vertex) % 16 == 0);
+        header.vertexOffset = alignUp(sizeof(MeshCacheHeader), sizeof(Model::Vertex));
+        header.lodCount = static_cast<uint32_t>(builder.lods.size());
+        header.indexOffset = alignUp(header.vertexOffset + builder.vertices.size() * sizeof(Model::Vertex), 16);
+        header.lodOffset = alignUp(header.indexOffset + builder.indices.size() * sizeof(uint32_t), 16);
+
+        std::vector<char> bytes(header.lodOffset + builder.lods.size() * sizeof(Model::Lod), 0);
+        std::memcpy(bytes.data(), &header, sizeof(header));
+        std::memcpy(bytes.data() + header.vertexOffset, builder.vertices.data(),
+                    builder.vertices.size() * sizeof(Model::Vertex));
+        std::memcpy(bytes.data() + header.indexOffset, builder.indices.data(),
+                    builder.indices.size() * sizeof(uint32_t));
+        std::memcpy(bytes.data() + header.lodOffset, builder.lods.data(), builder.lods.size() * sizeof(Model::Lod));
+
+        // write next to the target and swap it in, so a crash never leaves a truncated cache behind
+        std::string cachePath = CachePath(sourcePath);
+        std::string tempPath = cachePath + ".tmp";
+        {
+            std::ofstream file{tempPath, std::ios::binary | std::ios::trunc};
+            if (!file.is_open()) {
+                throw std::runtime_error("failed to open file for writing: " + tempPath);
+            }
+            file.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+            if (!file) {
+                throw std::runtime_error("failed to write mesh cache: " + tempPath);
+            }
+        }
+
+        std::remove(cachePath.c_str());
+        if (std::rename(tempPath.c_str(), cachePath.c_str()) != 0) {
+            throw std::runtime_error("failed to move mesh cache into place: " + cachePath);
+        }
+    }
+}
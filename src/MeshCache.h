@@ -0,0 +1,69 @@
+#pragma once
+
+#include "MappedFile.h"
+#include "Model.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace engine {
+    // On-disk layout of a cooked mesh: this header, vertexCount Model::Vertex at vertexOffset,
+    // indexCount uint32_t indices at indexOffset (all levels of detail back to back) and lodCount
+    // Model::Lod at lodOffset. The vertices start at a multiple of the vertex stride and the
+    // other sections are aligned for their types, so all of them can be read in place. Stored
+    // next to the source as <source>.meshcache.
+    struct MeshCacheHeader {
+        char magic[4];
+        uint32_t version;
+        uint64_t sourceHash;
+        uint64_t sourceSize;
+        uint32_t vertexStride;
+        uint32_t vertexCount;
+        uint32_t indexCount;
+        uint32_t lodCount;
+        uint64_t vertexOffset;
+        uint64_t indexOffset;
+        uint64_t lodOffset;
+    };
+
+    // A validated cache file, mapped into memory for as long as this object lives.
+    class CachedMesh {
+    public:
+        [[nodiscard]] const Model::Vertex *vertices() const {
+            return reinterpret_cast<const Model::Vertex *>(mFile.data() + mHeader->vertexOffset);
+        }
+        [[nodiscard]] uint32_t vertexCount() const { return mHeader->vertexCount; }
+        [[nodiscard]] const uint32_t *indices() const {
+            return reinterpret_cast<const uint32_t *>(mFile.data() + mHeader->indexOffset);
+        }
+        [[nodiscard]] uint32_t indexCount() const { return mHeader->indexCount; }
+        [[nodiscard]] const Model::Lod *lods() const {
+            return reinterpret_cast<const Model::Lod *>(mFile.data() + mHeader->lodOffset);
+        }
+        [[nodiscard]] uint32_t lodCount() const { return mHeader->lodCount; }
+
+    private:
+        friend class MeshCache;
+
+        MappedFile mFile;
+        const MeshCacheHeader *mHeader = nullptr;
+    };
+
+    class MeshCache {
+    public:
+        // bump whenever the layout, Model::Vertex or the import/optimization changes, old caches are then rebuilt
+        static constexpr uint32_t VERSION = 4;
+
+        static std::string CachePath(const std::string &sourcePath) { return sourcePath + ".meshcache"; }
+
+        // Returns nullptr if there is no cache, it is from another version, or the source has changed since.
+        static std::unique_ptr<CachedMesh> Load(const std::string &sourcePath);
+
+        static void Write(const std::string &sourcePath, const Model::Builder &builder);
+
+    private:
+        static bool HashSource(const std::string &sourcePath, uint64_t &hash, uint64_t &size);
+    };
+}
@@ -0,0 +1,189 @@
+#include "MeshImport.h"
+#include "FlatHashMap.h"
+#include "Utils.h"
+
+#define TINYOBJLOADER_IMPLEMENTATION
+
+#include "tiny_obj_loader/tiny_obj_loader.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+
+namespace engine {
+    static_assert(sizeof(Model::Vertex) == 11 * sizeof(float) + sizeof(int),
+                  "bitwise vertex hashing must not see padding bytes");
+
+    // below this many face vertices per thread the thread start-up costs more than it saves
+    static constexpr size_t MIN_FACE_VERTICES_PER_THREAD = 1 << 16;
+
+    using VertexMap = FlatHashMap<Model::Vertex, uint32_t, VertexBitwiseHash, VertexBitwiseEqual>;
+
+    size_t VertexBitwiseHash::operator()(const Model::Vertex &vertex) const {
+        return static_cast<size_t>(HashBytes(&vertex, sizeof(vertex)));
+    }
+
+    bool VertexBitwiseEqual::operator()(const Model::Vertex &a, const Model::Vertex &b) const {
+        return std::memcmp(&a, &b, sizeof(Model::Vertex)) == 0;
+    }
+
+    namespace {
+        struct Chunk {
+            size_t begin;
+            size_t end;
+            std::vector<Model::Vertex> vertices;
+            // indices into the chunk's own vertices until the merge remaps them
+            std::vector<uint32_t> indices;
+        };
+
+        Model::Vertex buildVertex(const tinyobj::attrib_t &attrib, const tinyobj::index_t &index) {
+            Model::Vertex vertex{};
+
+            if (index.vertex_index >= 0) {
+                vertex.position = {
+                        attrib.vertices[3 * index.vertex_index + 0],
+                        attrib.vertices[3 * index.vertex_index + 1],
+                        attrib.vertices[3 * index.vertex_index + 2]
+                };
+            }
+
+            if (index.normal_index >= 0) {
+                vertex.normal = {
+                        attrib.normals[3 * index.normal_index + 0],
+                        attrib.normals[3 * index.normal_index + 1],
+                        attrib.normals[3 * index.normal_index + 2]
+                };
+            }
+
+            if (index.texcoord_index >= 0) {
+                vertex.uv = {
+                        attrib.texcoords[2 * index.texcoord_index + 0],
+                        1.0f - attrib.texcoords[2 * index.texcoord_index + 1]
+                };
+            }
+
+            vertex.color = {1.0f, 0.5f, 1.0f};
+            // materials do not map to textures yet, every vertex uses texture 0
+            vertex.textureIndex = 0;
+
+            return vertex;
+        }
+
+        void dedupChunk(const tinyobj::attrib_t &attrib, const std::vector<tinyobj::shape_t> &shapes,
+                        const std::vector<size_t> &shapeStarts, Chunk &chunk) {
+            size_t count = chunk.end - chunk.begin;
+            // closed triangle meshes have about one unique vertex per six face vertices
+            VertexMap unique{count / 4};
+            chunk.indices.reserve(count);
+
+            size_t shape = std::upper_bound(shapeStarts.begin(), shapeStarts.end(), chunk.begin) - shapeStarts.begin() - 1;
+            for (size_t i = chunk.begin; i < chunk.end; i++) {
+                while (i >= shapeStarts[shape + 1]) {
+                    shape++;
+                }
+
+                Model::Vertex vertex = buildVertex(attrib, shapes[shape].mesh.indices[i - shapeStarts[shape]]);
+                auto [index, inserted] = unique.tryEmplace(vertex, static_cast<uint32_t>(chunk.vertices.size()));
+                if (inserted) {
+                    chunk.vertices.push_back(vertex);
+                }
+                chunk.indices.push_back(index);
+            }
+        }
+    }
+
+    void ImportObj(const std::string &filepath,
+                   std::vector<Model::Vertex> &vertices,
+                   std::vector<uint32_t> &indices,
+                   uint32_t workerCount,
+                   MeshImportStats *stats) {
+        auto start = std::chrono::high_resolution_clock::now();
+
+        tinyobj::attrib_t attrib;
+        std::vector<tinyobj::shape_t> shapes;
+        std::vector<tinyobj::material_t> materials;
+        std::string err;
+
+        std::string mtlDir = filepath.substr(0, filepath.find_last_of('/') + 1);
+        if (!tinyobj::LoadObj(&attrib, &shapes, &materials, &err, filepath.c_str(), mtlDir.c_str())) {
+            throw std::runtime_error(err);
+        }
+
+        auto parsed = std::chrono::high_resolution_clock::now();
+
+        // face vertices of all shapes as one stream, shapeStarts[s] is where shape s begins
+        std::vector<size_t> shapeStarts{0};
+        for (const auto &shape : shapes) {
+            shapeStarts.push_back(shapeStarts.back() + shape.mesh.indices.size());
+        }
+        size_t total = shapeStarts.back();
+
+        if (workerCount == 0) {
+            workerCount = std::max(1u, std::thread::hardware_concurrency());
+        }
+        auto threadCount = static_cast<uint32_t>(std::clamp<size_t>(total / MIN_FACE_VERTICES_PER_THREAD, 1, workerCount));
+
+        std::vector<Chunk> chunks(threadCount);
+        for (uint32_t c = 0; c < threadCount; c++) {
+            chunks[c].begin = total * c / threadCount;
+            chunks[c].end = total * (c + 1) / threadCount;
+        }
+
+        auto runParallel = [&](auto &&work) {
+            std::vector<std::thread> threads;
+            for (uint32_t c = 1; c < threadCount; c++) {
+                threads.emplace_back(work, c);
+            }
+            work(0);
+            for (auto &thread : threads) {
+                thread.join();
+            }
+        };
+
+        runParallel([&](uint32_t c) { dedupChunk(attrib, shapes, shapeStarts, chunks[c]); });
+
+        // merging the chunks in order keeps the first-occurrence order of a serial dedup
+        size_t uniqueUpperBound = 0;
+        for (auto &chunk : chunks) {
+            uniqueUpperBound += chunk.vertices.size();
+        }
+
+        vertices.clear();
+        vertices.reserve(uniqueUpperBound);
+        VertexMap unique{threadCount > 1 ? uniqueUpperBound : 0};
+        std::vector<std::vector<uint32_t>> remaps(threadCount);
+
+        if (threadCount == 1) {
+            vertices = std::move(chunks[0].vertices);
+        } else {
+            for (uint32_t c = 0; c < threadCount; c++) {
+                remaps[c].resize(chunks[c].vertices.size());
+                for (size_t v = 0; v < chunks[c].vertices.size(); v++) {
+                    const auto &vertex = chunks[c].vertices[v];
+                    auto [index, inserted] = unique.tryEmplace(vertex, static_cast<uint32_t>(vertices.size()));
+                    if (inserted) {
+                        vertices.push_back(vertex);
+                    }
+                    remaps[c][v] = index;
+                }
+            }
+        }
+
+        indices.resize(total);
+        runParallel([&](uint32_t c) {
+            auto &chunk = chunks[c];
+            for (size_t i = 0; i < chunk.indices.size(); i++) {
+                indices[chunk.begin + i] = threadCount == 1 ? chunk.indices[i] : remaps[c][chunk.indices[i]];
+            }
+        });
+
+        if (stats) {
+            auto done = std::chrono::high_resolution_clock::now();
+            stats->parseSeconds = std::chrono::duration<double>(parsed - start).count();
+            stats->dedupSeconds = std::chrono::duration<double>(done - parsed).count();
+            stats->threadCount = threadCount;
+        }
+    }
+}
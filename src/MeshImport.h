@@ -0,0 +1,34 @@
+#pragma once
+
+#include "Model.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace engine {
+    struct MeshImportStats {
+        double parseSeconds = 0.0;
+        double dedupSeconds = 0.0;
+        uint32_t threadCount = 0;
+    };
+
+    // Hash and equality on the raw bytes of a vertex. -0.0f and 0.0f therefore stay distinct,
+    // which only costs a duplicate vertex and keeps the comparison branch free.
+    struct VertexBitwiseHash {
+        size_t operator()(const Model::Vertex &vertex) const;
+    };
+
+    struct VertexBitwiseEqual {
+        bool operator()(const Model::Vertex &a, const Model::Vertex &b) const;
+    };
+
+    // Parses an OBJ file and builds a deduplicated vertex/index list. Face vertices are split into
+    // contiguous ranges that are built and deduplicated on separate threads, then merged in order,
+    // so the result matches a serial first-occurrence dedup exactly. A workerCount of 0 uses every core.
+    void ImportObj(const std::string &filepath,
+                   std::vector<Model::Vertex> &vertices,
+                   std::vector<uint32_t> &indices,
+                   uint32_t workerCount = 0,
+                   MeshImportStats *stats = nullptr);
+}
@@ -0,0 +1,305 @@
+#include "MeshOptimizer.h"
+
+#include <glm/geometric.hpp>
+
+#include <algorithm>
+#include <numeric>
+
+namespace engine {
+    namespace {
+        // FIFO cache simulation: a vertex is cached while fewer than cacheSize misses happened since it was loaded.
+        class FifoCache {
+        public:
+            FifoCache(uint32_t vertexCount, uint32_t cacheSize)
+                    : mLoadedAt(vertexCount, 0), mCacheSize(cacheSize), mTime(cacheSize + 1) {}
+
+            // returns true on a miss
+            bool access(uint32_t vertex) {
+                if (mTime - mLoadedAt[vertex] <= mCacheSize) {
+                    return false;
+                }
+                mLoadedAt[vertex] = mTime++;
+                return true;
+            }
+
+            void flush() { mTime += mCacheSize + 1; }
+
+        private:
+            std::vector<uint32_t> mLoadedAt;
+            uint32_t mCacheSize;
+            uint32_t mTime;
+        };
+
+        // triangles using each vertex, as offsets into one flat array
+        struct Adjacency {
+            std::vector<uint32_t> offsets;
+            std::vector<uint32_t> triangles;
+
+            Adjacency(const std::vector<uint32_t> &indices, uint32_t vertexCount) : offsets(vertexCount + 1, 0) {
+                for (uint32_t index : indices) {
+                    offsets[index + 1]++;
+                }
+                std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+
+                triangles.resize(indices.size());
+                std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+                for (size_t i = 0; i < indices.size(); i++) {
+                    triangles[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+                }
+            }
+
+            [[nodiscard]] uint32_t count(uint32_t vertex) const { return offsets[vertex + 1] - offsets[vertex]; }
+        };
+    }
+
+    VertexCacheStats AnalyzeVertexCache(const std::vector<uint32_t> &indices, uint32_t vertexCount, uint32_t cacheSize) {
+        VertexCacheStats stats;
+        if (indices.empty()) {
+            return stats;
+        }
+
+        FifoCache cache{vertexCount, cacheSize};
+        std::vector<bool> referenced(vertexCount, false);
+        uint32_t misses = 0;
+        uint32_t uniqueVertices = 0;
+
+        for (uint32_t index : indices) {
+            misses += cache.access(index);
+            if (!referenced[index]) {
+                referenced[index] = true;
+                uniqueVertices++;
+            }
+        }
+
+        stats.acmr = static_cast<float>(misses) / static_cast<float>(indices.size() / 3);
+        stats.atvr = static_cast<float>(misses) / static_cast<float>(uniqueVertices);
+        return stats;
+    }
+
+    std::vector<uint32_t> OptimizeVertexCache(std::vector<uint32_t> &indices, uint32_t vertexCount, uint32_t cacheSize) {
+        auto triangleCount = static_cast<uint32_t>(indices.size() / 3);
+        std::vector<uint32_t> clusters;
+        if (triangleCount == 0) {
+            return clusters;
+        }
+
+        Adjacency adjacency{indices, vertexCount};
+
+        std::vector<uint32_t> liveTriangles(vertexCount);
+        for (uint32_t v = 0; v < vertexCount; v++) {
+            liveTriangles[v] = adjacency.count(v);
+        }
+
+        std::vector<uint32_t> cacheTime(vertexCount, 0);
+        std::vector<bool> emitted(triangleCount, false);
+        std::vector<uint32_t> deadEnds;
+        std::vector<uint32_t> candidates;
+        std::vector<uint32_t> result;
+        result.reserve(indices.size());
+
+        uint32_t time = cacheSize + 1;
+        uint32_t cursor = 0;
+
+        // picks a vertex with live triangles when the fan ran into a dead end, starting a new cluster
+        auto skipDeadEnd = [&]() -> int64_t {
+            while (!deadEnds.empty()) {
+                uint32_t vertex = deadEnds.back();
+                deadEnds.pop_back();
+                if (liveTriangles[vertex] > 0) {
+                    return vertex;
+                }
+            }
+            for (; cursor < vertexCount; cursor++) {
+                if (liveTriangles[cursor] > 0) {
+                    return cursor;
+                }
+            }
+            return -1;
+        };
+
+        int64_t fanning = skipDeadEnd();
+        clusters.push_back(0);
+
+        while (fanning >= 0) {
+            candidates.clear();
+
+            for (uint32_t i = adjacency.offsets[fanning]; i < adjacency.offsets[fanning + 1]; i++) {
+                uint32_t triangle = adjacency.triangles[i];
+                if (emitted[triangle]) {
+                    continue;
+                }
+                emitted[triangle] = true;
+
+                for (uint32_t corner = 0; corner < 3; corner++) {
+                    uint32_t vertex = indices[triangle * 3 + corner];
+                    result.push_back(vertex);
+                    deadEnds.push_back(vertex);
+                    candidates.push_back(vertex);
+                    liveTriangles[vertex]--;
+                    if (time - cacheTime[vertex] > cacheSize) {
+                        cacheTime[vertex] = time++;
+                    }
+                }
+            }
+
+            // prefer the candidate that is oldest in the cache while its remaining fan still fits
+            int64_t best = -1;
+            int64_t bestPriority = -1;
+            for (uint32_t vertex : candidates) {
+                if (liveTriangles[vertex] == 0) {
+                    continue;
+                }
+                int64_t priority = 0;
+                if (time - cacheTime[vertex] + 2 * liveTriangles[vertex] <= cacheSize) {
+                    priority = time - cacheTime[vertex];
+                }
+                if (priority > bestPriority) {
+                    bestPriority = priority;
+                    best = vertex;
+                }
+            }
+
+            if (best < 0) {
+                best = skipDeadEnd();
+                if (best >= 0 && result.size() < indices.size()) {
+                    clusters.push_back(static_cast<uint32_t>(result.size() / 3));
+                }
+            }
+            fanning = best;
+        }
+
+        indices = std::move(result);
+        return clusters;
+    }
+
+    void OptimizeOverdraw(std::vector<uint32_t> &indices, const std::vector<Model::Vertex> &vertices,
+                          const std::vector<uint32_t> &clusters, float threshold, uint32_t cacheSize) {
+        auto triangleCount = static_cast<uint32_t>(indices.size() / 3);
+        if (triangleCount == 0 || clusters.empty()) {
+            return;
+        }
+
+        auto vertexCount = static_cast<uint32_t>(vertices.size());
+
+        // split every cluster where the triangles so far are already about as cache efficient as the whole
+        std::vector<uint32_t> splits;
+        FifoCache cache{vertexCount, cacheSize};
+        for (size_t c = 0; c < clusters.size(); c++) {
+            uint32_t begin = clusters[c];
+            uint32_t end = c + 1 < clusters.size() ? clusters[c + 1] : triangleCount;
+
+            cache.flush();
+            uint32_t clusterMisses = 0;
+            for (uint32_t i = begin * 3; i < end * 3; i++) {
+                clusterMisses += cache.access(indices[i]);
+            }
+            float clusterAcmr = static_cast<float>(clusterMisses) / static_cast<float>(end - begin);
+
+            splits.push_back(begin);
+            cache.flush();
+            uint32_t misses = 0;
+            uint32_t start = begin;
+            for (uint32_t t = begin; t < end; t++) {
+                for (uint32_t corner = 0; corner < 3; corner++) {
+                    misses += cache.access(indices[t * 3 + corner]);
+                }
+                auto acmr = static_cast<float>(misses) / static_cast<float>(t + 1 - start);
+                if (t + 1 < end && acmr <= clusterAcmr * threshold && t + 1 - start >= cacheSize) {
+                    // the next triangle starts cold, as it may end up anywhere after sorting
+                    splits.push_back(t + 1);
+                    start = t + 1;
+                    misses = 0;
+                    cache.flush();
+                }
+            }
+        }
+
+        glm::vec3 meshCentroid{0.0f};
+        float meshArea = 0.0f;
+
+        struct Cluster {
+            uint32_t begin;
+            uint32_t end;
+            glm::vec3 centroid{0.0f};
+            glm::vec3 normal{0.0f};
+            float sortKey = 0.0f;
+        };
+        std::vector<Cluster> sorted(splits.size());
+
+        for (size_t c = 0; c < splits.size(); c++) {
+            Cluster &cluster = sorted[c];
+            cluster.begin = splits[c];
+            cluster.end = c + 1 < splits.size() ? splits[c + 1] : triangleCount;
+
+            float area = 0.0f;
+            for (uint32_t t = cluster.begin; t < cluster.end; t++) {
+                const glm::vec3 &a = vertices[indices[t * 3 + 0]].position;
+                const glm::vec3 &b = vertices[indices[t * 3 + 1]].position;
+                const glm::vec3 &p = vertices[indices[t * 3 + 2]].position;
+
+                // twice the area, weighted by it so slivers do not skew the cluster
+                glm::vec3 normal = glm::cross(b - a, p - a);
+                float triangleArea = glm::length(normal);
+
+                cluster.centroid += (a + b + p) * (triangleArea / 3.0f);
+                cluster.normal += normal;
+                area += triangleArea;
+            }
+
+            meshCentroid += cluster.centroid;
+            meshArea += area;
+            cluster.centroid = area > 0.0f ? cluster.centroid / area : vertices[indices[cluster.begin * 3]].position;
+            float normalLength = glm::length(cluster.normal);
+            cluster.normal = normalLength > 0.0f ? cluster.normal / normalLength : glm::vec3{0.0f};
+        }
+
+        if (meshArea > 0.0f) {
+            meshCentroid /= meshArea;
+        }
+
+        for (auto &cluster : sorted) {
+            cluster.sortKey = glm::dot(cluster.centroid - meshCentroid, cluster.normal);
+        }
+
+        std::stable_sort(sorted.begin(), sorted.end(), [](const Cluster &a, const Cluster &b) {
+            return a.sortKey > b.sortKey;
+        });
+
+        std::vector<uint32_t> result;
+        result.reserve(indices.size());
+        for (const auto &cluster : sorted) {
+            result.insert(result.end(), indices.begin() + cluster.begin * 3, indices.begin() + cluster.end * 3);
+        }
+        indices = std::move(result);
+    }
+
+    void OptimizeVertexFetch(std::vector<Model::Vertex> &vertices, std::vector<uint32_t> &indices) {
+        constexpr uint32_t UNUSED = ~0u;
+        std::vector<uint32_t> remap(vertices.size(), UNUSED);
+        std::vector<Model::Vertex> result;
+        result.reserve(vertices.size());
+
+        for (uint32_t &index : indices) {
+            if (remap[index] == UNUSED) {
+                remap[index] = static_cast<uint32_t>(result.size());
+                result.push_back(vertices[index]);
+            }
+            index = remap[index];
+        }
+
+        vertices = std::move(result);
+    }
+
+    MeshOptimizationStats OptimizeMesh(std::vector<Model::Vertex> &vertices, std::vector<uint32_t> &indices) {
+        MeshOptimizationStats stats;
+        auto vertexCount = static_cast<uint32_t>(vertices.size());
+        stats.before = AnalyzeVertexCache(indices, vertexCount);
+
+        std::vector<uint32_t> clusters = OptimizeVertexCache(indices, vertexCount);
+        OptimizeOverdraw(indices, vertices, clusters);
+        OptimizeVertexFetch(vertices, indices);
+
+        stats.after = AnalyzeVertexCache(indices, static_cast<uint32_t>(vertices.size()));
+        return stats;
+    }
+}
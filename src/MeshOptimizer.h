@@ -0,0 +1,47 @@
+#pragma once
+
+#include "Model.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace engine {
+    // Post-transform vertex cache efficiency of an index buffer, simulated with a FIFO cache.
+    struct VertexCacheStats {
+        // cache misses per triangle, 0.5 is the best a regular grid can do and 3 the worst
+        float acmr = 0.0f;
+        // cache misses per referenced vertex, 1 is optimal
+        float atvr = 0.0f;
+    };
+
+    struct MeshOptimizationStats {
+        VertexCacheStats before;
+        VertexCacheStats after;
+    };
+
+    // size of the post-transform cache modelled by the optimizer, small enough to be pessimistic on current GPUs
+    static constexpr uint32_t VERTEX_CACHE_SIZE = 16;
+
+    VertexCacheStats AnalyzeVertexCache(const std::vector<uint32_t> &indices, uint32_t vertexCount,
+                                        uint32_t cacheSize = VERTEX_CACHE_SIZE);
+
+    // Reorders triangles for vertex cache locality (Tipsify, Sander et al. 2007). Returns the
+    // first triangle of every cluster: ranges that are cache efficient on their own, so their
+    // order can be changed without losing much locality.
+    std::vector<uint32_t> OptimizeVertexCache(std::vector<uint32_t> &indices, uint32_t vertexCount,
+                                              uint32_t cacheSize = VERTEX_CACHE_SIZE);
+
+    // Sorts the clusters so that those facing away from the mesh centre come first; they tend to
+    // occlude the rest from any direction. Clusters are split further until each one's ACMR is
+    // within threshold of its surroundings, trading a little cache efficiency for finer sorting.
+    void OptimizeOverdraw(std::vector<uint32_t> &indices, const std::vector<Model::Vertex> &vertices,
+                          const std::vector<uint32_t> &clusters, float threshold = 1.05f,
+                          uint32_t cacheSize = VERTEX_CACHE_SIZE);
+
+    // Renumbers vertices in the order the index buffer first uses them so vertex fetch reads the
+    // buffer mostly sequentially. Unreferenced vertices are dropped.
+    void OptimizeVertexFetch(std::vector<Model::Vertex> &vertices, std::vector<uint32_t> &indices);
+
+    // All of the above, in that order.
+    MeshOptimizationStats OptimizeMesh(std::vector<Model::Vertex> &vertices, std::vector<uint32_t> &indices);
+}
@@ -0,0 +1,309 @@
+#include "MeshSimplifier.h"
+#include "FlatHashMap.h"
+#include "MeshOptimizer.h"
+
+#include <glm/geometric.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace engine {
+    namespace {
+        // Sum of squared distances to a set of planes, kept as the upper half of a symmetric 4x4
+        // matrix, and the total area of the triangles the planes came from.
+        struct Quadric {
+            double a00 = 0, a01 = 0, a02 = 0, a03 = 0;
+            double a11 = 0, a12 = 0, a13 = 0;
+            double a22 = 0, a23 = 0;
+            double a33 = 0;
+            double weight = 0;
+
+            static Quadric FromPlane(const glm::dvec3 &normal, double d, double weight) {
+                Quadric q;
+                q.a00 = normal.x * normal.x * weight;
+                q.a01 = normal.x * normal.y * weight;
+                q.a02 = normal.x * normal.z * weight;
+                q.a03 = normal.x * d * weight;
+                q.a11 = normal.y * normal.y * weight;
+                q.a12 = normal.y * normal.z * weight;
+                q.a13 = normal.y * d * weight;
+                q.a22 = normal.z * normal.z * weight;
+                q.a23 = normal.z * d * weight;
+                q.a33 = d * d * weight;
+                q.weight = weight;
+                return q;
+            }
+
+            Quadric &operator+=(const Quadric &other) {
+                a00 += other.a00; a01 += other.a01; a02 += other.a02; a03 += other.a03;
+                a11 += other.a11; a12 += other.a12; a13 += other.a13;
+                a22 += other.a22; a23 += other.a23;
+                a33 += other.a33;
+                weight += other.weight;
+                return *this;
+            }
+
+            // mean squared distance of the point to the planes
+            [[nodiscard]] double Error(const glm::vec3 &point) const {
+                double x = point.x, y = point.y, z = point.z;
+                double error = a00 * x * x + 2 * a01 * x * y + 2 * a02 * x * z + 2 * a03 * x
+                               + a11 * y * y + 2 * a12 * y * z + 2 * a13 * y
+                               + a22 * z * z + 2 * a23 * z
+                               + a33;
+                return weight > 0 ? std::max(error, 0.0) / weight : 0.0;
+            }
+        };
+
+        struct PositionHash {
+            size_t operator()(const glm::vec3 &position) const {
+                // adding zero turns -0 into 0, which compare equal
+                glm::vec3 normalized = position + glm::vec3{0.0f};
+                return static_cast<size_t>(HashBytes(&normalized, sizeof(normalized)));
+            }
+        };
+
+        struct Collapse {
+            uint32_t from;
+            uint32_t to;
+            double error;
+        };
+
+        uint64_t edgeKey(uint32_t a, uint32_t b) {
+            return a < b ? (uint64_t(a) << 32) | b : (uint64_t(b) << 32) | a;
+        }
+    }
+
+    std::vector<uint32_t> SimplifyMesh(const std::vector<Model::Vertex> &vertices,
+                                       const std::vector<uint32_t> &indices,
+                                       size_t targetIndexCount, float maxError, float *error) {
+        auto vertexCount = static_cast<uint32_t>(vertices.size());
+        std::vector<uint32_t> result = indices;
+        double resultError = 0.0;
+
+        // vertices split along UV or normal seams share a position, the topology is built on that
+        std::vector<uint32_t> positionOf(vertexCount);
+        std::vector<bool> locked(vertexCount, false);
+        {
+            FlatHashMap<glm::vec3, uint32_t, PositionHash> firstWithPosition{vertexCount};
+            for (uint32_t v = 0; v < vertexCount; v++) {
+                auto [first, inserted] = firstWithPosition.tryEmplace(vertices[v].position, v);
+                positionOf[v] = first;
+                if (!inserted) {
+                    locked[v] = true;
+                    locked[first] = true;
+                }
+            }
+        }
+
+        // edges with only one triangle are open borders, with more than two non-manifold
+        {
+            FlatHashMap<uint64_t, uint32_t> edgeUses{result.size()};
+            for (size_t i = 0; i < result.size(); i += 3) {
+                for (int e = 0; e < 3; e++) {
+                    uint64_t key = edgeKey(positionOf[result[i + e]], positionOf[result[i + (e + 1) % 3]]);
+                    edgeUses.tryEmplace(key, 0).first++;
+                }
+            }
+            for (size_t i = 0; i < result.size(); i += 3) {
+                for (int e = 0; e < 3; e++) {
+                    uint32_t a = result[i + e];
+                    uint32_t b = result[i + (e + 1) % 3];
+                    if (*edgeUses.find(edgeKey(positionOf[a], positionOf[b])) != 2) {
+                        locked[a] = true;
+                        locked[b] = true;
+                    }
+                }
+            }
+        }
+
+        std::vector<Quadric> quadrics(vertexCount);
+        for (size_t i = 0; i < result.size(); i += 3) {
+            glm::dvec3 a = vertices[result[i + 0]].position;
+            glm::dvec3 b = vertices[result[i + 1]].position;
+            glm::dvec3 c = vertices[result[i + 2]].position;
+
+            glm::dvec3 normal = glm::cross(b - a, c - a);
+            double area = glm::length(normal);
+            if (area == 0.0) {
+                continue;
+            }
+            normal /= area;
+
+            Quadric q = Quadric::FromPlane(normal, -glm::dot(normal, a), area);
+            for (int corner = 0; corner < 3; corner++) {
+                quadrics[positionOf[result[i + corner]]] += q;
+            }
+        }
+
+        double maxErrorSquared = double(maxError) * maxError;
+        std::vector<uint32_t> remap(vertexCount);
+        std::vector<bool> touched(vertexCount);
+        std::vector<Collapse> collapses;
+        std::vector<uint32_t> adjacencyOffsets(vertexCount + 1);
+        std::vector<uint32_t> adjacency;
+
+        while (result.size() > targetIndexCount) {
+            // every edge in both directions, as long as the vertex that moves is free to
+            collapses.clear();
+            for (size_t i = 0; i < result.size(); i += 3) {
+                for (int e = 0; e < 3; e++) {
+                    uint32_t from = result[i + e];
+                    uint32_t to = result[i + (e + 1) % 3];
+                    if (locked[from]) {
+                        continue;
+                    }
+                    Quadric q = quadrics[from];
+                    q += quadrics[positionOf[to]];
+                    double collapseError = q.Error(vertices[to].position);
+                    if (collapseError <= maxErrorSquared) {
+                        collapses.push_back({from, to, collapseError});
+                    }
+                }
+            }
+            if (collapses.empty()) {
+                break;
+            }
+            std::sort(collapses.begin(), collapses.end(), [](const Collapse &a, const Collapse &b) {
+                return a.error < b.error;
+            });
+
+            // triangles around every vertex, to check collapses for flipped triangles
+            std::fill(adjacencyOffsets.begin(), adjacencyOffsets.end(), 0);
+            for (uint32_t index : result) {
+                adjacencyOffsets[index + 1]++;
+            }
+            for (uint32_t v = 0; v < vertexCount; v++) {
+                adjacencyOffsets[v + 1] += adjacencyOffsets[v];
+            }
+            adjacency.resize(result.size());
+            {
+                std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+                for (size_t i = 0; i < result.size(); i++) {
+                    adjacency[fill[result[i]]++] = static_cast<uint32_t>(i / 3);
+                }
+            }
+
+            for (uint32_t v = 0; v < vertexCount; v++) {
+                remap[v] = v;
+            }
+            std::fill(touched.begin(), touched.end(), false);
+
+            // each collapse removes about two triangles, stop once that would reach the target
+            size_t trianglesToRemove = (result.size() - targetIndexCount) / 3;
+            size_t removed = 0;
+
+            for (const auto &collapse : collapses) {
+                if (removed >= trianglesToRemove) {
+                    break;
+                }
+                if (touched[collapse.from] || touched[collapse.to]) {
+                    continue;
+                }
+
+                // the collapse must not flip any triangle around the moving vertex, and those
+                // triangles must not have changed earlier in this pass
+                bool valid = true;
+                const glm::vec3 &target = vertices[collapse.to].position;
+                for (uint32_t i = adjacencyOffsets[collapse.from]; i < adjacencyOffsets[collapse.from + 1] && valid; i++) {
+                    const uint32_t *triangle = &result[adjacency[i] * 3];
+                    glm::vec3 before[3];
+                    glm::vec3 after[3];
+                    bool containsTarget = false;
+                    for (int corner = 0; corner < 3; corner++) {
+                        valid &= !touched[triangle[corner]];
+                        containsTarget |= positionOf[triangle[corner]] == positionOf[collapse.to];
+                        before[corner] = vertices[triangle[corner]].position;
+                        after[corner] = triangle[corner] == collapse.from ? target : before[corner];
+                    }
+                    if (!valid || containsTarget) {
+                        continue;
+                    }
+                    glm::vec3 normalBefore = glm::cross(before[1] - before[0], before[2] - before[0]);
+                    glm::vec3 normalAfter = glm::cross(after[1] - after[0], after[2] - after[0]);
+                    valid = glm::dot(normalBefore, normalAfter) > 0.0f;
+                }
+                if (!valid) {
+                    continue;
+                }
+
+                remap[collapse.from] = collapse.to;
+                quadrics[positionOf[collapse.to]] += quadrics[collapse.from];
+                touched[collapse.from] = true;
+                touched[collapse.to] = true;
+                for (uint32_t i = adjacencyOffsets[collapse.from]; i < adjacencyOffsets[collapse.from + 1]; i++) {
+                    const uint32_t *triangle = &result[adjacency[i] * 3];
+                    for (int corner = 0; corner < 3; corner++) {
+                        touched[triangle[corner]] = true;
+                    }
+                }
+                resultError = std::max(resultError, collapse.error);
+                removed += 2;
+            }
+
+            if (removed == 0) {
+                break;
+            }
+
+            // apply the collapses and drop the triangles that became degenerate
+            size_t write = 0;
+            for (size_t i = 0; i < result.size(); i += 3) {
+                uint32_t a = remap[result[i + 0]];
+                uint32_t b = remap[result[i + 1]];
+                uint32_t c = remap[result[i + 2]];
+                if (positionOf[a] == positionOf[b] || positionOf[b] == positionOf[c] || positionOf[c] == positionOf[a]) {
+                    continue;
+                }
+                result[write++] = a;
+                result[write++] = b;
+                result[write++] = c;
+            }
+            result.resize(write);
+        }
+
+        if (error) {
+            *error = static_cast<float>(std::sqrt(resultError));
+        }
+        return result;
+    }
+
+    void GenerateLods(Model::Builder &builder, uint32_t lodCount, float reduction, float maxError) {
+        builder.lods.clear();
+        builder.lods.push_back({0, static_cast<uint32_t>(builder.indices.size()), 0.0f});
+        if (builder.vertices.empty() || builder.indices.empty()) {
+            return;
+        }
+
+        glm::vec3 minExtent = builder.vertices[0].position;
+        glm::vec3 maxExtent = builder.vertices[0].position;
+        for (const auto &vertex : builder.vertices) {
+            minExtent = glm::min(minExtent, vertex.position);
+            maxExtent = glm::max(maxExtent, vertex.position);
+        }
+        float absoluteMaxError = glm::length(maxExtent - minExtent) * maxError;
+
+        std::vector<uint32_t> previous = builder.indices;
+        auto vertexCount = static_cast<uint32_t>(builder.vertices.size());
+
+        for (uint32_t lod = 1; lod < lodCount; lod++) {
+            auto target = static_cast<size_t>(static_cast<float>(previous.size() / 3) * reduction) * 3;
+
+            float error = 0.0f;
+            std::vector<uint32_t> simplified = SimplifyMesh(builder.vertices, previous, target, absoluteMaxError, &error);
+            // not worth a level of its own
+            if (simplified.empty() || simplified.size() > previous.size() * 9 / 10) {
+                break;
+            }
+            OptimizeVertexCache(simplified, vertexCount);
+
+            // each level is simplified from the one before, so the deviation from the original adds up
+            Model::Lod level{};
+            level.firstIndex = static_cast<uint32_t>(builder.indices.size());
+            level.indexCount = static_cast<uint32_t>(simplified.size());
+            level.error = builder.lods.back().error + error;
+            builder.lods.push_back(level);
+
+            builder.indices.insert(builder.indices.end(), simplified.begin(), simplified.end());
+            previous = std::move(simplified);
+        }
+    }
+}
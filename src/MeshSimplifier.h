@@ -0,0 +1,22 @@
+#pragma once
+
+#include "Model.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace engine {
+    // Collapses edges in order of their quadric error (Garland and Heckbert 1997) until the mesh has
+    // at most targetIndexCount indices or the next collapse would move the surface by more than
+    // maxError, in object space units. Vertices only ever collapse onto existing vertices, so the
+    // result indexes the same vertex buffer. UV seams and open borders are kept in place.
+    // Returns the new index list; error receives the largest deviation it introduced.
+    std::vector<uint32_t> SimplifyMesh(const std::vector<Model::Vertex> &vertices,
+                                       const std::vector<uint32_t> &indices,
+                                       size_t targetIndexCount, float maxError, float *error = nullptr);
+
+    // Appends lodCount - 1 coarser index lists to builder.indices, each with about reduction times
+    // the triangles of the previous one, and records every level in builder.lods. Stops early once
+    // the mesh cannot be simplified further. maxError is relative to the size of the mesh.
+    void GenerateLods(Model::Builder &builder, uint32_t lodCount = 4, float reduction = 0.5f, float maxError = 0.05f);
+}
@@ -1,58 +1,77 @@
 #include "Model.h"
+#include "MeshCache.h"
+#include "MeshImport.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
 
 #include <vulkan/vulkan_core.h>
 
-#define TINYOBJLOADER_IMPLEMENTATION
-
-#include "tiny_obj_loader/tiny_obj_loader.h"
-
-#define GLM_ENABLE_EXPERIMENTAL
-
-#include <glm/gtx/hash.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/packing.hpp>
 
+#include <algorithm>
 #include <cassert>
+#include <cmath>
 #include <cstddef>
 #include <cstring>
 #include <iostream>
 #include <memory>
 
-namespace std {
-    template<>
-    struct hash<engine::Model::Vertex> {
-        size_t operator()(engine::Model::Vertex const &vertex) const {
-            size_t seed = 0;
-            engine::HashCombine(seed, vertex.position, vertex.color, vertex.normal, vertex.uv);
-            return seed;
-        }
-    };
-}
-
 namespace engine {
-    Model::Model(Device &device, const Builder &builder)
-            : m_Device(device) {
-        CreateVertexBuffers(builder.vertices);
-        CreateIndexBuffer(builder.indices);
-        FindMinMaxExtent(builder.vertices);
+    static_assert(sizeof(Model::PackedVertex) == 20, "PackedVertex must stay tightly packed");
+
+    Model::Model(Device &device, const Builder &builder, VertexFormat format)
+            : Model(device, builder.vertices.data(), static_cast<uint32_t>(builder.vertices.size()),
+                    builder.indices.data(), static_cast<uint32_t>(builder.indices.size()), format,
+                    builder.lods.data(), static_cast<uint32_t>(builder.lods.size())) {
     }
 
-    void Model::CreateVertexBuffers(const std::vector<Vertex> &vertices) {
-        m_VertexCount = static_cast<uint32_t>(vertices.size());
+    Model::Model(Device &device, const Vertex *vertices, uint32_t vertexCount, const uint32_t *indices,
+                 uint32_t indexCount, VertexFormat format, const Lod *lods, uint32_t lodCount)
+            : m_Device(device), m_VertexFormat(format) {
+        // the packed format quantizes against the extents, so they have to be known first
+        FindMinMaxExtent(vertices, vertexCount);
+        CreateVertexBuffers(vertices, vertexCount);
+        CreateIndexBuffer(indices, indexCount);
+
+        if (lodCount > 0) {
+            m_Lods.assign(lods, lods + lodCount);
+        } else {
+            m_Lods.push_back({0, indexCount, 0.0f});
+        }
+    }
+
+    void Model::CreateVertexBuffers(const Vertex *vertices, uint32_t vertexCount) {
+        m_VertexCount = vertexCount;
         assert(m_VertexCount >= 3 && "Vertex count must be at least 3");
-        VkDeviceSize bufferSize = sizeof(vertices[0]) * m_VertexCount;
-        uint32_t vertexSize = sizeof(vertices[0]);
+
+        if (m_VertexFormat == VertexFormat::Full) {
+            UploadVertexBuffer(vertices, sizeof(Vertex), vertexCount);
+            return;
+        }
+
+        std::vector<PackedVertex> packed(vertexCount);
+        for (uint32_t i = 0; i < vertexCount; i++) {
+            packed[i] = PackedVertex::Pack(vertices[i], mMinExtent, mMaxExtent);
+        }
+        UploadVertexBuffer(packed.data(), sizeof(PackedVertex), vertexCount);
+    }
+
+    void Model::UploadVertexBuffer(const void *vertices, uint32_t vertexSize, uint32_t vertexCount) {
+        VkDeviceSize bufferSize = static_cast<VkDeviceSize>(vertexSize) * vertexCount;
 
         Buffer stagingBuffer{
                 m_Device,
                 vertexSize,
-                m_VertexCount,
+                vertexCount,
                 VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
                 VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
         };
 
         stagingBuffer.map();
-        stagingBuffer.writeToBuffer((void *) vertices.data());
+        stagingBuffer.writeToBuffer(const_cast<void *>(vertices));
 
-        m_VertexBuffer = std::make_unique<Buffer>(m_Device, vertexSize, m_VertexCount,
+        m_VertexBuffer = std::make_unique<Buffer>(m_Device, vertexSize, vertexCount,
                                                   VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
                                                   VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
         );
@@ -60,8 +79,8 @@ namespace engine {
         m_Device.copyBuffer(stagingBuffer.getBuffer(), m_VertexBuffer->getBuffer(), bufferSize);
     }
 
-    void Model::CreateIndexBuffer(const std::vector<uint32_t> &indices) {
-        m_IndexCount = static_cast<uint32_t>(indices.size());
+    void Model::CreateIndexBuffer(const uint32_t *indices, uint32_t indexCount) {
+        m_IndexCount = indexCount;
         m_HasIndexBuffer = m_IndexCount > 0;
 
         if (!m_HasIndexBuffer) {
@@ -81,7 +100,7 @@ namespace engine {
         };
 
         stagingBuffer.map();
-        stagingBuffer.writeToBuffer((void *) indices.data());
+        stagingBuffer.writeToBuffer((void *) indices);
 
         m_IndexBuffer = std::make_unique<Buffer>(
                 m_Device,
@@ -95,29 +114,38 @@ namespace engine {
         m_Device.copyBuffer(stagingBuffer.getBuffer(), m_IndexBuffer->getBuffer(), bufferSize);
     }
 
-    void Model::Draw(VkCommandBuffer commandBuffer) const {
+    void Model::Draw(VkCommandBuffer commandBuffer, uint32_t lod) const {
         if (m_HasIndexBuffer) {
-            vkCmdDrawIndexed(commandBuffer, m_IndexCount, 1, 0, 0, 0);
+            const Lod &level = m_Lods[std::min(lod, GetLodCount() - 1)];
+            m_Device.dispatch().vkCmdDrawIndexed(commandBuffer, level.indexCount, 1, level.firstIndex, 0, 0);
         } else {
-            vkCmdDraw(commandBuffer, m_VertexCount, 1, 0, 0);
+            m_Device.dispatch().vkCmdDraw(commandBuffer, m_VertexCount, 1, 0, 0);
         }
     }
 
     void Model::Bind(VkCommandBuffer commandBuffer) {
         VkBuffer buffers[] = {m_VertexBuffer->getBuffer()};
         VkDeviceSize offsets[] = {0};
-        vkCmdBindVertexBuffers(commandBuffer, 0, 1, buffers, offsets);
+        m_Device.dispatch().vkCmdBindVertexBuffers(commandBuffer, 0, 1, buffers, offsets);
 
         if (m_HasIndexBuffer) {
-            vkCmdBindIndexBuffer(commandBuffer, m_IndexBuffer->getBuffer(), 0, VK_INDEX_TYPE_UINT32);
+            m_Device.dispatch().vkCmdBindIndexBuffer(commandBuffer, m_IndexBuffer->getBuffer(), 0, VK_INDEX_TYPE_UINT32);
         }
     }
 
-    std::unique_ptr<Model> Model::CreateModelFromFile(Device &device, const std::string &filepath) {
+    std::unique_ptr<Model> Model::CreateModelFromFile(Device &device, const std::string &filepath,
+                                                      VertexFormat format) {
+        if (auto cached = MeshCache::Load(filepath)) {
+            std::cout << "Vertex count: " << cached->vertexCount() << " (cached)" << std::endl;
+            return std::make_unique<Model>(device, cached->vertices(), cached->vertexCount(),
+                                           cached->indices(), cached->indexCount(), format,
+                                           cached->lods(), cached->lodCount());
+        }
+
         Builder builder{};
-        builder.LoadModel(filepath);
-        std::cout << "Vertex count: " << builder.vertices.size() << std::endl;
-        return std::make_unique<Model>(device, builder);
+        builder.Cook(filepath);
+
+        return std::make_unique<Model>(device, builder, format);
     }
 
     glm::vec3 Model::GetMinExtents() const {
@@ -128,11 +156,46 @@ namespace engine {
         return mMaxExtent;
     }
 
-    void Model::FindMinMaxExtent(const std::vector<Vertex>& vertices) {
+    uint32_t Model::SelectLod(const glm::mat4 &modelMatrix, const glm::vec3 &cameraPosition,
+                              float projectionScale, float pixelError) const {
+        glm::vec3 center = modelMatrix * glm::vec4{(mMinExtent + mMaxExtent) * 0.5f, 1.0f};
+        float scale = std::max({glm::length(glm::vec3{modelMatrix[0]}),
+                                glm::length(glm::vec3{modelMatrix[1]}),
+                                glm::length(glm::vec3{modelMatrix[2]})});
+        float radius = glm::length(mMaxExtent - mMinExtent) * 0.5f * scale;
+
+        // distance to the nearest point of the bounding sphere, inside it we always want full detail
+        float distance = glm::length(center - cameraPosition) - radius;
+        if (distance <= 0.0f) {
+            return 0;
+        }
+
+        for (auto lod = static_cast<uint32_t>(m_Lods.size()) - 1; lod > 0; lod--) {
+            if (m_Lods[lod].error * scale * projectionScale / distance <= pixelError) {
+                return lod;
+            }
+        }
+        return 0;
+    }
+
+    float Model::ProjectionScale(float fovY, float viewportHeight) {
+        return viewportHeight / (2.0f * std::tan(fovY * 0.5f));
+    }
+
+    glm::mat4 Model::GetDequantization() const {
+        if (m_VertexFormat == VertexFormat::Full) {
+            return glm::mat4{1.0f};
+        }
+        // the UNORM positions arrive in [0, 1], scale them back over the bounds they were quantized in
+        glm::mat4 dequantization = glm::translate(glm::mat4{1.0f}, mMinExtent);
+        return glm::scale(dequantization, mMaxExtent - mMinExtent);
+    }
+
+    void Model::FindMinMaxExtent(const Vertex *vertices, uint32_t vertexCount) {
         mMinExtent = vertices[0].position;
         mMaxExtent = vertices[0].position;
 
-        for (uint32_t i = 1; i < vertices.size(); i++) {
+        for (uint32_t i = 1; i < vertexCount; i++) {
             mMinExtent.x = std::min(mMinExtent.x, vertices[i].position.x);
             mMinExtent.y = std::min(mMinExtent.y, vertices[i].position.y);
             mMinExtent.z = std::min(mMinExtent.z, vertices[i].position.z);
@@ -164,77 +227,82 @@ namespace engine {
         return attributeDescriptions;
     }
 
-    void Model::Builder::LoadModel(const std::string &filepath) {
-        tinyobj::attrib_t attrib;
-        std::vector<tinyobj::shape_t> shapes;
-        std::vector<tinyobj::material_t> materials;
-        std::string err;
-
-        std::string mtlDir = filepath.substr(0, filepath.find_last_of('/') + 1);
-        if (!tinyobj::LoadObj(&attrib, &shapes, &materials, &err, filepath.c_str(), mtlDir.c_str())) {
-            throw std::runtime_error(err);
+    Model::PackedVertex Model::PackedVertex::Pack(const Vertex &vertex, glm::vec3 minExtent, glm::vec3 maxExtent) {
+        PackedVertex packed{};
+
+        glm::vec3 extent = maxExtent - minExtent;
+        for (int axis = 0; axis < 3; axis++) {
+            // flat axes keep 0, the dequantization scale for them is 0 as well
+            float t = extent[axis] > 0.0f ? (vertex.position[axis] - minExtent[axis]) / extent[axis] : 0.0f;
+            packed.position[axis] = static_cast<uint16_t>(std::lround(glm::clamp(t, 0.0f, 1.0f) * 65535.0f));
         }
+        packed.textureIndex = static_cast<int16_t>(vertex.textureIndex);
+
+        // octahedral mapping: project onto |x| + |y| + |z| = 1 and fold the lower half over the diagonals
+        glm::vec3 n = vertex.normal;
+        float l1 = std::abs(n.x) + std::abs(n.y) + std::abs(n.z);
+        glm::vec2 octahedral = l1 > 0.0f ? glm::vec2{n.x, n.y} / l1 : glm::vec2{0.0f};
+        if (n.z < 0.0f) {
+            octahedral = (1.0f - glm::abs(glm::vec2{octahedral.y, octahedral.x})) *
+                         glm::vec2{octahedral.x >= 0.0f ? 1.0f : -1.0f, octahedral.y >= 0.0f ? 1.0f : -1.0f};
+        }
+        uint32_t normal = glm::packSnorm2x16(octahedral);
+        std::memcpy(packed.normal, &normal, sizeof(packed.normal));
 
-        vertices.clear();
-        indices.clear();
-
-        std::unordered_map<Vertex, uint32_t> uniqueVertices{};
-        for (const auto &shape: shapes) {
-            size_t indexOffset = 0;
-            for (size_t f = 0; f < shape.mesh.num_face_vertices.size(); f++) {
-                int fv = shape.mesh.num_face_vertices[f];
-
-                // Get the material ID for the current face
-                int materialId = shape.mesh.material_ids[f];
-
-                for (size_t v = 0; v < fv; v++) {
-                    tinyobj::index_t index = shape.mesh.indices[indexOffset + v];
-
-                    Vertex vertex{};
-
-                    if (index.vertex_index >= 0) {
-                        vertex.position = {
-                                attrib.vertices[3 * index.vertex_index + 0],
-                                attrib.vertices[3 * index.vertex_index + 1],
-                                attrib.vertices[3 * index.vertex_index + 2]
-                        };
-                    }
-
-                    if (index.normal_index >= 0) {
-                        vertex.normal = {
-                                attrib.normals[3 * index.normal_index + 0],
-                                attrib.normals[3 * index.normal_index + 1],
-                                attrib.normals[3 * index.normal_index + 2]
-                        };
-                    }
-
-                    if (index.texcoord_index >= 0) {
-                        vertex.uv = {
-                                attrib.texcoords[2 * index.texcoord_index + 0],
-                                1.0f - attrib.texcoords[2 * index.texcoord_index + 1]
-                        };
-                    }
-
-                    vertex.color = {1.0f, 0.5f, 1.0f};
-
-                    // Use the material ID to access the corresponding material
-                    if (materialId >= 0 && materialId < materials.size()) {
-                        const tinyobj::material_t &material = materials[materialId];
-                        // Access material properties, texture maps, etc.
-                        // For example, to get the diffuse texture map:
-                        std::string diffuseTexName = material.diffuse_texname;
-                        // Load and assign the diffuse texture index to the vertex
-                        vertex.textureIndex = 0;
-                    }
-
-                    if (uniqueVertices.count(vertex) == 0) {
-                        uniqueVertices[vertex] = static_cast<uint32_t>(vertices.size());
-                        vertices.push_back(vertex);
-                    }
-                    indices.push_back(uniqueVertices[vertex]);
-                }
-                indexOffset += fv;
-            }
+        uint32_t uv = glm::packHalf2x16(vertex.uv);
+        std::memcpy(packed.uv, &uv, sizeof(packed.uv));
+
+        uint32_t color = glm::packUnorm4x8(glm::vec4{vertex.color, 1.0f});
+        std::memcpy(packed.color, &color, sizeof(packed.color));
+
+        return packed;
+    }
+
+    std::vector<VkVertexInputBindingDescription> Model::PackedVertex::getBindingsDescriptions() {
+        std::vector<VkVertexInputBindingDescription> bindingDescriptions(1);
+        bindingDescriptions[0].binding = 0;
+        bindingDescriptions[0].stride = sizeof(PackedVertex);
+        bindingDescriptions[0].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+        return bindingDescriptions;
+    }
+
+    // Same locations as Vertex, so shaders only change in how they decode. R16G16B16_UNORM is not a
+    // required vertex format, so the position is read as four components and the texture index
+    // overlaps its w.
+    std::vector<VkVertexInputAttributeDescription>
+    Model::PackedVertex::getAttributeDescriptions() {
+        std::vector<VkVertexInputAttributeDescription> attributeDescriptions{};
+
+        attributeDescriptions.push_back({0, 0, VK_FORMAT_R16G16B16A16_UNORM, offsetof(PackedVertex, position)});
+        attributeDescriptions.push_back({1, 0, VK_FORMAT_R8G8B8A8_UNORM, offsetof(PackedVertex, color)});
+        attributeDescriptions.push_back({2, 0, VK_FORMAT_R16G16_SNORM, offsetof(PackedVertex, normal)});
+        attributeDescriptions.push_back({3, 0, VK_FORMAT_R16G16_SFLOAT, offsetof(PackedVertex, uv)});
+        attributeDescriptions.push_back({4, 0, VK_FORMAT_R16_SINT, offsetof(PackedVertex, textureIndex)});
+
+        return attributeDescriptions;
+    }
+
+    void Model::Builder::Cook(const std::string &filepath) {
+        LoadModel(filepath);
+        std::cout << "Vertex count: " << vertices.size() << std::endl;
+
+        // only done when cooking, the cache stores the optimized order
+        MeshOptimizationStats stats = OptimizeMesh(vertices, indices);
+        std::cout << "ACMR " << stats.before.acmr << " -> " << stats.after.acmr
+                  << ", ATVR " << stats.before.atvr << " -> " << stats.after.atvr << std::endl;
+
+        GenerateLods(*this);
+        std::cout << "LODs: " << lods.size() << std::endl;
+
+        try {
+            MeshCache::Write(filepath, *this);
+        } catch (const std::exception &e) {
+            // a read-only asset directory only costs us the cache
+            std::cerr << "failed to write mesh cache: " << e.what() << std::endl;
         }
     }
+
+    void Model::Builder::LoadModel(const std::string &filepath) {
+        ImportObj(filepath, vertices, indices);
+    }
 } // namespace engine
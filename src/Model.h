@@ -20,7 +20,7 @@ namespace engine {
             glm::vec3 color{};
             glm::vec3 normal{};
             glm::vec2 uv{};
-            int textureIndex;
+            int textureIndex = 0;
 
             static std::vector<VkVertexInputBindingDescription>
             getBindingsDescriptions();
@@ -33,14 +33,61 @@ namespace engine {
             }
         };
 
+        // 20 byte vertex for static meshes, less than half the bandwidth and memory of Vertex.
+        // The position is quantized to 16 bits inside the mesh bounds and is brought back to
+        // object space by folding GetDequantization() into the model matrix; the normal matrix
+        // stays as it is. The normal is octahedral encoded and decoded in the vertex shader:
+        //   vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+        //   if (n.z < 0.0) n.xy = (1.0 - abs(n.yx)) * sign(n.xy);
+        //   normal = normalize(n);
+        // The texture index is R16_SINT, so it is read as the same `int` as Vertex::textureIndex.
+        struct PackedVertex {
+            uint16_t position[3];
+            int16_t textureIndex;
+            int16_t normal[2];
+            // half floats
+            uint16_t uv[2];
+            uint8_t color[4];
+
+            static PackedVertex Pack(const Vertex &vertex, glm::vec3 minExtent, glm::vec3 maxExtent);
+
+            static std::vector<VkVertexInputBindingDescription>
+            getBindingsDescriptions();
+
+            static std::vector<VkVertexInputAttributeDescription>
+            getAttributeDescriptions();
+        };
+
+        enum class VertexFormat {
+            Full,
+            Packed
+        };
+
+        // Range of the index buffer holding one level of detail. error is how far, in object
+        // space, the level deviates from the full mesh.
+        struct Lod {
+            uint32_t firstIndex;
+            uint32_t indexCount;
+            float error;
+        };
+
         struct Builder {
             std::vector<Vertex> vertices{};
             std::vector<uint32_t> indices{};
+            // empty when indices is a single level
+            std::vector<Lod> lods{};
 
             void LoadModel(const std::string &filepath);
+
+            // LoadModel, then optimizes the mesh, generates its LODs and writes the mesh cache.
+            void Cook(const std::string &filepath);
         };
 
-        Model(Device &device, const Builder &builder);
+        Model(Device &device, const Builder &builder, VertexFormat format = VertexFormat::Full);
+
+        // Uploads straight from the given memory, e.g. a mapped mesh cache, without an intermediate copy.
+        Model(Device &device, const Vertex *vertices, uint32_t vertexCount, const uint32_t *indices, uint32_t indexCount,
+              VertexFormat format = VertexFormat::Full, const Lod *lods = nullptr, uint32_t lodCount = 0);
 
         ~Model() = default;
 
@@ -48,31 +95,53 @@ namespace engine {
 
         Model &operator=(const Model &) = delete;
 
-        static std::unique_ptr<Model> CreateModelFromFile(Device &device, const std::string &filepath);
+        // Loads <filepath>.meshcache when it matches the source, otherwise parses the OBJ and rewrites the cache.
+        static std::unique_ptr<Model> CreateModelFromFile(Device &device, const std::string &filepath,
+                                                          VertexFormat format = VertexFormat::Full);
 
         void Bind(VkCommandBuffer commandBuffer);
 
-        void Draw(VkCommandBuffer commandBuffer) const;
+        void Draw(VkCommandBuffer commandBuffer, uint32_t lod = 0) const;
+
+        [[nodiscard]] uint32_t GetLodCount() const { return static_cast<uint32_t>(m_Lods.size()); }
+        [[nodiscard]] const std::vector<Lod> &GetLods() const { return m_Lods; }
+
+        // Coarsest level whose error projects to at most pixelError pixels, for an instance drawn
+        // with the given model matrix. projectionScale converts object size over distance to
+        // pixels, see ProjectionScale().
+        [[nodiscard]] uint32_t SelectLod(const glm::mat4 &modelMatrix, const glm::vec3 &cameraPosition,
+                                         float projectionScale, float pixelError = 1.0f) const;
+
+        // viewport height / (2 tan(fovY / 2)) for a perspective projection
+        static float ProjectionScale(float fovY, float viewportHeight);
 
         glm::vec3 GetMinExtents() const;
         glm::vec3 GetMaxExtents() const;
 
+        [[nodiscard]] VertexFormat GetVertexFormat() const { return m_VertexFormat; }
+
+        // Maps quantized positions to object space (model matrix * this), identity for VertexFormat::Full.
+        glm::mat4 GetDequantization() const;
 
     private:
-        void CreateVertexBuffers(const std::vector<Vertex> &vertices);
+        void CreateVertexBuffers(const Vertex *vertices, uint32_t vertexCount);
+
+        void UploadVertexBuffer(const void *vertices, uint32_t vertexSize, uint32_t vertexCount);
 
-        void CreateIndexBuffer(const std::vector<uint32_t> &indices);
+        void CreateIndexBuffer(const uint32_t *indices, uint32_t indexCount);
 
-        void FindMinMaxExtent(const std::vector<Vertex> &vertices);
+        void FindMinMaxExtent(const Vertex *vertices, uint32_t vertexCount);
 
         Device &m_Device;
 
+        VertexFormat m_VertexFormat;
         std::unique_ptr<Buffer> m_VertexBuffer;
         uint32_t m_VertexCount;
 
         bool m_HasIndexBuffer{false};
         std::unique_ptr<Buffer> m_IndexBuffer;
         uint32_t m_IndexCount;
+        std::vector<Lod> m_Lods;
 
         glm::vec3 mMinExtent, mMaxExtent;
     };
@@ -4,26 +4,119 @@
 
 #include "Particle.h"
 
+#include <glm/packing.hpp>
+#include <glm/gtc/packing.hpp>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#define PARTICLE_SSE 1
+#include <emmintrin.h>
+#endif
+
+#ifdef __F16C__
+#include <immintrin.h>
+#endif
+
 namespace engine {
-    std::vector<VkVertexInputBindingDescription> Particle::getBindingDescription() {
+    std::vector<VkVertexInputBindingDescription> ParticleVertex::getBindingDescription() {
         std::vector<VkVertexInputBindingDescription> bindingDescriptions(1);
         bindingDescriptions[0].binding = 0;
-        bindingDescriptions[0].stride = sizeof(Particle);
+        bindingDescriptions[0].stride = sizeof(ParticleVertex);
         bindingDescriptions[0].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
         return bindingDescriptions;
     }
 
-    std::vector<VkVertexInputAttributeDescription> Particle::getAttributeDescriptions() {
+    std::vector<VkVertexInputAttributeDescription> ParticleVertex::getAttributeDescriptions() {
         std::vector<VkVertexInputAttributeDescription> attributeDescriptions{};
 
-        attributeDescriptions.push_back({0, 0, VK_FORMAT_R32G32_SFLOAT, offsetof(Particle, position)});
-        attributeDescriptions.push_back({1, 0, VK_FORMAT_R32G32B32A32_SFLOAT, offsetof(Particle, color)});
-        attributeDescriptions.push_back({2, 0, VK_FORMAT_R32_SFLOAT, offsetof(Particle, size)});
+        attributeDescriptions.push_back({0, 0, VK_FORMAT_R32G32_SFLOAT, offsetof(ParticleVertex, position)});
+        attributeDescriptions.push_back({1, 0, VK_FORMAT_R8G8B8A8_UNORM, offsetof(ParticleVertex, color)});
+        attributeDescriptions.push_back({2, 0, VK_FORMAT_R16_SFLOAT, offsetof(ParticleVertex, size)});
 
         return attributeDescriptions;
     }
 
+    void PackParticles(const Particle *particles, size_t count, ParticleVertex *vertices, const uint8_t *colorIndices) {
+        size_t i = 0;
+#ifdef PARTICLE_SSE
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 one = _mm_set1_ps(1.0f);
+        const __m128 scale = _mm_set1_ps(255.0f);
+        // round(clamp(c, 0, 1) * 255) per channel
+        auto quantize = [&](const glm::vec4 &color) {
+            return _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(&color.x), zero), one), scale));
+        };
+
+        for (; i + 4 <= count; i += 4) {
+            const Particle *p = particles + i;
+
+            // all 16 channels saturated down to bytes in two packs
+            alignas(16) uint32_t colors[4];
+            _mm_store_si128(reinterpret_cast<__m128i *>(colors),
+                            _mm_packus_epi16(_mm_packs_epi32(quantize(p[0].color), quantize(p[1].color)),
+                                             _mm_packs_epi32(quantize(p[2].color), quantize(p[3].color))));
+
+            alignas(16) uint16_t sizes[8];
+#ifdef __F16C__
+            _mm_store_si128(reinterpret_cast<__m128i *>(sizes),
+                            _mm_cvtps_ph(_mm_setr_ps(p[0].size, p[1].size, p[2].size, p[3].size), _MM_FROUND_TO_NEAREST_INT));
+#else
+            for (int j = 0; j < 4; j++) {
+                sizes[j] = glm::packHalf1x16(p[j].size);
+            }
+#endif
+
+            for (int j = 0; j < 4; j++) {
+                vertices[i + j].position = p[j].position;
+                vertices[i + j].color = colorIndices ? colorIndices[i + j] : colors[j];
+                vertices[i + j].size = sizes[j];
+                vertices[i + j].padding = 0;
+            }
+        }
+#endif
+        for (; i < count; i++) {
+            vertices[i].position = particles[i].position;
+            vertices[i].color = colorIndices ? colorIndices[i] : glm::packUnorm4x8(particles[i].color);
+            vertices[i].size = glm::packHalf1x16(particles[i].size);
+            vertices[i].padding = 0;
+        }
+    }
+
+    size_t CullParticles(const Particle *particles, size_t count, const glm::vec2 &viewMin, const glm::vec2 &viewMax, uint32_t *visibleIndices) {
+        size_t visible = 0;
+        size_t i = 0;
+#ifdef PARTICLE_SSE
+        const __m128 minX = _mm_set1_ps(viewMin.x);
+        const __m128 minY = _mm_set1_ps(viewMin.y);
+        const __m128 maxX = _mm_set1_ps(viewMax.x);
+        const __m128 maxY = _mm_set1_ps(viewMax.y);
+
+        for (; i + 4 <= count; i += 4) {
+            const Particle *p = particles + i;
+            __m128 x = _mm_setr_ps(p[0].position.x, p[1].position.x, p[2].position.x, p[3].position.x);
+            __m128 y = _mm_setr_ps(p[0].position.y, p[1].position.y, p[2].position.y, p[3].position.y);
+            __m128 size = _mm_setr_ps(p[0].size, p[1].size, p[2].size, p[3].size);
+
+            __m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(_mm_add_ps(x, size), minX), _mm_cmple_ps(_mm_sub_ps(x, size), maxX)),
+                                       _mm_and_ps(_mm_cmpge_ps(_mm_add_ps(y, size), minY), _mm_cmple_ps(_mm_sub_ps(y, size), maxY)));
+            int mask = _mm_movemask_ps(inside);
+
+            // compacted without branching, a culled index is overwritten by the next one
+            for (int j = 0; j < 4; j++) {
+                visibleIndices[visible] = static_cast<uint32_t>(i + j);
+                visible += (mask >> j) & 1;
+            }
+        }
+#endif
+        for (; i < count; i++) {
+            const Particle &p = particles[i];
+            visibleIndices[visible] = static_cast<uint32_t>(i);
+            visible += p.position.x + p.size >= viewMin.x && p.position.x - p.size <= viewMax.x &&
+                       p.position.y + p.size >= viewMin.y && p.position.y - p.size <= viewMax.y;
+        }
+        return visible;
+    }
+
     glm::vec2 LinkedParticle::distToChild() const {
         return particle->position - child->position;
     }
-} // engine
\ No newline at end of file
+} // engine
@@ -10,11 +10,15 @@
 #include <glm/vec4.hpp>
 #include <vulkan/vulkan.h>
 
+#include <cstddef>
+#include <cstdint>
+
 namespace engine {
 
+    // What the game simulates on the CPU. The GPU only ever sees the packed ParticleVertex.
     struct Particle {
-        alignas(8) glm::vec2 position;
-        alignas(8) glm::vec4 color;
+        glm::vec2 position;
+        glm::vec4 color;
         float size;
 
         Particle()
@@ -25,11 +29,32 @@ namespace engine {
 
         Particle(const glm::vec2 &position, const glm::vec4 &color, const float size)
                 : position(position), size(size), color(color) {}
+    };
+
+    // 16 bytes per particle instead of the 40 of Particle.
+    struct ParticleVertex {
+        glm::vec2 position;
+        // R8G8B8A8_UNORM, or the palette index in the red channel
+        uint32_t color;
+        // half float
+        uint16_t size;
+        uint16_t padding;
 
         static std::vector<VkVertexInputBindingDescription> getBindingDescription();
         static std::vector<VkVertexInputAttributeDescription> getAttributeDescriptions();
     };
 
+    static_assert(sizeof(ParticleVertex) == 16);
+
+    // Packs count particles into vertices, four at a time with SSE2 where available. With
+    // colorIndices the color is replaced by the index.
+    void PackParticles(const Particle *particles, size_t count, ParticleVertex *vertices, const uint8_t *colorIndices = nullptr);
+
+    // Writes the index of every particle that overlaps the rectangle from viewMin to viewMax to
+    // visibleIndices, in order, and returns how many there are. Tests four particles at a time with
+    // SSE2 where available.
+    size_t CullParticles(const Particle *particles, size_t count, const glm::vec2 &viewMin, const glm::vec2 &viewMax, uint32_t *visibleIndices);
+
     struct LinkedParticle {
         Particle *particle;
         Particle *child;
@@ -0,0 +1,86 @@
+#include "ParticleLod.h"
+
+#include <glm/geometric.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace engine {
+
+    static bool offScreen(const Particle &particle, const ParticleLodSettings &settings) {
+        return particle.position.x + particle.size < settings.viewMin.x || particle.position.x - particle.size > settings.viewMax.x ||
+               particle.position.y + particle.size < settings.viewMin.y || particle.position.y - particle.size > settings.viewMax.y;
+    }
+
+    size_t BuildChainLod(const std::vector<LinkedParticle> &chain, const ParticleLodSettings &settings, std::vector<Particle> &out) {
+        size_t first = out.size();
+
+        // the larger axis, so a merged particle never exceeds mergeRadiusPixels on either
+        glm::vec2 axisScale = settings.viewportSize / (settings.viewMax - settings.viewMin);
+        float pixelsPerUnit = std::max(axisScale.x, axisScale.y);
+        float mergeRadius = settings.mergeRadiusPixels / pixelsPerUnit;
+        float tolerance = settings.tolerancePixels / pixelsPerUnit;
+
+        size_t i = 0;
+        while (i < chain.size()) {
+            const Particle &start = *chain[i].particle;
+            i++;
+            if (offScreen(start, settings)) {
+                continue;
+            }
+
+            // the bounding circle of the run, grown one segment at a time
+            Particle merged = start;
+            float maxRadius = std::max(start.size + tolerance, mergeRadius);
+            float turn = 0.0f;
+            glm::vec2 previousStep{0.0f};
+
+            for (; i < chain.size(); i++) {
+                const Particle &next = *chain[i].particle;
+                if (offScreen(next, settings)) {
+                    break;
+                }
+
+                glm::vec2 step = next.position - chain[i - 1].particle->position;
+                float stepLength = glm::length(step);
+                float nextTurn = turn;
+                if (stepLength > 0.0f) {
+                    step /= stepLength;
+                    if (previousStep != glm::vec2(0.0f)) {
+                        nextTurn += std::acos(std::clamp(glm::dot(previousStep, step), -1.0f, 1.0f));
+                    }
+                }
+                if (nextTurn > settings.maxTurnAngle) {
+                    break;
+                }
+
+                glm::vec2 offset = next.position - merged.position;
+                float distance = glm::length(offset);
+                float radius = merged.size;
+                glm::vec2 center = merged.position;
+                if (distance + next.size > radius) {
+                    // smallest circle around the old one and the next segment
+                    radius = (merged.size + distance + next.size) * 0.5f;
+                    if (distance > 0.0f) {
+                        center += offset / distance * (radius - merged.size);
+                    }
+                }
+                if (radius > maxRadius) {
+                    break;
+                }
+
+                merged.position = center;
+                merged.size = radius;
+                turn = nextTurn;
+                if (stepLength > 0.0f) {
+                    previousStep = step;
+                }
+            }
+
+            out.push_back(merged);
+        }
+
+        return out.size() - first;
+    }
+
+} // engine
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "Particle.h"
+
+#include <glm/vec2.hpp>
+
+#include <vector>
+
+namespace engine {
+
+    struct ParticleLodSettings {
+        // framebuffer size in pixels
+        glm::vec2 viewportSize{1.0f};
+        // the rectangle of the world the framebuffer shows, see Camera2D
+        glm::vec2 viewMin{-1.0f};
+        glm::vec2 viewMax{1.0f};
+        // a run of segments is merged into one particle of at most this radius on screen
+        float mergeRadiusPixels = 2.0f;
+        // segments already bigger than that are only merged while the merged particle is at most
+        // this much bigger, so dense overlapping runs collapse without a visible bulge
+        float tolerancePixels = 0.5f;
+        // and only while the chain turns by less than this in total, in radians, so bends keep
+        // their full resolution
+        float maxTurnAngle = 0.5f;
+    };
+
+    // Appends a reduced version of chain, ordered from head to tail, to out. Segments outside the
+    // viewport are dropped and runs of segments are collapsed into one particle that covers them.
+    // Only meant for drawing, chain itself stays at full resolution for collisions. Returns the
+    // number of particles appended.
+    size_t BuildChainLod(const std::vector<LinkedParticle> &chain, const ParticleLodSettings &settings, std::vector<Particle> &out);
+
+} // engine
@@ -13,11 +13,13 @@ namespace engine {
     }
 
     Pipeline::~Pipeline() {
-        vkQueueWaitIdle(m_Device.graphicsQueue());
-        vkDestroyShaderModule(m_Device.device(), m_VertShaderModule, nullptr);
-        vkDestroyShaderModule(m_Device.device(), m_FragShaderModule, nullptr);
-        if (m_geomShaderModule) { vkDestroyShaderModule(m_Device.device(), m_geomShaderModule, nullptr); }
-        vkDestroyPipeline(m_Device.device(), m_GraphicsPipeline, nullptr);
+        if (m_waitIdleOnDestroy) {
+            m_Device.dispatch().vkQueueWaitIdle(m_Device.graphicsQueue());
+        }
+        m_Device.dispatch().vkDestroyShaderModule(m_Device.device(), m_VertShaderModule, nullptr);
+        m_Device.dispatch().vkDestroyShaderModule(m_Device.device(), m_FragShaderModule, nullptr);
+        if (m_geomShaderModule) { m_Device.dispatch().vkDestroyShaderModule(m_Device.device(), m_geomShaderModule, nullptr); }
+        m_Device.dispatch().vkDestroyPipeline(m_Device.device(), m_GraphicsPipeline, nullptr);
     }
 
     std::vector<char> Pipeline::readFile(const std::string &filepath) {
@@ -46,18 +48,23 @@ namespace engine {
                 configInfo.renderPass != VK_NULL_HANDLE &&
                 "Cannot create graphics pipeline: no renderPass provided in configInfo");
 
-        auto vertCode = readFile(configInfo.vertPath);
-        auto fragCode = readFile(configInfo.fragPath);
-
-        createShaderModule(vertCode, &m_VertShaderModule);
-        createShaderModule(fragCode, &m_FragShaderModule);
+        m_VertShaderModule = createShaderModule(m_Device, configInfo.vertShader, configInfo.vertPath);
+        m_FragShaderModule = createShaderModule(m_Device, configInfo.fragShader, configInfo.fragPath);
 
-        if (!configInfo.geomPath.empty()) {
-            auto geomCode = readFile(configInfo.geomPath);
-            createShaderModule(geomCode, &m_geomShaderModule);
+        bool hasGeometryStage = configInfo.geomShader != nullptr || !configInfo.geomPath.empty();
+        if (hasGeometryStage) {
+            m_geomShaderModule = createShaderModule(m_Device, configInfo.geomShader, configInfo.geomPath);
         }
 
-        uint8_t numStages = configInfo.geomPath.empty() ? 2 : 3;
+        uint8_t numStages = hasGeometryStage ? 3 : 2;
+
+        VkSpecializationInfo specializationInfo{};
+        specializationInfo.mapEntryCount = static_cast<uint32_t>(configInfo.specializationEntries.size());
+        specializationInfo.pMapEntries = configInfo.specializationEntries.data();
+        specializationInfo.dataSize = configInfo.specializationData.size();
+        specializationInfo.pData = configInfo.specializationData.data();
+        const VkSpecializationInfo *specialization =
+                configInfo.specializationEntries.empty() ? nullptr : &specializationInfo;
 
         // VkPipelineShaderStageCreateInfo shaderStages[numStages];
         std::vector<VkPipelineShaderStageCreateInfo> shaderStages{ numStages };
@@ -67,7 +74,7 @@ namespace engine {
         shaderStages[0].pName = "main";
         shaderStages[0].flags = 0;
         shaderStages[0].pNext = nullptr;
-        shaderStages[0].pSpecializationInfo = nullptr;
+        shaderStages[0].pSpecializationInfo = specialization;
 
         shaderStages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
         shaderStages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
@@ -75,16 +82,16 @@ namespace engine {
         shaderStages[1].pName = "main";
         shaderStages[1].flags = 0;
         shaderStages[1].pNext = nullptr;
-        shaderStages[1].pSpecializationInfo = nullptr;
+        shaderStages[1].pSpecializationInfo = specialization;
 
-        if (!configInfo.geomPath.empty()) {
+        if (hasGeometryStage) {
             shaderStages[2].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
             shaderStages[2].stage = VK_SHADER_STAGE_GEOMETRY_BIT;
             shaderStages[2].module = m_geomShaderModule;
             shaderStages[2].pName = "main";
             shaderStages[2].flags = 0;
             shaderStages[2].pNext = nullptr;
-            shaderStages[2].pSpecializationInfo = nullptr;
+            shaderStages[2].pSpecializationInfo = specialization;
         }
 
         auto &bindingDescriptions = configInfo.bindingDescriptions;
@@ -119,7 +126,7 @@ namespace engine {
         pipelineInfo.basePipelineIndex = -1;
         pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
 
-        if (vkCreateGraphicsPipelines(m_Device.device(), VK_NULL_HANDLE, 1,
+        if (m_Device.dispatch().vkCreateGraphicsPipelines(m_Device.device(), VK_NULL_HANDLE, 1,
                                       &pipelineInfo, nullptr,
                                       &m_GraphicsPipeline) != VK_SUCCESS) {
             throw std::runtime_error("Failed to create graphics pipeline");
@@ -213,21 +220,29 @@ namespace engine {
         configInfo.attributeDescriptions = Model::Vertex::getAttributeDescriptions();
     }
 
-    void Pipeline::createShaderModule(const std::vector<char> &code,
-                                      VkShaderModule *shaderModule) {
+    VkShaderModule Pipeline::createShaderModule(Device &device, const ShaderInfo *shader, const std::string &filepath) {
+        std::vector<char> fileCode;
         VkShaderModuleCreateInfo createInfo{};
         createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-        createInfo.codeSize = code.size();
-        createInfo.pCode = reinterpret_cast<const uint32_t *>(code.data());
+        if (shader) {
+            createInfo.codeSize = shader->codeSize;
+            createInfo.pCode = shader->code;
+        } else {
+            fileCode = readFile(filepath);
+            createInfo.codeSize = fileCode.size();
+            createInfo.pCode = reinterpret_cast<const uint32_t *>(fileCode.data());
+        }
 
-        if (vkCreateShaderModule(m_Device.device(), &createInfo, nullptr,
-                                 shaderModule) != VK_SUCCESS) {
+        VkShaderModule shaderModule;
+        if (device.dispatch().vkCreateShaderModule(device.device(), &createInfo, nullptr,
+                                                   &shaderModule) != VK_SUCCESS) {
             throw std::runtime_error("Failed to create shader module");
         }
+        return shaderModule;
     }
 
     void Pipeline::bind(VkCommandBuffer commandBuffer) {
-        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
+        m_Device.dispatch().vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
                           m_GraphicsPipeline);
     }
 
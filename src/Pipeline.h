@@ -1,8 +1,11 @@
 #pragma once
 
 #include "Device.h"
+#include "ShaderReflection.h"
 
+#include <cstring>
 #include <string>
+#include <type_traits>
 #include <vector>
 #include <vulkan/vulkan_core.h>
 
@@ -27,9 +30,27 @@ namespace engine {
         std::string vertPath;
         std::string fragPath;
         std::string geomPath;
+        // Modules embedded by the build, see EmbeddedShaders.h. The paths are only read for
+        // stages without one.
+        const ShaderInfo *vertShader = nullptr;
+        const ShaderInfo *fragShader = nullptr;
+        const ShaderInfo *geomShader = nullptr;
+        // Specialization constants, shared by all stages. A stage ignores the ids it does not declare.
+        std::vector<VkSpecializationMapEntry> specializationEntries;
+        std::vector<uint8_t> specializationData;
         VkPipelineLayout pipelineLayout = nullptr;
         VkRenderPass renderPass = nullptr;
         uint32_t subpass = 0;
+
+        // GLSL bools are specialized with a VkBool32.
+        template<typename T>
+        void addSpecializationConstant(uint32_t constantId, const T &value) {
+            static_assert(std::is_trivially_copyable_v<T> && !std::is_same_v<T, bool>, "use VkBool32 for bools");
+            auto offset = static_cast<uint32_t>(specializationData.size());
+            specializationEntries.push_back({constantId, offset, sizeof(T)});
+            specializationData.resize(offset + sizeof(T));
+            std::memcpy(specializationData.data() + offset, &value, sizeof(T));
+        }
     };
 
     class Pipeline {
@@ -44,20 +65,25 @@ namespace engine {
 
         void bind(VkCommandBuffer commandBuffer);
 
+        // Skips the queue wait in the destructor, for pipelines only destroyed once no frame in
+        // flight can use them anymore.
+        void setWaitIdleOnDestroy(bool waitIdle) { m_waitIdleOnDestroy = waitIdle; }
+
         static void defaultPipelineConfigInfo(PipelineConfigInfo &configInfo);
 
-    private:
         static std::vector<char> readFile(const std::string &filepath);
 
-        void createGraphicsPipeline(const PipelineConfigInfo &configInfo);
+        // From the embedded words when shader is set, from the .spv at filepath otherwise.
+        static VkShaderModule createShaderModule(Device &device, const ShaderInfo *shader, const std::string &filepath);
 
-        void createShaderModule(const std::vector<char> &code,
-                                VkShaderModule *shaderModule);
+    private:
+        void createGraphicsPipeline(const PipelineConfigInfo &configInfo);
 
         Device &m_Device;
         VkPipeline m_GraphicsPipeline;
         VkShaderModule m_VertShaderModule;
         VkShaderModule m_FragShaderModule;
-        VkShaderModule m_geomShaderModule;
+        VkShaderModule m_geomShaderModule = VK_NULL_HANDLE;
+        bool m_waitIdleOnDestroy = true;
     };
 } // namespace engine
@@ -4,6 +4,8 @@
 
 #include "RayTracingModel.h"
 
+#include <stdexcept>
+
 namespace engine {
     RayTracingModel::RayTracingModel(Device &device, Model::Builder &builder) : m_device(device) {
             CreateVertexBuffers(builder.vertices);
@@ -72,6 +74,10 @@ namespace engine {
     }
 
     void RayTracingModel::CreateAccelerationStructure() {
+        if (m_device.dispatch().vkCreateAccelerationStructureKHR == nullptr) {
+            throw std::runtime_error("VK_KHR_acceleration_structure is not enabled");
+        }
+
         VkCommandBuffer cmdBuffer = m_device.beginSingleTimeCommands();
 
         VkDeviceAddress vertexBufferAddress = m_vertexBuffer->getBufferDeviceAddress();
@@ -107,8 +113,7 @@ namespace engine {
 
         VkAccelerationStructureBuildSizesInfoKHR sizeInfo{VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_BUILD_SIZES_INFO_KHR};
 
-        auto vkGetAccelerationStructureBuildSizesKHR = reinterpret_cast<PFN_vkGetAccelerationStructureBuildSizesKHR>(vkGetDeviceProcAddr(m_device.device(), "vkGetAccelerationStructureBuildSizesKHR"));
-        vkGetAccelerationStructureBuildSizesKHR(
+        m_device.dispatch().vkGetAccelerationStructureBuildSizesKHR(
                 m_device.device(),
                 VK_ACCELERATION_STRUCTURE_BUILD_TYPE_DEVICE_KHR,
                 &buildInfo,
@@ -129,8 +134,7 @@ namespace engine {
         createInfo.size   = sizeInfo.accelerationStructureSize;
         createInfo.buffer = m_blasBuffer->getBuffer();
         createInfo.offset = 0;
-        auto vkCreateAccelerationStructureKHR = reinterpret_cast<PFN_vkCreateAccelerationStructureKHR>(vkGetDeviceProcAddr(m_device.device(), "vkCreateAccelerationStructureKHR"));
-        vkCreateAccelerationStructureKHR(m_device.device(), &createInfo, nullptr, &m_blas);
+        m_device.dispatch().vkCreateAccelerationStructureKHR(m_device.device(), &createInfo, nullptr, &m_blas);
         buildInfo.dstAccelerationStructure = m_blas;
 
         Buffer scratchBuffer{m_device,
@@ -144,8 +148,7 @@ namespace engine {
         buildInfo.scratchData.deviceAddress = scratchBuffer.getBufferDeviceAddress();
 
         VkAccelerationStructureBuildRangeInfoKHR* pRangeInfo = &rangeInfo;
-        auto vkCmdBuildAccelerationStructuresKHR = reinterpret_cast<PFN_vkCmdBuildAccelerationStructuresKHR>(vkGetDeviceProcAddr(m_device.device(), "vkCmdBuildAccelerationStructuresKHR"));
-        vkCmdBuildAccelerationStructuresKHR(cmdBuffer, 1, &buildInfo, &pRangeInfo);
+        m_device.dispatch().vkCmdBuildAccelerationStructuresKHR(cmdBuffer, 1, &buildInfo, &pRangeInfo);
         m_device.endSingleTimeCommands(cmdBuffer);
     }
 } // engine
\ No newline at end of file
@@ -20,7 +20,7 @@ namespace engine {
             glfwWaitEvents();
         }
 
-        vkDeviceWaitIdle(m_Device.device());
+        m_Device.dispatch().vkDeviceWaitIdle(m_Device.device());
 
         if (m_SwapChain == nullptr) {
             m_SwapChain = std::make_unique<SwapChain>(m_Device, extent);
@@ -43,14 +43,14 @@ namespace engine {
         allocInfo.commandPool = m_Device.getCommandPool();
         allocInfo.commandBufferCount = static_cast<uint32_t>(m_CommandBuffers.size());
 
-        if (vkAllocateCommandBuffers(m_Device.device(), &allocInfo,
+        if (m_Device.dispatch().vkAllocateCommandBuffers(m_Device.device(), &allocInfo,
                                      m_CommandBuffers.data()) != VK_SUCCESS) {
             throw std::runtime_error("Failed to allocate command buffers");
         }
     }
 
     void Renderer::FreeCommandBuffers() {
-        vkFreeCommandBuffers(m_Device.device(), m_Device.getCommandPool(),
+        m_Device.dispatch().vkFreeCommandBuffers(m_Device.device(), m_Device.getCommandPool(),
                              static_cast<uint32_t>(m_CommandBuffers.size()),
                              m_CommandBuffers.data());
 
@@ -76,7 +76,7 @@ namespace engine {
         VkCommandBufferBeginInfo beginInfo{};
         beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
 
-        if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
+        if (m_Device.dispatch().vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
             throw std::runtime_error("Failed to begin recording command buffer");
         }
         return commandBuffer;
@@ -85,7 +85,7 @@ namespace engine {
     void Renderer::EndFrame() {
         assert(m_IsFramStarted && "Can't call EndFrame while frame is not in progress");
         auto commandBuffer = GetCurrentCommandBuffer();
-        if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
+        if (m_Device.dispatch().vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
             throw std::runtime_error("Failed to record command buffer");
         }
 
@@ -121,7 +121,7 @@ namespace engine {
         renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
         renderPassInfo.pClearValues = clearValues.data();
 
-        vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+        m_Device.dispatch().vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
 
         VkViewport viewport{};
         viewport.x = 0.0f;
@@ -131,8 +131,8 @@ namespace engine {
         viewport.minDepth = 0.0f;
         viewport.maxDepth = 1.0f;
         VkRect2D scissor{{0, 0}, m_SwapChain->getSwapChainExtent()};
-        vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
-        vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+        m_Device.dispatch().vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+        m_Device.dispatch().vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
     }
 
     void Renderer::EndSwapChainRenderPass(VkCommandBuffer commandBuffer) const {
@@ -140,7 +140,7 @@ namespace engine {
         assert(commandBuffer == GetCurrentCommandBuffer() &&
                "Can't end render pass on command buffer from a different frame");
 
-        vkCmdEndRenderPass(commandBuffer);
+        m_Device.dispatch().vkCmdEndRenderPass(commandBuffer);
     }
 
 
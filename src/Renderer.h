@@ -50,6 +50,8 @@ namespace engine {
 
         [[nodiscard]] float GetAspectRatio() const { return m_SwapChain->extentAspectRatio(); }
 
+        [[nodiscard]] VkExtent2D GetSwapChainExtent() const { return m_SwapChain->getSwapChainExtent(); }
+
         [[nodiscard]] bool IsFrameInProgress() const { return m_IsFramStarted; }
 
         [[nodiscard]] VkCommandBuffer GetCurrentCommandBuffer() const {
@@ -0,0 +1,257 @@
+#include "ShaderHotReloader.h"
+#include "SwapChain.h"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace engine {
+    namespace fs = std::filesystem;
+
+    static bool isShaderSource(const std::string &fileName) {
+        static const char *extensions[] = {".vert", ".frag", ".geom", ".comp"};
+        return std::any_of(std::begin(extensions), std::end(extensions), [&](const char *extension) {
+            return fs::path(fileName).extension() == extension;
+        });
+    }
+
+    // particle.vert -> particle_vert, the name spirv_reflect gives the embedded module
+    static std::string shaderName(const std::string &fileName) {
+        std::string name = fileName;
+        for (char &c : name) {
+            if (!std::isalnum(static_cast<unsigned char>(c))) {
+                c = '_';
+            }
+        }
+        return name;
+    }
+
+    // FNV-1a, the stage follows from the file name so it is part of the key
+    static uint64_t hashSource(const std::string &fileName, const std::vector<char> &source) {
+        uint64_t hash = 14695981039346656037ull;
+        auto add = [&hash](char c) {
+            hash ^= static_cast<unsigned char>(c);
+            hash *= 1099511628211ull;
+        };
+        std::for_each(fileName.begin(), fileName.end(), add);
+        add('\0');
+        std::for_each(source.begin(), source.end(), add);
+        return hash;
+    }
+
+    ShaderHotReloader::ShaderHotReloader(Device &device, std::string sourceDir, std::string cacheDir, std::string compiler)
+            : mDevice(device), mSourceDir(std::move(sourceDir)), mCacheDir(std::move(cacheDir)), mCompiler(std::move(compiler)) {
+        fs::create_directories(mCacheDir);
+        mThread = std::thread(&ShaderHotReloader::WatchLoop, this);
+    }
+
+    ShaderHotReloader::~ShaderHotReloader() {
+        mStopping = true;
+        mThread.join();
+
+        if (!mRetiredPipelines.empty()) {
+            mDevice.dispatch().vkQueueWaitIdle(mDevice.graphicsQueue());
+        }
+    }
+
+    const ShaderInfo *ShaderHotReloader::Resolve(const ShaderInfo &shader) {
+        auto it = mOverrides.find(shader.name);
+        if (it == mOverrides.end()) {
+            return &shader;
+        }
+
+        // keeps the embedded reflection, see the class comment
+        Override &replacement = it->second;
+        replacement.info = shader;
+        replacement.info.code = replacement.code.data();
+        replacement.info.codeSize = replacement.code.size() * sizeof(uint32_t);
+        return &replacement.info;
+    }
+
+    void ShaderHotReloader::Watch(const void *owner, std::initializer_list<const ShaderInfo *> shaders,
+                                  std::unique_ptr<Pipeline> &pipeline, std::function<void()> create) {
+        mWatchers.push_back({owner, shaders, &pipeline, std::move(create)});
+    }
+
+    void ShaderHotReloader::Unwatch(const void *owner) {
+        mWatchers.erase(std::remove_if(mWatchers.begin(), mWatchers.end(),
+                                       [owner](const Watcher &watcher) { return watcher.owner == owner; }),
+                        mWatchers.end());
+    }
+
+    void ShaderHotReloader::Update() {
+        mFrameNumber++;
+        while (!mRetiredPipelines.empty() &&
+               mRetiredPipelines.front().first + SwapChain::MAX_FRAMES_IN_FLIGHT + 1 <= mFrameNumber) {
+            mRetiredPipelines.pop_front();
+        }
+
+        std::vector<CompiledShader> compiled;
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            compiled.swap(mCompiled);
+        }
+        if (compiled.empty()) {
+            return;
+        }
+
+        std::set<std::string> changed;
+        for (CompiledShader &shader : compiled) {
+            mOverrides[shader.name].code = std::move(shader.code);
+            changed.insert(shader.name);
+        }
+
+        for (Watcher &watcher : mWatchers) {
+            bool affected = std::any_of(watcher.shaders.begin(), watcher.shaders.end(),
+                                        [&](const ShaderInfo *shader) { return changed.count(shader->name) > 0; });
+            if (!affected) {
+                continue;
+            }
+
+            std::unique_ptr<Pipeline> previous = std::move(*watcher.pipeline);
+            try {
+                watcher.create();
+            } catch (const std::exception &e) {
+                std::cerr << "Failed to rebuild pipeline: " << e.what() << std::endl;
+                *watcher.pipeline = std::move(previous);
+                continue;
+            }
+
+            if (previous) {
+                previous->setWaitIdleOnDestroy(false);
+                mRetiredPipelines.emplace_back(mFrameNumber, std::move(previous));
+            }
+        }
+    }
+
+    void ShaderHotReloader::WatchLoop() {
+#ifdef __linux__
+        int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (fd < 0 || inotify_add_watch(fd, mSourceDir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+            std::cerr << "Failed to watch " << mSourceDir << ", shader hot reload is disabled" << std::endl;
+            if (fd >= 0) {
+                close(fd);
+            }
+            return;
+        }
+
+        std::set<std::string> changed;
+        alignas(inotify_event) char buffer[4096];
+        while (!mStopping) {
+            pollfd pollFd{fd, POLLIN, 0};
+            if (poll(&pollFd, 1, changed.empty() ? 200 : 50) > 0) {
+                ssize_t length;
+                while ((length = read(fd, buffer, sizeof(buffer))) > 0) {
+                    for (char *event = buffer; event < buffer + length;) {
+                        auto *notification = reinterpret_cast<inotify_event *>(event);
+                        if (notification->len > 0 && isShaderSource(notification->name)) {
+                            changed.insert(notification->name);
+                        }
+                        event += sizeof(inotify_event) + notification->len;
+                    }
+                }
+                continue;
+            }
+
+            // quiet for a moment, editors saving through a temporary file are done by now
+            for (const std::string &fileName : changed) {
+                Compile(fileName);
+            }
+            changed.clear();
+        }
+        close(fd);
+#else
+        std::unordered_map<std::string, fs::file_time_type> writeTimes;
+        bool initialScan = true;
+        while (!mStopping) {
+            std::error_code error;
+            for (const fs::directory_entry &entry : fs::directory_iterator(mSourceDir, error)) {
+                std::string fileName = entry.path().filename().string();
+                if (!isShaderSource(fileName)) {
+                    continue;
+                }
+                fs::file_time_type writeTime = entry.last_write_time(error);
+                auto [it, inserted] = writeTimes.try_emplace(fileName, writeTime);
+                if (!inserted && it->second != writeTime) {
+                    it->second = writeTime;
+                    Compile(fileName);
+                } else if (inserted && !initialScan) {
+                    Compile(fileName);
+                }
+            }
+            initialScan = false;
+            std::this_thread::sleep_for(std::chrono::milliseconds(250));
+        }
+#endif
+    }
+
+    void ShaderHotReloader::Compile(const std::string &fileName) {
+        std::string sourcePath = mSourceDir + "/" + fileName;
+        std::vector<char> source;
+        try {
+            source = Pipeline::readFile(sourcePath);
+        } catch (const std::runtime_error &) {
+            // deleted again
+            return;
+        }
+
+        std::ostringstream cachePath;
+        cachePath << mCacheDir << "/" << fileName << "." << std::hex << hashSource(fileName, source) << ".spv";
+        std::string spirvPath = cachePath.str();
+
+        if (!fs::exists(spirvPath)) {
+            std::string tempPath = spirvPath + ".tmp";
+            std::string logPath = mCacheDir + "/" + fileName + ".log";
+            std::string command = "\"" + mCompiler + "\" -V \"" + sourcePath + "\" -o \"" + tempPath + "\" > \"" + logPath + "\" 2>&1";
+#ifdef _WIN32
+            // cmd.exe strips the outer quotes
+            command = "\"" + command + "\"";
+#endif
+            if (std::system(command.c_str()) != 0) {
+                std::ifstream log{logPath};
+                std::cerr << "Failed to compile " << fileName << ":\n" << log.rdbuf() << std::endl;
+                return;
+            }
+
+            std::error_code error;
+            fs::rename(tempPath, spirvPath, error);
+            if (error) {
+                std::cerr << "Failed to cache " << fileName << ": " << error.message() << std::endl;
+                return;
+            }
+        }
+
+        std::vector<char> bytes = Pipeline::readFile(spirvPath);
+        if (bytes.empty() || bytes.size() % sizeof(uint32_t) != 0) {
+            std::cerr << spirvPath << " is not a SPIR-V module" << std::endl;
+            return;
+        }
+
+        CompiledShader compiled{shaderName(fileName), std::vector<uint32_t>(bytes.size() / sizeof(uint32_t))};
+        std::copy(bytes.begin(), bytes.end(), reinterpret_cast<char *>(compiled.code.data()));
+
+        std::lock_guard<std::mutex> lock(mMutex);
+        // a newer version of the same file replaces one Update() has not picked up yet
+        auto it = std::find_if(mCompiled.begin(), mCompiled.end(),
+                               [&](const CompiledShader &shader) { return shader.name == compiled.name; });
+        if (it != mCompiled.end()) {
+            *it = std::move(compiled);
+        } else {
+            mCompiled.push_back(std::move(compiled));
+        }
+        std::cout << "Reloaded " << fileName << std::endl;
+    }
+}
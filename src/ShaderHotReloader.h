@@ -0,0 +1,89 @@
+#pragma once
+
+#include "Pipeline.h"
+#include "ShaderReflection.h"
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace engine {
+
+    // Development mode only (SHADER_HOT_RELOAD): watches the GLSL sources, recompiles changed files
+    // with glslangValidator on a background thread and rebuilds the pipelines using them in Update().
+    // Compiled modules are cached on disk under the hash of their source, so going back to an
+    // earlier version of a shader or restarting does not compile it again. Changes to bindings or
+    // push constants still need a rebuild, the layouts are made from the embedded reflection.
+    class ShaderHotReloader {
+    public:
+        ShaderHotReloader(Device &device, std::string sourceDir, std::string cacheDir, std::string compiler);
+
+        ~ShaderHotReloader();
+
+        ShaderHotReloader(const ShaderHotReloader &) = delete;
+        ShaderHotReloader &operator=(const ShaderHotReloader &) = delete;
+
+        // The latest compiled version of shader, shader itself until its source changed. Only valid
+        // until the next Update().
+        [[nodiscard]] const ShaderInfo *Resolve(const ShaderInfo &shader);
+
+        // create() is called from Update() whenever one of shaders was recompiled and has to assign a
+        // pipeline built from Resolve()d modules to pipeline. The replaced pipeline is destroyed once
+        // no frame in flight uses it, or put back if create() throws.
+        void Watch(const void *owner, std::initializer_list<const ShaderInfo *> shaders,
+                   std::unique_ptr<Pipeline> &pipeline, std::function<void()> create);
+
+        void Unwatch(const void *owner);
+
+        // Call once per frame, before recording: swaps in the modules finished since the last call
+        // and rebuilds the pipelines watching them.
+        void Update();
+
+    private:
+        struct CompiledShader {
+            // e.g. particle_vert, as in EmbeddedShaders.h
+            std::string name;
+            std::vector<uint32_t> code;
+        };
+
+        struct Override {
+            std::vector<uint32_t> code;
+            ShaderInfo info;
+        };
+
+        struct Watcher {
+            const void *owner;
+            std::vector<const ShaderInfo *> shaders;
+            std::unique_ptr<Pipeline> *pipeline;
+            std::function<void()> create;
+        };
+
+        void WatchLoop();
+        void Compile(const std::string &fileName);
+
+        Device &mDevice;
+        const std::string mSourceDir;
+        const std::string mCacheDir;
+        const std::string mCompiler;
+
+        std::unordered_map<std::string, Override> mOverrides;
+        std::vector<Watcher> mWatchers;
+
+        // pipelines replaced while frames in flight may still use them, with the frame they were replaced in
+        std::deque<std::pair<uint64_t, std::unique_ptr<Pipeline>>> mRetiredPipelines;
+        uint64_t mFrameNumber = 0;
+
+        std::thread mThread;
+        std::atomic<bool> mStopping{false};
+        std::mutex mMutex;
+        std::vector<CompiledShader> mCompiled;
+    };
+}
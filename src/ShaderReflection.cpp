@@ -0,0 +1,74 @@
+#include "ShaderReflection.h"
+
+#include <algorithm>
+#include <map>
+#include <stdexcept>
+#include <string>
+
+namespace engine {
+
+    ShaderLayout::ShaderLayout(Device &device, LayoutCache &layoutCache, std::initializer_list<const ShaderInfo *> shaders,
+                               const std::vector<VkDescriptorSetLayout> &sharedSets) {
+        std::map<uint32_t, std::map<uint32_t, VkDescriptorSetLayoutBinding>> sets;
+
+        for (const ShaderInfo *shader : shaders) {
+            for (uint32_t i = 0; i < shader->bindingCount; i++) {
+                const ShaderBinding &binding = shader->bindings[i];
+                if (binding.set < sharedSets.size()) {
+                    continue;
+                }
+                if (binding.count == 0) {
+                    throw std::runtime_error(std::string(shader->name) + ": runtime sized descriptor arrays are not supported");
+                }
+
+                auto [it, inserted] = sets[binding.set].try_emplace(binding.binding);
+                VkDescriptorSetLayoutBinding &merged = it->second;
+                if (inserted) {
+                    merged.binding = binding.binding;
+                    merged.descriptorType = binding.type;
+                    merged.descriptorCount = binding.count;
+                    merged.stageFlags = 0;
+                } else if (merged.descriptorType != binding.type) {
+                    throw std::runtime_error(std::string(shader->name) + ": set " + std::to_string(binding.set) +
+                                             " binding " + std::to_string(binding.binding) +
+                                             " does not match the other stages");
+                }
+                merged.descriptorCount = std::max(merged.descriptorCount, binding.count);
+                merged.stageFlags |= shader->stage;
+            }
+
+            if (shader->pushConstantSize > 0) {
+                mPushConstantRange.stageFlags |= shader->stage;
+                mPushConstantRange.size = std::max(mPushConstantRange.size, shader->pushConstantSize);
+            }
+        }
+
+        uint32_t setCount = static_cast<uint32_t>(sharedSets.size());
+        if (!sets.empty()) {
+            setCount = std::max(setCount, sets.rbegin()->first + 1);
+        }
+
+        std::vector<VkDescriptorSetLayout> setLayouts(setCount);
+        mSetLayouts.resize(setCount);
+        for (uint32_t set = 0; set < setCount; set++) {
+            if (set < sharedSets.size()) {
+                setLayouts[set] = sharedSets[set];
+                continue;
+            }
+
+            // sets no stage uses still need a (then empty) layout to keep the numbering
+            DescriptorSetLayout::Builder builder{device};
+            for (const auto &[index, binding] : sets[set]) {
+                builder.addBinding(index, binding.descriptorType, binding.stageFlags, binding.descriptorCount);
+            }
+            mSetLayouts[set] = builder.build(layoutCache);
+            setLayouts[set] = mSetLayouts[set]->getDescriptorSetLayout();
+        }
+
+        std::vector<VkPushConstantRange> pushConstantRanges;
+        if (mPushConstantRange.size > 0) {
+            pushConstantRanges.push_back(mPushConstantRange);
+        }
+        mPipelineLayout = layoutCache.getPipelineLayout(setLayouts, pushConstantRanges);
+    }
+}
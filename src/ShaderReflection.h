@@ -0,0 +1,70 @@
+#pragma once
+
+#include "Device.h"
+#include "descriptors/DescriptorSetLayout.h"
+#include "descriptors/LayoutCache.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <memory>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+namespace engine {
+
+    // A descriptor declared by a shader, as found by spirv_reflect.
+    struct ShaderBinding {
+        uint32_t set;
+        uint32_t binding;
+        VkDescriptorType type;
+        // 0 for runtime sized arrays
+        uint32_t count;
+    };
+
+    // A SPIR-V module embedded into the binary at build time, see the generated EmbeddedShaders.h.
+    // Everything is constexpr, so the structs filled on the C++ side can be static_asserted against it.
+    struct ShaderInfo {
+        const char *name;
+        VkShaderStageFlagBits stage;
+        const uint32_t *code;
+        // in bytes
+        size_t codeSize;
+        const ShaderBinding *bindings;
+        uint32_t bindingCount;
+        // 0 without a push constant block
+        uint32_t pushConstantSize;
+
+        [[nodiscard]] constexpr bool binds(uint32_t set, uint32_t binding, VkDescriptorType type) const {
+            for (uint32_t i = 0; i < bindingCount; i++) {
+                if (bindings[i].set == set && bindings[i].binding == binding) {
+                    return bindings[i].type == type;
+                }
+            }
+            return false;
+        }
+    };
+
+    // The descriptor set layouts and pipeline layout of one pipeline, merged from the reflection of
+    // its stages. Bindings used by several stages are visible to all of them, the push constant
+    // range is as large as the largest block. sharedSets are used as is for the leading sets, e.g.
+    // the global set every system binds at 0, and have to match what the shaders declare there.
+    // Everything else is created through the LayoutCache.
+    class ShaderLayout {
+    public:
+        ShaderLayout(Device &device, LayoutCache &layoutCache, std::initializer_list<const ShaderInfo *> shaders,
+                     const std::vector<VkDescriptorSetLayout> &sharedSets = {});
+
+        [[nodiscard]] VkPipelineLayout pipelineLayout() const { return mPipelineLayout; }
+
+        // nullptr for shared sets
+        [[nodiscard]] const std::shared_ptr<DescriptorSetLayout> &setLayout(uint32_t set) const { return mSetLayouts.at(set); }
+
+        [[nodiscard]] VkShaderStageFlags pushConstantStages() const { return mPushConstantRange.stageFlags; }
+
+    private:
+        std::vector<std::shared_ptr<DescriptorSetLayout>> mSetLayouts;
+        VkPushConstantRange mPushConstantRange{};
+        VkPipelineLayout mPipelineLayout;
+    };
+}
@@ -0,0 +1,131 @@
+#include "SnakePath.h"
+
+#include <glm/geometric.hpp>
+
+#include <algorithm>
+#include <cassert>
+
+namespace engine {
+
+    // cumulative arc lengths are moved back toward 0 past this, so floats keep their precision over
+    // a long game
+    static constexpr float REBASE_ARC_LENGTH = 1024.0f;
+
+    SnakePath::SnakePath(uint32_t capacity, float minSampleDistance)
+            : m_samples(std::max(capacity, 2u)), m_minSampleDistance(minSampleDistance) {}
+
+    void SnakePath::Reset(const glm::vec2 &tail, const glm::vec2 &head) {
+        m_oldest = 0;
+        m_count = 0;
+        Append(tail);
+        Append(head);
+    }
+
+    void SnakePath::Push(const glm::vec2 &head) {
+        assert(m_count >= 2 && "Reset the path before pushing to it");
+
+        const Sample &previous = Get(m_count - 2);
+        if (glm::distance(previous.position, head) < m_minSampleDistance) {
+            Sample &newest = Get(m_count - 1);
+            newest.position = head;
+            newest.arcLength = previous.arcLength + glm::distance(previous.position, head);
+            return;
+        }
+        Append(head);
+    }
+
+    void SnakePath::Append(const glm::vec2 &position) {
+        float arcLength = 0.0f;
+        if (m_count > 0) {
+            const Sample &newest = Get(m_count - 1);
+            arcLength = newest.arcLength + glm::distance(newest.position, position);
+        }
+
+        if (m_count == m_samples.size()) {
+            m_oldest = (m_oldest + 1) % m_samples.size();
+            m_count--;
+        }
+        Get(m_count++) = {position, arcLength};
+
+        if (arcLength > REBASE_ARC_LENGTH) {
+            float base = Get(0).arcLength;
+            for (Sample &sample : m_samples) {
+                sample.arcLength -= base;
+            }
+        }
+    }
+
+    float SnakePath::Length() const {
+        return m_count > 0 ? Get(m_count - 1).arcLength - Get(0).arcLength : 0.0f;
+    }
+
+    glm::vec2 SnakePath::Interpolate(uint32_t i, float arcLength) const {
+        // between samples i and i + 1
+        const Sample &a = Get(i);
+        const Sample &b = Get(i + 1);
+        float span = b.arcLength - a.arcLength;
+        float t = span > 0.0f ? (arcLength - a.arcLength) / span : 0.0f;
+        return a.position + (b.position - a.position) * t;
+    }
+
+    glm::vec2 SnakePath::Extrapolate(float arcLength) const {
+        const Sample &oldest = Get(0);
+        const Sample &next = Get(1);
+        glm::vec2 step = oldest.position - next.position;
+        float stepLength = glm::length(step);
+        if (stepLength <= 0.0f) {
+            return oldest.position;
+        }
+        return oldest.position + step * ((oldest.arcLength - arcLength) / stepLength);
+    }
+
+    glm::vec2 SnakePath::At(float distance) const {
+        assert(m_count >= 2 && "Reset the path before reading it");
+
+        float arcLength = Get(m_count - 1).arcLength - distance;
+        if (arcLength <= Get(0).arcLength) {
+            return Extrapolate(arcLength);
+        }
+        if (distance <= 0.0f) {
+            return Get(m_count - 1).position;
+        }
+
+        // first sample past arcLength, samples are sorted by it
+        uint32_t low = 1, high = m_count - 1;
+        while (low < high) {
+            uint32_t mid = (low + high) / 2;
+            if (Get(mid).arcLength < arcLength) {
+                low = mid + 1;
+            } else {
+                high = mid;
+            }
+        }
+        return Interpolate(low - 1, arcLength);
+    }
+
+    void SnakePath::Resolve(float spacing, size_t count, glm::vec2 *positions) const {
+        assert(m_count >= 2 && "Reset the path before reading it");
+
+        float headArcLength = Get(m_count - 1).arcLength;
+        float oldestArcLength = Get(0).arcLength;
+
+        // the targets only move toward the tail, so one cursor walks the samples once
+        uint32_t i = m_count - 1;
+        for (size_t segment = 0; segment < count; segment++) {
+            float arcLength = headArcLength - static_cast<float>(segment) * spacing;
+            if (segment == 0) {
+                positions[segment] = Get(m_count - 1).position;
+                continue;
+            }
+            if (arcLength <= oldestArcLength) {
+                positions[segment] = Extrapolate(arcLength);
+                continue;
+            }
+            while (Get(i - 1).arcLength >= arcLength) {
+                i--;
+            }
+            positions[segment] = Interpolate(i - 1, arcLength);
+        }
+    }
+
+} // engine
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <glm/vec2.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace engine {
+
+    // The path the snake's head took, as a fixed ring of samples with their cumulative arc length.
+    // Body segments sit at fixed distances behind the head along it, so they are looked up instead of
+    // being pulled after the head link by link, growing is just asking for one more distance, and
+    // every segment can be resolved independently of the others.
+    class SnakePath {
+    public:
+        // minSampleDistance is the spacing of the recorded samples, a few per segment keep the body
+        // close to the path the head actually took. Once capacity samples are recorded the oldest
+        // ones are dropped.
+        SnakePath(uint32_t capacity, float minSampleDistance);
+
+        // Starts over with a straight path from tail to head.
+        void Reset(const glm::vec2 &tail, const glm::vec2 &head);
+
+        // Moves the head. A new sample is only recorded once the head is minSampleDistance away from
+        // the previous one, until then the newest sample follows the head.
+        void Push(const glm::vec2 &head);
+
+        // The point distance behind the head along the path, by binary search. Past the oldest sample
+        // the path continues straight in the direction of its last step.
+        [[nodiscard]] glm::vec2 At(float distance) const;
+
+        // positions[i] = At(i * spacing) for count points, in one walk from the head down.
+        void Resolve(float spacing, size_t count, glm::vec2 *positions) const;
+
+        // from the oldest sample to the head
+        [[nodiscard]] float Length() const;
+
+        [[nodiscard]] uint32_t SampleCount() const { return m_count; }
+
+    private:
+        struct Sample {
+            glm::vec2 position;
+            // cumulative, increases toward the head
+            float arcLength;
+        };
+
+        // i-th sample from the oldest
+        [[nodiscard]] const Sample &Get(uint32_t i) const { return m_samples[(m_oldest + i) % m_samples.size()]; }
+        Sample &Get(uint32_t i) { return m_samples[(m_oldest + i) % m_samples.size()]; }
+
+        [[nodiscard]] glm::vec2 Interpolate(uint32_t i, float arcLength) const;
+        [[nodiscard]] glm::vec2 Extrapolate(float arcLength) const;
+
+        void Append(const glm::vec2 &position);
+
+        std::vector<Sample> m_samples;
+        uint32_t m_oldest = 0;
+        uint32_t m_count = 0;
+        const float m_minSampleDistance;
+    };
+
+} // engine
@@ -35,40 +35,40 @@ void SwapChain::Init() {
 
 SwapChain::~SwapChain() {
   for (auto imageView : swapChainImageViews) {
-    vkDestroyImageView(device.device(), imageView, nullptr);
+    device.dispatch().vkDestroyImageView(device.device(), imageView, nullptr);
   }
   swapChainImageViews.clear();
 
   if (swapChain != nullptr) {
-    vkDestroySwapchainKHR(device.device(), swapChain, nullptr);
+    device.dispatch().vkDestroySwapchainKHR(device.device(), swapChain, nullptr);
     swapChain = nullptr;
   }
 
   for (int i = 0; i < depthImages.size(); i++) {
-    vkDestroyImageView(device.device(), depthImageViews[i], nullptr);
-    vkDestroyImage(device.device(), depthImages[i], nullptr);
-    vkFreeMemory(device.device(), depthImageMemorys[i], nullptr);
+    device.dispatch().vkDestroyImageView(device.device(), depthImageViews[i], nullptr);
+    device.dispatch().vkDestroyImage(device.device(), depthImages[i], nullptr);
+    device.dispatch().vkFreeMemory(device.device(), depthImageMemorys[i], nullptr);
   }
 
   for (auto framebuffer : swapChainFramebuffers) {
-    vkDestroyFramebuffer(device.device(), framebuffer, nullptr);
+    device.dispatch().vkDestroyFramebuffer(device.device(), framebuffer, nullptr);
   }
 
-  vkDestroyRenderPass(device.device(), renderPass, nullptr);
+  device.dispatch().vkDestroyRenderPass(device.device(), renderPass, nullptr);
 
   // cleanup synchronization objects
   for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
-    vkDestroySemaphore(device.device(), renderFinishedSemaphores[i], nullptr);
-    vkDestroySemaphore(device.device(), imageAvailableSemaphores[i], nullptr);
-    vkDestroyFence(device.device(), inFlightFences[i], nullptr);
+    device.dispatch().vkDestroySemaphore(device.device(), renderFinishedSemaphores[i], nullptr);
+    device.dispatch().vkDestroySemaphore(device.device(), imageAvailableSemaphores[i], nullptr);
+    device.dispatch().vkDestroyFence(device.device(), inFlightFences[i], nullptr);
   }
 }
 
 VkResult SwapChain::acquireNextImage(uint32_t *imageIndex) {
-  vkWaitForFences(device.device(), 1, &inFlightFences[currentFrame], VK_TRUE,
+  device.dispatch().vkWaitForFences(device.device(), 1, &inFlightFences[currentFrame], VK_TRUE,
                   std::numeric_limits<uint64_t>::max());
 
-  VkResult result = vkAcquireNextImageKHR(
+  VkResult result = device.dispatch().vkAcquireNextImageKHR(
       device.device(), swapChain, std::numeric_limits<uint64_t>::max(),
       imageAvailableSemaphores[currentFrame], // must be a not signaled
       // semaphore
@@ -80,7 +80,7 @@ VkResult SwapChain::acquireNextImage(uint32_t *imageIndex) {
 VkResult SwapChain::submitCommandBuffers(const VkCommandBuffer *buffers,
                                          uint32_t *imageIndex) {
   if (imagesInFlight[*imageIndex] != VK_NULL_HANDLE) {
-    vkWaitForFences(device.device(), 1, &imagesInFlight[*imageIndex], VK_TRUE,
+    device.dispatch().vkWaitForFences(device.device(), 1, &imagesInFlight[*imageIndex], VK_TRUE,
                     UINT64_MAX);
   }
   imagesInFlight[*imageIndex] = inFlightFences[currentFrame];
@@ -102,8 +102,8 @@ VkResult SwapChain::submitCommandBuffers(const VkCommandBuffer *buffers,
   submitInfo.signalSemaphoreCount = 1;
   submitInfo.pSignalSemaphores = signalSemaphores;
 
-  vkResetFences(device.device(), 1, &inFlightFences[currentFrame]);
-  if (vkQueueSubmit(device.graphicsQueue(), 1, &submitInfo,
+  device.dispatch().vkResetFences(device.device(), 1, &inFlightFences[currentFrame]);
+  if (device.dispatch().vkQueueSubmit(device.graphicsQueue(), 1, &submitInfo,
                     inFlightFences[currentFrame]) != VK_SUCCESS) {
     throw std::runtime_error("failed to submit draw command buffer!");
   }
@@ -120,7 +120,7 @@ VkResult SwapChain::submitCommandBuffers(const VkCommandBuffer *buffers,
 
   presentInfo.pImageIndices = imageIndex;
 
-  auto result = vkQueuePresentKHR(device.presentQueue(), &presentInfo);
+  auto result = device.dispatch().vkQueuePresentKHR(device.presentQueue(), &presentInfo);
 
   currentFrame = (currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
 
@@ -176,7 +176,7 @@ void SwapChain::createSwapChain() {
   createInfo.oldSwapchain =
       m_OldSwapChain == nullptr ? VK_NULL_HANDLE : m_OldSwapChain->swapChain;
 
-  if (vkCreateSwapchainKHR(device.device(), &createInfo, nullptr, &swapChain) !=
+  if (device.dispatch().vkCreateSwapchainKHR(device.device(), &createInfo, nullptr, &swapChain) !=
       VK_SUCCESS) {
     throw std::runtime_error("failed to create swap chain!");
   }
@@ -186,9 +186,9 @@ void SwapChain::createSwapChain() {
   // we'll first query the final number of images with vkGetSwapchainImagesKHR,
   // then resize the container and finally call it again to retrieve the
   // handles.
-  vkGetSwapchainImagesKHR(device.device(), swapChain, &imageCount, nullptr);
+  device.dispatch().vkGetSwapchainImagesKHR(device.device(), swapChain, &imageCount, nullptr);
   swapChainImages.resize(imageCount);
-  vkGetSwapchainImagesKHR(device.device(), swapChain, &imageCount,
+  device.dispatch().vkGetSwapchainImagesKHR(device.device(), swapChain, &imageCount,
                           swapChainImages.data());
 
   swapChainImageFormat = surfaceFormat.format;
@@ -209,7 +209,7 @@ void SwapChain::createImageViews() {
     viewInfo.subresourceRange.baseArrayLayer = 0;
     viewInfo.subresourceRange.layerCount = 1;
 
-    if (vkCreateImageView(device.device(), &viewInfo, nullptr,
+    if (device.dispatch().vkCreateImageView(device.device(), &viewInfo, nullptr,
                           &swapChainImageViews[i]) != VK_SUCCESS) {
       throw std::runtime_error("failed to create texture image view!");
     }
@@ -274,7 +274,7 @@ void SwapChain::createRenderPass() {
   renderPassInfo.dependencyCount = 1;
   renderPassInfo.pDependencies = &dependency;
 
-  if (vkCreateRenderPass(device.device(), &renderPassInfo, nullptr,
+  if (device.dispatch().vkCreateRenderPass(device.device(), &renderPassInfo, nullptr,
                          &renderPass) != VK_SUCCESS) {
     throw std::runtime_error("failed to create render pass!");
   }
@@ -296,7 +296,7 @@ void SwapChain::createFramebuffers() {
     framebufferInfo.height = swapChainExtent.height;
     framebufferInfo.layers = 1;
 
-    if (vkCreateFramebuffer(device.device(), &framebufferInfo, nullptr,
+    if (device.dispatch().vkCreateFramebuffer(device.device(), &framebufferInfo, nullptr,
                             &swapChainFramebuffers[i]) != VK_SUCCESS) {
       throw std::runtime_error("failed to create framebuffer!");
     }
@@ -343,7 +343,7 @@ void SwapChain::createDepthResources() {
     viewInfo.subresourceRange.baseArrayLayer = 0;
     viewInfo.subresourceRange.layerCount = 1;
 
-    if (vkCreateImageView(device.device(), &viewInfo, nullptr,
+    if (device.dispatch().vkCreateImageView(device.device(), &viewInfo, nullptr,
                           &depthImageViews[i]) != VK_SUCCESS) {
       throw std::runtime_error("failed to create texture image view!");
     }
@@ -364,11 +364,11 @@ void SwapChain::createSyncObjects() {
   fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
 
   for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
-    if (vkCreateSemaphore(device.device(), &semaphoreInfo, nullptr,
+    if (device.dispatch().vkCreateSemaphore(device.device(), &semaphoreInfo, nullptr,
                           &imageAvailableSemaphores[i]) != VK_SUCCESS ||
-        vkCreateSemaphore(device.device(), &semaphoreInfo, nullptr,
+        device.dispatch().vkCreateSemaphore(device.device(), &semaphoreInfo, nullptr,
                           &renderFinishedSemaphores[i]) != VK_SUCCESS ||
-        vkCreateFence(device.device(), &fenceInfo, nullptr,
+        device.dispatch().vkCreateFence(device.device(), &fenceInfo, nullptr,
                       &inFlightFences[i]) != VK_SUCCESS) {
       throw std::runtime_error(
           "failed to create synchronization objects for a frame!");
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstdint>
+#include <cstring>
 #include <functional>
 
 namespace engine {
@@ -8,4 +10,33 @@ void HashCombine(std::size_t &seed, const T &v, const Rest &...rest) {
   seed ^= std::hash<T>{}(v) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
   (HashCombine(seed, rest), ...);
 };
+
+// Non-cryptographic 64-bit hash over a block of memory, eight bytes per step so hashing
+// whole files stays cheap. Used to detect when a cooked asset is out of date.
+inline uint64_t HashBytes(const void *data, size_t size, uint64_t seed = 0) {
+  constexpr uint64_t prime = 0x9E3779B97F4A7C15ull;
+  auto mix = [](uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDull;
+    h ^= h >> 33;
+    return h;
+  };
+
+  const auto *bytes = static_cast<const unsigned char *>(data);
+  uint64_t hash = seed ^ (size * prime);
+
+  size_t i = 0;
+  for (; i + 8 <= size; i += 8) {
+    uint64_t chunk;
+    std::memcpy(&chunk, bytes + i, 8);
+    hash = (hash ^ mix(chunk)) * prime;
+    hash = (hash << 31) | (hash >> 33);
+  }
+
+  uint64_t tail = 0;
+  std::memcpy(&tail, bytes + i, size - i);
+  hash = (hash ^ mix(tail)) * prime;
+
+  return mix(hash);
+}
 } // namespace engine
@@ -42,14 +42,14 @@ DescriptorPool::DescriptorPool(
     descriptorPoolInfo.maxSets = maxSets;
     descriptorPoolInfo.flags = poolFlags;
 
-    if (vkCreateDescriptorPool(mDevice.device(), &descriptorPoolInfo, nullptr, &mDescriptorPool) !=
+    if (mDevice.dispatch().vkCreateDescriptorPool(mDevice.device(), &descriptorPoolInfo, nullptr, &mDescriptorPool) !=
         VK_SUCCESS) {
         throw std::runtime_error("failed to create descriptor pool!");
     }
 }
 
 DescriptorPool::~DescriptorPool() {
-    vkDestroyDescriptorPool(mDevice.device(), mDescriptorPool, nullptr);
+    mDevice.dispatch().vkDestroyDescriptorPool(mDevice.device(), mDescriptorPool, nullptr);
 }
 
 bool DescriptorPool::allocateDescriptor(
@@ -62,14 +62,14 @@ bool DescriptorPool::allocateDescriptor(
 
     // Might want to create a "DescriptorPoolManager" class that handles this case, and builds
     // a new pool whenever an old pool fills up. But this is beyond our current scope
-    if (vkAllocateDescriptorSets(mDevice.device(), &allocInfo, &descriptor) != VK_SUCCESS) {
+    if (mDevice.dispatch().vkAllocateDescriptorSets(mDevice.device(), &allocInfo, &descriptor) != VK_SUCCESS) {
         return false;
     }
     return true;
 }
 
 void DescriptorPool::freeDescriptors(std::vector<VkDescriptorSet> &descriptors) const {
-    vkFreeDescriptorSets(
+    mDevice.dispatch().vkFreeDescriptorSets(
             mDevice.device(),
             mDescriptorPool,
             static_cast<uint32_t>(descriptors.size()),
@@ -77,7 +77,7 @@ void DescriptorPool::freeDescriptors(std::vector<VkDescriptorSet> &descriptors)
 }
 
 void DescriptorPool::resetPool() {
-    vkResetDescriptorPool(mDevice.device(), mDescriptorPool, 0);
+    mDevice.dispatch().vkResetDescriptorPool(mDevice.device(), mDescriptorPool, 0);
 }
 
 }
\ No newline at end of file
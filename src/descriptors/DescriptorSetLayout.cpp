@@ -3,6 +3,7 @@
 //
 
 #include "DescriptorSetLayout.h"
+#include "LayoutCache.h"
 
 #include <cassert>
 #include <stdexcept>
@@ -28,6 +29,10 @@ std::unique_ptr<DescriptorSetLayout> DescriptorSetLayout::Builder::build() const
     return std::make_unique<DescriptorSetLayout>(mDevice, bindings);
 }
 
+std::shared_ptr<DescriptorSetLayout> DescriptorSetLayout::Builder::build(LayoutCache &cache) const {
+    return cache.getSetLayout(bindings);
+}
+
     DescriptorSetLayout::DescriptorSetLayout(
             Device &device, std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding> bindings)
             : mDevice{device}, mBindings{bindings} {
@@ -41,7 +46,7 @@ std::unique_ptr<DescriptorSetLayout> DescriptorSetLayout::Builder::build() const
         descriptorSetLayoutInfo.bindingCount = static_cast<uint32_t>(setLayoutBindings.size());
         descriptorSetLayoutInfo.pBindings = setLayoutBindings.data();
 
-        if (vkCreateDescriptorSetLayout(
+        if (mDevice.dispatch().vkCreateDescriptorSetLayout(
                 mDevice.device(),
                 &descriptorSetLayoutInfo,
                 nullptr,
@@ -51,7 +56,7 @@ std::unique_ptr<DescriptorSetLayout> DescriptorSetLayout::Builder::build() const
     }
 
     DescriptorSetLayout::~DescriptorSetLayout() {
-        vkDestroyDescriptorSetLayout(mDevice.device(), mDescriptorSetLayout, nullptr);
+        mDevice.dispatch().vkDestroyDescriptorSetLayout(mDevice.device(), mDescriptorSetLayout, nullptr);
     }
 
 }
\ No newline at end of file
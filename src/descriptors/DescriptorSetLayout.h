@@ -6,6 +6,8 @@
 #include <unordered_map>
 
 namespace engine {
+class LayoutCache;
+
 class DescriptorSetLayout {
 public:
     class Builder {
@@ -20,6 +22,8 @@ public:
 
         std::unique_ptr <DescriptorSetLayout> build() const;
 
+        std::shared_ptr <DescriptorSetLayout> build(LayoutCache &cache) const;
+
     private:
         Device &mDevice;
         std::unordered_map <uint32_t, VkDescriptorSetLayoutBinding> bindings{};
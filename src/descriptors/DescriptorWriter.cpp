@@ -65,7 +65,7 @@ void DescriptorWriter::overwrite(VkDescriptorSet &set) {
     for (auto &write : mWrites) {
         write.dstSet = set;
     }
-    vkUpdateDescriptorSets(mPool.mDevice.device(), mWrites.size(), mWrites.data(), 0, nullptr);
+    mPool.mDevice.dispatch().vkUpdateDescriptorSets(mPool.mDevice.device(), mWrites.size(), mWrites.data(), 0, nullptr);
 }
 
 }
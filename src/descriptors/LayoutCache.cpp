@@ -0,0 +1,112 @@
+#include "LayoutCache.h"
+#include "Utils.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace engine {
+
+LayoutCache::~LayoutCache() {
+    for (auto &kv : mPipelineLayouts) {
+        mDevice.dispatch().vkDestroyPipelineLayout(mDevice.device(), kv.second, nullptr);
+    }
+}
+
+std::shared_ptr<DescriptorSetLayout> LayoutCache::getSetLayout(
+        const std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding> &bindings) {
+    SetLayoutKey key{};
+    key.bindings.reserve(bindings.size());
+    for (auto &kv : bindings) {
+        key.bindings.push_back(kv.second);
+    }
+
+    // unordered_map iteration order is unspecified, sort so equal binding sets hash equally
+    std::sort(key.bindings.begin(), key.bindings.end(),
+              [](const VkDescriptorSetLayoutBinding &a, const VkDescriptorSetLayoutBinding &b) {
+                  return a.binding < b.binding;
+              });
+
+    auto it = mSetLayouts.find(key);
+    if (it != mSetLayouts.end()) {
+        return it->second;
+    }
+
+    auto layout = std::make_shared<DescriptorSetLayout>(mDevice, bindings);
+    mSetLayouts.emplace(std::move(key), layout);
+    mOwnedSetLayouts.insert(layout->getDescriptorSetLayout());
+    return layout;
+}
+
+VkPipelineLayout LayoutCache::getPipelineLayout(
+        const std::vector<VkDescriptorSetLayout> &setLayouts,
+        const std::vector<VkPushConstantRange> &pushConstantRanges) {
+    PipelineLayoutKey key{setLayouts, pushConstantRanges};
+
+    auto it = mPipelineLayouts.find(key);
+    if (it != mPipelineLayouts.end()) {
+        return it->second;
+    }
+
+    // a layout destroyed elsewhere could have its handle reused for different bindings
+    for (VkDescriptorSetLayout setLayout : setLayouts) {
+        if (!mOwnedSetLayouts.count(setLayout)) {
+            throw std::runtime_error("pipeline layout uses a descriptor set layout not created by the layout cache");
+        }
+    }
+
+    VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+    pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(setLayouts.size());
+    pipelineLayoutInfo.pSetLayouts = setLayouts.data();
+    pipelineLayoutInfo.pushConstantRangeCount = static_cast<uint32_t>(pushConstantRanges.size());
+    pipelineLayoutInfo.pPushConstantRanges = pushConstantRanges.data();
+
+    VkPipelineLayout pipelineLayout;
+    if (mDevice.dispatch().vkCreatePipelineLayout(mDevice.device(), &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create pipeline layout");
+    }
+
+    mPipelineLayouts.emplace(std::move(key), pipelineLayout);
+    return pipelineLayout;
+}
+
+bool LayoutCache::SetLayoutKey::operator==(const SetLayoutKey &other) const {
+    return std::equal(bindings.begin(), bindings.end(), other.bindings.begin(), other.bindings.end(),
+                      [](const VkDescriptorSetLayoutBinding &a, const VkDescriptorSetLayoutBinding &b) {
+                          return a.binding == b.binding &&
+                                 a.descriptorType == b.descriptorType &&
+                                 a.descriptorCount == b.descriptorCount &&
+                                 a.stageFlags == b.stageFlags &&
+                                 a.pImmutableSamplers == b.pImmutableSamplers;
+                      });
+}
+
+bool LayoutCache::PipelineLayoutKey::operator==(const PipelineLayoutKey &other) const {
+    return setLayouts == other.setLayouts &&
+           std::equal(pushConstantRanges.begin(), pushConstantRanges.end(),
+                      other.pushConstantRanges.begin(), other.pushConstantRanges.end(),
+                      [](const VkPushConstantRange &a, const VkPushConstantRange &b) {
+                          return a.stageFlags == b.stageFlags && a.offset == b.offset && a.size == b.size;
+                      });
+}
+
+size_t LayoutCache::KeyHash::operator()(const SetLayoutKey &key) const {
+    size_t seed = key.bindings.size();
+    for (auto &binding : key.bindings) {
+        HashCombine(seed, binding.binding, binding.descriptorType, binding.descriptorCount, binding.stageFlags);
+    }
+    return seed;
+}
+
+size_t LayoutCache::KeyHash::operator()(const PipelineLayoutKey &key) const {
+    size_t seed = key.setLayouts.size();
+    for (auto setLayout : key.setLayouts) {
+        HashCombine(seed, setLayout);
+    }
+    for (auto &range : key.pushConstantRanges) {
+        HashCombine(seed, range.stageFlags, range.offset, range.size);
+    }
+    return seed;
+}
+
+}
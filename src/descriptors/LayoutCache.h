@@ -0,0 +1,69 @@
+#pragma once
+
+#include "Device.h"
+#include "DescriptorSetLayout.h"
+
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace engine {
+
+// Deduplicates descriptor set layouts and pipeline layouts. Two requests with the same
+// bindings (or the same set layouts and push constant ranges) get the same handle back,
+// which keeps memory down and makes pipelines built by different systems layout-compatible.
+//
+// The cache keeps every set layout it hands out alive until it is destroyed, so a set layout
+// handle always stands for the same bindings and pipeline layouts can be keyed on the handles.
+// getPipelineLayout() therefore only accepts set layouts that came from getSetLayout().
+class LayoutCache {
+public:
+    explicit LayoutCache(Device &device) : mDevice{device} {}
+
+    ~LayoutCache();
+
+    LayoutCache(const LayoutCache &) = delete;
+
+    LayoutCache &operator=(const LayoutCache &) = delete;
+
+    std::shared_ptr<DescriptorSetLayout> getSetLayout(
+            const std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding> &bindings);
+
+    // Throws for set layouts that were not created by this cache.
+    VkPipelineLayout getPipelineLayout(
+            const std::vector<VkDescriptorSetLayout> &setLayouts,
+            const std::vector<VkPushConstantRange> &pushConstantRanges);
+
+    [[nodiscard]] size_t setLayoutCount() const { return mSetLayouts.size(); }
+
+    [[nodiscard]] size_t pipelineLayoutCount() const { return mPipelineLayouts.size(); }
+
+private:
+    struct SetLayoutKey {
+        std::vector<VkDescriptorSetLayoutBinding> bindings;
+
+        bool operator==(const SetLayoutKey &other) const;
+    };
+
+    struct PipelineLayoutKey {
+        std::vector<VkDescriptorSetLayout> setLayouts;
+        std::vector<VkPushConstantRange> pushConstantRanges;
+
+        bool operator==(const PipelineLayoutKey &other) const;
+    };
+
+    struct KeyHash {
+        size_t operator()(const SetLayoutKey &key) const;
+
+        size_t operator()(const PipelineLayoutKey &key) const;
+    };
+
+    Device &mDevice;
+    std::unordered_map<SetLayoutKey, std::shared_ptr<DescriptorSetLayout>, KeyHash> mSetLayouts;
+    std::unordered_map<PipelineLayoutKey, VkPipelineLayout, KeyHash> mPipelineLayouts;
+    // the handles of mSetLayouts
+    std::unordered_set<VkDescriptorSetLayout> mOwnedSetLayouts;
+};
+
+}
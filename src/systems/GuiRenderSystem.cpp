@@ -1,58 +1,121 @@
 #include <stdexcept>
 #include "GuiRenderSystem.h"
-#include "Components.h"
-#include "SnakeGame.h"
+#include "EmbeddedShaders.h"
+#include "descriptors/DescriptorWriter.h"
+
+#include <glm/gtc/packing.hpp>
+
+#include <algorithm>
+#include <cassert>
 
 namespace engine {
 
-    struct ParticlePushConstantsData {
-        glm::mat3 modelMatrix{1.0f};
+    struct GuiPushConstantsData {
+        // pixels to normalized device coordinates
+        glm::vec2 scale;
     };
 
-    GuiRenderSystem::GuiRenderSystem(Device &device, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout) : m_device(device) {
+    static_assert(shaders::gui_vert.pushConstantSize == sizeof(GuiPushConstantsData), "must match the push block in gui.vert");
+    static_assert(shaders::gui_frag.binds(1, 0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER), "gui.frag samples the atlas at set 1");
+
+    GuiRenderSystem::GuiRenderSystem(Device &device, LayoutCache &layoutCache, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout,
+                                     const TextureAtlas &atlas, uint32_t maxElements)
+            : m_device(device), m_layoutCache(layoutCache), m_atlas(atlas), m_renderPass(renderPass), m_maxElements(maxElements) {
         CreatePipelineLayout(globalSetLayout);
         CreatePipeline(renderPass);
+        CreateResources();
     }
 
     GuiRenderSystem::~GuiRenderSystem() {
-        vkDestroyPipelineLayout(m_device.device(), m_pipelineLayout, nullptr);
+        if (m_hotReloader) {
+            m_hotReloader->Unwatch(this);
+        }
     }
 
-    void GuiRenderSystem::RenderElements(FrameInfo &frameInfo) {
+    void GuiRenderSystem::WatchShaders(ShaderHotReloader &hotReloader) {
+        m_hotReloader = &hotReloader;
+        hotReloader.Watch(this, {&shaders::gui_vert, &shaders::gui_frag}, m_pipeline,
+                          [this] { CreatePipeline(m_renderPass); });
+    }
+
+    void GuiRenderSystem::RenderElements(FrameInfo &frameInfo, GuiInfo &guiInfo) {
+        std::vector<GuiElement> &elements = guiInfo.guiElements;
+        if (elements.empty()) {
+            return;
+        }
+
+        // one pipeline and one atlas leave nothing to sort by but the layer, and a HUD built back
+        // to front is usually in order already
+        auto byLayer = [](const GuiElement &a, const GuiElement &b) { return a.layer < b.layer; };
+        if (!std::is_sorted(elements.begin(), elements.end(), byLayer)) {
+            std::stable_sort(elements.begin(), elements.end(), byLayer);
+        }
+
+        Buffer &instanceBuffer = *m_instanceBuffers[frameInfo.frameIndex];
+        auto *instances = static_cast<GuiInstance *>(instanceBuffer.getMappedMemory());
+        auto count = static_cast<uint32_t>(std::min<size_t>(elements.size(), m_maxElements));
+
+        for (uint32_t i = 0; i < count; i++) {
+            const GuiElement &element = elements[i];
+            const TextureAtlas::Region &region = m_atlas.GetRegion(element.region);
+            instances[i].position = element.position;
+            instances[i].extent = element.extent;
+            instances[i].uvRect = {region.uvMin, region.uvMax};
+            instances[i].color = glm::packUnorm4x8(element.color);
+        }
+        instanceBuffer.flush();
+
         m_pipeline->bind(frameInfo.commandBuffer);
 
-        vkCmdBindDescriptorSets(
+        std::vector<VkDescriptorSet> descriptorSets = frameInfo.descriptorSets;
+        descriptorSets.push_back(m_atlasSet);
+        m_device.dispatch().vkCmdBindDescriptorSets(
                 frameInfo.commandBuffer,
                 VK_PIPELINE_BIND_POINT_GRAPHICS,
                 m_pipelineLayout,
                 0,
-                frameInfo.descriptorSets.size(),
-                frameInfo.descriptorSets.data(),
+                descriptorSets.size(),
+                descriptorSets.data(),
                 0,
                 nullptr
         );
 
-//        frameInfo.particleSystem.Bind (frameInfo.commandBuffer);
-//        frameInfo.particleSystem.Render(frameInfo.commandBuffer);
+        GuiPushConstantsData push{};
+        push.scale = {2.0f / static_cast<float>(guiInfo.extent.width), 2.0f / static_cast<float>(guiInfo.extent.height)};
+        m_device.dispatch().vkCmdPushConstants(frameInfo.commandBuffer, m_pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT,
+                                               0, sizeof(GuiPushConstantsData), &push);
+
+        VkBuffer buffers[] = {instanceBuffer.getBuffer()};
+        VkDeviceSize offsets[] = {0};
+        m_device.dispatch().vkCmdBindVertexBuffers(frameInfo.commandBuffer, 0, 1, buffers, offsets);
+
+        // four strip vertices per quad, the corners come from gl_VertexIndex
+        m_device.dispatch().vkCmdDraw(frameInfo.commandBuffer, 4, count, 0, 0);
     }
 
     void GuiRenderSystem::CreatePipelineLayout(VkDescriptorSetLayout globalSetLayout) {
-        VkPushConstantRange pushConstantRange{};
-        pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
-        pushConstantRange.offset = 0;
-        pushConstantRange.size = sizeof(ParticlePushConstantsData);
-
-        std::vector<VkDescriptorSetLayout> descriptorSetLayouts{globalSetLayout};
-
-        VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
-        pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-        pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(descriptorSetLayouts.size());
-        pipelineLayoutInfo.pSetLayouts = descriptorSetLayouts.data();
-        pipelineLayoutInfo.pushConstantRangeCount = 1;
-        pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
-
-        if (vkCreatePipelineLayout(m_device.device(), &pipelineLayoutInfo, nullptr, &m_pipelineLayout) != VK_SUCCESS) {
-            throw std::runtime_error("Failed to create pipeline layout");
+        ShaderLayout layout{m_device, m_layoutCache, {&shaders::gui_vert, &shaders::gui_frag}, {globalSetLayout}};
+        m_atlasSetLayout = layout.setLayout(1);
+        m_pipelineLayout = layout.pipelineLayout();
+    }
+
+    void GuiRenderSystem::CreateResources() {
+        m_descriptorPool = DescriptorPool::Builder(m_device)
+                .setMaxSets(1)
+                .addPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1)
+                .build();
+
+        // the atlas never changes, so all frames share its set
+        VkDescriptorImageInfo atlasInfo = m_atlas.GetImage().descriptorInfo();
+        DescriptorWriter(*m_atlasSetLayout, *m_descriptorPool)
+                .writeImage(0, &atlasInfo)
+                .build(m_atlasSet);
+
+        for (auto &buffer : m_instanceBuffers) {
+            buffer = std::make_unique<Buffer>(m_device, sizeof(GuiInstance), m_maxElements,
+                                              VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+            // stays mapped for the lifetime of the system
+            buffer->map();
         }
     }
 
@@ -61,7 +124,7 @@ namespace engine {
 
         PipelineConfigInfo pipelineConfig{};
         pipelineConfig.inputAssemblyInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
-        pipelineConfig.inputAssemblyInfo.topology = VK_PRIMITIVE_TOPOLOGY_POINT_LIST;
+        pipelineConfig.inputAssemblyInfo.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP;
         pipelineConfig.inputAssemblyInfo.primitiveRestartEnable = VK_FALSE;
 
         pipelineConfig.viewportInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
@@ -126,15 +189,20 @@ namespace engine {
         pipelineConfig.dynamicStateInfo.dynamicStateCount = static_cast<uint32_t>(pipelineConfig.dynamicStateEnables.size());
         pipelineConfig.dynamicStateInfo.flags = 0;
 
-        pipelineConfig.bindingDescriptions = Particle::getBindingDescription();
-        pipelineConfig.attributeDescriptions = Particle::getAttributeDescriptions();
+        pipelineConfig.bindingDescriptions = {{0, sizeof(GuiInstance), VK_VERTEX_INPUT_RATE_INSTANCE}};
+        pipelineConfig.attributeDescriptions = {
+                {0, 0, VK_FORMAT_R32G32_SFLOAT, offsetof(GuiInstance, position)},
+                {1, 0, VK_FORMAT_R32G32_SFLOAT, offsetof(GuiInstance, extent)},
+                {2, 0, VK_FORMAT_R32G32B32A32_SFLOAT, offsetof(GuiInstance, uvRect)},
+                {3, 0, VK_FORMAT_R8G8B8A8_UNORM, offsetof(GuiInstance, color)},
+        };
         pipelineConfig.renderPass = renderPass;
         pipelineConfig.pipelineLayout = m_pipelineLayout;
 
-        pipelineConfig.vertPath = "../shader/gui.vert.spv";
-        pipelineConfig.fragPath = "../shader/gui.frag.spv";
-        pipelineConfig.geomPath = "../shader/gui.geom.spv";
+        auto shader = [this](const ShaderInfo &embedded) { return m_hotReloader ? m_hotReloader->Resolve(embedded) : &embedded; };
+        pipelineConfig.vertShader = shader(shaders::gui_vert);
+        pipelineConfig.fragShader = shader(shaders::gui_frag);
 
-        m_pipeline = std::make_unique<Pipeline>(  m_device, pipelineConfig);
+        m_pipeline = std::make_unique<Pipeline>(m_device, pipelineConfig);
     }
 } // engine
\ No newline at end of file
@@ -1,32 +1,68 @@
 #pragma once
 
+#include "Buffer.h"
 #include "Device.h"
 #include "Pipeline.h"
+#include "ShaderHotReloader.h"
 #include "FrameInfo.h"
+#include "SwapChain.h"
+#include "descriptors/DescriptorPool.h"
+#include "descriptors/DescriptorSetLayout.h"
+#include "descriptors/LayoutCache.h"
+#include "textures/TextureAtlas.h"
 
+#include <array>
 #include <memory>
 
 
 namespace engine {
 
     struct GuiElement {
+        // in pixels, from the top left corner of the screen
         glm::vec2 position;
         glm::vec2 extent;
+        // TextureAtlas::WHITE_REGION draws a flat colored quad
+        uint32_t region = TextureAtlas::WHITE_REGION;
+        // multiplies the atlas texels
+        glm::vec4 color{1.0f};
+        // higher layers are drawn on top, equal layers in submission order
+        uint32_t layer = 0;
     };
 
     struct GuiInfo {
-        VkCommandBuffer cmdBuffer;
+        VkExtent2D extent;
         std::vector<GuiElement> guiElements;
     };
 
+    // Draws screen space quads textured from one TextureAtlas. Every element of a frame is written
+    // into a persistently mapped per-frame instance buffer and expanded to a quad in the vertex
+    // shader, so the whole HUD is a single instanced draw call.
     class GuiRenderSystem {
     private:
+        // matches the vertex input of gui.vert
+        struct GuiInstance {
+            glm::vec2 position;
+            glm::vec2 extent;
+            glm::vec4 uvRect;
+            uint32_t color;
+        };
+
         Device &m_device;
+        LayoutCache &m_layoutCache;
+        const TextureAtlas &m_atlas;
         std::unique_ptr<Pipeline> m_pipeline;
         VkPipelineLayout m_pipelineLayout;
+        VkRenderPass m_renderPass;
+        ShaderHotReloader *m_hotReloader = nullptr;
+        std::shared_ptr<DescriptorSetLayout> m_atlasSetLayout;
+        std::unique_ptr<DescriptorPool> m_descriptorPool;
+        VkDescriptorSet m_atlasSet;
+        std::array<std::unique_ptr<Buffer>, SwapChain::MAX_FRAMES_IN_FLIGHT> m_instanceBuffers;
+        const uint32_t m_maxElements;
 
     public:
-        GuiRenderSystem(Device &device, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout);
+        GuiRenderSystem(Device &device, LayoutCache &layoutCache, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout,
+                        const TextureAtlas &atlas, uint32_t maxElements = 4096);
 
         ~GuiRenderSystem();
 
@@ -34,12 +70,19 @@ namespace engine {
 
         GuiRenderSystem &operator=(const GuiRenderSystem &) = delete;
 
-        void RenderElements(FrameInfo &frameInfo);
+        // Elements past maxElements are dropped. Sorts guiInfo.guiElements by layer if they were
+        // not submitted in layer order already.
+        void RenderElements(FrameInfo &frameInfo, GuiInfo &guiInfo);
+
+        // Rebuilds the pipeline whenever hotReloader recompiles gui.vert or gui.frag.
+        void WatchShaders(ShaderHotReloader &hotReloader);
 
     private:
         void CreatePipelineLayout(VkDescriptorSetLayout globalSetLayout);
 
         void CreatePipeline(VkRenderPass renderPass);
+
+        void CreateResources();
     };
 
 } // engine
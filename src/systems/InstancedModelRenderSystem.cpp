@@ -0,0 +1,334 @@
+#include "InstancedModelRenderSystem.h"
+#include "EmbeddedShaders.h"
+#include "descriptors/DescriptorWriter.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <stdexcept>
+
+namespace engine {
+
+    // levels beyond this are not drawn, GenerateLods makes 4
+    static constexpr uint32_t MAX_LODS = 8;
+    static constexpr uint32_t CULL_GROUP_SIZE = 64;
+
+    struct CullPushConstantsData {
+        glm::vec4 frustumPlanes[6];
+        // xyz camera position, w projection scale
+        glm::vec4 camera;
+        uint32_t instanceSlots;
+        uint32_t batchCount;
+        float pixelError;
+    };
+
+    static_assert(sizeof(CullPushConstantsData) <= 128, "push constants are only guaranteed to have 128 bytes");
+    static_assert(shaders::cull_comp.pushConstantSize == sizeof(CullPushConstantsData) &&
+                  shaders::compact_draws_comp.pushConstantSize == sizeof(CullPushConstantsData),
+                  "must match the push block in cull.comp and compact_draws.comp");
+
+    // Gribb/Hartmann extraction, planes point inwards. The near plane assumes a -1..1 depth range,
+    // which also holds (conservatively) for 0..1 projections.
+    static void ExtractFrustumPlanes(const glm::mat4 &m, glm::vec4 planes[6]) {
+        glm::vec4 row0{m[0][0], m[1][0], m[2][0], m[3][0]};
+        glm::vec4 row1{m[0][1], m[1][1], m[2][1], m[3][1]};
+        glm::vec4 row2{m[0][2], m[1][2], m[2][2], m[3][2]};
+        glm::vec4 row3{m[0][3], m[1][3], m[2][3], m[3][3]};
+
+        planes[0] = row3 + row0;
+        planes[1] = row3 - row0;
+        planes[2] = row3 + row1;
+        planes[3] = row3 - row1;
+        planes[4] = row3 + row2;
+        planes[5] = row3 - row2;
+
+        for (int i = 0; i < 6; i++) {
+            planes[i] /= glm::length(glm::vec3{planes[i]});
+        }
+    }
+
+    InstancedModelRenderSystem::InstancedModelRenderSystem(Device &device, LayoutCache &layoutCache,
+                                                           VkRenderPass renderPass,
+                                                           VkDescriptorSetLayout globalSetLayout,
+                                                           GeometryPool &geometryPool,
+                                                           uint32_t maxInstances, uint32_t maxModels)
+            : m_device(device), m_layoutCache(layoutCache), m_geometryPool(geometryPool),
+              m_poolGeneration(geometryPool.Generation()), m_maxInstances(maxInstances), m_maxModels(maxModels) {
+        const VkPhysicalDeviceFeatures &features = m_device.enabledFeatures();
+        if (!m_device.enabledFeatures12().drawIndirectCount || !features.multiDrawIndirect ||
+            !features.drawIndirectFirstInstance) {
+            throw std::runtime_error("GPU driven rendering needs drawIndirectCount, multiDrawIndirect and drawIndirectFirstInstance");
+        }
+
+        m_instances.reserve(m_maxInstances);
+
+        CreatePipelineLayouts(globalSetLayout);
+        CreatePipelines(renderPass);
+        CreateFrameResources();
+    }
+
+    InstancedModelRenderSystem::~InstancedModelRenderSystem() = default;
+
+    uint32_t InstancedModelRenderSystem::AddModel(GeometryPool::MeshHandle mesh) {
+        if (m_models.size() == m_maxModels) {
+            throw std::runtime_error("InstancedModelRenderSystem: too many models");
+        }
+
+        m_models.push_back(mesh);
+        m_batchCount += std::min(static_cast<uint32_t>(m_geometryPool.GetMesh(mesh).lods.size()), MAX_LODS);
+        m_modelInstanceCounts.push_back(0);
+        MarkStale();
+        return static_cast<uint32_t>(m_models.size() - 1);
+    }
+
+    uint32_t InstancedModelRenderSystem::AddInstance(uint32_t model, const component::Transform &transform) {
+        assert(model < m_models.size() && "Unknown model");
+
+        uint32_t instance;
+        if (!m_freeInstances.empty()) {
+            instance = m_freeInstances.back();
+            m_freeInstances.pop_back();
+        } else if (m_instances.size() < m_maxInstances) {
+            instance = static_cast<uint32_t>(m_instances.size());
+            m_instances.emplace_back();
+        } else {
+            return INVALID_INSTANCE;
+        }
+
+        m_instances[instance].modelIndex = model;
+        m_modelInstanceCounts[model]++;
+        m_instanceCount++;
+        SetTransform(instance, transform);
+        return instance;
+    }
+
+    void InstancedModelRenderSystem::SetTransform(uint32_t instance, const component::Transform &transform) {
+        m_instances[instance].modelMatrix = transform.mat4();
+        m_instances[instance].normalMatrix = glm::mat4{transform.normalMatrix()};
+        MarkStale();
+    }
+
+    void InstancedModelRenderSystem::RemoveInstance(uint32_t instance) {
+        InstanceData &data = m_instances[instance];
+        if (data.modelIndex == INVALID_INSTANCE) {
+            return;
+        }
+
+        // the slot stays in the buffer, the cull pass skips it
+        m_modelInstanceCounts[data.modelIndex]--;
+        m_instanceCount--;
+        data.modelIndex = INVALID_INSTANCE;
+        m_freeInstances.push_back(instance);
+        MarkStale();
+    }
+
+    void InstancedModelRenderSystem::Cull(FrameInfo &frameInfo, const glm::mat4 &projectionView,
+                                          const glm::vec3 &cameraPosition, float projectionScale, float pixelError) {
+        if (m_geometryPool.Generation() != m_poolGeneration) {
+            // defragmentation moved the meshes
+            m_poolGeneration = m_geometryPool.Generation();
+            MarkStale();
+        }
+
+        auto frameIndex = static_cast<uint32_t>(frameInfo.frameIndex);
+        if (m_staleFrames & (1u << frameIndex)) {
+            UploadFrameData(frameIndex);
+            m_staleFrames &= ~(1u << frameIndex);
+        }
+
+        FrameResources &frame = m_frames[frameIndex];
+        VkCommandBuffer commandBuffer = frameInfo.commandBuffer;
+
+        CullPushConstantsData push{};
+        ExtractFrustumPlanes(projectionView, push.frustumPlanes);
+        push.camera = glm::vec4{cameraPosition, projectionScale};
+        push.instanceSlots = static_cast<uint32_t>(m_instances.size());
+        push.batchCount = m_batchCount;
+        push.pixelError = pixelError;
+
+        m_device.dispatch().vkCmdFillBuffer(commandBuffer, frame.counters->getBuffer(), 0, VK_WHOLE_SIZE, 0);
+
+        VkMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+        m_device.dispatch().vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                             0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+        m_device.dispatch().vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_cullPipelineLayout,
+                                0, 1, &frame.cullSet, 0, nullptr);
+        m_device.dispatch().vkCmdPushConstants(commandBuffer, m_cullPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT,
+                           0, sizeof(CullPushConstantsData), &push);
+
+        m_cullPipeline->bind(commandBuffer);
+        m_device.dispatch().vkCmdDispatch(commandBuffer, (push.instanceSlots + CULL_GROUP_SIZE - 1) / CULL_GROUP_SIZE, 1, 1);
+
+        barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+        m_device.dispatch().vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                             0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+        m_compactPipeline->bind(commandBuffer);
+        m_device.dispatch().vkCmdDispatch(commandBuffer, (push.batchCount + CULL_GROUP_SIZE - 1) / CULL_GROUP_SIZE, 1, 1);
+
+        barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+        m_device.dispatch().vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                             VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT,
+                             0, 1, &barrier, 0, nullptr, 0, nullptr);
+    }
+
+    void InstancedModelRenderSystem::Render(FrameInfo &frameInfo) {
+        FrameResources &frame = m_frames[frameInfo.frameIndex];
+        VkCommandBuffer commandBuffer = frameInfo.commandBuffer;
+
+        m_pipeline->bind(commandBuffer);
+
+        std::vector<VkDescriptorSet> descriptorSets = frameInfo.descriptorSets;
+        descriptorSets.push_back(frame.drawSet);
+        m_device.dispatch().vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipelineLayout,
+                                0, static_cast<uint32_t>(descriptorSets.size()), descriptorSets.data(),
+                                0, nullptr);
+
+        if (m_instanceCount == 0) {
+            return;
+        }
+
+        // every model comes from the pool, so one bind and one draw call cover all of them
+        m_geometryPool.Bind(commandBuffer);
+        m_device.dispatch().vkCmdDrawIndexedIndirectCount(commandBuffer,
+                                      frame.commands->getBuffer(), 0,
+                                      frame.counters->getBuffer(), 0,
+                                      m_batchCount,
+                                      sizeof(VkDrawIndexedIndirectCommand));
+    }
+
+    void InstancedModelRenderSystem::UploadFrameData(uint32_t frameIndex) {
+        FrameResources &frame = m_frames[frameIndex];
+
+        std::vector<ModelData> models(m_models.size());
+        std::vector<BatchData> batches;
+        uint32_t visibleOffset = 0;
+
+        for (uint32_t m = 0; m < m_models.size(); m++) {
+            const GeometryPool::Mesh &mesh = m_geometryPool.GetMesh(m_models[m]);
+            uint32_t lodCount = std::min(static_cast<uint32_t>(mesh.lods.size()), MAX_LODS);
+
+            models[m].minExtent = glm::vec4{mesh.minExtent, 0.0f};
+            models[m].maxExtent = glm::vec4{mesh.maxExtent, 0.0f};
+            models[m].firstBatch = static_cast<uint32_t>(batches.size());
+            models[m].lodCount = lodCount;
+
+            for (uint32_t lod = 0; lod < lodCount; lod++) {
+                const Model::Lod &level = mesh.lods[lod];
+                BatchData batch{};
+                batch.indexCount = level.indexCount;
+                batch.firstIndex = mesh.firstIndex + level.firstIndex;
+                batch.vertexOffset = mesh.vertexOffset;
+                batch.firstInstance = visibleOffset;
+                batch.error = level.error;
+                batch.modelIndex = m;
+                batches.push_back(batch);
+
+                // in the worst case every instance of the model picks this level
+                visibleOffset += m_modelInstanceCounts[m];
+            }
+        }
+
+        if (!m_instances.empty()) {
+            frame.instances->writeToBuffer(m_instances.data(), m_instances.size() * sizeof(InstanceData));
+            frame.instances->flush();
+        }
+        if (!models.empty()) {
+            frame.models->writeToBuffer(models.data(), models.size() * sizeof(ModelData));
+            frame.models->flush();
+            frame.batches->writeToBuffer(batches.data(), batches.size() * sizeof(BatchData));
+            frame.batches->flush();
+        }
+    }
+
+    void InstancedModelRenderSystem::CreatePipelineLayouts(VkDescriptorSetLayout globalSetLayout) {
+        // both passes share one layout and descriptor set
+        ShaderLayout cullLayout{m_device, m_layoutCache, {&shaders::cull_comp, &shaders::compact_draws_comp}};
+        m_cullSetLayout = cullLayout.setLayout(0);
+        m_cullPipelineLayout = cullLayout.pipelineLayout();
+
+        ShaderLayout drawLayout{m_device, m_layoutCache, {&shaders::instanced_model_vert, &shaders::instanced_model_frag},
+                                {globalSetLayout}};
+        m_drawSetLayout = drawLayout.setLayout(1);
+        m_pipelineLayout = drawLayout.pipelineLayout();
+    }
+
+    void InstancedModelRenderSystem::CreatePipelines(VkRenderPass renderPass) {
+        assert(m_pipelineLayout != nullptr && "Cannot create pipeline before pipeline layout");
+
+        PipelineConfigInfo pipelineConfig{};
+        Pipeline::defaultPipelineConfigInfo(pipelineConfig);
+        pipelineConfig.renderPass = renderPass;
+        pipelineConfig.pipelineLayout = m_pipelineLayout;
+        pipelineConfig.vertShader = &shaders::instanced_model_vert;
+        pipelineConfig.fragShader = &shaders::instanced_model_frag;
+
+        m_pipeline = std::make_unique<Pipeline>(m_device, pipelineConfig);
+        m_cullPipeline = std::make_unique<ComputePipeline>(m_device, shaders::cull_comp, m_cullPipelineLayout);
+        m_compactPipeline = std::make_unique<ComputePipeline>(m_device, shaders::compact_draws_comp,
+                                                              m_cullPipelineLayout);
+    }
+
+    void InstancedModelRenderSystem::CreateFrameResources() {
+        uint32_t maxBatches = m_maxModels * MAX_LODS;
+
+        m_descriptorPool = DescriptorPool::Builder(m_device)
+                .setMaxSets(SwapChain::MAX_FRAMES_IN_FLIGHT * 2)
+                .addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, SwapChain::MAX_FRAMES_IN_FLIGHT * 8)
+                .build();
+
+        for (auto &frame : m_frames) {
+            auto hostBuffer = [&](VkDeviceSize size, uint32_t count) {
+                auto buffer = std::make_unique<Buffer>(m_device, size, count, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                                                       VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+                buffer->map();
+                return buffer;
+            };
+
+            frame.instances = hostBuffer(sizeof(InstanceData), m_maxInstances);
+            frame.models = hostBuffer(sizeof(ModelData), m_maxModels);
+            frame.batches = hostBuffer(sizeof(BatchData), maxBatches);
+
+            frame.counters = std::make_unique<Buffer>(
+                    m_device, sizeof(uint32_t), 1 + maxBatches,
+                    VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                    VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+            frame.visible = std::make_unique<Buffer>(
+                    m_device, sizeof(uint32_t), m_maxInstances * MAX_LODS,
+                    VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                    VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+            frame.commands = std::make_unique<Buffer>(
+                    m_device, sizeof(VkDrawIndexedIndirectCommand), maxBatches,
+                    VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+                    VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+            auto instancesInfo = frame.instances->descriptorInfo();
+            auto modelsInfo = frame.models->descriptorInfo();
+            auto batchesInfo = frame.batches->descriptorInfo();
+            auto countersInfo = frame.counters->descriptorInfo();
+            auto visibleInfo = frame.visible->descriptorInfo();
+            auto commandsInfo = frame.commands->descriptorInfo();
+
+            DescriptorWriter(*m_cullSetLayout, *m_descriptorPool)
+                    .writeBuffer(0, &instancesInfo)
+                    .writeBuffer(1, &modelsInfo)
+                    .writeBuffer(2, &batchesInfo)
+                    .writeBuffer(3, &countersInfo)
+                    .writeBuffer(4, &visibleInfo)
+                    .writeBuffer(5, &commandsInfo)
+                    .build(frame.cullSet);
+
+            DescriptorWriter(*m_drawSetLayout, *m_descriptorPool)
+                    .writeBuffer(0, &instancesInfo)
+                    .writeBuffer(1, &visibleInfo)
+                    .build(frame.drawSet);
+        }
+    }
+
+} // engine
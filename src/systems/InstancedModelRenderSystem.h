@@ -0,0 +1,139 @@
+#pragma once
+
+#include "Buffer.h"
+#include "Components.h"
+#include "ComputePipeline.h"
+#include "Device.h"
+#include "FrameInfo.h"
+#include "GeometryPool.h"
+#include "Pipeline.h"
+#include "SwapChain.h"
+#include "descriptors/DescriptorPool.h"
+#include "descriptors/DescriptorSetLayout.h"
+#include "descriptors/LayoutCache.h"
+
+#include <array>
+#include <memory>
+#include <vector>
+
+namespace engine {
+
+    // Draws many instances of a few models with all per-instance work on the GPU. Transforms live
+    // in a storage buffer; a compute pass tests every instance's bounds against the view frustum,
+    // picks its level of detail and appends the survivors to a per (model, lod) list, and a
+    // second pass compacts the non-empty lists into indirect draw commands. As all meshes live in
+    // one GeometryPool, the whole scene is a single vkCmdDrawIndexedIndirectCount, whatever the
+    // number of models and instances.
+    //
+    // Requires the drawIndirectCount, multiDrawIndirect and drawIndirectFirstInstance features.
+    class InstancedModelRenderSystem {
+    public:
+        static constexpr uint32_t INVALID_INSTANCE = ~0u;
+
+        InstancedModelRenderSystem(Device &device, LayoutCache &layoutCache, VkRenderPass renderPass,
+                                   VkDescriptorSetLayout globalSetLayout, GeometryPool &geometryPool,
+                                   uint32_t maxInstances, uint32_t maxModels = 64);
+
+        ~InstancedModelRenderSystem();
+
+        InstancedModelRenderSystem(const InstancedModelRenderSystem &) = delete;
+
+        InstancedModelRenderSystem &operator=(const InstancedModelRenderSystem &) = delete;
+
+        // The mesh has to stay in the pool while the system uses it. Returns the index to create
+        // instances with.
+        uint32_t AddModel(GeometryPool::MeshHandle mesh);
+
+        // Returns INVALID_INSTANCE when all maxInstances are in use.
+        uint32_t AddInstance(uint32_t model, const component::Transform &transform);
+        void SetTransform(uint32_t instance, const component::Transform &transform);
+        void RemoveInstance(uint32_t instance);
+
+        // Records the culling passes. Has to be called outside of a render pass, before Render.
+        // projectionScale is Model::ProjectionScale() of the camera, pixelError as in Model::SelectLod.
+        void Cull(FrameInfo &frameInfo, const glm::mat4 &projectionView, const glm::vec3 &cameraPosition,
+                  float projectionScale, float pixelError = 1.0f);
+
+        void Render(FrameInfo &frameInfo);
+
+        [[nodiscard]] uint32_t InstanceCount() const { return m_instanceCount; }
+
+    private:
+        // std430 mirrors of the structs in cull.comp and instanced_model.vert. Structs only align
+        // to their largest member there, so BatchData needs no padding.
+        struct InstanceData {
+            glm::mat4 modelMatrix;
+            glm::mat4 normalMatrix;
+            uint32_t modelIndex;
+            uint32_t padding[3];
+        };
+
+        struct ModelData {
+            glm::vec4 minExtent;
+            glm::vec4 maxExtent;
+            uint32_t firstBatch;
+            uint32_t lodCount;
+            uint32_t padding[2];
+        };
+
+        // one level of one model, with room for every instance of that model in the visible list
+        struct BatchData {
+            uint32_t indexCount;
+            uint32_t firstIndex;
+            int32_t vertexOffset;
+            uint32_t firstInstance;
+            float error;
+            uint32_t modelIndex;
+        };
+
+        static_assert(sizeof(InstanceData) == 144 && sizeof(ModelData) == 48 && sizeof(BatchData) == 24,
+                      "must match the std430 layout in the shaders");
+
+        struct FrameResources {
+            std::unique_ptr<Buffer> instances;
+            std::unique_ptr<Buffer> models;
+            std::unique_ptr<Buffer> batches;
+            // draw count, then visible instance count per batch
+            std::unique_ptr<Buffer> counters;
+            std::unique_ptr<Buffer> visible;
+            std::unique_ptr<Buffer> commands;
+            VkDescriptorSet cullSet;
+            VkDescriptorSet drawSet;
+        };
+
+        void CreatePipelineLayouts(VkDescriptorSetLayout globalSetLayout);
+        void CreatePipelines(VkRenderPass renderPass);
+        void CreateFrameResources();
+        void UploadFrameData(uint32_t frameIndex);
+        void MarkStale() { m_staleFrames = (1u << SwapChain::MAX_FRAMES_IN_FLIGHT) - 1; }
+
+        Device &m_device;
+        LayoutCache &m_layoutCache;
+        GeometryPool &m_geometryPool;
+        // pool generation the uploaded batches were built for
+        uint32_t m_poolGeneration;
+
+        std::unique_ptr<Pipeline> m_pipeline;
+        VkPipelineLayout m_pipelineLayout;
+        std::unique_ptr<ComputePipeline> m_cullPipeline;
+        std::unique_ptr<ComputePipeline> m_compactPipeline;
+        VkPipelineLayout m_cullPipelineLayout;
+
+        std::shared_ptr<DescriptorSetLayout> m_cullSetLayout;
+        std::shared_ptr<DescriptorSetLayout> m_drawSetLayout;
+        std::unique_ptr<DescriptorPool> m_descriptorPool;
+        std::array<FrameResources, SwapChain::MAX_FRAMES_IN_FLIGHT> m_frames;
+        uint32_t m_staleFrames = 0;
+
+        const uint32_t m_maxInstances;
+        const uint32_t m_maxModels;
+
+        std::vector<GeometryPool::MeshHandle> m_models;
+        uint32_t m_batchCount = 0;
+        std::vector<uint32_t> m_modelInstanceCounts;
+        std::vector<InstanceData> m_instances;
+        std::vector<uint32_t> m_freeInstances;
+        uint32_t m_instanceCount = 0;
+    };
+
+} // engine
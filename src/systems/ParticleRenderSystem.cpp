@@ -1,31 +1,82 @@
 #include <stdexcept>
 #include "ParticleRenderSystem.h"
 #include "SnakeGame.h"
+#include "EmbeddedShaders.h"
+
+#include <algorithm>
+#include <cassert>
 
 namespace engine {
 
     struct ParticlePushConstantsData {
-        glm::mat3 modelMatrix{1.0f};
+        glm::vec4 palette[ParticleRenderSystem::PALETTE_SIZE];
+        float quadSize;
     };
 
-    ParticleRenderSystem::ParticleRenderSystem(Device &device, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout, uint32_t maxParticles)
-    : m_device(device), m_maxParticles(maxParticles) {
+    // 7 palette colors leave room for the quad size in the guaranteed minimum
+    static_assert(sizeof(ParticlePushConstantsData) <= 128, "push constants are only guaranteed to have 128 bytes");
+    static_assert(shaders::particle_vert.pushConstantSize == sizeof(ParticlePushConstantsData), "must match the push block in particle.vert");
+    static_assert(shaders::particle_geom.pushConstantSize == sizeof(ParticlePushConstantsData), "must match the push block in particle.geom");
+
+    uint64_t ParticleVariant::key() const {
+        return uint64_t{softEdge} | uint64_t{paletteColor} << 1 | uint64_t{fixedSize} << 2;
+    }
+
+    ParticleRenderSystem::ParticleRenderSystem(Device &device, LayoutCache &layoutCache, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout, uint32_t maxParticles)
+    : m_device(device), m_layoutCache(layoutCache), m_renderPass(renderPass), m_maxParticles(maxParticles) {
         m_particles.reserve(m_maxParticles);
+        m_visibleIndices.reserve(m_maxParticles);
+        m_visibleParticles.reserve(m_maxParticles);
 
         CreatePipelineLayout(globalSetLayout);
-        CreatePipeline(renderPass);
-
-        CreateVertexBuffer();
+        CreateVertexBuffers();
     }
 
     ParticleRenderSystem::~ParticleRenderSystem() {
-        vkDestroyPipelineLayout(m_device.device(), m_pipelineLayout, nullptr);
+        if (m_hotReloader) {
+            m_hotReloader->Unwatch(this);
+        }
+    }
+
+    void ParticleRenderSystem::WatchShaders(ShaderHotReloader &hotReloader) {
+        m_hotReloader = &hotReloader;
+        for (auto &[key, variantPipeline] : m_pipelines) {
+            WatchVariant(variantPipeline);
+        }
     }
 
-    void ParticleRenderSystem::Render(FrameInfo &frameInfo) {
-        m_pipeline->bind(frameInfo.commandBuffer);
+    void ParticleRenderSystem::WatchVariant(VariantPipeline &variantPipeline) {
+        ParticleVariant variant = variantPipeline.variant;
+        m_hotReloader->Watch(this, {&shaders::particle_vert, &shaders::particle_geom, &shaders::particle_frag},
+                             variantPipeline.pipeline, [this, variant] { CreatePipeline(variant); });
+    }
+
+    void ParticleRenderSystem::Render(FrameInfo &frameInfo, uint32_t particleCount) {
+        Render(frameInfo, m_particles.data(), std::min<size_t>(particleCount, m_particles.size()));
+    }
+
+    void ParticleRenderSystem::Render(FrameInfo &frameInfo, const Particle *particles, size_t count) {
+        count = std::min<size_t>(count, m_maxParticles);
+
+        m_visibleIndices.resize(count);
+        size_t visible = CullParticles(particles, count, m_viewMin, m_viewMax, m_visibleIndices.data());
+        m_visibleParticles.resize(visible);
+        for (size_t i = 0; i < visible; i++) {
+            m_visibleParticles[i] = particles[m_visibleIndices[i]];
+        }
+        m_drawnCount = static_cast<uint32_t>(visible);
+        m_culledCount = static_cast<uint32_t>(count - visible);
+        if (visible == 0) {
+            return;
+        }
+
+        // the palette and the quad size only have to fit what is actually drawn
+        ParticleVariant variant = ChooseVariant(m_visibleParticles.data(), visible);
+        UpdateVertexBuffer(frameInfo.frameIndex, variant, m_visibleParticles.data(), visible);
 
-        vkCmdBindDescriptorSets(
+        GetPipeline(variant).bind(frameInfo.commandBuffer);
+
+        m_device.dispatch().vkCmdBindDescriptorSets(
                 frameInfo.commandBuffer,
                 VK_PIPELINE_BIND_POINT_GRAPHICS,
                 m_pipelineLayout,
@@ -36,35 +87,27 @@ namespace engine {
                 nullptr
         );
 
-        UpdateVertexBuffer();
-        Bind(frameInfo.commandBuffer);
-        VkBuffer vertexBuffers[] = {m_vertexBuffer->getBuffer()};
-        VkDeviceSize offsets[] = {0};
-        vkCmdBindVertexBuffers(frameInfo.commandBuffer, 0, 1, vertexBuffers, offsets);
-        vkCmdDraw(frameInfo.commandBuffer, m_particles.size(), 1, 0, 0);
+        if (variant.paletteColor || variant.fixedSize) {
+            ParticlePushConstantsData push{};
+            std::copy(m_palette.begin(), m_palette.begin() + m_paletteSize, push.palette);
+            push.quadSize = m_quadSize;
+            m_device.dispatch().vkCmdPushConstants(frameInfo.commandBuffer, m_pipelineLayout, m_pushConstantStages,
+                                                   0, sizeof(ParticlePushConstantsData), &push);
+        }
+
+        Bind(frameInfo.commandBuffer, frameInfo.frameIndex);
+        m_device.dispatch().vkCmdDraw(frameInfo.commandBuffer, m_drawnCount, 1, 0, 0);
     }
 
     void ParticleRenderSystem::CreatePipelineLayout(VkDescriptorSetLayout globalSetLayout) {
-        VkPushConstantRange pushConstantRange{};
-        pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
-        pushConstantRange.offset = 0;
-        pushConstantRange.size = sizeof(ParticlePushConstantsData);
-
-        std::vector<VkDescriptorSetLayout> descriptorSetLayouts{globalSetLayout};
-
-        VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
-        pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-        pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(descriptorSetLayouts.size());
-        pipelineLayoutInfo.pSetLayouts = descriptorSetLayouts.data();
-        pipelineLayoutInfo.pushConstantRangeCount = 1;
-        pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
-
-        if (vkCreatePipelineLayout(m_device.device(), &pipelineLayoutInfo, nullptr, &m_pipelineLayout) != VK_SUCCESS) {
-            throw std::runtime_error("Failed to create pipeline layout");
-        }
+        ShaderLayout layout{m_device, m_layoutCache,
+                            {&shaders::particle_vert, &shaders::particle_geom, &shaders::particle_frag},
+                            {globalSetLayout}};
+        m_pipelineLayout = layout.pipelineLayout();
+        m_pushConstantStages = layout.pushConstantStages();
     }
 
-    void ParticleRenderSystem::CreatePipeline(VkRenderPass renderPass) {
+    void ParticleRenderSystem::CreatePipeline(const ParticleVariant &variant) {
         assert(m_pipelineLayout != nullptr && "Cannot create pipeline before pipeline layout");
 
         PipelineConfigInfo pipelineConfig{};
@@ -134,53 +177,84 @@ namespace engine {
         pipelineConfig.dynamicStateInfo.dynamicStateCount = static_cast<uint32_t>(pipelineConfig.dynamicStateEnables.size());
         pipelineConfig.dynamicStateInfo.flags = 0;
 
-        pipelineConfig.bindingDescriptions = Particle::getBindingDescription();
-        pipelineConfig.attributeDescriptions = Particle::getAttributeDescriptions();
-        pipelineConfig.renderPass = renderPass;
+        pipelineConfig.bindingDescriptions = ParticleVertex::getBindingDescription();
+        pipelineConfig.attributeDescriptions = ParticleVertex::getAttributeDescriptions();
+        pipelineConfig.renderPass = m_renderPass;
         pipelineConfig.pipelineLayout = m_pipelineLayout;
 
-        pipelineConfig.vertPath = "../shader/particle.vert.spv";
-        pipelineConfig.fragPath = "../shader/particle.frag.spv";
-        pipelineConfig.geomPath = "../shader/particle.geom.spv";
-
-        m_pipeline = std::make_unique<Pipeline>(m_device, pipelineConfig);
-    }
-
-    void ParticleRenderSystem::CreateVertexBuffer() {
-        VkDeviceSize bufferSize = sizeof(Particle) * m_maxParticles;
+        // constant_ids as declared in the particle shaders
+        pipelineConfig.addSpecializationConstant<VkBool32>(0, variant.softEdge);
+        pipelineConfig.addSpecializationConstant<VkBool32>(1, variant.paletteColor);
+        pipelineConfig.addSpecializationConstant<VkBool32>(2, variant.fixedSize);
 
-        assert(bufferSize > 0 && "Buffer size cannot be zero");
+        auto shader = [this](const ShaderInfo &embedded) { return m_hotReloader ? m_hotReloader->Resolve(embedded) : &embedded; };
+        pipelineConfig.vertShader = shader(shaders::particle_vert);
+        pipelineConfig.fragShader = shader(shaders::particle_frag);
+        pipelineConfig.geomShader = shader(shaders::particle_geom);
 
-        Buffer stagingBuffer{m_device,
-                             bufferSize,
-                             1,
-                             VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-                             VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
-        };
+        m_pipelines[variant.key()].pipeline = std::make_unique<Pipeline>(m_device, pipelineConfig);
+    }
 
-        stagingBuffer.map();
-        stagingBuffer.writeToBuffer((void *) m_particles.data());
+    Pipeline &ParticleRenderSystem::GetPipeline(const ParticleVariant &variant) {
+        VariantPipeline &variantPipeline = m_pipelines[variant.key()];
+        if (!variantPipeline.pipeline) {
+            variantPipeline.variant = variant;
+            CreatePipeline(variant);
+            if (m_hotReloader) {
+                WatchVariant(variantPipeline);
+            }
+        }
+        return *variantPipeline.pipeline;
+    }
 
-        m_vertexBuffer = std::make_unique<Buffer>(m_device,
-                                                  sizeof(Particle),
-                                                  m_maxParticles,
-                                                  VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-                                                  VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
-        );
-        m_device.copyBuffer(stagingBuffer.getBuffer(), m_vertexBuffer->getBuffer(), bufferSize);
+    ParticleVariant ParticleRenderSystem::ChooseVariant(const Particle *particles, size_t count) {
+        ParticleVariant variant{};
+        variant.softEdge = m_softEdges;
+        variant.paletteColor = true;
+        variant.fixedSize = count > 0;
+        m_quadSize = variant.fixedSize ? particles[0].size : 0.0f;
+
+        m_paletteSize = 0;
+        m_colorIndices.resize(count);
+        for (size_t i = 0; i < count; i++) {
+            const Particle &particle = particles[i];
+            variant.fixedSize = variant.fixedSize && particle.size == m_quadSize;
+            if (!variant.paletteColor) {
+                continue;
+            }
+
+            // the game only ever uses a handful of colors, a linear search over them is cheapest
+            auto index = static_cast<uint32_t>(std::find(m_palette.begin(), m_palette.begin() + m_paletteSize, particle.color) - m_palette.begin());
+            if (index == m_paletteSize) {
+                if (m_paletteSize == PALETTE_SIZE) {
+                    variant.paletteColor = false;
+                    continue;
+                }
+                m_palette[m_paletteSize++] = particle.color;
+            }
+            m_colorIndices[i] = static_cast<uint8_t>(index);
+        }
 
+        return variant;
     }
 
-    void ParticleRenderSystem::UpdateVertexBuffer() {
-        VkDeviceSize bufferSize = sizeof(Particle) * m_maxParticles;
-
-        Buffer stagingBuffer{m_device, bufferSize, 1, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-                             VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT};
+    void ParticleRenderSystem::CreateVertexBuffers() {
+        assert(m_maxParticles > 0 && "Buffer size cannot be zero");
 
-        stagingBuffer.map();
-        stagingBuffer.writeToBuffer(m_particles.data());
+        for (auto &buffer : m_vertexBuffers) {
+            buffer = std::make_unique<Buffer>(m_device, sizeof(ParticleVertex), m_maxParticles,
+                                              VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+            // stays mapped for the lifetime of the system
+            buffer->map();
+        }
+    }
 
-        m_device.copyBuffer(stagingBuffer.getBuffer(), m_vertexBuffer->getBuffer(), bufferSize);
+    void ParticleRenderSystem::UpdateVertexBuffer(int frameIndex, const ParticleVariant &variant, const Particle *particles, size_t count) {
+        Buffer &vertexBuffer = *m_vertexBuffers[frameIndex];
+        auto *vertices = static_cast<ParticleVertex *>(vertexBuffer.getMappedMemory());
+        PackParticles(particles, count, vertices,
+                      variant.paletteColor ? m_colorIndices.data() : nullptr);
+        vertexBuffer.flush();
     }
 
     Particle *ParticleRenderSystem::AddParticle(const glm::vec2 &position, const glm::vec4 &color, float size) {
@@ -194,9 +268,9 @@ namespace engine {
         m_particles[index].color = glm::vec4(0);
     }
 
-    void ParticleRenderSystem::Bind(VkCommandBuffer commandBuffer) {
-        VkBuffer buffers[] = {m_vertexBuffer->getBuffer()};
+    void ParticleRenderSystem::Bind(VkCommandBuffer commandBuffer, int frameIndex) {
+        VkBuffer buffers[] = {m_vertexBuffers[frameIndex]->getBuffer()};
         VkDeviceSize offsets[] = {0};
-        vkCmdBindVertexBuffers(commandBuffer, 0, 1, buffers, offsets);
+        m_device.dispatch().vkCmdBindVertexBuffers(commandBuffer, 0, 1, buffers, offsets);
     }
 } // engine
\ No newline at end of file
@@ -2,27 +2,79 @@
 
 #include "Device.h"
 #include "Pipeline.h"
+#include "ShaderHotReloader.h"
+#include "SwapChain.h"
 #include "FrameInfo.h"
+#include "descriptors/LayoutCache.h"
 
+#include <array>
+#include <cstdint>
 #include <memory>
+#include <unordered_map>
 
 namespace engine {
 
     typedef uint32_t particle_id;
 
+    // Which specialization of the particle shaders a draw uses. Everything here is uniform for the
+    // whole draw, so it is compiled into the pipeline instead of being branched on per vertex or
+    // fragment.
+    struct ParticleVariant {
+        // smoothstep falloff at the edge instead of a hard cut
+        bool softEdge = true;
+        // colors come from the push constant palette, the vertex color only holds the index
+        bool paletteColor = false;
+        // every quad has the size from the push constants instead of the particle's own size
+        bool fixedSize = false;
+
+        [[nodiscard]] uint64_t key() const;
+    };
+
     class ParticleRenderSystem {
+    public:
+        // matches the push constant block of particle.vert
+        static constexpr uint32_t PALETTE_SIZE = 7;
+
     private:
+        struct VariantPipeline {
+            ParticleVariant variant;
+            std::unique_ptr<Pipeline> pipeline;
+        };
+
         Device &m_device;
-        std::unique_ptr<Pipeline> m_pipeline;
+        LayoutCache &m_layoutCache;
+        // created the first time a variant is drawn, by ParticleVariant::key()
+        std::unordered_map<uint64_t, VariantPipeline> m_pipelines;
         VkPipelineLayout m_pipelineLayout;
+        VkShaderStageFlags m_pushConstantStages;
+        VkRenderPass m_renderPass;
+        ShaderHotReloader *m_hotReloader = nullptr;
+
+        bool m_softEdges = true;
+        std::array<glm::vec4, PALETTE_SIZE> m_palette{};
+        uint32_t m_paletteSize = 0;
+        // size of every particle in the fixedSize variant, pushed with the palette
+        float m_quadSize = 0.0f;
+        // palette index of every particle, valid while the palette is in use
+        std::vector<uint8_t> m_colorIndices;
 
         std::vector<Particle> m_particles;
         const uint32_t m_maxParticles;
 
-        std::unique_ptr<Buffer> m_vertexBuffer;
+        // particles outside of this rectangle are neither uploaded nor drawn
+        glm::vec2 m_viewMin{-1.0f};
+        glm::vec2 m_viewMax{1.0f};
+        // compacted by CullParticles every Render
+        std::vector<uint32_t> m_visibleIndices;
+        std::vector<Particle> m_visibleParticles;
+        uint32_t m_drawnCount = 0;
+        uint32_t m_culledCount = 0;
+
+        // packed ParticleVertex, rewritten every frame
+        std::array<std::unique_ptr<Buffer>, SwapChain::MAX_FRAMES_IN_FLIGHT> m_vertexBuffers;
 
     public:
-        ParticleRenderSystem(Device &device, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout, uint32_t maxParticles);
+        ParticleRenderSystem(Device &device, LayoutCache &layoutCache, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout, uint32_t maxParticles);
 
         ~ParticleRenderSystem();
 
@@ -30,20 +82,49 @@ namespace engine {
 
         ParticleRenderSystem &operator=(const ParticleRenderSystem &) = delete;
 
-        void Render(FrameInfo &frameInfo);
+        // Draws the first particleCount particles, all of them by default.
+        void Render(FrameInfo &frameInfo, uint32_t particleCount = UINT32_MAX);
+
+        // Draws particles the system does not own instead, e.g. a level of detail of its own ones.
+        // At most maxParticles of them.
+        void Render(FrameInfo &frameInfo, const Particle *particles, size_t count);
 
         Particle *AddParticle(const glm::vec2 &position, const glm::vec4 &color, float size);
 
         void RemoveParticle(const Particle *particle);
 
+        // Rebuilds the pipelines whenever hotReloader recompiles one of the particle shaders.
+        void WatchShaders(ShaderHotReloader &hotReloader);
+
+        void SetSoftEdges(bool softEdges) { m_softEdges = softEdges; }
+
+        // The visible rectangle in the coordinates of the particles, normalized device coordinates
+        // by default.
+        void SetCullBounds(const glm::vec2 &viewMin, const glm::vec2 &viewMax) {
+            m_viewMin = viewMin;
+            m_viewMax = viewMax;
+        }
+
+        // of the last Render
+        [[nodiscard]] uint32_t DrawnCount() const { return m_drawnCount; }
+        [[nodiscard]] uint32_t CulledCount() const { return m_culledCount; }
+
     private:
         void CreatePipelineLayout(VkDescriptorSetLayout globalSetLayout);
-        void CreatePipeline(VkRenderPass renderPass);
+        void CreatePipeline(const ParticleVariant &variant);
+
+        Pipeline &GetPipeline(const ParticleVariant &variant);
+
+        void WatchVariant(VariantPipeline &variantPipeline);
+
+        // The cheapest variant that draws these particles with the current settings, fills the
+        // palette if it is used.
+        ParticleVariant ChooseVariant(const Particle *particles, size_t count);
 
-        void CreateVertexBuffer();
-        void UpdateVertexBuffer();
+        void CreateVertexBuffers();
+        void UpdateVertexBuffer(int frameIndex, const ParticleVariant &variant, const Particle *particles, size_t count);
 
-        void Bind(VkCommandBuffer commandBuffer);
+        void Bind(VkCommandBuffer commandBuffer, int frameIndex);
     };
 
 } // engine
@@ -0,0 +1,162 @@
+#include "PhysicsSystem.h"
+
+#include <algorithm>
+#include <iterator>
+
+namespace engine {
+
+    static bool PairLess(const DynamicAabbTree::Pair &a, const DynamicAabbTree::Pair &b) {
+        return a.first != b.first ? a.first < b.first : a.second < b.second;
+    }
+
+    PhysicsSystem::PhysicsSystem(const glm::vec3 &gravity, float margin) : gravity(gravity), m_tree(margin) {}
+
+    PhysicsSystem::BodyId PhysicsSystem::AddBody(const component::Transform &transform,
+                                                 const component::RigidBody &rigidBody,
+                                                 const component::AABBCollider &localBounds) {
+        BodyId id;
+        if (!m_freeBodies.empty()) {
+            id = m_freeBodies.back();
+            m_freeBodies.pop_back();
+        } else {
+            id = static_cast<BodyId>(m_bodies.size());
+            m_bodies.emplace_back();
+        }
+
+        Body &body = m_bodies[id];
+        body.transform = transform;
+        body.rigidBody = rigidBody;
+        body.localBounds = localBounds;
+        body.worldBounds = ComputeWorldBounds(body);
+        body.proxy = m_tree.CreateProxy(body.worldBounds, id);
+        return id;
+    }
+
+    void PhysicsSystem::RemoveBody(BodyId body) {
+        DynamicAabbTree::ProxyId proxy = m_bodies[body].proxy;
+        if (proxy == DynamicAabbTree::NULL_PROXY) {
+            return;
+        }
+
+        // the tree hands the proxy id out again, so no pair may outlive it
+        m_pairs.erase(std::remove_if(m_pairs.begin(), m_pairs.end(), [proxy](const DynamicAabbTree::Pair &pair) {
+            return pair.first == proxy || pair.second == proxy;
+        }), m_pairs.end());
+
+        m_tree.DestroyProxy(proxy);
+        m_bodies[body].proxy = DynamicAabbTree::NULL_PROXY;
+        m_freeBodies.push_back(body);
+    }
+
+    void PhysicsSystem::SetTransform(BodyId body, const component::Transform &transform) {
+        Body &moved = m_bodies[body];
+        glm::vec3 displacement = transform.translation - moved.transform.translation;
+        moved.transform = transform;
+        UpdateBounds(moved, displacement);
+    }
+
+    component::AABBCollider PhysicsSystem::ComputeWorldBounds(const Body &body) {
+        glm::mat4 matrix = body.transform.mat4();
+        glm::vec3 center = (body.localBounds.minExtent + body.localBounds.maxExtent) * 0.5f;
+        glm::vec3 extent = (body.localBounds.maxExtent - body.localBounds.minExtent) * 0.5f;
+
+        glm::vec3 worldCenter = glm::vec3{matrix * glm::vec4{center, 1.0f}};
+        glm::vec3 worldExtent = glm::abs(glm::vec3{matrix[0]}) * extent.x +
+                                glm::abs(glm::vec3{matrix[1]}) * extent.y +
+                                glm::abs(glm::vec3{matrix[2]}) * extent.z;
+        return {worldCenter - worldExtent, worldCenter + worldExtent};
+    }
+
+    void PhysicsSystem::UpdateBounds(Body &body, const glm::vec3 &displacement) {
+        body.worldBounds = ComputeWorldBounds(body);
+        m_tree.MoveProxy(body.proxy, body.worldBounds, displacement);
+    }
+
+    void PhysicsSystem::Step(float dt) {
+        for (Body &body : m_bodies) {
+            component::RigidBody &rigidBody = body.rigidBody;
+            if (body.proxy == DynamicAabbTree::NULL_PROXY || rigidBody.isStatic) {
+                continue;
+            }
+
+            rigidBody.acceleration = gravity + rigidBody.netForce * rigidBody.inverseMass;
+            rigidBody.velocity += rigidBody.acceleration * dt;
+            rigidBody.netForce = glm::vec3{0.0f};
+
+            glm::vec3 displacement = rigidBody.velocity * dt;
+            body.transform.translation += displacement;
+            UpdateBounds(body, displacement);
+        }
+
+        UpdateCandidatePairs();
+
+        m_contacts.clear();
+        for (const auto &pair : m_pairs) {
+            Resolve(m_tree.GetUserData(pair.first), m_tree.GetUserData(pair.second));
+        }
+    }
+
+    void PhysicsSystem::UpdateCandidatePairs() {
+        m_tree.UpdatePairs(m_newPairs);
+
+        m_mergedPairs.clear();
+        std::set_union(m_pairs.begin(), m_pairs.end(), m_newPairs.begin(), m_newPairs.end(),
+                       std::back_inserter(m_mergedPairs), PairLess);
+        m_pairs.swap(m_mergedPairs);
+
+        // a pair lives until the fat boxes separate
+        m_pairs.erase(std::remove_if(m_pairs.begin(), m_pairs.end(), [this](const DynamicAabbTree::Pair &pair) {
+            return !m_tree.GetFatAabb(pair.first).checkCollision(m_tree.GetFatAabb(pair.second));
+        }), m_pairs.end());
+    }
+
+    void PhysicsSystem::Resolve(BodyId first, BodyId second) {
+        Body &a = m_bodies[first];
+        Body &b = m_bodies[second];
+
+        float inverseMassA = a.rigidBody.isStatic ? 0.0f : a.rigidBody.inverseMass;
+        float inverseMassB = b.rigidBody.isStatic ? 0.0f : b.rigidBody.inverseMass;
+        float inverseMassSum = inverseMassA + inverseMassB;
+        if (inverseMassSum <= 0.0f || !a.worldBounds.checkCollision(b.worldBounds)) {
+            return;
+        }
+
+        glm::vec3 overlap = glm::min(a.worldBounds.maxExtent, b.worldBounds.maxExtent) -
+                            glm::max(a.worldBounds.minExtent, b.worldBounds.minExtent);
+        int axis = overlap.x < overlap.y ? (overlap.x < overlap.z ? 0 : 2) : (overlap.y < overlap.z ? 1 : 2);
+
+        glm::vec3 centerDelta = (b.worldBounds.minExtent + b.worldBounds.maxExtent) -
+                                (a.worldBounds.minExtent + a.worldBounds.maxExtent);
+        glm::vec3 normal{0.0f};
+        normal[axis] = centerDelta[axis] < 0.0f ? -1.0f : 1.0f;
+        float depth = overlap[axis];
+
+        // split the correction by inverse mass, static bodies do not move
+        glm::vec3 correction = normal * (depth / inverseMassSum);
+        glm::vec3 moveA = -correction * inverseMassA;
+        glm::vec3 moveB = correction * inverseMassB;
+        a.transform.translation += moveA;
+        a.worldBounds.minExtent += moveA;
+        a.worldBounds.maxExtent += moveA;
+        b.transform.translation += moveB;
+        b.worldBounds.minExtent += moveB;
+        b.worldBounds.maxExtent += moveB;
+        // the tree has to see the corrected bounds, or a body pushed out of its fat box misses pairs
+        if (inverseMassA > 0.0f) {
+            m_tree.MoveProxy(a.proxy, a.worldBounds, moveA);
+        }
+        if (inverseMassB > 0.0f) {
+            m_tree.MoveProxy(b.proxy, b.worldBounds, moveB);
+        }
+
+        float approachSpeed = glm::dot(b.rigidBody.velocity - a.rigidBody.velocity, normal);
+        if (approachSpeed < 0.0f) {
+            float impulse = -(1.0f + restitution) * approachSpeed / inverseMassSum;
+            a.rigidBody.velocity -= normal * (impulse * inverseMassA);
+            b.rigidBody.velocity += normal * (impulse * inverseMassB);
+        }
+
+        m_contacts.push_back({first, second, normal, depth});
+    }
+
+} // engine
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "Components.h"
+#include "DynamicAabbTree.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace engine {
+
+    // Integrates RigidBody components and resolves overlaps between their AABBColliders. Candidate
+    // pairs come from a DynamicAabbTree and are kept across steps: a step only queries the tree
+    // for bodies that left their fat boxes and drops pairs whose fat boxes came apart, so the
+    // cost follows the number of moving bodies and contacts rather than the number of pairs.
+    class PhysicsSystem {
+    public:
+        using BodyId = uint32_t;
+        static constexpr BodyId INVALID_BODY = ~0u;
+
+        struct Contact {
+            BodyId first;
+            BodyId second;
+            // from first towards second
+            glm::vec3 normal;
+            float depth;
+        };
+
+        explicit PhysicsSystem(const glm::vec3 &gravity = {0.0f, -9.81f, 0.0f}, float margin = 0.1f);
+
+        // localBounds are in object space, the world box follows the transform.
+        BodyId AddBody(const component::Transform &transform, const component::RigidBody &rigidBody,
+                       const component::AABBCollider &localBounds);
+        void RemoveBody(BodyId body);
+
+        [[nodiscard]] const component::Transform &GetTransform(BodyId body) const { return m_bodies[body].transform; }
+        // Moves the body right away, also for static ones, which Step otherwise never updates.
+        void SetTransform(BodyId body, const component::Transform &transform);
+        component::RigidBody &GetRigidBody(BodyId body) { return m_bodies[body].rigidBody; }
+        [[nodiscard]] const component::AABBCollider &GetWorldBounds(BodyId body) const { return m_bodies[body].worldBounds; }
+
+        // Semi-implicit Euler integration, broadphase update, then every overlapping candidate pair
+        // is pushed apart along the axis of least penetration.
+        void Step(float dt);
+
+        [[nodiscard]] const std::vector<Contact> &GetContacts() const { return m_contacts; }
+        [[nodiscard]] size_t GetCandidatePairCount() const { return m_pairs.size(); }
+        [[nodiscard]] const DynamicAabbTree &GetBroadphase() const { return m_tree; }
+
+        glm::vec3 gravity;
+        // 0 stops bodies dead on impact, 1 bounces them back at full speed
+        float restitution = 0.2f;
+
+    private:
+        struct Body {
+            component::Transform transform;
+            component::RigidBody rigidBody;
+            component::AABBCollider localBounds;
+            component::AABBCollider worldBounds;
+            DynamicAabbTree::ProxyId proxy;
+        };
+
+        static component::AABBCollider ComputeWorldBounds(const Body &body);
+        void UpdateBounds(Body &body, const glm::vec3 &displacement);
+        void UpdateCandidatePairs();
+        void Resolve(BodyId first, BodyId second);
+
+        DynamicAabbTree m_tree;
+        std::vector<Body> m_bodies;
+        std::vector<BodyId> m_freeBodies;
+
+        // sorted by proxy, persistent across steps
+        std::vector<DynamicAabbTree::Pair> m_pairs;
+        // scratch, reused every step
+        std::vector<DynamicAabbTree::Pair> m_newPairs;
+        std::vector<DynamicAabbTree::Pair> m_mergedPairs;
+        std::vector<Contact> m_contacts;
+    };
+
+} // engine
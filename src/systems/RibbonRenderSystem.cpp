@@ -0,0 +1,163 @@
+#include "RibbonRenderSystem.h"
+#include "EmbeddedShaders.h"
+
+#include <glm/gtc/constants.hpp>
+
+#include <algorithm>
+#include <cassert>
+
+namespace engine {
+
+    struct RibbonPushConstantsData {
+        glm::vec4 color;
+        float radius;
+        float length;
+    };
+
+    static_assert(shaders::ribbon_frag.pushConstantSize == sizeof(RibbonPushConstantsData), "must match the push block in ribbon.frag");
+
+    // the direction from a to b, fallback if they are on top of each other
+    static glm::vec2 direction(const glm::vec2 &a, const glm::vec2 &b, const glm::vec2 &fallback) {
+        glm::vec2 delta = b - a;
+        float length = glm::length(delta);
+        return length > 1e-6f ? delta / length : fallback;
+    }
+
+    static glm::vec2 perpendicular(const glm::vec2 &v) {
+        return {-v.y, v.x};
+    }
+
+    RibbonRenderSystem::RibbonRenderSystem(Device &device, LayoutCache &layoutCache, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout,
+                                           uint32_t maxPoints)
+            : m_device(device), m_layoutCache(layoutCache), m_renderPass(renderPass), m_maxPoints(maxPoints) {
+        CreatePipelineLayout(globalSetLayout);
+        CreatePipeline();
+        CreateVertexBuffers();
+    }
+
+    RibbonRenderSystem::~RibbonRenderSystem() {
+        if (m_hotReloader) {
+            m_hotReloader->Unwatch(this);
+        }
+    }
+
+    void RibbonRenderSystem::WatchShaders(ShaderHotReloader &hotReloader) {
+        m_hotReloader = &hotReloader;
+        hotReloader.Watch(this, {&shaders::ribbon_vert, &shaders::ribbon_frag}, m_pipeline, [this] { CreatePipeline(); });
+    }
+
+    void RibbonRenderSystem::Render(FrameInfo &frameInfo, const std::vector<glm::vec2> &points, float radius, const glm::vec4 &color) {
+        auto count = static_cast<uint32_t>(std::min<size_t>(points.size(), m_maxPoints));
+        if (count == 0) {
+            return;
+        }
+
+        // two vertices per point, plus one pair radius past each end for the caps
+        Buffer &vertexBuffer = *m_vertexBuffers[frameInfo.frameIndex];
+        auto *vertices = static_cast<RibbonVertex *>(vertexBuffer.getMappedMemory());
+        uint32_t vertexCount = 0;
+        auto emit = [&](const glm::vec2 &position, const glm::vec2 &normal, float along, float miter) {
+            vertices[vertexCount++] = {position + normal * radius * miter, {along, miter}};
+            vertices[vertexCount++] = {position - normal * radius * miter, {along, -miter}};
+        };
+
+        glm::vec2 first = count > 1 ? direction(points[0], points[1], {1.0f, 0.0f}) : glm::vec2{1.0f, 0.0f};
+        emit(points[0] - first * radius, perpendicular(first), -radius, 1.0f);
+
+        float along = 0.0f;
+        glm::vec2 incoming = first;
+        for (uint32_t i = 0; i < count; i++) {
+            if (i > 0) {
+                along += glm::length(points[i] - points[i - 1]);
+            }
+            glm::vec2 outgoing = i + 1 < count ? direction(points[i], points[i + 1], incoming) : incoming;
+
+            // miter joint, limited so that hairpin turns do not spike out
+            glm::vec2 tangent = direction(glm::vec2(0.0f), incoming + outgoing, incoming);
+            glm::vec2 normal = perpendicular(tangent);
+            float miter = 1.0f / std::max(glm::dot(normal, perpendicular(incoming)), 0.25f);
+            emit(points[i], normal, along, miter);
+
+            incoming = outgoing;
+        }
+
+        emit(points[count - 1] + incoming * radius, perpendicular(incoming), along + radius, 1.0f);
+        vertexBuffer.flush();
+
+        m_pipeline->bind(frameInfo.commandBuffer);
+
+        m_device.dispatch().vkCmdBindDescriptorSets(
+                frameInfo.commandBuffer,
+                VK_PIPELINE_BIND_POINT_GRAPHICS,
+                m_pipelineLayout,
+                0,
+                frameInfo.descriptorSets.size(),
+                frameInfo.descriptorSets.data(),
+                0,
+                nullptr
+        );
+
+        RibbonPushConstantsData push{color, radius, along};
+        m_device.dispatch().vkCmdPushConstants(frameInfo.commandBuffer, m_pipelineLayout, m_pushConstantStages,
+                                               0, sizeof(RibbonPushConstantsData), &push);
+
+        VkBuffer buffers[] = {vertexBuffer.getBuffer()};
+        VkDeviceSize offsets[] = {0};
+        m_device.dispatch().vkCmdBindVertexBuffers(frameInfo.commandBuffer, 0, 1, buffers, offsets);
+        m_device.dispatch().vkCmdDraw(frameInfo.commandBuffer, vertexCount, 1, 0, 0);
+    }
+
+    float RibbonRenderSystem::CoveredArea(const std::vector<glm::vec2> &points, float radius) {
+        if (points.empty()) {
+            return 0.0f;
+        }
+
+        float length = 0.0f;
+        for (size_t i = 1; i < points.size(); i++) {
+            length += glm::length(points[i] - points[i - 1]);
+        }
+        return 2.0f * radius * length + glm::pi<float>() * radius * radius;
+    }
+
+    void RibbonRenderSystem::CreatePipelineLayout(VkDescriptorSetLayout globalSetLayout) {
+        ShaderLayout layout{m_device, m_layoutCache, {&shaders::ribbon_vert, &shaders::ribbon_frag}, {globalSetLayout}};
+        m_pipelineLayout = layout.pipelineLayout();
+        m_pushConstantStages = layout.pushConstantStages();
+    }
+
+    void RibbonRenderSystem::CreatePipeline() {
+        assert(m_pipelineLayout != nullptr && "Cannot create pipeline before pipeline layout");
+
+        PipelineConfigInfo pipelineConfig{};
+        Pipeline::defaultPipelineConfigInfo(pipelineConfig);
+        pipelineConfig.inputAssemblyInfo.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP;
+        // drawn on top like the particles, opaque so nothing under it is blended
+        pipelineConfig.depthStencilInfo.depthTestEnable = VK_FALSE;
+        pipelineConfig.depthStencilInfo.depthWriteEnable = VK_FALSE;
+
+        pipelineConfig.bindingDescriptions = {{0, sizeof(RibbonVertex), VK_VERTEX_INPUT_RATE_VERTEX}};
+        pipelineConfig.attributeDescriptions = {
+                {0, 0, VK_FORMAT_R32G32_SFLOAT, offsetof(RibbonVertex, position)},
+                {1, 0, VK_FORMAT_R32G32_SFLOAT, offsetof(RibbonVertex, ribbonCoord)},
+        };
+        pipelineConfig.renderPass = m_renderPass;
+        pipelineConfig.pipelineLayout = m_pipelineLayout;
+
+        auto shader = [this](const ShaderInfo &embedded) { return m_hotReloader ? m_hotReloader->Resolve(embedded) : &embedded; };
+        pipelineConfig.vertShader = shader(shaders::ribbon_vert);
+        pipelineConfig.fragShader = shader(shaders::ribbon_frag);
+
+        m_pipeline = std::make_unique<Pipeline>(m_device, pipelineConfig);
+    }
+
+    void RibbonRenderSystem::CreateVertexBuffers() {
+        assert(m_maxPoints > 0 && "Buffer size cannot be zero");
+
+        for (auto &buffer : m_vertexBuffers) {
+            buffer = std::make_unique<Buffer>(m_device, sizeof(RibbonVertex), (m_maxPoints + 2) * 2,
+                                              VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+            // stays mapped for the lifetime of the system
+            buffer->map();
+        }
+    }
+} // engine
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "Buffer.h"
+#include "Device.h"
+#include "Pipeline.h"
+#include "FrameInfo.h"
+#include "ShaderHotReloader.h"
+#include "SwapChain.h"
+#include "descriptors/LayoutCache.h"
+
+#include <array>
+#include <memory>
+#include <vector>
+
+namespace engine {
+
+    // Draws a chain of points, e.g. the snake body, as one opaque triangle strip with round caps.
+    // Every covered pixel is shaded about once, where one point sprite per link blends each pixel
+    // two or three times.
+    class RibbonRenderSystem {
+    private:
+        // matches the vertex input of ribbon.vert
+        struct RibbonVertex {
+            glm::vec2 position;
+            glm::vec2 ribbonCoord;
+        };
+
+        Device &m_device;
+        LayoutCache &m_layoutCache;
+        std::unique_ptr<Pipeline> m_pipeline;
+        VkPipelineLayout m_pipelineLayout;
+        VkShaderStageFlags m_pushConstantStages;
+        VkRenderPass m_renderPass;
+        ShaderHotReloader *m_hotReloader = nullptr;
+        std::array<std::unique_ptr<Buffer>, SwapChain::MAX_FRAMES_IN_FLIGHT> m_vertexBuffers;
+        const uint32_t m_maxPoints;
+
+    public:
+        RibbonRenderSystem(Device &device, LayoutCache &layoutCache, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout,
+                           uint32_t maxPoints);
+
+        ~RibbonRenderSystem();
+
+        RibbonRenderSystem(const RibbonRenderSystem &) = delete;
+
+        RibbonRenderSystem &operator=(const RibbonRenderSystem &) = delete;
+
+        // points and radius in world units, see Camera2D, from head to tail. Points past maxPoints are dropped.
+        void Render(FrameInfo &frameInfo, const std::vector<glm::vec2> &points, float radius, const glm::vec4 &color);
+
+        // Rebuilds the pipeline whenever hotReloader recompiles ribbon.vert or ribbon.frag.
+        void WatchShaders(ShaderHotReloader &hotReloader);
+
+        // Area the ribbon covers in world units squared, ignoring where it overlaps itself.
+        [[nodiscard]] static float CoveredArea(const std::vector<glm::vec2> &points, float radius);
+
+    private:
+        void CreatePipelineLayout(VkDescriptorSetLayout globalSetLayout);
+
+        void CreatePipeline();
+
+        void CreateVertexBuffers();
+    };
+
+} // engine
@@ -0,0 +1,183 @@
+#include "Ktx2.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+namespace engine {
+    static constexpr uint8_t KTX2_IDENTIFIER[12] = {0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A};
+
+    // byte offsets of the fixed size parts of the file
+    static constexpr size_t HEADER_OFFSET = 12;
+    static constexpr size_t INDEX_OFFSET = HEADER_OFFSET + 9 * sizeof(uint32_t);
+    static constexpr size_t LEVEL_INDEX_OFFSET = INDEX_OFFSET + 4 * sizeof(uint32_t) + 2 * sizeof(uint64_t);
+    static constexpr size_t LEVEL_INDEX_ENTRY_SIZE = 3 * sizeof(uint64_t);
+
+    // Khronos data format descriptor values for the BC color models
+    static constexpr uint32_t KHR_DF_MODEL_BC4 = 131;
+    static constexpr uint32_t KHR_DF_MODEL_BC5 = 132;
+    static constexpr uint32_t KHR_DF_MODEL_BC7 = 134;
+    static constexpr uint32_t KHR_DF_PRIMARIES_BT709 = 1;
+    static constexpr uint32_t KHR_DF_TRANSFER_LINEAR = 1;
+    static constexpr uint32_t KHR_DF_TRANSFER_SRGB = 2;
+
+    template<typename T>
+    static T readValue(const std::vector<uint8_t> &bytes, size_t offset) {
+        if (offset + sizeof(T) > bytes.size()) {
+            throw std::runtime_error("ktx2 file is truncated");
+        }
+        T value;
+        std::memcpy(&value, bytes.data() + offset, sizeof(T));
+        return value;
+    }
+
+    template<typename T>
+    static void writeValue(std::vector<uint8_t> &bytes, size_t offset, T value) {
+        std::memcpy(bytes.data() + offset, &value, sizeof(T));
+    }
+
+    static uint64_t alignUp(uint64_t value, uint64_t alignment) {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    bool IsKtx2Path(const std::string &path) {
+        static const std::string extension = ".ktx2";
+        return path.size() >= extension.size() &&
+               path.compare(path.size() - extension.size(), extension.size(), extension) == 0;
+    }
+
+    uint32_t Ktx2BlockSize(VkFormat format) {
+        switch (format) {
+            case VK_FORMAT_BC4_UNORM_BLOCK:
+                return 8;
+            case VK_FORMAT_BC5_UNORM_BLOCK:
+            case VK_FORMAT_BC7_UNORM_BLOCK:
+            case VK_FORMAT_BC7_SRGB_BLOCK:
+                return 16;
+            default:
+                return 0;
+        }
+    }
+
+    Ktx2Image ReadKtx2(const std::string &path) {
+        std::ifstream file{path, std::ios::ate | std::ios::binary};
+
+        if (!file.is_open()) {
+            throw std::runtime_error("failed to open file: " + path);
+        }
+
+        Ktx2Image image{};
+        image.data.resize(static_cast<size_t>(file.tellg()));
+        file.seekg(0);
+        file.read(reinterpret_cast<char *>(image.data.data()), static_cast<std::streamsize>(image.data.size()));
+
+        if (image.data.size() < LEVEL_INDEX_OFFSET ||
+            std::memcmp(image.data.data(), KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER)) != 0) {
+            throw std::runtime_error("not a ktx2 file: " + path);
+        }
+
+        image.format = static_cast<VkFormat>(readValue<uint32_t>(image.data, HEADER_OFFSET));
+        image.width = readValue<uint32_t>(image.data, HEADER_OFFSET + 8);
+        image.height = readValue<uint32_t>(image.data, HEADER_OFFSET + 12);
+        uint32_t depth = readValue<uint32_t>(image.data, HEADER_OFFSET + 16);
+        uint32_t layerCount = readValue<uint32_t>(image.data, HEADER_OFFSET + 20);
+        uint32_t faceCount = readValue<uint32_t>(image.data, HEADER_OFFSET + 24);
+        uint32_t levelCount = readValue<uint32_t>(image.data, HEADER_OFFSET + 28);
+        uint32_t supercompression = readValue<uint32_t>(image.data, HEADER_OFFSET + 32);
+
+        if (depth > 1 || layerCount > 1 || faceCount != 1 || supercompression != 0) {
+            throw std::runtime_error("unsupported ktx2 layout (only plain 2D textures): " + path);
+        }
+
+        // a level count of 0 asks the loader to generate mips, the cooker always writes them
+        levelCount = std::max(levelCount, 1u);
+
+        image.levels.resize(levelCount);
+        for (uint32_t i = 0; i < levelCount; i++) {
+            size_t entry = LEVEL_INDEX_OFFSET + i * LEVEL_INDEX_ENTRY_SIZE;
+            image.levels[i].offset = readValue<uint64_t>(image.data, entry);
+            image.levels[i].size = readValue<uint64_t>(image.data, entry + 8);
+
+            if (image.levels[i].offset + image.levels[i].size > image.data.size()) {
+                throw std::runtime_error("ktx2 level out of bounds: " + path);
+            }
+        }
+
+        return image;
+    }
+
+    void WriteKtx2(const std::string &path, VkFormat format, uint32_t width, uint32_t height,
+                   const std::vector<std::vector<uint8_t>> &levelData) {
+        uint32_t blockSize = Ktx2BlockSize(format);
+        if (blockSize == 0) {
+            throw std::runtime_error("unsupported ktx2 format");
+        }
+
+        uint32_t colorModel = format == VK_FORMAT_BC4_UNORM_BLOCK ? KHR_DF_MODEL_BC4
+                            : format == VK_FORMAT_BC5_UNORM_BLOCK ? KHR_DF_MODEL_BC5
+                            : KHR_DF_MODEL_BC7;
+        uint32_t transfer = format == VK_FORMAT_BC7_SRGB_BLOCK ? KHR_DF_TRANSFER_SRGB : KHR_DF_TRANSFER_LINEAR;
+        uint32_t sampleCount = format == VK_FORMAT_BC5_UNORM_BLOCK ? 2 : 1;
+
+        auto levelCount = static_cast<uint32_t>(levelData.size());
+        size_t dfdOffset = LEVEL_INDEX_OFFSET + levelCount * LEVEL_INDEX_ENTRY_SIZE;
+        size_t dfdSize = sizeof(uint32_t) + 24 + 16 * sampleCount;
+
+        // levels are stored smallest first, each aligned to the block size
+        std::vector<uint64_t> levelOffsets(levelCount);
+        uint64_t end = dfdOffset + dfdSize;
+        for (int i = static_cast<int>(levelCount) - 1; i >= 0; i--) {
+            levelOffsets[i] = alignUp(end, blockSize);
+            end = levelOffsets[i] + levelData[i].size();
+        }
+
+        std::vector<uint8_t> bytes(end, 0);
+        std::memcpy(bytes.data(), KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER));
+
+        writeValue<uint32_t>(bytes, HEADER_OFFSET, format);
+        writeValue<uint32_t>(bytes, HEADER_OFFSET + 4, 1);
+        writeValue<uint32_t>(bytes, HEADER_OFFSET + 8, width);
+        writeValue<uint32_t>(bytes, HEADER_OFFSET + 12, height);
+        writeValue<uint32_t>(bytes, HEADER_OFFSET + 16, 0);
+        writeValue<uint32_t>(bytes, HEADER_OFFSET + 20, 0);
+        writeValue<uint32_t>(bytes, HEADER_OFFSET + 24, 1);
+        writeValue<uint32_t>(bytes, HEADER_OFFSET + 28, levelCount);
+        writeValue<uint32_t>(bytes, HEADER_OFFSET + 32, 0);
+
+        writeValue<uint32_t>(bytes, INDEX_OFFSET, static_cast<uint32_t>(dfdOffset));
+        writeValue<uint32_t>(bytes, INDEX_OFFSET + 4, static_cast<uint32_t>(dfdSize));
+
+        for (uint32_t i = 0; i < levelCount; i++) {
+            size_t entry = LEVEL_INDEX_OFFSET + i * LEVEL_INDEX_ENTRY_SIZE;
+            writeValue<uint64_t>(bytes, entry, levelOffsets[i]);
+            writeValue<uint64_t>(bytes, entry + 8, levelData[i].size());
+            writeValue<uint64_t>(bytes, entry + 16, levelData[i].size());
+            std::memcpy(bytes.data() + levelOffsets[i], levelData[i].data(), levelData[i].size());
+        }
+
+        // basic data format descriptor block
+        size_t dfd = dfdOffset;
+        writeValue<uint32_t>(bytes, dfd, static_cast<uint32_t>(dfdSize));
+        writeValue<uint32_t>(bytes, dfd + 4, 0);
+        writeValue<uint32_t>(bytes, dfd + 8, 2 | static_cast<uint32_t>(dfdSize - sizeof(uint32_t)) << 16);
+        writeValue<uint32_t>(bytes, dfd + 12, colorModel | KHR_DF_PRIMARIES_BT709 << 8 | transfer << 16);
+        writeValue<uint32_t>(bytes, dfd + 16, 3 | 3 << 8);
+        writeValue<uint32_t>(bytes, dfd + 20, blockSize);
+
+        for (uint32_t sample = 0; sample < sampleCount; sample++) {
+            size_t entry = dfd + 28 + sample * 16;
+            uint32_t bitLength = blockSize * 8 / sampleCount;
+            // channel 0 is red/color, 1 is green
+            writeValue<uint32_t>(bytes, entry, sample * bitLength | (bitLength - 1) << 16 | sample << 24);
+            writeValue<uint32_t>(bytes, entry + 8, 0);
+            writeValue<uint32_t>(bytes, entry + 12, UINT32_MAX);
+        }
+
+        std::ofstream file{path, std::ios::binary | std::ios::trunc};
+        if (!file.is_open()) {
+            throw std::runtime_error("failed to open file for writing: " + path);
+        }
+        file.write(reinterpret_cast<const char *>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+    }
+}
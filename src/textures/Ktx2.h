@@ -0,0 +1,36 @@
+#pragma once
+
+#include <vulkan/vulkan_core.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace engine {
+    struct Ktx2Level {
+        // offset into Ktx2Image::data
+        uint64_t offset;
+        uint64_t size;
+    };
+
+    // A single 2D texture with a full or partial mip chain, level 0 being the largest.
+    // Only what the texture cooker writes is supported: no array layers, cube faces or supercompression.
+    struct Ktx2Image {
+        VkFormat format = VK_FORMAT_UNDEFINED;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        std::vector<Ktx2Level> levels;
+        std::vector<uint8_t> data;
+    };
+
+    bool IsKtx2Path(const std::string &path);
+
+    // Block size in bytes of the BC formats the cooker emits, 0 for anything else.
+    uint32_t Ktx2BlockSize(VkFormat format);
+
+    Ktx2Image ReadKtx2(const std::string &path);
+
+    // levelData[i] holds the tightly packed blocks of mip level i.
+    void WriteKtx2(const std::string &path, VkFormat format, uint32_t width, uint32_t height,
+                   const std::vector<std::vector<uint8_t>> &levelData);
+}
@@ -0,0 +1,143 @@
+#include "ResidencyManager.h"
+
+#include <algorithm>
+
+namespace engine {
+    // textures unused for this many frames are evicted instead of only losing mips
+    static constexpr uint64_t EVICT_AFTER_FRAMES = 300;
+
+    ResidencyManager::ResidencyManager(Device &device, TextureStreamer &streamer, VkDeviceSize budget)
+            : mDevice(device), mStreamer(streamer), mConfiguredBudget(budget) {
+        mBudget = QueryBudget();
+    }
+
+    void ResidencyManager::Touch(const std::shared_ptr<StreamedTexture> &texture) {
+        auto &entry = mEntries[texture.get()];
+        if (entry.texture.expired()) {
+            // new, or a freed texture that happened to get the same address
+            entry = Entry{texture};
+        }
+        entry.lastUsed = mStreamer.FrameNumber();
+    }
+
+    void ResidencyManager::Update() {
+        uint64_t frame = mStreamer.FrameNumber();
+
+        std::vector<std::pair<Entry *, std::shared_ptr<StreamedTexture>>> resident;
+        mUsage = mFixedUsage;
+
+        for (auto it = mEntries.begin(); it != mEntries.end();) {
+            auto texture = it->second.texture.lock();
+            if (!texture) {
+                it = mEntries.erase(it);
+                continue;
+            }
+
+            Entry &entry = it->second;
+            if (texture->resident()) {
+                mUsage += texture->image()->memorySize();
+                resident.emplace_back(&entry, std::move(texture));
+            } else if (!texture->loading() && !texture->failed() && entry.lastUsed + 1 >= frame) {
+                // evicted earlier and in use again
+                mStreamer.Reload(texture, texture->skippedLevels());
+            }
+            ++it;
+        }
+
+        mBudget = QueryBudget();
+
+        std::sort(resident.begin(), resident.end(), [](const auto &a, const auto &b) {
+            return a.first->lastUsed < b.first->lastUsed;
+        });
+
+        VkDeviceSize projected = mUsage;
+        if (projected > mBudget) {
+            Shrink(resident, projected);
+        } else {
+            Grow(resident, projected);
+        }
+    }
+
+    void ResidencyManager::Shrink(std::vector<std::pair<Entry *, std::shared_ptr<StreamedTexture>>> &resident,
+                                  VkDeviceSize &projected) {
+        uint64_t frame = mStreamer.FrameNumber();
+
+        // least recently used first, textures in use this frame only as a last resort
+        for (auto &[entry, texture] : resident) {
+            if (projected <= mBudget) {
+                break;
+            }
+            if (texture->loading()) {
+                continue;
+            }
+
+            VkDeviceSize size = texture->image()->memorySize();
+            if (entry->lastUsed + EVICT_AFTER_FRAMES <= frame) {
+                entry->lastSize = size;
+                mStreamer.Evict(texture);
+                projected -= size;
+            } else if (texture->image()->mipLevels() > 1) {
+                // each dropped level leaves roughly a quarter of the memory. The old image stays
+                // alive until the smaller one is resident, so usage peaks briefly before it drops.
+                mStreamer.Reload(texture, texture->skippedLevels() + 1);
+                projected -= size - size / 4;
+            }
+        }
+    }
+
+    void ResidencyManager::Grow(std::vector<std::pair<Entry *, std::shared_ptr<StreamedTexture>>> &resident,
+                                VkDeviceSize projected) {
+        uint64_t frame = mStreamer.FrameNumber();
+
+        // most recently used first, and only one texture per frame so we do not overshoot and start trimming again
+        for (auto it = resident.rbegin(); it != resident.rend(); ++it) {
+            auto &[entry, texture] = *it;
+            if (entry->lastUsed + 1 < frame) {
+                break;
+            }
+            if (texture->skippedLevels() == 0 || texture->loading()) {
+                continue;
+            }
+
+            VkDeviceSize growth = texture->image()->memorySize() * 3;
+            if (projected + growth <= mBudget / 10 * 9) {
+                mStreamer.Reload(texture, texture->skippedLevels() - 1);
+            }
+            break;
+        }
+    }
+
+    VkDeviceSize ResidencyManager::QueryBudget() const {
+        VkPhysicalDeviceMemoryBudgetPropertiesEXT budgetProperties{};
+        budgetProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+
+        bool hasBudgetExtension = mDevice.isExtensionEnabled(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+
+        VkPhysicalDeviceMemoryProperties2 memoryProperties{};
+        memoryProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+        memoryProperties.pNext = hasBudgetExtension ? &budgetProperties : nullptr;
+        vkGetPhysicalDeviceMemoryProperties2(mDevice.physicalDevice(), &memoryProperties);
+
+        VkDeviceSize heapSize = 0;
+        VkDeviceSize heapBudget = 0;
+        VkDeviceSize heapUsage = 0;
+        for (uint32_t i = 0; i < memoryProperties.memoryProperties.memoryHeapCount; i++) {
+            if (memoryProperties.memoryProperties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) {
+                heapSize += memoryProperties.memoryProperties.memoryHeaps[i].size;
+                heapBudget += budgetProperties.heapBudget[i];
+                heapUsage += budgetProperties.heapUsage[i];
+            }
+        }
+
+        VkDeviceSize budget;
+        if (hasBudgetExtension) {
+            // everything on the heap that is not ours to manage (other processes, buffers, swap chain images)
+            VkDeviceSize otherUsage = heapUsage - std::min(heapUsage, mUsage);
+            budget = (heapBudget - std::min(heapBudget, otherUsage)) / 10 * 9;
+        } else {
+            budget = heapSize / 2;
+        }
+
+        return mConfiguredBudget ? std::min(mConfiguredBudget, budget) : budget;
+    }
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "Device.h"
+#include "TextureStreamer.h"
+
+#include <algorithm>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace engine {
+    // Keeps streamed textures within a device memory budget. When usage goes over it, the least
+    // recently used textures first lose their top mip levels and, once unused for a while, are
+    // evicted entirely. Textures that are touched again are reloaded, and dropped mips come back
+    // when there is room again.
+    class ResidencyManager {
+    public:
+        // A budget of 0 derives one from the device local heaps, using VK_EXT_memory_budget when
+        // the device has it so memory used by other processes is taken into account.
+        ResidencyManager(Device &device, TextureStreamer &streamer, VkDeviceSize budget = 0);
+
+        ResidencyManager(const ResidencyManager &) = delete;
+        ResidencyManager &operator=(const ResidencyManager &) = delete;
+
+        // Marks the texture as used this frame, tracking it if it is new.
+        void Touch(const std::shared_ptr<StreamedTexture> &texture);
+
+        // Memory that is counted against the budget but never evicted, e.g. sky boxes.
+        void AddFixedUsage(VkDeviceSize size) { mFixedUsage += size; }
+        void RemoveFixedUsage(VkDeviceSize size) { mFixedUsage -= std::min(size, mFixedUsage); }
+
+        // Call once per frame after TextureStreamer::Update().
+        void Update();
+
+        void SetBudget(VkDeviceSize budget) { mConfiguredBudget = budget; }
+        [[nodiscard]] VkDeviceSize Budget() const { return mBudget; }
+        [[nodiscard]] VkDeviceSize Usage() const { return mUsage; }
+        [[nodiscard]] size_t TrackedCount() const { return mEntries.size(); }
+
+    private:
+        struct Entry {
+            std::weak_ptr<StreamedTexture> texture;
+            uint64_t lastUsed = 0;
+            // size of the image before it was evicted, used to decide whether reloading fits
+            VkDeviceSize lastSize = 0;
+        };
+
+        VkDeviceSize QueryBudget() const;
+        void Shrink(std::vector<std::pair<Entry *, std::shared_ptr<StreamedTexture>>> &resident, VkDeviceSize &projected);
+        void Grow(std::vector<std::pair<Entry *, std::shared_ptr<StreamedTexture>>> &resident, VkDeviceSize projected);
+
+        Device &mDevice;
+        TextureStreamer &mStreamer;
+        VkDeviceSize mConfiguredBudget;
+        VkDeviceSize mBudget = 0;
+        VkDeviceSize mUsage = 0;
+        VkDeviceSize mFixedUsage = 0;
+        std::unordered_map<const StreamedTexture *, Entry> mEntries;
+    };
+}
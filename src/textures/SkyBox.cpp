@@ -60,6 +60,10 @@ SkyBox::SkyBox(Device &device, const std::array<std::string, 6> &filepaths) : mD
 
   mDevice.createImageWithInfo(imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, mImage, mImageMemory);
 
+  VkMemoryRequirements memoryRequirements;
+  mDevice.dispatch().vkGetImageMemoryRequirements(mDevice.device(), mImage, &memoryRequirements);
+  mMemorySize = memoryRequirements.size;
+
   VkImageSubresourceRange subresourceRange = {};
   subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
   subresourceRange.baseMipLevel = 0;
@@ -119,7 +123,7 @@ SkyBox::SkyBox(Device &device, const std::array<std::string, 6> &filepaths) : mD
   samplerInfo.anisotropyEnable = VK_FALSE;
   samplerInfo.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
 
-  vkCreateSampler(mDevice.device(), &samplerInfo, nullptr, &mSampler);
+  mDevice.dispatch().vkCreateSampler(mDevice.device(), &samplerInfo, nullptr, &mSampler);
 
   VkImageViewCreateInfo imageViewInfo{};
   imageViewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
@@ -133,16 +137,16 @@ SkyBox::SkyBox(Device &device, const std::array<std::string, 6> &filepaths) : mD
   imageViewInfo.subresourceRange.levelCount = mipLevels;
   imageViewInfo.image = mImage;
 
-  vkCreateImageView(mDevice.device(), &imageViewInfo, nullptr, &mImageView);
+  mDevice.dispatch().vkCreateImageView(mDevice.device(), &imageViewInfo, nullptr, &mImageView);
 
   for (uint32_t i = 0; i < 6; i++){ stbi_image_free(data[i]); }
 }
 
 SkyBox::~SkyBox() {
-  vkDestroyImage(mDevice.device(), mImage, nullptr);
-  vkFreeMemory(mDevice.device(), mImageMemory, nullptr);
-  vkDestroyImageView(mDevice.device(), mImageView, nullptr);
-  vkDestroySampler(mDevice.device(), mSampler, nullptr);
+  mDevice.dispatch().vkDestroyImage(mDevice.device(), mImage, nullptr);
+  mDevice.dispatch().vkFreeMemory(mDevice.device(), mImageMemory, nullptr);
+  mDevice.dispatch().vkDestroyImageView(mDevice.device(), mImageView, nullptr);
+  mDevice.dispatch().vkDestroySampler(mDevice.device(), mSampler, nullptr);
 }
 
 void SkyBox::transitionImageLayout(VkImageLayout oldLayout, VkImageLayout newLayout, VkImageSubresourceRange subresourceRange) {
@@ -176,7 +180,7 @@ void SkyBox::transitionImageLayout(VkImageLayout oldLayout, VkImageLayout newLay
     throw std::runtime_error("unsupported layout transition!");
   }
 
-  vkCmdPipelineBarrier(commandBuffer, sourceStage, destinationStage, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+  mDevice.dispatch().vkCmdPipelineBarrier(commandBuffer, sourceStage, destinationStage, 0, 0, nullptr, 0, nullptr, 1, &barrier);
   mDevice.endSingleTimeCommands(commandBuffer);
 }
 
@@ -211,7 +215,7 @@ void SkyBox::generateMipmaps() {
     barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
     barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
 
-    vkCmdPipelineBarrier(commandBuffer,
+    mDevice.dispatch().vkCmdPipelineBarrier(commandBuffer,
                          VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
                          0, nullptr,
                          0, nullptr,
@@ -233,7 +237,7 @@ void SkyBox::generateMipmaps() {
       blit.dstSubresource.baseArrayLayer = layer;
       blit.dstSubresource.layerCount = 1;
 
-      vkCmdBlitImage(
+      mDevice.dispatch().vkCmdBlitImage(
           commandBuffer, mImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, mImage,
           VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blit, VK_FILTER_LINEAR);
     }
@@ -243,7 +247,7 @@ void SkyBox::generateMipmaps() {
     barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
     barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
 
-    vkCmdPipelineBarrier(commandBuffer,
+    mDevice.dispatch().vkCmdPipelineBarrier(commandBuffer,
                          VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0,
                          0, nullptr,
                          0, nullptr,
@@ -259,7 +263,7 @@ void SkyBox::generateMipmaps() {
   barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
   barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
 
-  vkCmdPipelineBarrier(commandBuffer,
+  mDevice.dispatch().vkCmdPipelineBarrier(commandBuffer,
                        VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0,
                        0, nullptr,
                        0, nullptr,
@@ -21,6 +21,7 @@ public:
   [[nodiscard]] VkDescriptorImageInfo descriptorInfo() const { return {mSampler, mImageView, mImageLayout}; }
   [[nodiscard]] uint32_t width() const { return m_width; }
   [[nodiscard]] uint32_t height() const { return m_height; }
+  [[nodiscard]] VkDeviceSize memorySize() const { return mMemorySize; }
 
 private:
   void transitionImageLayout(VkImageLayout oldLayout, VkImageLayout newLayout, VkImageSubresourceRange subresourceRange);
@@ -30,6 +31,7 @@ private:
   Device &mDevice;
   VkImage mImage;
   VkDeviceMemory mImageMemory;
+  VkDeviceSize mMemorySize = 0;
   VkImageView mImageView;
   VkSampler mSampler;
   VkFormat mImageFormat;
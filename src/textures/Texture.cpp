@@ -6,12 +6,12 @@
 #include "Texture.h"
 
 namespace engine {
-    Texture::Texture(Device &device,
+    Texture::Texture(Device &device, LayoutCache &layoutCache,
                      const std::string &albedo, const std::string &roughness,
                      const std::string &normal, const std::string &metallic,
                      const std::string &ao, const std::string &height,
                      const std::string &specular, const std::string &emissive)
-                     : m_device(device) {
+                     : m_device(device), m_layoutCache(layoutCache) {
 
 
         std::unique_ptr<TextureImage> texture;
@@ -40,16 +40,35 @@ namespace engine {
         texture = std::make_unique<TextureImage>(m_device, emissive);
         m_textures.push_back(std::move(texture));
 
+        CreateUniformBuffers();
+        CreatePool();
+        CreateSetLayout();
+        CreateDescriptorSets();
+    }
+
+    Texture::Texture(Device &device, LayoutCache &layoutCache, TextureStreamer &streamer,
+                     const std::array<std::string, 8> &paths)
+                     : m_device(device), m_layoutCache(layoutCache) {
+        for (auto &path : paths) {
+            auto streamed = streamer.Request(path);
+            m_textures.push_back(streamed->image());
+            m_streamedGenerations.push_back(streamed->generation());
+            m_streamed.push_back(std::move(streamed));
+        }
+
+        CreateUniformBuffers();
+        CreatePool();
+        CreateSetLayout();
+        CreateDescriptorSets();
+    }
+
+    void Texture::CreateUniformBuffers() {
         for (int i = 0; i < uboBuffers.size(); i++) {
             uboBuffers[i] = std::make_unique<Buffer>(
                     m_device, sizeof(UvTransform), 1, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
                     VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
             uboBuffers[i]->map();
         }
-
-        CreatePool();
-        CreateSetLayout();
-        CreateDescriptorSets();
     }
 
     void Texture::CreateSetLayout() {
@@ -64,7 +83,7 @@ namespace engine {
                 .addBinding(7, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT, 1)
                 .addBinding(8, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT, 1)
                 .addBinding(9, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT, 1)
-                .build();
+                .build(m_layoutCache);
     }
 
     void Texture::CreateDescriptorSets() {
@@ -106,25 +125,62 @@ namespace engine {
         std::unique_ptr<TextureImage> newTexture = std::make_unique<TextureImage>(m_device, imagePath);
 
         m_textures[textureIndex] = std::move(newTexture);
+        if (textureIndex < m_streamed.size()) {
+            m_streamed[textureIndex].reset();
+        }
 
         UpdateDescriptorSets();
     }
 
     void Texture::UpdateDescriptorSets() {
-        VkDescriptorImageInfo *imageInfos = new VkDescriptorImageInfo[m_textures.size()];
-        for (uint32_t i = 0; i < m_textures.size(); i++) {
-            imageInfos[i].sampler = m_textures[i]->sampler();
-            imageInfos[i].imageView = m_textures[i]->imageView();
-            imageInfos[i].imageLayout = m_textures[i]->imageLayout();
+        for (uint32_t i = 0; i < mDescriptorSets.size(); i++) {
+            WriteDescriptorSet(i);
         }
+    }
 
-        for (uint32_t i = 0; i < mDescriptorSets.size(); i++) {
-            auto bufferInfo = uboBuffers[i]->descriptorInfo();
-            DescriptorWriter(*mDescriptorSetLayout, *mDescriptorPool)
-                    .writeImage(0, imageInfos, m_textures.size())
-                    .writeBuffer(8, &bufferInfo)
-                    .overwrite(mDescriptorSets[i]);
+    void Texture::Refresh(uint32_t frameIndex) {
+        for (uint32_t i = 0; i < m_streamed.size(); i++) {
+            if (m_streamed[i] && m_streamed[i]->generation() != m_streamedGenerations[i]) {
+                m_textures[i] = m_streamed[i]->image();
+                m_streamedGenerations[i] = m_streamed[i]->generation();
+                // the other frames may still be in flight, they pick the change up on their next Refresh
+                m_staleFrames = (1u << mDescriptorSets.size()) - 1;
+            }
         }
-        delete[] imageInfos;
+
+        if (m_staleFrames & (1u << frameIndex)) {
+            WriteDescriptorSet(frameIndex);
+            m_staleFrames &= ~(1u << frameIndex);
+        }
+    }
+
+    bool Texture::resident() const {
+        for (auto &streamed : m_streamed) {
+            if (streamed && !streamed->resident()) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void Texture::Touch(ResidencyManager &residency) const {
+        for (auto &streamed : m_streamed) {
+            if (streamed) {
+                residency.Touch(streamed);
+            }
+        }
+    }
+
+    void Texture::WriteDescriptorSet(uint32_t frameIndex) {
+        std::vector<VkDescriptorImageInfo> imageInfos(m_textures.size());
+        for (uint32_t i = 0; i < m_textures.size(); i++) {
+            imageInfos[i] = m_textures[i]->descriptorInfo();
+        }
+
+        auto bufferInfo = uboBuffers[frameIndex]->descriptorInfo();
+        DescriptorWriter(*mDescriptorSetLayout, *mDescriptorPool)
+                .writeImage(0, imageInfos.data(), imageInfos.size())
+                .writeBuffer(9, &bufferInfo)
+                .overwrite(mDescriptorSets[frameIndex]);
     }
 }
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <array>
 #include <string>
 #include <memory>
 #include <vector>
@@ -12,9 +13,12 @@
 #include "SkyBox.h"
 #include "SwapChain.h"
 #include "TextureImage.h"
+#include "TextureStreamer.h"
+#include "ResidencyManager.h"
 #include "descriptors/DescriptorPool.h"
 #include "descriptors/DescriptorSetLayout.h"
 #include "descriptors/DescriptorWriter.h"
+#include "descriptors/LayoutCache.h"
 
 namespace engine {
     struct UvTransform {
@@ -26,6 +30,7 @@ namespace engine {
     class Texture {
     public:
         Texture(Device &device,
+                LayoutCache &layoutCache,
                 const std::string &albedo = "../textures/default/albedo.jpg",
                 const std::string &roughness = "../textures/default/roughness.jpg",
                 const std::string &normal = "../textures/default/normal.jpg",
@@ -35,6 +40,13 @@ namespace engine {
                 const std::string &specular = "../textures/default/specular.jpg",
                 const std::string &emissive = "../textures/default/emissive.jpg");
 
+        // Binds the streamer's placeholder for every slot and returns immediately. Call Refresh()
+        // each frame to swap in the real images as they become resident.
+        Texture(Device &device,
+                LayoutCache &layoutCache,
+                TextureStreamer &streamer,
+                const std::array<std::string, 8> &paths);
+
         std::vector<VkDescriptorSet> GetDescriptorSets() { return mDescriptorSets; }
         std::shared_ptr<DescriptorSetLayout> GetDescriptorSetLayout() { return mDescriptorSetLayout; }
 
@@ -42,6 +54,12 @@ namespace engine {
         void UpdateImage(uint32_t textureIndex, const std::string &imagePath);
         void UpdateDescriptorSets();
 
+        // Rewrites the descriptor set of frameIndex if a streamed image changed since it was last written.
+        void Refresh(uint32_t frameIndex);
+        [[nodiscard]] bool resident() const;
+        // Call for every frame the material is drawn so its images are not evicted.
+        void Touch(ResidencyManager &residency) const;
+
         std::shared_ptr<TextureImage> albedo() { return m_textures[0]; }
         std::shared_ptr<TextureImage> roughness() { return m_textures[1]; }
         std::shared_ptr<TextureImage> normal() { return m_textures[2]; }
@@ -53,15 +71,21 @@ namespace engine {
 
     private:
         Device &m_device;
+        LayoutCache &m_layoutCache;
         std::unique_ptr<DescriptorPool> mDescriptorPool{};
         std::vector<VkDescriptorSet> mDescriptorSets{SwapChain::MAX_FRAMES_IN_FLIGHT};
         std::shared_ptr<DescriptorSetLayout> mDescriptorSetLayout{};
         std::vector<std::shared_ptr<TextureImage>> m_textures;
         std::vector<std::unique_ptr<Buffer>> uboBuffers{SwapChain::MAX_FRAMES_IN_FLIGHT};
+        std::vector<std::shared_ptr<StreamedTexture>> m_streamed;
+        std::vector<uint32_t> m_streamedGenerations;
+        uint32_t m_staleFrames = 0;
 
+        void CreateUniformBuffers();
         void CreatePool();
         void CreateSetLayout();
         void CreateDescriptorSets();
+        void WriteDescriptorSet(uint32_t frameIndex);
     };
 
 }
@@ -0,0 +1,152 @@
+#include "TextureAtlas.h"
+#include "Buffer.h"
+#include "stb/stb_image.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <stdexcept>
+
+namespace engine {
+    // texels repeated around every region
+    static constexpr uint32_t BORDER = 1;
+    static constexpr uint32_t WHITE_SIZE = 4;
+
+    static uint32_t NextPowerOfTwo(uint32_t value) {
+        uint32_t result = 1;
+        while (result < value) {
+            result <<= 1;
+        }
+        return result;
+    }
+
+    TextureAtlas::Builder &TextureAtlas::Builder::addImage(const std::string &name, const std::string &filepath) {
+        int width, height, channels;
+        stbi_uc *data = stbi_load(filepath.c_str(), &width, &height, &channels, 4);
+        if (!data) {
+            throw std::runtime_error("failed to load image: " + filepath);
+        }
+
+        addPixels(name, static_cast<uint32_t>(width), static_cast<uint32_t>(height), data);
+        stbi_image_free(data);
+        return *this;
+    }
+
+    TextureAtlas::Builder &TextureAtlas::Builder::addPixels(const std::string &name, uint32_t width, uint32_t height,
+                                                            const uint8_t *rgba) {
+        if (width == 0 || height == 0) {
+            throw std::runtime_error("empty atlas image: " + name);
+        }
+
+        mSources.push_back({name, width, height, {rgba, rgba + size_t{width} * height * 4}});
+        return *this;
+    }
+
+    std::unique_ptr<TextureAtlas> TextureAtlas::Builder::build(uint32_t maxSize) const {
+        std::vector<Source> sources;
+        sources.reserve(mSources.size() + 1);
+        sources.push_back({"", WHITE_SIZE, WHITE_SIZE, std::vector<uint8_t>(WHITE_SIZE * WHITE_SIZE * 4, 255)});
+        sources.insert(sources.end(), mSources.begin(), mSources.end());
+
+        // shelves fill best with the tallest images first
+        std::vector<uint32_t> order(sources.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+            return sources[a].height > sources[b].height;
+        });
+
+        uint64_t area = 0;
+        uint32_t widest = 0;
+        for (const Source &source : sources) {
+            area += uint64_t{source.width + 2 * BORDER} * (source.height + 2 * BORDER);
+            widest = std::max(widest, source.width + 2 * BORDER);
+        }
+
+        // the narrowest power of two width whose shelves fit under maxSize
+        std::vector<glm::uvec2> offsets(sources.size());
+        uint32_t width = std::max(NextPowerOfTwo(static_cast<uint32_t>(std::sqrt(static_cast<double>(area)))),
+                                  NextPowerOfTwo(widest));
+        uint32_t height = 0;
+        for (; width <= maxSize; width *= 2) {
+            uint32_t x = 0;
+            uint32_t shelfY = 0;
+            uint32_t shelfHeight = 0;
+            for (uint32_t index : order) {
+                uint32_t paddedWidth = sources[index].width + 2 * BORDER;
+                if (x + paddedWidth > width) {
+                    shelfY += shelfHeight;
+                    x = 0;
+                    shelfHeight = 0;
+                }
+                offsets[index] = {x, shelfY};
+                x += paddedWidth;
+                shelfHeight = std::max(shelfHeight, sources[index].height + 2 * BORDER);
+            }
+
+            height = NextPowerOfTwo(shelfY + shelfHeight);
+            if (height <= maxSize) {
+                break;
+            }
+        }
+        if (width > maxSize) {
+            throw std::runtime_error("texture atlas images do not fit into " + std::to_string(maxSize) + " pixels");
+        }
+
+        std::vector<uint8_t> pixels(size_t{width} * height * 4, 0);
+        std::vector<Region> regions(sources.size());
+        std::unordered_map<std::string, uint32_t> names;
+
+        for (uint32_t i = 0; i < sources.size(); i++) {
+            const Source &source = sources[i];
+            glm::uvec2 offset = offsets[i];
+
+            // clamping the source coordinates repeats the edge texels into the border
+            for (uint32_t y = 0; y < source.height + 2 * BORDER; y++) {
+                uint32_t sourceY = std::min(std::max(y, BORDER) - BORDER, source.height - 1);
+                for (uint32_t x = 0; x < source.width + 2 * BORDER; x++) {
+                    uint32_t sourceX = std::min(std::max(x, BORDER) - BORDER, source.width - 1);
+                    const uint8_t *texel = &source.pixels[(size_t{sourceY} * source.width + sourceX) * 4];
+                    std::copy(texel, texel + 4, &pixels[(size_t{offset.y + y} * width + offset.x + x) * 4]);
+                }
+            }
+
+            glm::vec2 atlasSize{width, height};
+            regions[i].uvMin = glm::vec2{offset + BORDER} / atlasSize;
+            regions[i].uvMax = glm::vec2{offset + BORDER + glm::uvec2{source.width, source.height}} / atlasSize;
+            regions[i].size = {source.width, source.height};
+
+            if (i != WHITE_REGION && !names.emplace(source.name, i).second) {
+                throw std::runtime_error("duplicate atlas image: " + source.name);
+            }
+        }
+
+        return std::make_unique<TextureAtlas>(mDevice, width, height, pixels, std::move(regions), std::move(names));
+    }
+
+    TextureAtlas::TextureAtlas(Device &device, uint32_t width, uint32_t height, const std::vector<uint8_t> &pixels,
+                               std::vector<Region> regions, std::unordered_map<std::string, uint32_t> names)
+            : m_image(device, width, height, VK_FORMAT_R8G8B8A8_SRGB, 1), m_regions(std::move(regions)),
+              m_names(std::move(names)) {
+        Buffer stagingBuffer{device,
+                             4,
+                             width * height,
+                             VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                             VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
+                             | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT};
+
+        stagingBuffer.map();
+        stagingBuffer.writeToBuffer(const_cast<uint8_t *>(pixels.data()));
+
+        VkCommandBuffer commandBuffer = device.beginSingleTimeCommands();
+        m_image.recordUpload(commandBuffer, stagingBuffer.getBuffer(), 0);
+        device.endSingleTimeCommands(commandBuffer);
+    }
+
+    uint32_t TextureAtlas::Find(const std::string &name) const {
+        auto it = m_names.find(name);
+        if (it == m_names.end()) {
+            throw std::runtime_error("no atlas image named " + name);
+        }
+        return it->second;
+    }
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "Device.h"
+#include "TextureImage.h"
+
+#include <glm/glm.hpp>
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace engine {
+    // Many small RGBA images packed into one TextureImage, so everything drawn from it can share a
+    // single descriptor set and be batched into one draw. Images are placed on shelves, tallest
+    // first, with their border pixels repeated once around them so linear filtering at a region's
+    // edge does not pick up its neighbours. Region 0 is a small white square for flat colored quads.
+    class TextureAtlas {
+    public:
+        struct Region {
+            glm::vec2 uvMin;
+            glm::vec2 uvMax;
+            // in pixels, without the border
+            glm::uvec2 size;
+        };
+
+        static constexpr uint32_t WHITE_REGION = 0;
+
+        class Builder {
+        public:
+            explicit Builder(Device &device) : mDevice{device} {}
+
+            Builder &addImage(const std::string &name, const std::string &filepath);
+
+            // rgba holds width * height tightly packed RGBA8 texels
+            Builder &addPixels(const std::string &name, uint32_t width, uint32_t height, const uint8_t *rgba);
+
+            // Throws if the images do not fit into maxSize x maxSize.
+            std::unique_ptr<TextureAtlas> build(uint32_t maxSize = 4096) const;
+
+        private:
+            struct Source {
+                std::string name;
+                uint32_t width;
+                uint32_t height;
+                std::vector<uint8_t> pixels;
+            };
+
+            Device &mDevice;
+            std::vector<Source> mSources;
+        };
+
+        TextureAtlas(Device &device, uint32_t width, uint32_t height, const std::vector<uint8_t> &pixels,
+                     std::vector<Region> regions, std::unordered_map<std::string, uint32_t> names);
+
+        TextureAtlas(const TextureAtlas &) = delete;
+        TextureAtlas &operator=(const TextureAtlas &) = delete;
+
+        // Throws for names that were never added. Look regions up once and keep the index.
+        [[nodiscard]] uint32_t Find(const std::string &name) const;
+        [[nodiscard]] const Region &GetRegion(uint32_t region) const { return m_regions[region]; }
+        [[nodiscard]] uint32_t RegionCount() const { return static_cast<uint32_t>(m_regions.size()); }
+
+        [[nodiscard]] const TextureImage &GetImage() const { return m_image; }
+
+    private:
+        TextureImage m_image;
+        std::vector<Region> m_regions;
+        std::unordered_map<std::string, uint32_t> m_names;
+    };
+}
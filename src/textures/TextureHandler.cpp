@@ -5,7 +5,8 @@
 #include "descriptors/DescriptorWriter.h"
 
 namespace engine {
-    TextureHandler::TextureHandler(Device &device, uint32_t maxTextures) : mDevice(device), mMaxTextures(maxTextures) {
+    TextureHandler::TextureHandler(Device &device, LayoutCache &layoutCache, uint32_t maxTextures)
+            : mDevice(device), mLayoutCache(layoutCache), mMaxTextures(maxTextures) {
         GeneratePool();
     }
 
@@ -25,7 +26,7 @@ namespace engine {
     void TextureHandler::GenerateSetLayout() {
         mDescriptorSetLayout = DescriptorSetLayout::Builder(mDevice)
                 .addBinding(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT, mMaxTextures)
-                .build();
+                .build(mLayoutCache);
     }
 
     void TextureHandler::GenerateDescriptorSets() {
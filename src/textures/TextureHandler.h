@@ -4,13 +4,14 @@
 #include "TextureImage.h"
 #include "descriptors/DescriptorPool.h"
 #include "descriptors/DescriptorSetLayout.h"
+#include "descriptors/LayoutCache.h"
 #include "SwapChain.h"
 
 namespace engine {
 
     class TextureHandler {
     public:
-        TextureHandler(Device &device, uint32_t maxTextures);
+        TextureHandler(Device &device, LayoutCache &layoutCache, uint32_t maxTextures);
 
         void GenerateSetLayout();
         void GenerateDescriptorSets();
@@ -24,6 +25,7 @@ namespace engine {
         void GeneratePool();
 
         Device &mDevice;
+        LayoutCache &mLayoutCache;
         std::unique_ptr<DescriptorPool> mDescriptorPool{};
         std::vector<VkDescriptorSet> mDescriptorSets{SwapChain::MAX_FRAMES_IN_FLIGHT};
         std::shared_ptr<DescriptorSetLayout> mDescriptorSetLayout{};
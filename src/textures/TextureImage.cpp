@@ -9,6 +9,11 @@
 namespace engine {
 
     TextureImage::TextureImage(Device &device, const std::string &filepath) : mDevice(device) {
+        if (IsKtx2Path(filepath)) {
+            loadKtx2(filepath);
+            return;
+        }
+
         int channels;
         int bytesPerPixel;
 
@@ -18,7 +23,9 @@ namespace engine {
             throw std::runtime_error("failed to load image: " + filepath);
         }
 
-        m_mipLevels = std::floor(std::log2(std::max(m_width, m_height))) + 1;
+        mImageFormat = VK_FORMAT_R8G8B8A8_SRGB;
+        m_mipLevels = 0;
+        createImage();
 
         Buffer stagingBuffer{mDevice,
                              4,
@@ -30,7 +37,55 @@ namespace engine {
         stagingBuffer.map();
         stagingBuffer.writeToBuffer(data);
 
-        mImageFormat = VK_FORMAT_R8G8B8A8_SRGB;
+        // transition, copy and mip generation share one submission instead of waiting on the queue for each
+        VkCommandBuffer commandBuffer = mDevice.beginSingleTimeCommands();
+        recordUpload(commandBuffer, stagingBuffer.getBuffer(), 0);
+        mDevice.endSingleTimeCommands(commandBuffer);
+
+        stbi_image_free(data);
+    }
+
+    TextureImage::TextureImage(Device &device, uint32_t width, uint32_t height, VkFormat format, uint32_t mipLevels)
+            : m_width(static_cast<int>(width)), m_height(static_cast<int>(height)), m_mipLevels(static_cast<int>(mipLevels)),
+              mDevice(device), mImageFormat(format) {
+        createImage();
+    }
+
+    void TextureImage::loadKtx2(const std::string &filepath) {
+        Ktx2Image ktx2 = ReadKtx2(filepath);
+
+        m_width = static_cast<int>(ktx2.width);
+        m_height = static_cast<int>(ktx2.height);
+        m_mipLevels = static_cast<int>(ktx2.levels.size());
+        mImageFormat = ktx2.format;
+        createImage();
+
+        Buffer stagingBuffer{mDevice,
+                             ktx2.data.size(),
+                             1,
+                             VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                             VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
+                             | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT};
+
+        stagingBuffer.map();
+        stagingBuffer.writeToBuffer(ktx2.data.data());
+
+        VkCommandBuffer commandBuffer = mDevice.beginSingleTimeCommands();
+        recordUpload(commandBuffer, stagingBuffer.getBuffer(), 0, ktx2.levels);
+        mDevice.endSingleTimeCommands(commandBuffer);
+    }
+
+    void TextureImage::createImage() {
+        VkFormatProperties formatProperties{};
+        vkGetPhysicalDeviceFormatProperties(mDevice.physicalDevice(), mImageFormat, &formatProperties);
+
+        if (!(formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT)) {
+            throw std::runtime_error("texture image format is not supported for sampling!");
+        }
+
+        if (m_mipLevels == 0) {
+            m_mipLevels = std::floor(std::log2(std::max(m_width, m_height))) + 1;
+        }
 
         VkImageCreateInfo imageInfo{};
         imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
@@ -50,13 +105,9 @@ namespace engine {
 
         mDevice.createImageWithInfo(imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, mImage, mImageMemory);
 
-        transitionImageLayout(VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-
-        mDevice.copyBufferToImage(stagingBuffer.getBuffer(), mImage, m_width, m_height, 1);
-
-//        transitionImageLayout(VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
-
-        generateMipmaps();
+        VkMemoryRequirements memoryRequirements;
+        mDevice.dispatch().vkGetImageMemoryRequirements(mDevice.device(), mImage, &memoryRequirements);
+        mMemorySize = memoryRequirements.size;
 
         mImageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
 
@@ -71,12 +122,12 @@ namespace engine {
         samplerInfo.mipLodBias = 0.0f;
         samplerInfo.compareOp = VK_COMPARE_OP_NEVER;
         samplerInfo.minLod = 0.0f;
-        samplerInfo.maxLod = 0.0f;
+        samplerInfo.maxLod = static_cast<float>(m_mipLevels);
         samplerInfo.maxAnisotropy = 4.0f;
         samplerInfo.anisotropyEnable = VK_TRUE;
         samplerInfo.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
 
-        vkCreateSampler(mDevice.device(), &samplerInfo, nullptr, &mSampler);
+        mDevice.dispatch().vkCreateSampler(mDevice.device(), &samplerInfo, nullptr, &mSampler);
 
         VkImageViewCreateInfo imageViewInfo{};
         imageViewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
@@ -90,21 +141,58 @@ namespace engine {
         imageViewInfo.subresourceRange.levelCount = m_mipLevels;
         imageViewInfo.image = mImage;
 
-        vkCreateImageView(mDevice.device(), &imageViewInfo, nullptr, &mImageView);
+        mDevice.dispatch().vkCreateImageView(mDevice.device(), &imageViewInfo, nullptr, &mImageView);
+    }
 
-        stbi_image_free(data);
+    void TextureImage::recordUpload(VkCommandBuffer commandBuffer, VkBuffer stagingBuffer, VkDeviceSize stagingOffset) {
+        recordTransition(commandBuffer, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+
+        VkBufferImageCopy region{};
+        region.bufferOffset = stagingOffset;
+        region.bufferRowLength = 0;
+        region.bufferImageHeight = 0;
+        region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        region.imageSubresource.mipLevel = 0;
+        region.imageSubresource.baseArrayLayer = 0;
+        region.imageSubresource.layerCount = 1;
+        region.imageOffset = {0, 0, 0};
+        region.imageExtent = {static_cast<uint32_t>(m_width), static_cast<uint32_t>(m_height), 1};
+
+        mDevice.dispatch().vkCmdCopyBufferToImage(commandBuffer, stagingBuffer, mImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+
+        recordMipmaps(commandBuffer);
     }
 
-    TextureImage::~TextureImage() {
-        vkDestroyImage(mDevice.device(), mImage, nullptr);
-        vkFreeMemory(mDevice.device(), mImageMemory, nullptr);
-        vkDestroyImageView(mDevice.device(), mImageView, nullptr);
-        vkDestroySampler(mDevice.device(), mSampler, nullptr);
+    void TextureImage::recordUpload(VkCommandBuffer commandBuffer, VkBuffer stagingBuffer, VkDeviceSize stagingOffset,
+                                    const std::vector<Ktx2Level> &levels) {
+        recordTransition(commandBuffer, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+
+        std::vector<VkBufferImageCopy> regions(levels.size());
+        for (uint32_t i = 0; i < levels.size(); i++) {
+            regions[i].bufferOffset = stagingOffset + levels[i].offset;
+            regions[i].imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            regions[i].imageSubresource.mipLevel = i;
+            regions[i].imageSubresource.baseArrayLayer = 0;
+            regions[i].imageSubresource.layerCount = 1;
+            regions[i].imageOffset = {0, 0, 0};
+            regions[i].imageExtent = {std::max(static_cast<uint32_t>(m_width) >> i, 1u),
+                                      std::max(static_cast<uint32_t>(m_height) >> i, 1u), 1};
+        }
+
+        mDevice.dispatch().vkCmdCopyBufferToImage(commandBuffer, stagingBuffer, mImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                               static_cast<uint32_t>(regions.size()), regions.data());
+
+        recordTransition(commandBuffer, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
     }
 
-    void TextureImage::transitionImageLayout(VkImageLayout oldLayout, VkImageLayout newLayout) {
-        VkCommandBuffer commandBuffer = mDevice.beginSingleTimeCommands();
+    TextureImage::~TextureImage() {
+        mDevice.dispatch().vkDestroyImage(mDevice.device(), mImage, nullptr);
+        mDevice.dispatch().vkFreeMemory(mDevice.device(), mImageMemory, nullptr);
+        mDevice.dispatch().vkDestroyImageView(mDevice.device(), mImageView, nullptr);
+        mDevice.dispatch().vkDestroySampler(mDevice.device(), mSampler, nullptr);
+    }
 
+    void TextureImage::recordTransition(VkCommandBuffer commandBuffer, VkImageLayout oldLayout, VkImageLayout newLayout) {
         VkImageMemoryBarrier barrier{};
         barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
         barrier.oldLayout = oldLayout;
@@ -137,11 +225,10 @@ namespace engine {
             throw std::runtime_error("unsupported layout transition!");
         }
 
-        vkCmdPipelineBarrier(commandBuffer, sourceStage, destinationStage, 0, 0, nullptr, 0, nullptr, 1, &barrier);
-        mDevice.endSingleTimeCommands(commandBuffer);
+        mDevice.dispatch().vkCmdPipelineBarrier(commandBuffer, sourceStage, destinationStage, 0, 0, nullptr, 0, nullptr, 1, &barrier);
     }
 
-    void TextureImage::generateMipmaps() {
+    void TextureImage::recordMipmaps(VkCommandBuffer commandBuffer) {
         VkFormatProperties formatProperties{};
         vkGetPhysicalDeviceFormatProperties(mDevice.physicalDevice(), mImageFormat, &formatProperties);
 
@@ -149,8 +236,6 @@ namespace engine {
             throw std::runtime_error("texture image format does not support linear blitting!");
         }
 
-        VkCommandBuffer commandBuffer = mDevice.beginSingleTimeCommands();
-
         VkImageMemoryBarrier barrier{};
         barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
         barrier.image = mImage;
@@ -172,7 +257,7 @@ namespace engine {
             barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
             barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
 
-            vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0,
+            mDevice.dispatch().vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0,
                                  nullptr, 0, nullptr, 1, &barrier);
 
             VkImageBlit blit{};
@@ -183,20 +268,20 @@ namespace engine {
             blit.srcSubresource.baseArrayLayer = 0;
             blit.srcSubresource.layerCount = 1;
             blit.dstOffsets[0] = {0, 0, 0};
-            blit.dstOffsets[1] = {mipWidth > 1 ? mipWidth / 2 : 1, mipHeight > 1 ? mipHeight / 2 > 1 : 1, 1};
+            blit.dstOffsets[1] = {mipWidth > 1 ? mipWidth / 2 : 1, mipHeight > 1 ? mipHeight / 2 : 1, 1};
             blit.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
             blit.dstSubresource.mipLevel = i;
             blit.dstSubresource.baseArrayLayer = 0;
             blit.dstSubresource.layerCount = 1;
 
-            vkCmdBlitImage(commandBuffer, mImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, mImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blit, VK_FILTER_LINEAR);
+            mDevice.dispatch().vkCmdBlitImage(commandBuffer, mImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, mImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blit, VK_FILTER_LINEAR);
 
             barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
             barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
             barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
             barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
 
-            vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0,
+            mDevice.dispatch().vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0,
                                  nullptr, 0, nullptr, 1, &barrier);
 
             if (mipWidth > 1) mipWidth /= 2;
@@ -206,12 +291,10 @@ namespace engine {
         barrier.subresourceRange.baseMipLevel = m_mipLevels - 1;
         barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
         barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-        barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
         barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
 
-        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0,
+        mDevice.dispatch().vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0,
                              nullptr, 0, nullptr, 1, &barrier);
-
-        mDevice.endSingleTimeCommands(commandBuffer);
     }
 }
\ No newline at end of file
@@ -1,36 +1,59 @@
 #pragma once
 
 #include "Device.h"
-
+#include "Ktx2.h"
 
 #include <string>
 
 namespace engine {
     class TextureImage {
     public:
+        // .ktx2 files written by texture_cook are uploaded as is, anything else goes through stb_image
+        // and gets its mips generated on the GPU.
         TextureImage(Device &device, const std::string &filepath);
+
+        // Allocates image, view and sampler without uploading anything. The texels are
+        // written by recording recordUpload() into a command buffer owned by the caller.
+        // A mipLevels of 0 allocates the full chain.
+        TextureImage(Device &device, uint32_t width, uint32_t height, VkFormat format = VK_FORMAT_R8G8B8A8_SRGB,
+                     uint32_t mipLevels = 0);
+
         ~TextureImage();
 
         TextureImage(const TextureImage &) = delete;
         TextureImage &operator=(const TextureImage &) = delete;
 
+        // Records the copy of tightly packed level 0 texels at stagingOffset, the mip chain
+        // blits and the final transition to shader read. Does not submit anything.
+        void recordUpload(VkCommandBuffer commandBuffer, VkBuffer stagingBuffer, VkDeviceSize stagingOffset);
+
+        // Records the copy of precomputed levels, level offsets are relative to stagingOffset.
+        void recordUpload(VkCommandBuffer commandBuffer, VkBuffer stagingBuffer, VkDeviceSize stagingOffset,
+                          const std::vector<Ktx2Level> &levels);
+
         [[nodiscard]] VkSampler sampler() const { return mSampler; }
         [[nodiscard]] VkImageView imageView() const { return mImageView; }
         [[nodiscard]] VkImageLayout imageLayout() const { return mImageLayout; }
+        [[nodiscard]] VkDescriptorImageInfo descriptorInfo() const { return {mSampler, mImageView, mImageLayout}; }
         [[nodiscard]] uint32_t width() const { return m_width; }
         [[nodiscard]] uint32_t height() const { return m_height; }
+        [[nodiscard]] uint32_t mipLevels() const { return m_mipLevels; }
+        [[nodiscard]] VkDeviceSize memorySize() const { return mMemorySize; }
 
     private:
-        void transitionImageLayout(VkImageLayout oldLayout, VkImageLayout newLayout);
-        void generateMipmaps();
+        void createImage();
+        void loadKtx2(const std::string &filepath);
+        void recordTransition(VkCommandBuffer commandBuffer, VkImageLayout oldLayout, VkImageLayout newLayout);
+        void recordMipmaps(VkCommandBuffer commandBuffer);
 
         int m_width, m_height, m_mipLevels;
         Device &mDevice;
         VkImage mImage;
         VkDeviceMemory mImageMemory;
+        VkDeviceSize mMemorySize = 0;
         VkImageView mImageView;
         VkSampler mSampler;
         VkFormat mImageFormat;
         VkImageLayout mImageLayout;
     };
-}
\ No newline at end of file
+}
@@ -0,0 +1,398 @@
+#include "TextureStreamer.h"
+#include "stb/stb_image.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+namespace engine {
+    // satisfies the texel block alignment of every uncompressed color format
+    static constexpr VkDeviceSize STAGING_ALIGNMENT = 16;
+
+    // 2x2 box filter on RGBA8 texels, returns a malloc'd buffer like stbi_load so both free the same way
+    static unsigned char *halveImage(unsigned char *pixels, int &width, int &height) {
+        int newWidth = std::max(width / 2, 1);
+        int newHeight = std::max(height / 2, 1);
+        auto *result = static_cast<unsigned char *>(std::malloc(static_cast<size_t>(newWidth) * newHeight * 4));
+
+        for (int y = 0; y < newHeight; y++) {
+            for (int x = 0; x < newWidth; x++) {
+                int x0 = std::min(x * 2, width - 1), x1 = std::min(x * 2 + 1, width - 1);
+                int y0 = std::min(y * 2, height - 1), y1 = std::min(y * 2 + 1, height - 1);
+                for (int c = 0; c < 4; c++) {
+                    int sum = pixels[(y0 * width + x0) * 4 + c] + pixels[(y0 * width + x1) * 4 + c]
+                              + pixels[(y1 * width + x0) * 4 + c] + pixels[(y1 * width + x1) * 4 + c];
+                    result[(y * newWidth + x) * 4 + c] = static_cast<unsigned char>((sum + 2) / 4);
+                }
+            }
+        }
+
+        stbi_image_free(pixels);
+        width = newWidth;
+        height = newHeight;
+        return result;
+    }
+
+    TextureStreamer::TextureStreamer(Device &device, VkDeviceSize stagingSize, uint32_t workerCount)
+            : mDevice(device) {
+        VkCommandPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        poolInfo.queueFamilyIndex = mDevice.findPhysicalQueueFamilies().graphicsFamily;
+        poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+
+        if (mDevice.dispatch().vkCreateCommandPool(mDevice.device(), &poolInfo, nullptr, &mCommandPool) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create texture streamer command pool!");
+        }
+
+        mStagingBuffer = std::make_unique<Buffer>(mDevice,
+                                                  stagingSize,
+                                                  1,
+                                                  VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                                                  VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
+                                                  | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        mStagingBuffer->map();
+
+        CreatePlaceholder();
+
+        if (workerCount == 0) {
+            // leave one core for the render loop, hardware_concurrency() is 0 when it is unknown
+            workerCount = std::max(2u, std::thread::hardware_concurrency()) - 1;
+        }
+
+        mWorkers.reserve(workerCount);
+        for (uint32_t i = 0; i < workerCount; i++) {
+            mWorkers.emplace_back(&TextureStreamer::WorkerLoop, this);
+        }
+    }
+
+    TextureStreamer::~TextureStreamer() {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mStopping = true;
+        }
+        mJobAvailable.notify_all();
+
+        for (auto &worker : mWorkers) {
+            worker.join();
+        }
+
+        // covers both the upload batches and frames still sampling retired images
+        mDevice.dispatch().vkQueueWaitIdle(mDevice.graphicsQueue());
+
+        for (auto &batch : mInFlight) {
+            mDevice.dispatch().vkDestroyFence(mDevice.device(), batch.fence, nullptr);
+        }
+        mInFlight.clear();
+        mRetiredImages.clear();
+
+        for (auto &decoded : mDecoded) {
+            stbi_image_free(decoded.pixels);
+        }
+        for (auto &decoded : mWaitingForStaging) {
+            stbi_image_free(decoded.pixels);
+        }
+
+        mDevice.dispatch().vkDestroyCommandPool(mDevice.device(), mCommandPool, nullptr);
+    }
+
+    std::shared_ptr<StreamedTexture> TextureStreamer::Request(const std::string &path) {
+        auto it = mTextures.find(path);
+        if (it != mTextures.end()) {
+            if (auto existing = it->second.lock()) {
+                return existing;
+            }
+        }
+
+        std::shared_ptr<StreamedTexture> texture{new StreamedTexture(path, mPlaceholder)};
+        mTextures[path] = texture;
+        Enqueue({texture, 0});
+
+        return texture;
+    }
+
+    bool TextureStreamer::Reload(const std::shared_ptr<StreamedTexture> &texture, uint32_t skipLevels) {
+        if (texture->mLoading || texture->mFailed) {
+            return false;
+        }
+
+        texture->mLoading = true;
+        Enqueue({texture, skipLevels});
+        return true;
+    }
+
+    void TextureStreamer::Evict(const std::shared_ptr<StreamedTexture> &texture) {
+        if (!texture->mResident) {
+            return;
+        }
+
+        RetireImage(std::move(texture->mImage));
+        texture->mImage = mPlaceholder;
+        texture->mResident = false;
+        texture->mGeneration++;
+    }
+
+    void TextureStreamer::Enqueue(LoadJob job) {
+        mPendingCount++;
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mJobs.push_back(std::move(job));
+        }
+        mJobAvailable.notify_one();
+    }
+
+    void TextureStreamer::RetireImage(std::shared_ptr<TextureImage> image) {
+        if (image && image != mPlaceholder) {
+            mRetiredImages.emplace_back(mFrameNumber, std::move(image));
+        }
+    }
+
+    void TextureStreamer::Update() {
+        mFrameNumber++;
+
+        // descriptor sets of the other frames in flight are rewritten on their next Refresh, after which
+        // their command buffers stop referencing the old image
+        while (!mRetiredImages.empty() &&
+               mRetiredImages.front().first + SwapChain::MAX_FRAMES_IN_FLIGHT + 1 <= mFrameNumber) {
+            mRetiredImages.pop_front();
+        }
+
+        RetireBatches();
+
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            while (!mDecoded.empty()) {
+                mWaitingForStaging.push_back(std::move(mDecoded.front()));
+                mDecoded.pop_front();
+            }
+        }
+
+        if (!mWaitingForStaging.empty()) {
+            SubmitDecoded();
+        }
+    }
+
+    void TextureStreamer::WorkerLoop() {
+        while (true) {
+            LoadJob job;
+            {
+                std::unique_lock<std::mutex> lock(mMutex);
+                mJobAvailable.wait(lock, [this] { return mStopping || !mJobs.empty(); });
+                if (mStopping) {
+                    return;
+                }
+                job = std::move(mJobs.front());
+                mJobs.pop_front();
+            }
+
+            DecodedImage decoded{};
+            decoded.texture = std::move(job.texture);
+            decoded.skipLevels = job.skipLevels;
+
+            const std::string &path = decoded.texture->path();
+            if (IsKtx2Path(path)) {
+                try {
+                    decoded.ktx2 = std::make_unique<Ktx2Image>(ReadKtx2(path));
+
+                    // cooked files carry every level already, dropping the top ones is free
+                    auto &levels = decoded.ktx2->levels;
+                    decoded.skipLevels = std::min(decoded.skipLevels, static_cast<uint32_t>(levels.size() - 1));
+                    levels.erase(levels.begin(), levels.begin() + decoded.skipLevels);
+                    decoded.ktx2->width = std::max(decoded.ktx2->width >> decoded.skipLevels, 1u);
+                    decoded.ktx2->height = std::max(decoded.ktx2->height >> decoded.skipLevels, 1u);
+                } catch (const std::exception &e) {
+                    std::cerr << e.what() << '\n';
+                }
+            } else {
+                int channels;
+                decoded.pixels = stbi_load(path.c_str(), &decoded.width, &decoded.height, &channels, 4);
+
+                for (uint32_t i = 0; decoded.pixels && i < decoded.skipLevels; i++) {
+                    if (decoded.width == 1 && decoded.height == 1) {
+                        decoded.skipLevels = i;
+                        break;
+                    }
+                    decoded.pixels = halveImage(decoded.pixels, decoded.width, decoded.height);
+                }
+            }
+
+            std::lock_guard<std::mutex> lock(mMutex);
+            mDecoded.push_back(std::move(decoded));
+        }
+    }
+
+    void TextureStreamer::RetireBatches() {
+        while (!mInFlight.empty()) {
+            auto &batch = mInFlight.front();
+            if (mDevice.dispatch().vkGetFenceStatus(mDevice.device(), batch.fence) != VK_SUCCESS) {
+                // batches complete in submission order, nothing behind this one is done either
+                break;
+            }
+
+            for (auto &uploaded : batch.textures) {
+                auto &texture = uploaded.texture;
+                RetireImage(std::move(texture->mImage));
+                texture->mImage = std::move(uploaded.image);
+                texture->mSkippedLevels = uploaded.skipLevels;
+                texture->mResident = true;
+                texture->mLoading = false;
+                texture->mGeneration++;
+                mPendingCount--;
+            }
+
+            mDevice.dispatch().vkDestroyFence(mDevice.device(), batch.fence, nullptr);
+            mDevice.dispatch().vkFreeCommandBuffers(mDevice.device(), mCommandPool, 1, &batch.commandBuffer);
+            mStagingTail = batch.stagingEnd;
+            mInFlight.pop_front();
+        }
+
+        if (mInFlight.empty()) {
+            mStagingHead = 0;
+            mStagingTail = 0;
+        }
+    }
+
+    void TextureStreamer::SubmitDecoded() {
+        UploadBatch batch{};
+
+        VkCommandBufferAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        allocInfo.commandPool = mCommandPool;
+        allocInfo.commandBufferCount = 1;
+        mDevice.dispatch().vkAllocateCommandBuffers(mDevice.device(), &allocInfo, &batch.commandBuffer);
+
+        VkCommandBufferBeginInfo beginInfo{};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        mDevice.dispatch().vkBeginCommandBuffer(batch.commandBuffer, &beginInfo);
+
+        auto *staging = static_cast<unsigned char *>(mStagingBuffer->getMappedMemory());
+
+        while (!mWaitingForStaging.empty()) {
+            auto &decoded = mWaitingForStaging.front();
+
+            if (!decoded.pixels && !decoded.ktx2) {
+                std::cerr << "failed to load image: " << decoded.texture->path() << '\n';
+                decoded.texture->mFailed = true;
+                decoded.texture->mLoading = false;
+                mPendingCount--;
+                mWaitingForStaging.pop_front();
+                continue;
+            }
+
+            const void *data = decoded.ktx2 ? static_cast<const void *>(decoded.ktx2->data.data()) : decoded.pixels;
+            VkDeviceSize size = decoded.ktx2 ? decoded.ktx2->data.size()
+                                             : static_cast<VkDeviceSize>(decoded.width) * decoded.height * 4;
+            VkBuffer source;
+            VkDeviceSize offset = 0;
+
+            if (size > mStagingBuffer->getBufferSize()) {
+                // would never fit in the ring, give it a buffer of its own for this batch
+                auto overflow = std::make_unique<Buffer>(mDevice,
+                                                         size,
+                                                         1,
+                                                         VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                                                         VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
+                                                         | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+                overflow->map();
+                overflow->writeToBuffer(const_cast<void *>(data));
+                source = overflow->getBuffer();
+                batch.overflowBuffers.push_back(std::move(overflow));
+            } else if (AllocateStaging(size, offset)) {
+                std::memcpy(staging + offset, data, size);
+                source = mStagingBuffer->getBuffer();
+            } else {
+                // ring is full, try again once earlier batches have retired
+                break;
+            }
+
+            std::shared_ptr<TextureImage> image;
+            try {
+                if (decoded.ktx2) {
+                    image = std::make_shared<TextureImage>(mDevice,
+                                                           decoded.ktx2->width,
+                                                           decoded.ktx2->height,
+                                                           decoded.ktx2->format,
+                                                           static_cast<uint32_t>(decoded.ktx2->levels.size()));
+                    image->recordUpload(batch.commandBuffer, source, offset, decoded.ktx2->levels);
+                } else {
+                    image = std::make_shared<TextureImage>(mDevice,
+                                                           static_cast<uint32_t>(decoded.width),
+                                                           static_cast<uint32_t>(decoded.height));
+                    image->recordUpload(batch.commandBuffer, source, offset);
+                }
+            } catch (const std::exception &e) {
+                // e.g. a BC texture on a device without BC support, keep showing the placeholder
+                std::cerr << decoded.texture->path() << ": " << e.what() << '\n';
+                decoded.texture->mFailed = true;
+                decoded.texture->mLoading = false;
+                mPendingCount--;
+                stbi_image_free(decoded.pixels);
+                mWaitingForStaging.pop_front();
+                continue;
+            }
+
+            batch.textures.push_back({std::move(decoded.texture), std::move(image), decoded.skipLevels});
+            stbi_image_free(decoded.pixels);
+            mWaitingForStaging.pop_front();
+        }
+
+        mDevice.dispatch().vkEndCommandBuffer(batch.commandBuffer);
+
+        if (batch.textures.empty()) {
+            mDevice.dispatch().vkFreeCommandBuffers(mDevice.device(), mCommandPool, 1, &batch.commandBuffer);
+            return;
+        }
+
+        VkFenceCreateInfo fenceInfo{};
+        fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+        mDevice.dispatch().vkCreateFence(mDevice.device(), &fenceInfo, nullptr, &batch.fence);
+
+        VkSubmitInfo submitInfo{};
+        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submitInfo.commandBufferCount = 1;
+        submitInfo.pCommandBuffers = &batch.commandBuffer;
+
+        if (mDevice.dispatch().vkQueueSubmit(mDevice.graphicsQueue(), 1, &submitInfo, batch.fence) != VK_SUCCESS) {
+            throw std::runtime_error("failed to submit texture upload batch!");
+        }
+
+        batch.stagingEnd = mStagingHead;
+        mInFlight.push_back(std::move(batch));
+    }
+
+    bool TextureStreamer::AllocateStaging(VkDeviceSize size, VkDeviceSize &offset) {
+        VkDeviceSize capacity = mStagingBuffer->getBufferSize();
+        VkDeviceSize head = (mStagingHead + STAGING_ALIGNMENT - 1) & ~(STAGING_ALIGNMENT - 1);
+
+        if (mStagingHead >= mStagingTail) {
+            // free space is [head, capacity) followed by [0, tail)
+            if (head + size > capacity) {
+                if (size >= mStagingTail) {
+                    return false;
+                }
+                head = 0;
+            }
+        } else if (head + size >= mStagingTail) {
+            // wrapped around already, the oldest batch in flight is right ahead of us
+            return false;
+        }
+
+        offset = head;
+        mStagingHead = head + size;
+        return true;
+    }
+
+    void TextureStreamer::CreatePlaceholder() {
+        mPlaceholder = std::make_shared<TextureImage>(mDevice, 1, 1);
+
+        uint32_t white = 0xFFFFFFFF;
+        std::memcpy(mStagingBuffer->getMappedMemory(), &white, sizeof(white));
+
+        VkCommandBuffer commandBuffer = mDevice.beginSingleTimeCommands();
+        mPlaceholder->recordUpload(commandBuffer, mStagingBuffer->getBuffer(), 0);
+        mDevice.endSingleTimeCommands(commandBuffer);
+    }
+}
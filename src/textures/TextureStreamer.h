@@ -0,0 +1,147 @@
+#pragma once
+
+#include "Buffer.h"
+#include "Device.h"
+#include "Ktx2.h"
+#include "SwapChain.h"
+#include "TextureImage.h"
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace engine {
+    class TextureStreamer;
+
+    // Handle to a texture that is loaded in the background. Until the upload has finished on
+    // the GPU image() returns the streamer's placeholder, so it can be bound right away.
+    class StreamedTexture {
+    public:
+        [[nodiscard]] const std::string &path() const { return mPath; }
+        [[nodiscard]] bool resident() const { return mResident; }
+        [[nodiscard]] bool failed() const { return mFailed; }
+
+        // Bumped every time image() starts returning a different TextureImage.
+        [[nodiscard]] uint32_t generation() const { return mGeneration; }
+        [[nodiscard]] std::shared_ptr<TextureImage> image() const { return mImage; }
+
+        // Number of top mip levels left out of the resident image to save memory.
+        [[nodiscard]] uint32_t skippedLevels() const { return mSkippedLevels; }
+        [[nodiscard]] bool loading() const { return mLoading; }
+
+    private:
+        friend class TextureStreamer;
+
+        StreamedTexture(std::string path, std::shared_ptr<TextureImage> placeholder)
+                : mPath(std::move(path)), mImage(std::move(placeholder)) {}
+
+        std::string mPath;
+        std::shared_ptr<TextureImage> mImage;
+        uint32_t mGeneration = 0;
+        uint32_t mSkippedLevels = 0;
+        bool mResident = false;
+        bool mFailed = false;
+        bool mLoading = true;
+    };
+
+    // Decodes images (or reads cooked .ktx2 files) on a pool of worker threads and uploads them
+    // through a shared staging ring buffer. Uploads that become ready in the same frame are
+    // recorded into a single command buffer (copies and mip blits) and tracked with a fence, so
+    // Update() never waits on the GPU. All Vulkan work happens on the thread calling Update().
+    class TextureStreamer {
+    public:
+        explicit TextureStreamer(Device &device,
+                                 VkDeviceSize stagingSize = 64 * 1024 * 1024,
+                                 uint32_t workerCount = 0);
+
+        ~TextureStreamer();
+
+        TextureStreamer(const TextureStreamer &) = delete;
+        TextureStreamer &operator=(const TextureStreamer &) = delete;
+
+        // Queues the file for loading. Requests for a path that is still alive return the same handle.
+        std::shared_ptr<StreamedTexture> Request(const std::string &path);
+
+        // Loads the file again without its top skipLevels mips (0 is full resolution). The current
+        // image stays bound until the new one is resident. Ignored while a load is in progress.
+        bool Reload(const std::shared_ptr<StreamedTexture> &texture, uint32_t skipLevels);
+
+        // Falls back to the placeholder and frees the image once no frame in flight can use it.
+        void Evict(const std::shared_ptr<StreamedTexture> &texture);
+
+        // Call once per frame: publishes finished uploads and submits newly decoded images.
+        void Update();
+
+        [[nodiscard]] uint64_t FrameNumber() const { return mFrameNumber; }
+
+        [[nodiscard]] std::shared_ptr<TextureImage> Placeholder() const { return mPlaceholder; }
+        [[nodiscard]] size_t PendingCount() const { return mPendingCount; }
+
+    private:
+        struct LoadJob {
+            std::shared_ptr<StreamedTexture> texture;
+            uint32_t skipLevels = 0;
+        };
+
+        struct DecodedImage {
+            std::shared_ptr<StreamedTexture> texture;
+            uint32_t skipLevels = 0;
+            int width = 0;
+            int height = 0;
+            unsigned char *pixels = nullptr;
+            // set instead of pixels for cooked textures, which are staged as is
+            std::unique_ptr<Ktx2Image> ktx2;
+        };
+
+        struct UploadedImage {
+            std::shared_ptr<StreamedTexture> texture;
+            std::shared_ptr<TextureImage> image;
+            uint32_t skipLevels;
+        };
+
+        struct UploadBatch {
+            VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+            VkFence fence = VK_NULL_HANDLE;
+            VkDeviceSize stagingEnd = 0;
+            std::vector<std::unique_ptr<Buffer>> overflowBuffers;
+            std::vector<UploadedImage> textures;
+        };
+
+        void WorkerLoop();
+        void RetireBatches();
+        void SubmitDecoded();
+        bool AllocateStaging(VkDeviceSize size, VkDeviceSize &offset);
+        void CreatePlaceholder();
+        void RetireImage(std::shared_ptr<TextureImage> image);
+        void Enqueue(LoadJob job);
+
+        Device &mDevice;
+        VkCommandPool mCommandPool = VK_NULL_HANDLE;
+
+        std::unique_ptr<Buffer> mStagingBuffer;
+        VkDeviceSize mStagingHead = 0;
+        VkDeviceSize mStagingTail = 0;
+
+        std::shared_ptr<TextureImage> mPlaceholder;
+        std::unordered_map<std::string, std::weak_ptr<StreamedTexture>> mTextures;
+        std::deque<UploadBatch> mInFlight;
+        std::deque<DecodedImage> mWaitingForStaging;
+        size_t mPendingCount = 0;
+
+        // images replaced while frames in flight may still sample them, with the frame they were replaced in
+        std::deque<std::pair<uint64_t, std::shared_ptr<TextureImage>>> mRetiredImages;
+        uint64_t mFrameNumber = 0;
+
+        std::vector<std::thread> mWorkers;
+        std::mutex mMutex;
+        std::condition_variable mJobAvailable;
+        std::deque<LoadJob> mJobs;
+        std::deque<DecodedImage> mDecoded;
+        bool mStopping = false;
+    };
+}
@@ -0,0 +1,165 @@
+// Compares the DynamicAabbTree broadphase against testing every pair of AABBColliders.
+//
+// usage: broadphase_bench [body count ...]     (default 1000 10000 100000)
+//
+// Bodies are scattered in a cube that grows with their number, so each one overlaps a handful
+// of others whatever the count. For every count this times finding all overlapping pairs by
+// brute force and with the tree, checks that both find the same pairs, then times frames in
+// which every body moves a little, for the tree alone and for a full PhysicsSystem::Step.
+// Brute force at 100k bodies takes a minute or more.
+
+#include "DynamicAabbTree.h"
+#include "systems/PhysicsSystem.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using engine::DynamicAabbTree;
+using engine::PhysicsSystem;
+using engine::component::AABBCollider;
+
+namespace {
+    using Clock = std::chrono::high_resolution_clock;
+
+    constexpr int FRAME_COUNT = 60;
+    constexpr float DT = 1.0f / 60.0f;
+
+    double secondsSince(Clock::time_point start) {
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    struct Scene {
+        std::vector<glm::vec3> positions;
+        std::vector<glm::vec3> halfExtents;
+        std::vector<glm::vec3> velocities;
+
+        [[nodiscard]] AABBCollider bounds(size_t i) const {
+            return {positions[i] - halfExtents[i], positions[i] + halfExtents[i]};
+        }
+    };
+
+    Scene makeScene(uint32_t count) {
+        // about 1 unit of volume per body
+        float side = std::cbrt(static_cast<float>(count));
+
+        std::mt19937 generator(42);
+        std::uniform_real_distribution<float> position(0.0f, side);
+        std::uniform_real_distribution<float> size(0.1f, 0.5f);
+        std::uniform_real_distribution<float> speed(-1.0f, 1.0f);
+
+        Scene scene;
+        for (uint32_t i = 0; i < count; i++) {
+            scene.positions.emplace_back(position(generator), position(generator), position(generator));
+            scene.halfExtents.emplace_back(size(generator), size(generator), size(generator));
+            scene.velocities.emplace_back(speed(generator), speed(generator), speed(generator));
+        }
+        return scene;
+    }
+
+    void benchmark(uint32_t count) {
+        Scene scene = makeScene(count);
+        std::printf("%u bodies\n", count);
+
+        auto start = Clock::now();
+        std::vector<DynamicAabbTree::Pair> bruteForcePairs;
+        for (uint32_t i = 0; i < count; i++) {
+            AABBCollider a = scene.bounds(i);
+            for (uint32_t j = i + 1; j < count; j++) {
+                if (a.checkCollision(scene.bounds(j))) {
+                    bruteForcePairs.push_back({static_cast<int32_t>(i), static_cast<int32_t>(j)});
+                }
+            }
+        }
+        double bruteForceSeconds = secondsSince(start);
+        std::printf("  brute force pairs    %10.3f ms  (%zu pairs)\n", bruteForceSeconds * 1e3, bruteForcePairs.size());
+
+        // no margin, so the tree's pairs are exactly the overlapping ones
+        start = Clock::now();
+        DynamicAabbTree exactTree{0.0f};
+        for (uint32_t i = 0; i < count; i++) {
+            exactTree.CreateProxy(scene.bounds(i), i);
+        }
+        double buildSeconds = secondsSince(start);
+
+        start = Clock::now();
+        std::vector<DynamicAabbTree::Pair> treePairs;
+        exactTree.FindAllPairs(treePairs);
+        double querySeconds = secondsSince(start);
+
+        // proxy ids are node indices, compare by body
+        for (auto &pair : treePairs) {
+            auto first = static_cast<int32_t>(exactTree.GetUserData(pair.first));
+            auto second = static_cast<int32_t>(exactTree.GetUserData(pair.second));
+            pair = {std::min(first, second), std::max(first, second)};
+        }
+        std::sort(treePairs.begin(), treePairs.end(), [](const auto &a, const auto &b) {
+            return a.first != b.first ? a.first < b.first : a.second < b.second;
+        });
+        bool identical = treePairs == bruteForcePairs;
+        std::printf("  tree build           %10.3f ms  (height %d)\n", buildSeconds * 1e3, exactTree.GetHeight());
+        std::printf("  tree pairs           %10.3f ms  speedup %.1fx%s\n", querySeconds * 1e3,
+                    bruteForceSeconds / querySeconds, identical ? "" : "  PAIRS DIFFER");
+
+        // frames of incremental updates with the default margin
+        DynamicAabbTree tree;
+        std::vector<DynamicAabbTree::ProxyId> proxies;
+        for (uint32_t i = 0; i < count; i++) {
+            proxies.push_back(tree.CreateProxy(scene.bounds(i), i));
+        }
+        std::vector<DynamicAabbTree::Pair> pairs;
+        tree.UpdatePairs(pairs);
+
+        uint32_t reinserted = 0;
+        start = Clock::now();
+        for (int frame = 0; frame < FRAME_COUNT; frame++) {
+            for (uint32_t i = 0; i < count; i++) {
+                glm::vec3 displacement = scene.velocities[i] * DT;
+                scene.positions[i] += displacement;
+                reinserted += tree.MoveProxy(proxies[i], scene.bounds(i), displacement);
+            }
+            tree.UpdatePairs(pairs);
+        }
+        std::printf("  tree update          %10.3f ms/frame  (%.1f%% reinserted per frame)\n",
+                    secondsSince(start) * 1e3 / FRAME_COUNT, 100.0 * reinserted / (count * FRAME_COUNT));
+
+        PhysicsSystem physics{glm::vec3{0.0f}};
+        for (uint32_t i = 0; i < count; i++) {
+            engine::component::Transform transform{};
+            transform.translation = scene.positions[i];
+            engine::component::RigidBody rigidBody{};
+            rigidBody.velocity = scene.velocities[i];
+            rigidBody.isStatic = false;
+            physics.AddBody(transform, rigidBody, {-scene.halfExtents[i], scene.halfExtents[i]});
+        }
+
+        physics.Step(DT);
+        start = Clock::now();
+        for (int frame = 0; frame < FRAME_COUNT; frame++) {
+            physics.Step(DT);
+        }
+        std::printf("  PhysicsSystem::Step  %10.3f ms/frame  (%zu candidate pairs, %zu contacts)\n",
+                    secondsSince(start) * 1e3 / FRAME_COUNT, physics.GetCandidatePairCount(),
+                    physics.GetContacts().size());
+    }
+}
+
+int main(int argc, char **argv) {
+    std::vector<uint32_t> counts;
+    for (int i = 1; i < argc; i++) {
+        counts.push_back(static_cast<uint32_t>(std::stoul(argv[i])));
+    }
+    if (counts.empty()) {
+        counts = {1000, 10000, 100000};
+    }
+
+    for (uint32_t count : counts) {
+        benchmark(count);
+    }
+    return 0;
+}
@@ -0,0 +1,237 @@
+// Builds a Bvh over the given OBJ files, or a generated sphere, and measures build time and ray
+// throughput for closest hit and occlusion queries.
+//
+// usage: bvh_bench [model.obj ...]
+//        bvh_bench --sphere <segments>
+//
+// Coherent rays come from a pinhole camera looking at the mesh, incoherent ones go from random
+// points around the mesh to random points inside its bounds. A sample of rays is checked
+// against brute force intersection of every triangle.
+
+#include "Bvh.h"
+#include "MeshImport.h"
+
+#include <glm/gtc/constants.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using engine::Bvh;
+using engine::Model;
+using engine::Ray;
+using engine::RayHit;
+
+namespace {
+    using Clock = std::chrono::high_resolution_clock;
+
+    constexpr uint32_t IMAGE_SIZE = 1024;
+    constexpr uint32_t RANDOM_RAY_COUNT = IMAGE_SIZE * IMAGE_SIZE;
+    constexpr uint32_t VALIDATION_RAY_COUNT = 2000;
+
+    double secondsSince(Clock::time_point start) {
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    void makeSphere(uint32_t segments, Model::Builder &builder) {
+        uint32_t rings = segments / 2;
+        for (uint32_t ring = 0; ring <= rings; ring++) {
+            float theta = glm::pi<float>() * ring / rings;
+            for (uint32_t segment = 0; segment <= segments; segment++) {
+                float phi = glm::two_pi<float>() * segment / segments;
+                Model::Vertex vertex{};
+                vertex.position = {std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi)};
+                vertex.normal = vertex.position;
+                builder.vertices.push_back(vertex);
+            }
+        }
+
+        for (uint32_t ring = 0; ring < rings; ring++) {
+            for (uint32_t segment = 0; segment < segments; segment++) {
+                uint32_t a = ring * (segments + 1) + segment;
+                uint32_t b = a + segments + 1;
+                builder.indices.insert(builder.indices.end(), {a, b, a + 1, a + 1, b, b + 1});
+            }
+        }
+    }
+
+    bool bruteForce(const Model::Builder &builder, const Ray &ray, RayHit &hit) {
+        bool found = false;
+        float tMax = ray.tMax;
+        for (uint32_t triangle = 0; triangle < builder.indices.size() / 3; triangle++) {
+            glm::vec3 v0 = builder.vertices[builder.indices[3 * triangle + 0]].position;
+            glm::vec3 edge1 = builder.vertices[builder.indices[3 * triangle + 1]].position - v0;
+            glm::vec3 edge2 = builder.vertices[builder.indices[3 * triangle + 2]].position - v0;
+
+            glm::vec3 p = glm::cross(ray.direction, edge2);
+            float det = glm::dot(edge1, p);
+            if (det == 0.0f) {
+                continue;
+            }
+            glm::vec3 s = ray.origin - v0;
+            glm::vec3 q = glm::cross(s, edge1);
+            float u = glm::dot(s, p) / det;
+            float v = glm::dot(ray.direction, q) / det;
+            float t = glm::dot(edge2, q) / det;
+            if (u >= 0.0f && v >= 0.0f && u + v <= 1.0f && t > ray.tMin && t < tMax) {
+                tMax = t;
+                hit.t = t;
+                hit.primitiveIndex = triangle;
+                found = true;
+            }
+        }
+        return found;
+    }
+
+    std::vector<Ray> cameraRays(const Bvh &bvh) {
+        glm::vec3 center = (bvh.GetMinExtent() + bvh.GetMaxExtent()) * 0.5f;
+        float radius = glm::length(bvh.GetMaxExtent() - bvh.GetMinExtent()) * 0.5f;
+        glm::vec3 eye = center + glm::vec3{0.3f, 0.4f, 1.0f} * (2.0f * radius);
+
+        glm::vec3 forward = glm::normalize(center - eye);
+        glm::vec3 right = glm::normalize(glm::cross(forward, glm::vec3{0.0f, 1.0f, 0.0f}));
+        glm::vec3 up = glm::cross(right, forward);
+
+        std::vector<Ray> rays;
+        rays.reserve(IMAGE_SIZE * IMAGE_SIZE);
+        for (uint32_t y = 0; y < IMAGE_SIZE; y++) {
+            for (uint32_t x = 0; x < IMAGE_SIZE; x++) {
+                float u = (x + 0.5f) / IMAGE_SIZE * 2.0f - 1.0f;
+                float v = (y + 0.5f) / IMAGE_SIZE * 2.0f - 1.0f;
+                glm::vec3 direction = glm::normalize(forward + 0.5f * (u * right + v * up));
+                rays.push_back({eye, 0.0f, direction, 1e30f});
+            }
+        }
+        return rays;
+    }
+
+    std::vector<Ray> randomRays(const Bvh &bvh, uint32_t count) {
+        glm::vec3 minimum = bvh.GetMinExtent();
+        glm::vec3 maximum = bvh.GetMaxExtent();
+        glm::vec3 center = (minimum + maximum) * 0.5f;
+        float radius = glm::length(maximum - minimum);
+
+        std::mt19937 generator(7);
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+        std::normal_distribution<float> normal;
+
+        std::vector<Ray> rays;
+        rays.reserve(count);
+        for (uint32_t i = 0; i < count; i++) {
+            glm::vec3 origin = center + glm::normalize(glm::vec3{normal(generator), normal(generator), normal(generator)}) * radius;
+            glm::vec3 target = minimum + (maximum - minimum) * glm::vec3{unit(generator), unit(generator), unit(generator)};
+            rays.push_back({origin, 0.0f, target - origin, 1e30f});
+        }
+        return rays;
+    }
+
+    // Traces all rays on the given number of threads, returns rays per second and the hit count.
+    double trace(const Bvh &bvh, const std::vector<Ray> &rays, uint32_t flags, uint32_t threadCount, uint32_t &hits) {
+        std::atomic<uint32_t> hitCount{0};
+        auto work = [&](uint32_t thread) {
+            uint32_t local = 0;
+            RayHit hit{};
+            size_t begin = rays.size() * thread / threadCount;
+            size_t end = rays.size() * (thread + 1) / threadCount;
+            for (size_t i = begin; i < end; i++) {
+                local += bvh.Intersect(rays[i], hit, flags);
+            }
+            hitCount += local;
+        };
+
+        auto start = Clock::now();
+        std::vector<std::thread> threads;
+        for (uint32_t thread = 1; thread < threadCount; thread++) {
+            threads.emplace_back(work, thread);
+        }
+        work(0);
+        for (auto &thread : threads) {
+            thread.join();
+        }
+        double seconds = secondsSince(start);
+
+        hits = hitCount;
+        return rays.size() / seconds;
+    }
+
+    void benchmark(const std::string &name, const Model::Builder &builder) {
+        std::cout << name << ": " << builder.indices.size() / 3 << " triangles\n";
+
+        uint32_t cores = std::max(1u, std::thread::hardware_concurrency());
+        for (uint32_t workers : {1u, cores}) {
+            auto start = Clock::now();
+            Bvh bvh{builder, workers};
+            std::printf("  build, %2u thread%s %8.3f s  (%zu nodes)\n", workers, workers > 1 ? "s" : " ",
+                        secondsSince(start), bvh.GetNodes().size());
+            if (cores == 1) {
+                break;
+            }
+        }
+
+        Bvh bvh{builder};
+
+        uint32_t mismatches = 0;
+        for (const Ray &ray : randomRays(bvh, VALIDATION_RAY_COUNT)) {
+            RayHit expected{};
+            RayHit actual{};
+            bool expectedHit = bruteForce(builder, ray, expected);
+            bool actualHit = bvh.Intersect(ray, actual);
+            if (expectedHit != actualHit || (expectedHit && std::abs(expected.t - actual.t) > 1e-4f * expected.t)) {
+                mismatches++;
+            }
+        }
+        std::printf("  validation: %u of %u rays differ from brute force\n", mismatches, VALIDATION_RAY_COUNT);
+
+        struct Workload {
+            const char *name;
+            std::vector<Ray> rays;
+        };
+        Workload workloads[] = {{"coherent", cameraRays(bvh)}, {"incoherent", randomRays(bvh, RANDOM_RAY_COUNT)}};
+
+        for (const auto &workload : workloads) {
+            for (uint32_t flags : {0u, static_cast<uint32_t>(engine::RAY_FLAGS_TERMINATE_ON_FIRST_HIT)}) {
+                for (uint32_t threads : {1u, cores}) {
+                    uint32_t hits;
+                    double raysPerSecond = trace(bvh, workload.rays, flags, threads, hits);
+                    std::printf("  %-10s %-8s %2u thread%s %8.2f Mrays/s  (%.1f%% hit)\n", workload.name,
+                                flags ? "any" : "closest", threads, threads > 1 ? "s" : " ",
+                                raysPerSecond * 1e-6, 100.0 * hits / workload.rays.size());
+                    if (cores == 1) {
+                        break;
+                    }
+                }
+            }
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    try {
+        if (argc >= 3 && std::strcmp(argv[1], "--sphere") == 0) {
+            Model::Builder builder;
+            makeSphere(static_cast<uint32_t>(std::stoi(argv[2])), builder);
+            benchmark("sphere", builder);
+        } else if (argc >= 2) {
+            for (int i = 1; i < argc; i++) {
+                Model::Builder builder;
+                engine::ImportObj(argv[i], builder.vertices, builder.indices);
+                benchmark(argv[i], builder);
+            }
+        } else {
+            std::cerr << "usage: bvh_bench <model.obj ...> | --sphere <segments>\n";
+            return 1;
+        }
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << '\n';
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,174 @@
+// Compares the serial unordered_map OBJ import the engine used to have against ImportObj.
+//
+// usage: mesh_import_bench [model.obj ...]
+//        mesh_import_bench --grid <quads per side> [output.obj]
+//
+// --grid writes a flat grid with positions, normals and uvs (two triangles per quad, so
+// 2000 quads per side is eight million triangles) and then benchmarks it.
+
+#include "MeshImport.h"
+#include "Utils.h"
+#include "tiny_obj_loader/tiny_obj_loader.h"
+
+#define GLM_ENABLE_EXPERIMENTAL
+
+#include <glm/gtx/hash.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+using engine::Model;
+
+namespace {
+    using Clock = std::chrono::high_resolution_clock;
+
+    struct LegacyVertexHash {
+        size_t operator()(const Model::Vertex &vertex) const {
+            size_t seed = 0;
+            engine::HashCombine(seed, vertex.position, vertex.color, vertex.normal, vertex.uv);
+            return seed;
+        }
+    };
+
+    double secondsSince(Clock::time_point start) {
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    // the loader as it was before ImportObj, one thread and count() followed by operator[]
+    void importLegacy(const std::string &path, std::vector<Model::Vertex> &vertices, std::vector<uint32_t> &indices,
+                      double &parseSeconds, double &dedupSeconds) {
+        auto start = Clock::now();
+
+        tinyobj::attrib_t attrib;
+        std::vector<tinyobj::shape_t> shapes;
+        std::vector<tinyobj::material_t> materials;
+        std::string err;
+        if (!tinyobj::LoadObj(&attrib, &shapes, &materials, &err, path.c_str())) {
+            throw std::runtime_error(err);
+        }
+        parseSeconds = secondsSince(start);
+
+        auto dedupStart = Clock::now();
+        std::unordered_map<Model::Vertex, uint32_t, LegacyVertexHash> uniqueVertices;
+        for (const auto &shape : shapes) {
+            for (const auto &index : shape.mesh.indices) {
+                Model::Vertex vertex{};
+                if (index.vertex_index >= 0) {
+                    vertex.position = {attrib.vertices[3 * index.vertex_index + 0],
+                                       attrib.vertices[3 * index.vertex_index + 1],
+                                       attrib.vertices[3 * index.vertex_index + 2]};
+                }
+                if (index.normal_index >= 0) {
+                    vertex.normal = {attrib.normals[3 * index.normal_index + 0],
+                                     attrib.normals[3 * index.normal_index + 1],
+                                     attrib.normals[3 * index.normal_index + 2]};
+                }
+                if (index.texcoord_index >= 0) {
+                    vertex.uv = {attrib.texcoords[2 * index.texcoord_index + 0],
+                                 1.0f - attrib.texcoords[2 * index.texcoord_index + 1]};
+                }
+                vertex.color = {1.0f, 0.5f, 1.0f};
+
+                if (uniqueVertices.count(vertex) == 0) {
+                    uniqueVertices[vertex] = static_cast<uint32_t>(vertices.size());
+                    vertices.push_back(vertex);
+                }
+                indices.push_back(uniqueVertices[vertex]);
+            }
+        }
+        dedupSeconds = secondsSince(dedupStart);
+    }
+
+    void writeGrid(const std::string &path, int quads) {
+        std::ofstream file(path);
+        if (!file) {
+            throw std::runtime_error("failed to open " + path);
+        }
+
+        char line[96];
+        for (int y = 0; y <= quads; y++) {
+            for (int x = 0; x <= quads; x++) {
+                float u = static_cast<float>(x) / quads;
+                float v = static_cast<float>(y) / quads;
+                file.write(line, std::snprintf(line, sizeof(line), "v %f %f %f\nvt %f %f\n", u, 0.0f, v, u, v));
+            }
+        }
+        file << "vn 0 1 0\n";
+
+        int row = quads + 1;
+        for (int y = 0; y < quads; y++) {
+            for (int x = 0; x < quads; x++) {
+                int a = y * row + x + 1;
+                int b = a + 1;
+                int c = a + row;
+                int d = c + 1;
+                file.write(line, std::snprintf(line, sizeof(line), "f %d/%d/1 %d/%d/1 %d/%d/1\n", a, a, b, b, d, d));
+                file.write(line, std::snprintf(line, sizeof(line), "f %d/%d/1 %d/%d/1 %d/%d/1\n", a, a, d, d, c, c));
+            }
+        }
+    }
+
+    void benchmark(const std::string &path) {
+        std::vector<Model::Vertex> legacyVertices;
+        std::vector<uint32_t> legacyIndices;
+        double legacyParse;
+        double legacyDedup;
+        importLegacy(path, legacyVertices, legacyIndices, legacyParse, legacyDedup);
+
+        std::cout << path << ": " << legacyIndices.size() / 3 << " triangles, "
+                  << legacyVertices.size() << " unique vertices\n";
+        std::printf("  %-16s parse %8.3f s  dedup %8.3f s\n", "unordered_map", legacyParse, legacyDedup);
+
+        uint32_t cores = std::max(1u, std::thread::hardware_concurrency());
+        for (uint32_t workers = 1;; workers = std::min(workers * 2, cores)) {
+            std::vector<Model::Vertex> vertices;
+            std::vector<uint32_t> indices;
+            engine::MeshImportStats stats;
+            engine::ImportObj(path, vertices, indices, workers, &stats);
+
+            bool identical = vertices.size() == legacyVertices.size() && indices == legacyIndices &&
+                             std::memcmp(vertices.data(), legacyVertices.data(), vertices.size() * sizeof(Model::Vertex)) == 0;
+
+            std::string label = "flat, " + std::to_string(stats.threadCount) + " thread" + (stats.threadCount > 1 ? "s" : "");
+            std::printf("  %-16s parse %8.3f s  dedup %8.3f s  speedup %5.2fx%s\n", label.c_str(),
+                        stats.parseSeconds, stats.dedupSeconds, legacyDedup / stats.dedupSeconds,
+                        identical ? "" : "  OUTPUT DIFFERS");
+
+            if (workers == cores) {
+                break;
+            }
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    try {
+        std::vector<std::string> paths;
+        if (argc >= 3 && std::strcmp(argv[1], "--grid") == 0) {
+            std::string path = argc >= 4 ? argv[3] : "grid.obj";
+            writeGrid(path, std::stoi(argv[2]));
+            paths.push_back(path);
+        } else if (argc >= 2) {
+            paths.assign(argv + 1, argv + argc);
+        } else {
+            std::cerr << "usage: mesh_import_bench <model.obj ...> | --grid <quads per side> [output.obj]\n";
+            return 1;
+        }
+
+        for (const auto &path : paths) {
+            benchmark(path);
+        }
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << '\n';
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,411 @@
+// Build step: reflects compiled SPIR-V modules and writes a header that embeds them, so the
+// engine creates its shader modules without touching the file system and sizes its
+// descriptor set and pipeline layouts from what the shaders actually declare.
+//
+// usage: spirv_reflect <output.h> <module.spv ...>
+//
+// For every module the header holds its words, its stage, its descriptor bindings and the
+// size of its push constant block as constexpr data (see ShaderReflection.h), named after the
+// file: particle.vert.spv becomes engine::shaders::particle_vert.
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+    // the few parts of the SPIR-V grammar that matter here
+    constexpr uint32_t MAGIC = 0x07230203;
+
+    enum Op : uint32_t {
+        OpEntryPoint = 15,
+        OpTypeInt = 21,
+        OpTypeFloat = 22,
+        OpTypeVector = 23,
+        OpTypeMatrix = 24,
+        OpTypeImage = 25,
+        OpTypeSampler = 26,
+        OpTypeSampledImage = 27,
+        OpTypeArray = 28,
+        OpTypeRuntimeArray = 29,
+        OpTypeStruct = 30,
+        OpTypePointer = 32,
+        OpConstant = 43,
+        OpVariable = 59,
+        OpDecorate = 71,
+        OpMemberDecorate = 72,
+        OpTypeAccelerationStructureKHR = 5341,
+    };
+
+    enum Decoration : uint32_t {
+        DecorationBlock = 2,
+        DecorationBufferBlock = 3,
+        DecorationArrayStride = 6,
+        DecorationMatrixStride = 7,
+        DecorationBinding = 33,
+        DecorationDescriptorSet = 34,
+        DecorationOffset = 35,
+    };
+
+    enum StorageClass : uint32_t {
+        StorageClassUniformConstant = 0,
+        StorageClassUniform = 2,
+        StorageClassPushConstant = 9,
+        StorageClassStorageBuffer = 12,
+    };
+
+    enum Dim : uint32_t {
+        DimBuffer = 5,
+        DimSubpassData = 6,
+    };
+
+    struct Decorations {
+        uint32_t set = ~0u;
+        uint32_t binding = ~0u;
+        uint32_t arrayStride = 0;
+        bool block = false;
+        bool bufferBlock = false;
+    };
+
+    struct MemberDecorations {
+        uint32_t offset = 0;
+        uint32_t matrixStride = 0;
+    };
+
+    struct Binding {
+        uint32_t set;
+        uint32_t binding;
+        std::string type;
+        // 0 for runtime sized arrays
+        uint32_t count;
+    };
+
+    struct Module {
+        std::string name;
+        std::string stage;
+        std::vector<uint32_t> words;
+        std::vector<Binding> bindings;
+        uint32_t pushConstantSize = 0;
+    };
+
+    class Reflector {
+    public:
+        explicit Reflector(const std::vector<uint32_t> &words) {
+            if (words.size() < 5 || words[0] != MAGIC) {
+                throw std::runtime_error("not a SPIR-V module");
+            }
+
+            for (size_t i = 5; i < words.size();) {
+                uint32_t wordCount = words[i] >> 16;
+                uint32_t opcode = words[i] & 0xFFFF;
+                if (wordCount == 0 || i + wordCount > words.size()) {
+                    throw std::runtime_error("truncated SPIR-V instruction");
+                }
+                Parse(opcode, &words[i + 1], wordCount - 1);
+                i += wordCount;
+            }
+        }
+
+        void Reflect(Module &module) const {
+            module.stage = m_stage;
+
+            for (const auto &[id, pointerType, storageClass] : m_variables) {
+                uint32_t type = Operands(pointerType)[2];
+
+                if (storageClass == StorageClassPushConstant) {
+                    module.pushConstantSize = std::max(module.pushConstantSize, TypeSize(type, 0));
+                    continue;
+                }
+                if (storageClass != StorageClassUniformConstant && storageClass != StorageClassUniform &&
+                    storageClass != StorageClassStorageBuffer) {
+                    continue;
+                }
+
+                auto decorations = m_decorations.find(id);
+                if (decorations == m_decorations.end() || decorations->second.binding == ~0u) {
+                    continue;
+                }
+
+                Binding binding{decorations->second.set == ~0u ? 0 : decorations->second.set,
+                                decorations->second.binding, "", 1};
+
+                // arrays of descriptors
+                while (m_opcodes.at(type) == OpTypeArray || m_opcodes.at(type) == OpTypeRuntimeArray) {
+                    if (m_opcodes.at(type) == OpTypeArray) {
+                        binding.count *= m_constants.at(Operands(type)[2]);
+                    } else {
+                        binding.count = 0;
+                    }
+                    type = Operands(type)[1];
+                }
+
+                binding.type = DescriptorType(type, storageClass);
+                module.bindings.push_back(binding);
+            }
+
+            std::sort(module.bindings.begin(), module.bindings.end(), [](const Binding &a, const Binding &b) {
+                return a.set != b.set ? a.set < b.set : a.binding < b.binding;
+            });
+        }
+
+    private:
+        void Parse(uint32_t opcode, const uint32_t *operands, uint32_t count) {
+            switch (opcode) {
+                case OpEntryPoint:
+                    if (m_stage.empty()) {
+                        m_stage = Stage(operands[0]);
+                    }
+                    break;
+                case OpDecorate: {
+                    Decorations &decorations = m_decorations[operands[0]];
+                    switch (operands[1]) {
+                        case DecorationDescriptorSet: decorations.set = operands[2]; break;
+                        case DecorationBinding: decorations.binding = operands[2]; break;
+                        case DecorationArrayStride: decorations.arrayStride = operands[2]; break;
+                        case DecorationBlock: decorations.block = true; break;
+                        case DecorationBufferBlock: decorations.bufferBlock = true; break;
+                        default: break;
+                    }
+                    break;
+                }
+                case OpMemberDecorate: {
+                    MemberDecorations &decorations = m_memberDecorations[{operands[0], operands[1]}];
+                    if (operands[2] == DecorationOffset) {
+                        decorations.offset = operands[3];
+                    } else if (operands[2] == DecorationMatrixStride) {
+                        decorations.matrixStride = operands[3];
+                    }
+                    break;
+                }
+                case OpConstant:
+                    m_constants[operands[1]] = operands[2];
+                    break;
+                case OpVariable:
+                    m_variables.push_back({operands[1], operands[0], operands[2]});
+                    break;
+                case OpTypeInt:
+                case OpTypeFloat:
+                case OpTypeVector:
+                case OpTypeMatrix:
+                case OpTypeImage:
+                case OpTypeSampler:
+                case OpTypeSampledImage:
+                case OpTypeArray:
+                case OpTypeRuntimeArray:
+                case OpTypeStruct:
+                case OpTypePointer:
+                case OpTypeAccelerationStructureKHR:
+                    m_opcodes[operands[0]] = opcode;
+                    m_operands[operands[0]] = {operands, operands + count};
+                    break;
+                default:
+                    break;
+            }
+        }
+
+        [[nodiscard]] const std::vector<uint32_t> &Operands(uint32_t id) const { return m_operands.at(id); }
+
+        // Size in bytes with the explicit layout the shader declares. matrixStride comes from the
+        // struct member holding the matrix, 0 means tightly packed.
+        [[nodiscard]] uint32_t TypeSize(uint32_t type, uint32_t matrixStride) const {
+            const std::vector<uint32_t> &operands = Operands(type);
+            switch (m_opcodes.at(type)) {
+                case OpTypeInt:
+                case OpTypeFloat:
+                    return operands[1] / 8;
+                case OpTypeVector:
+                    return operands[2] * TypeSize(operands[1], 0);
+                case OpTypeMatrix:
+                    return operands[2] * (matrixStride ? matrixStride : TypeSize(operands[1], 0));
+                case OpTypeArray: {
+                    auto decorations = m_decorations.find(type);
+                    uint32_t stride = decorations != m_decorations.end() && decorations->second.arrayStride
+                                      ? decorations->second.arrayStride : TypeSize(operands[1], matrixStride);
+                    return m_constants.at(operands[2]) * stride;
+                }
+                case OpTypeRuntimeArray:
+                    return 0;
+                case OpTypeStruct: {
+                    uint32_t size = 0;
+                    for (uint32_t member = 0; member + 1 < operands.size(); member++) {
+                        MemberDecorations decorations;
+                        auto it = m_memberDecorations.find({type, member});
+                        if (it != m_memberDecorations.end()) {
+                            decorations = it->second;
+                        }
+                        size = std::max(size, decorations.offset + TypeSize(operands[member + 1], decorations.matrixStride));
+                    }
+                    return size;
+                }
+                default:
+                    throw std::runtime_error("unexpected type in an interface block");
+            }
+        }
+
+        [[nodiscard]] std::string DescriptorType(uint32_t type, uint32_t storageClass) const {
+            if (storageClass == StorageClassStorageBuffer) {
+                return "VK_DESCRIPTOR_TYPE_STORAGE_BUFFER";
+            }
+            if (storageClass == StorageClassUniform) {
+                auto decorations = m_decorations.find(type);
+                bool bufferBlock = decorations != m_decorations.end() && decorations->second.bufferBlock;
+                return bufferBlock ? "VK_DESCRIPTOR_TYPE_STORAGE_BUFFER" : "VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER";
+            }
+
+            switch (m_opcodes.at(type)) {
+                case OpTypeSampledImage:
+                    return "VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER";
+                case OpTypeSampler:
+                    return "VK_DESCRIPTOR_TYPE_SAMPLER";
+                case OpTypeAccelerationStructureKHR:
+                    return "VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR";
+                case OpTypeImage: {
+                    const std::vector<uint32_t> &operands = Operands(type);
+                    uint32_t dim = operands[2];
+                    bool storage = operands[6] == 2;
+                    if (dim == DimBuffer) {
+                        return storage ? "VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER" : "VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER";
+                    }
+                    if (dim == DimSubpassData) {
+                        return "VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT";
+                    }
+                    return storage ? "VK_DESCRIPTOR_TYPE_STORAGE_IMAGE" : "VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE";
+                }
+                default:
+                    throw std::runtime_error("unsupported descriptor type");
+            }
+        }
+
+        static std::string Stage(uint32_t executionModel) {
+            switch (executionModel) {
+                case 0: return "VK_SHADER_STAGE_VERTEX_BIT";
+                case 1: return "VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT";
+                case 2: return "VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT";
+                case 3: return "VK_SHADER_STAGE_GEOMETRY_BIT";
+                case 4: return "VK_SHADER_STAGE_FRAGMENT_BIT";
+                case 5: return "VK_SHADER_STAGE_COMPUTE_BIT";
+                default: throw std::runtime_error("unsupported execution model");
+            }
+        }
+
+        struct Variable {
+            uint32_t id;
+            uint32_t pointerType;
+            uint32_t storageClass;
+        };
+
+        std::string m_stage;
+        std::map<uint32_t, uint32_t> m_opcodes;
+        std::map<uint32_t, std::vector<uint32_t>> m_operands;
+        std::map<uint32_t, uint32_t> m_constants;
+        std::map<uint32_t, Decorations> m_decorations;
+        std::map<std::pair<uint32_t, uint32_t>, MemberDecorations> m_memberDecorations;
+        std::vector<Variable> m_variables;
+    };
+
+    std::vector<uint32_t> readWords(const std::string &path) {
+        std::ifstream file{path, std::ios::ate | std::ios::binary};
+        if (!file.is_open()) {
+            throw std::runtime_error("failed to open " + path);
+        }
+
+        auto size = static_cast<size_t>(file.tellg());
+        if (size % 4 != 0) {
+            throw std::runtime_error(path + " is not a whole number of words");
+        }
+
+        std::vector<uint32_t> words(size / 4);
+        file.seekg(0);
+        file.read(reinterpret_cast<char *>(words.data()), static_cast<std::streamsize>(size));
+        return words;
+    }
+
+    // particle.vert.spv -> particle_vert
+    std::string identifier(const std::string &path) {
+        std::string name = path.substr(path.find_last_of("/\\") + 1);
+        if (name.size() > 4 && name.compare(name.size() - 4, 4, ".spv") == 0) {
+            name.resize(name.size() - 4);
+        }
+        for (char &c : name) {
+            if (!std::isalnum(static_cast<unsigned char>(c))) {
+                c = '_';
+            }
+        }
+        if (name.empty() || std::isdigit(static_cast<unsigned char>(name[0]))) {
+            name.insert(name.begin(), '_');
+        }
+        return name;
+    }
+
+    void write(std::ostream &out, const std::vector<Module> &modules) {
+        out << "// Generated by spirv_reflect, do not edit.\n"
+               "#pragma once\n\n"
+               "#include \"ShaderReflection.h\"\n\n"
+               "namespace engine::shaders {\n";
+
+        for (const Module &module : modules) {
+            out << "\n    inline constexpr uint32_t " << module.name << "_code[] = {";
+            for (size_t i = 0; i < module.words.size(); i++) {
+                char word[16];
+                std::snprintf(word, sizeof(word), "0x%08x,", module.words[i]);
+                out << (i % 8 == 0 ? "\n            " : " ") << word;
+            }
+            out << "\n    };\n";
+
+            std::string bindings = "nullptr";
+            if (!module.bindings.empty()) {
+                bindings = module.name + "_bindings";
+                out << "    inline constexpr ShaderBinding " << bindings << "[] = {\n";
+                for (const Binding &binding : module.bindings) {
+                    out << "            {" << binding.set << ", " << binding.binding << ", " << binding.type << ", "
+                        << binding.count << "},\n";
+                }
+                out << "    };\n";
+            }
+
+            out << "    inline constexpr ShaderInfo " << module.name << "{\"" << module.name << "\", " << module.stage
+                << ", " << module.name << "_code, sizeof(" << module.name << "_code), " << bindings << ", "
+                << module.bindings.size() << ", " << module.pushConstantSize << "};\n";
+        }
+
+        out << "}\n";
+    }
+}
+
+int main(int argc, char **argv) {
+    if (argc < 3) {
+        std::cerr << "usage: spirv_reflect <output.h> <module.spv ...>\n";
+        return 1;
+    }
+
+    try {
+        std::vector<Module> modules;
+        for (int i = 2; i < argc; i++) {
+            Module module;
+            module.name = identifier(argv[i]);
+            module.words = readWords(argv[i]);
+            try {
+                Reflector{module.words}.Reflect(module);
+            } catch (const std::exception &e) {
+                throw std::runtime_error(std::string(argv[i]) + ": " + e.what());
+            }
+            modules.push_back(std::move(module));
+        }
+
+        std::ofstream out{argv[1], std::ios::binary | std::ios::trunc};
+        if (!out) {
+            throw std::runtime_error(std::string("failed to open ") + argv[1] + " for writing");
+        }
+        write(out, modules);
+    } catch (const std::exception &e) {
+        std::cerr << "spirv_reflect: " << e.what() << '\n';
+        return 1;
+    }
+    return 0;
+}
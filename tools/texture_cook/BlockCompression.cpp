@@ -0,0 +1,190 @@
+#include "BlockCompression.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace engine::cook {
+    static constexpr int BC7_WEIGHTS[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+    class BitWriter {
+    public:
+        explicit BitWriter(uint8_t *out, size_t size) : mOut(out) { std::memset(out, 0, size); }
+
+        void write(uint32_t value, int count) {
+            for (int i = 0; i < count; i++, mPosition++) {
+                if (value & (1u << i)) {
+                    mOut[mPosition / 8] |= static_cast<uint8_t>(1u << (mPosition % 8));
+                }
+            }
+        }
+
+    private:
+        uint8_t *mOut;
+        int mPosition = 0;
+    };
+
+    static int interpolate(int e0, int e1, int weight) {
+        return ((64 - weight) * e0 + weight * e1 + 32) >> 6;
+    }
+
+    // Picks the best 16 indices for the given 8-bit endpoints and returns the summed squared error.
+    static int selectIndices(const uint8_t rgba[64], const int e0[4], const int e1[4], uint8_t indices[16]) {
+        int palette[16][4];
+        for (int i = 0; i < 16; i++) {
+            for (int c = 0; c < 4; c++) {
+                palette[i][c] = interpolate(e0[c], e1[c], BC7_WEIGHTS[i]);
+            }
+        }
+
+        int total = 0;
+        for (int texel = 0; texel < 16; texel++) {
+            int bestError = INT32_MAX;
+            for (int i = 0; i < 16; i++) {
+                int error = 0;
+                for (int c = 0; c < 4; c++) {
+                    int d = rgba[texel * 4 + c] - palette[i][c];
+                    error += d * d;
+                }
+                if (error < bestError) {
+                    bestError = error;
+                    indices[texel] = static_cast<uint8_t>(i);
+                }
+            }
+            total += bestError;
+        }
+        return total;
+    }
+
+    void EncodeBC7(const uint8_t rgba[64], uint8_t out[16]) {
+        float mean[4] = {};
+        for (int texel = 0; texel < 16; texel++) {
+            for (int c = 0; c < 4; c++) {
+                mean[c] += rgba[texel * 4 + c] / 16.0f;
+            }
+        }
+
+        float covariance[4][4] = {};
+        for (int texel = 0; texel < 16; texel++) {
+            float d[4];
+            for (int c = 0; c < 4; c++) {
+                d[c] = rgba[texel * 4 + c] - mean[c];
+            }
+            for (int a = 0; a < 4; a++) {
+                for (int b = 0; b < 4; b++) {
+                    covariance[a][b] += d[a] * d[b];
+                }
+            }
+        }
+
+        // principal axis by power iteration, converges in a handful of steps for 4x4
+        float axis[4] = {1.0f, 1.0f, 1.0f, 1.0f};
+        for (int iteration = 0; iteration < 8; iteration++) {
+            float next[4] = {};
+            for (int a = 0; a < 4; a++) {
+                for (int b = 0; b < 4; b++) {
+                    next[a] += covariance[a][b] * axis[b];
+                }
+            }
+            float length = std::sqrt(next[0] * next[0] + next[1] * next[1] + next[2] * next[2] + next[3] * next[3]);
+            if (length < 1e-6f) {
+                break;
+            }
+            for (int c = 0; c < 4; c++) {
+                axis[c] = next[c] / length;
+            }
+        }
+
+        float minT = 0.0f;
+        float maxT = 0.0f;
+        for (int texel = 0; texel < 16; texel++) {
+            float t = 0.0f;
+            for (int c = 0; c < 4; c++) {
+                t += (rgba[texel * 4 + c] - mean[c]) * axis[c];
+            }
+            minT = std::min(minT, t);
+            maxT = std::max(maxT, t);
+        }
+
+        float endpoints[2][4];
+        for (int c = 0; c < 4; c++) {
+            endpoints[0][c] = std::clamp(mean[c] + axis[c] * minT, 0.0f, 255.0f);
+            endpoints[1][c] = std::clamp(mean[c] + axis[c] * maxT, 0.0f, 255.0f);
+        }
+
+        // try every p-bit combination, each endpoint is stored as 7 bits plus the shared p-bit
+        int bestError = INT32_MAX;
+        int bestQuantized[2][4] = {};
+        int bestPBits[2] = {};
+        uint8_t bestIndices[16] = {};
+
+        for (int pbits = 0; pbits < 4; pbits++) {
+            int p[2] = {pbits & 1, pbits >> 1};
+            int quantized[2][4];
+            int expanded[2][4];
+            for (int e = 0; e < 2; e++) {
+                for (int c = 0; c < 4; c++) {
+                    quantized[e][c] = std::clamp(static_cast<int>(std::lround((endpoints[e][c] - p[e]) / 2.0f)), 0, 127);
+                    expanded[e][c] = quantized[e][c] << 1 | p[e];
+                }
+            }
+
+            uint8_t indices[16];
+            int error = selectIndices(rgba, expanded[0], expanded[1], indices);
+            if (error < bestError) {
+                bestError = error;
+                std::memcpy(bestQuantized, quantized, sizeof(quantized));
+                std::memcpy(bestPBits, p, sizeof(p));
+                std::memcpy(bestIndices, indices, sizeof(indices));
+            }
+        }
+
+        // the anchor index is stored with its top bit implied zero
+        if (bestIndices[0] & 8) {
+            for (int c = 0; c < 4; c++) {
+                std::swap(bestQuantized[0][c], bestQuantized[1][c]);
+            }
+            std::swap(bestPBits[0], bestPBits[1]);
+            for (auto &index : bestIndices) {
+                index = static_cast<uint8_t>(15 - index);
+            }
+        }
+
+        BitWriter writer{out, 16};
+        writer.write(1u << 6, 7);
+        for (int c = 0; c < 4; c++) {
+            writer.write(bestQuantized[0][c], 7);
+            writer.write(bestQuantized[1][c], 7);
+        }
+        writer.write(bestPBits[0], 1);
+        writer.write(bestPBits[1], 1);
+        writer.write(bestIndices[0], 3);
+        for (int i = 1; i < 16; i++) {
+            writer.write(bestIndices[i], 4);
+        }
+    }
+
+    void EncodeBC4(const uint8_t values[16], uint8_t out[8]) {
+        int minValue = *std::min_element(values, values + 16);
+        int maxValue = *std::max_element(values, values + 16);
+
+        BitWriter writer{out, 8};
+        writer.write(maxValue, 8);
+        writer.write(minValue, 8);
+
+        // with red0 > red1 index 0 is the max, 1 the min and 2..7 step from max towards min
+        for (int texel = 0; texel < 16; texel++) {
+            int index = 0;
+            if (maxValue > minValue) {
+                int step = static_cast<int>(std::lround(7.0f * (values[texel] - minValue) / (maxValue - minValue)));
+                index = step == 7 ? 0 : step == 0 ? 1 : 8 - step;
+            }
+            writer.write(index, 3);
+        }
+    }
+
+    void EncodeBC5(const uint8_t red[16], const uint8_t green[16], uint8_t out[16]) {
+        EncodeBC4(red, out);
+        EncodeBC4(green, out + 8);
+    }
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstdint>
+
+namespace engine::cook {
+    // All encoders take one 4x4 block in row-major order.
+
+    // BC7 mode 6 only: one subset, RGBA endpoints with p-bits and 4-bit indices.
+    // Good enough for albedo and emissive, which is all the cooker uses BC7 for.
+    void EncodeBC7(const uint8_t rgba[64], uint8_t out[16]);
+
+    // Single channel, 8 interpolated values between the block min and max.
+    void EncodeBC4(const uint8_t values[16], uint8_t out[8]);
+
+    // Two independent BC4 blocks, used for tangent space normals (x in red, y in green).
+    void EncodeBC5(const uint8_t red[16], const uint8_t green[16], uint8_t out[16]);
+}
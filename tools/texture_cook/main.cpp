@@ -0,0 +1,223 @@
+// Offline texture cooker: builds the full mip chain of an image and writes it as a
+// BC compressed KTX2 file that TextureImage uploads without any decoding.
+//
+// usage: texture_cook <input image> <output.ktx2> [slot]
+//
+// The slot decides the format and defaults to the input file name (albedo.jpg -> albedo):
+//   albedo, emissive                               BC7 sRGB
+//   normal                                         BC5 (x, y), z is reconstructed in the shader
+//   roughness, metallic, ao, height, specular      BC4
+
+#include "BlockCompression.h"
+#include "textures/Ktx2.h"
+#include "stb/stb_image.cpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+    enum class Encoding {
+        ColorSrgb,
+        Normal,
+        SingleChannel
+    };
+
+    struct Level {
+        uint32_t width;
+        uint32_t height;
+        // four linear floats per texel, normals in [-1, 1]
+        std::vector<float> texels;
+    };
+
+    Encoding encodingForSlot(const std::string &slot) {
+        if (slot == "albedo" || slot == "emissive") {
+            return Encoding::ColorSrgb;
+        }
+        if (slot == "normal") {
+            return Encoding::Normal;
+        }
+        if (slot == "roughness" || slot == "metallic" || slot == "ao" || slot == "height" || slot == "specular") {
+            return Encoding::SingleChannel;
+        }
+        throw std::runtime_error("unknown texture slot: " + slot);
+    }
+
+    std::string slotFromPath(const std::string &path) {
+        size_t begin = path.find_last_of("/\\");
+        begin = begin == std::string::npos ? 0 : begin + 1;
+        size_t end = path.find('.', begin);
+        return path.substr(begin, end == std::string::npos ? std::string::npos : end - begin);
+    }
+
+    float srgbToLinear(float value) {
+        return value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+    }
+
+    float linearToSrgb(float value) {
+        return value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+    }
+
+    uint8_t toByte(float value) {
+        return static_cast<uint8_t>(std::lround(std::clamp(value, 0.0f, 1.0f) * 255.0f));
+    }
+
+    Level decode(const unsigned char *pixels, uint32_t width, uint32_t height, Encoding encoding) {
+        Level level{width, height, std::vector<float>(size_t(width) * height * 4)};
+        for (size_t i = 0; i < level.texels.size(); i++) {
+            float value = pixels[i] / 255.0f;
+            bool alpha = i % 4 == 3;
+            if (encoding == Encoding::ColorSrgb && !alpha) {
+                value = srgbToLinear(value);
+            } else if (encoding == Encoding::Normal && !alpha) {
+                value = value * 2.0f - 1.0f;
+            }
+            level.texels[i] = value;
+        }
+        return level;
+    }
+
+    // 2x2 box filter, the last row/column is repeated for odd sizes
+    Level downsample(const Level &source, Encoding encoding) {
+        Level level{std::max(source.width / 2, 1u), std::max(source.height / 2, 1u), {}};
+        level.texels.resize(size_t(level.width) * level.height * 4);
+
+        for (uint32_t y = 0; y < level.height; y++) {
+            for (uint32_t x = 0; x < level.width; x++) {
+                float sum[4] = {};
+                for (uint32_t dy = 0; dy < 2; dy++) {
+                    for (uint32_t dx = 0; dx < 2; dx++) {
+                        uint32_t sx = std::min(x * 2 + dx, source.width - 1);
+                        uint32_t sy = std::min(y * 2 + dy, source.height - 1);
+                        for (int c = 0; c < 4; c++) {
+                            sum[c] += source.texels[(size_t(sy) * source.width + sx) * 4 + c] * 0.25f;
+                        }
+                    }
+                }
+
+                if (encoding == Encoding::Normal) {
+                    float length = std::sqrt(sum[0] * sum[0] + sum[1] * sum[1] + sum[2] * sum[2]);
+                    if (length > 1e-6f) {
+                        sum[0] /= length;
+                        sum[1] /= length;
+                        sum[2] /= length;
+                    }
+                }
+
+                std::copy(sum, sum + 4, &level.texels[(size_t(y) * level.width + x) * 4]);
+            }
+        }
+        return level;
+    }
+
+    std::vector<uint8_t> encode(const Level &level, Encoding encoding, uint32_t blockSize) {
+        uint32_t blocksX = (level.width + 3) / 4;
+        uint32_t blocksY = (level.height + 3) / 4;
+        std::vector<uint8_t> blocks(size_t(blocksX) * blocksY * blockSize);
+
+        auto encodeRows = [&](uint32_t firstRow, uint32_t lastRow) {
+            for (uint32_t by = firstRow; by < lastRow; by++) {
+                for (uint32_t bx = 0; bx < blocksX; bx++) {
+                    uint8_t rgba[64];
+                    uint8_t red[16];
+                    uint8_t green[16];
+
+                    for (uint32_t i = 0; i < 16; i++) {
+                        // edge blocks repeat the border texels
+                        uint32_t x = std::min(bx * 4 + i % 4, level.width - 1);
+                        uint32_t y = std::min(by * 4 + i / 4, level.height - 1);
+                        const float *texel = &level.texels[(size_t(y) * level.width + x) * 4];
+
+                        if (encoding == Encoding::ColorSrgb) {
+                            for (int c = 0; c < 3; c++) {
+                                rgba[i * 4 + c] = toByte(linearToSrgb(texel[c]));
+                            }
+                            rgba[i * 4 + 3] = toByte(texel[3]);
+                        } else if (encoding == Encoding::Normal) {
+                            red[i] = toByte(texel[0] * 0.5f + 0.5f);
+                            green[i] = toByte(texel[1] * 0.5f + 0.5f);
+                        } else {
+                            red[i] = toByte(texel[0]);
+                        }
+                    }
+
+                    uint8_t *out = &blocks[(size_t(by) * blocksX + bx) * blockSize];
+                    switch (encoding) {
+                        case Encoding::ColorSrgb:
+                            engine::cook::EncodeBC7(rgba, out);
+                            break;
+                        case Encoding::Normal:
+                            engine::cook::EncodeBC5(red, green, out);
+                            break;
+                        case Encoding::SingleChannel:
+                            engine::cook::EncodeBC4(red, out);
+                            break;
+                    }
+                }
+            }
+        };
+
+        uint32_t threadCount = std::max(1u, std::min(std::thread::hardware_concurrency(), blocksY));
+        uint32_t rowsPerThread = (blocksY + threadCount - 1) / threadCount;
+
+        std::vector<std::thread> threads;
+        for (uint32_t first = 0; first < blocksY; first += rowsPerThread) {
+            threads.emplace_back(encodeRows, first, std::min(first + rowsPerThread, blocksY));
+        }
+        for (auto &thread : threads) {
+            thread.join();
+        }
+
+        return blocks;
+    }
+}
+
+int main(int argc, char **argv) {
+    if (argc < 3) {
+        std::cerr << "usage: texture_cook <input image> <output.ktx2> [slot]\n";
+        return 1;
+    }
+
+    std::string input = argv[1];
+    std::string output = argv[2];
+
+    try {
+        Encoding encoding = encodingForSlot(argc > 3 ? argv[3] : slotFromPath(input));
+
+        VkFormat format = encoding == Encoding::ColorSrgb ? VK_FORMAT_BC7_SRGB_BLOCK
+                        : encoding == Encoding::Normal ? VK_FORMAT_BC5_UNORM_BLOCK
+                        : VK_FORMAT_BC4_UNORM_BLOCK;
+        uint32_t blockSize = engine::Ktx2BlockSize(format);
+
+        int width, height, channels;
+        stbi_uc *pixels = stbi_load(input.c_str(), &width, &height, &channels, 4);
+        if (!pixels) {
+            throw std::runtime_error("failed to load image: " + input);
+        }
+
+        Level level = decode(pixels, static_cast<uint32_t>(width), static_cast<uint32_t>(height), encoding);
+        stbi_image_free(pixels);
+
+        std::vector<std::vector<uint8_t>> levels;
+        while (true) {
+            levels.push_back(encode(level, encoding, blockSize));
+            if (level.width == 1 && level.height == 1) {
+                break;
+            }
+            level = downsample(level, encoding);
+        }
+
+        engine::WriteKtx2(output, format, static_cast<uint32_t>(width), static_cast<uint32_t>(height), levels);
+
+        std::cout << input << " -> " << output << " (" << levels.size() << " levels)\n";
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << '\n';
+        return 1;
+    }
+
+    return 0;
+}